@@ -0,0 +1,227 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file AllocationCounter.h
+ *
+ * \brief Counts the calls of the global operator new/delete of each thread,
+ * so that tests can verify that the real-time paths do not allocate.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace OpenSimRT {
+
+/**
+ * \brief Per-thread counters of the global operator new/delete.
+ *
+ * The counting operators replace the global ones of a program, therefore they
+ * are defined only in the single translation unit that includes this header
+ * after defining OPENSIMRT_ALLOCATION_HOOK (normally the test program). In
+ * all other cases the counters remain zero and isInstalled() is false. The
+ * hook observes allocations of the shared libraries on platforms with a
+ * single global operator new (e.g., Linux, macOS), but not of other DLLs on
+ * Windows.
+ *
+ * ****************************************************************************
+ * Example code:
+ * ****************************************************************************
+ *
+ * #define OPENSIMRT_ALLOCATION_HOOK
+ * #include "AllocationCounter.h"
+ *
+ * auto before = AllocationCounter::getThreadCounts();
+ * f();
+ * auto after = AllocationCounter::getThreadCounts();
+ * if (after.allocations != before.allocations) { ... }
+ */
+class AllocationCounter {
+ public:
+    struct Counts {
+        std::uint64_t allocations;
+        std::uint64_t deallocations;
+        std::uint64_t bytes; // allocated
+    };
+
+    /**
+     * Counts of the calling thread since the thread started.
+     */
+    static Counts getThreadCounts();
+
+    /**
+     * Number of allocations of the calling thread since the thread started.
+     */
+    static std::uint64_t getThreadAllocations() {
+        return getThreadCounts().allocations;
+    }
+
+    /**
+     * True if the counting operators are linked in the program.
+     */
+    static bool isInstalled();
+};
+
+namespace internal {
+// constant-initialized, thus usable by operator new at any time (also before
+// the static initialization and during the creation of a thread)
+inline thread_local AllocationCounter::Counts threadAllocationCounts{0, 0, 0};
+inline bool isAllocationHookInstalled = false;
+
+inline void* countedAllocate(std::size_t size) noexcept {
+    auto& counts = threadAllocationCounts;
+    counts.allocations++;
+    counts.bytes += size;
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+inline void* countedAllocate(std::size_t size,
+                             std::align_val_t alignment) noexcept {
+    auto& counts = threadAllocationCounts;
+    counts.allocations++;
+    counts.bytes += size;
+    auto align = static_cast<std::size_t>(alignment);
+    if (align < sizeof(void*)) align = sizeof(void*);
+#ifdef _WIN32
+    return _aligned_malloc(size == 0 ? 1 : size, align);
+#else
+    void* p = nullptr;
+    return posix_memalign(&p, align, size == 0 ? 1 : size) == 0 ? p
+                                                                 : nullptr;
+#endif
+}
+
+inline void countedFree(void* p) noexcept {
+    if (!p) return;
+    threadAllocationCounts.deallocations++;
+    std::free(p);
+}
+
+inline void countedAlignedFree(void* p) noexcept {
+    if (!p) return;
+    threadAllocationCounts.deallocations++;
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+} // namespace internal
+
+inline AllocationCounter::Counts AllocationCounter::getThreadCounts() {
+    return internal::threadAllocationCounts;
+}
+
+inline bool AllocationCounter::isInstalled() {
+    return internal::isAllocationHookInstalled;
+}
+
+} // namespace OpenSimRT
+
+#ifdef OPENSIMRT_ALLOCATION_HOOK
+
+namespace OpenSimRT {
+namespace internal {
+static const bool allocationHookInstalled =
+        (isAllocationHookInstalled = true);
+} // namespace internal
+} // namespace OpenSimRT
+
+void* operator new(std::size_t size) {
+    void* p = OpenSimRT::internal::countedAllocate(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](std::size_t size) {
+    void* p = OpenSimRT::internal::countedAllocate(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return OpenSimRT::internal::countedAllocate(size);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return OpenSimRT::internal::countedAllocate(size);
+}
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    void* p = OpenSimRT::internal::countedAllocate(size, alignment);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    void* p = OpenSimRT::internal::countedAllocate(size, alignment);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void* operator new(std::size_t size, std::align_val_t alignment,
+                   const std::nothrow_t&) noexcept {
+    return OpenSimRT::internal::countedAllocate(size, alignment);
+}
+void* operator new[](std::size_t size, std::align_val_t alignment,
+                     const std::nothrow_t&) noexcept {
+    return OpenSimRT::internal::countedAllocate(size, alignment);
+}
+
+void operator delete(void* p) noexcept {
+    OpenSimRT::internal::countedFree(p);
+}
+void operator delete[](void* p) noexcept {
+    OpenSimRT::internal::countedFree(p);
+}
+void operator delete(void* p, std::size_t) noexcept {
+    OpenSimRT::internal::countedFree(p);
+}
+void operator delete[](void* p, std::size_t) noexcept {
+    OpenSimRT::internal::countedFree(p);
+}
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    OpenSimRT::internal::countedFree(p);
+}
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    OpenSimRT::internal::countedFree(p);
+}
+void operator delete(void* p, std::align_val_t) noexcept {
+    OpenSimRT::internal::countedAlignedFree(p);
+}
+void operator delete[](void* p, std::align_val_t) noexcept {
+    OpenSimRT::internal::countedAlignedFree(p);
+}
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    OpenSimRT::internal::countedAlignedFree(p);
+}
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+    OpenSimRT::internal::countedAlignedFree(p);
+}
+void operator delete(void* p, std::align_val_t,
+                     const std::nothrow_t&) noexcept {
+    OpenSimRT::internal::countedAlignedFree(p);
+}
+void operator delete[](void* p, std::align_val_t,
+                       const std::nothrow_t&) noexcept {
+    OpenSimRT::internal::countedAlignedFree(p);
+}
+
+#endif
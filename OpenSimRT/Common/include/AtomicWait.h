@@ -0,0 +1,49 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file AtomicWait.h
+ *
+ * \brief Blocking on an atomic word without a mutex (futex on Linux,
+ * WaitOnAddress on Windows).
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#pragma once
+
+#include "internal/CommonExports.h"
+#include <atomic>
+#include <cstdint>
+
+namespace OpenSimRT {
+
+/**
+ * Block the calling thread while word == value. The function may return
+ * spuriously, thus the caller must check its condition in a loop. On
+ * platforms without an address-based wait, the thread sleeps briefly.
+ */
+Common_API void atomicWait(const std::atomic<std::uint32_t>& word,
+                           std::uint32_t value);
+
+/**
+ * Wake all threads that wait on word. Must be called after the word is
+ * modified.
+ */
+Common_API void atomicWakeAll(std::atomic<std::uint32_t>& word);
+
+} // namespace OpenSimRT
@@ -0,0 +1,231 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file BinaryLogger.h
+ *
+ * \brief Asynchronous logging of time series to an append-only binary file
+ * and reading of the logged time series.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#pragma once
+
+#include "Exception.h"
+#include "SPSCQueue.h"
+#include "internal/CommonExports.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace OpenSimRT {
+
+/**
+ * \brief Logs rows of time series (tables with fixed column labels, e.g., the
+ * tables of the initializeLogger() functions) to a binary file, without
+ * accumulating them in memory. The rows are passed from the logging thread
+ * (e.g., a thread of the real-time pipeline) to a background thread through a
+ * lock-free queue and the background thread appends them to the file. Thus,
+ * appendRow() neither allocates nor performs I/O and the memory is constant
+ * regardless of the duration of the session. The file is synchronized to the
+ * disk periodically, so that at most syncInterval seconds of data are lost if
+ * the process crashes.
+ *
+ * Rows are split into fixed-size chunks in the queue. If the queue does not
+ * have room for a row (the disk cannot keep up), the row is dropped and
+ * counted, instead of blocking the logging thread (DROP_NEWEST). Offline
+ * (e.g., replay of a recorded trial) rows must not be lost, thus with the
+ * BLOCK overflow policy appendRow() waits for room instead. All rows must be
+ * appended from the same thread.
+ *
+ * File format (native byte order):
+ *
+ * header:  "OSRTBLOG" | version (u32) | number of tables (u32) |
+ *          for each table: name | number of columns (u32) | column labels
+ * records: table index (u32) | time (f64) | values (f64 x columns)
+ *
+ * where strings are stored as length (u32) | characters. A truncated record at
+ * the end of the file (crash) is ignored by the BinaryLogReader.
+ *
+ * ****************************************************************************
+ * Example code:
+ * ****************************************************************************
+ *
+ * BinaryLogger logger("session.bin");
+ * int qTable = logger.addTable("q", ik.initializeLogger().getColumnLabels());
+ * logger.start();
+ * while (...) logger.appendRow(qTable, t, q); // any vector with operator[]
+ * logger.close();
+ *
+ * // conversion to .sto (see OpenSimUtils::convertBinaryLog)
+ */
+class Common_API BinaryLogger {
+ public:
+    struct Parameters {
+        std::size_t queueCapacity; // chunks between the threads (4096)
+        double syncInterval;       // seconds between synchronizations (1)
+    };
+
+    BinaryLogger(const std::string& fileName,
+                 const Parameters& parameters = {4096, 1.0});
+    ~BinaryLogger();
+
+    BinaryLogger(const BinaryLogger&) = delete;
+    BinaryLogger& operator=(const BinaryLogger&) = delete;
+
+    /**
+     * Add a table and return its index. Must be called before start().
+     */
+    int addTable(const std::string& name,
+                 const std::vector<std::string>& columnLabels);
+
+    /**
+     * Write the header and start the background thread.
+     */
+    void start();
+
+    /**
+     * Drop the rows that do not fit in the queue (DROP_NEWEST, default) or
+     * wait for room (BLOCK). May be called while rows are appended.
+     */
+    void setOverflowPolicy(OverflowPolicy policy);
+    OverflowPolicy getOverflowPolicy() const {
+        return isBlocking.load(std::memory_order_relaxed)
+                       ? OverflowPolicy::BLOCK
+                       : OverflowPolicy::DROP_NEWEST;
+    }
+
+    /**
+     * Append a row to a table (logging thread). The values must have one
+     * element per column. Returns false if the row was dropped or the logger
+     * was closed.
+     */
+    template <typename V>
+    bool appendRow(int table, double t, const V& values) {
+        if (!isStarted) THROW_EXCEPTION("logger is not started");
+        if (queue.isClosed()) return false;
+        if (table < 0 || table >= tables.size()) {
+            THROW_EXCEPTION("unknown table " + std::to_string(table));
+        }
+        int n = tables[table].columnLabels.size();
+        if (values.size() != n) {
+            THROW_EXCEPTION("wrong number of values for table " +
+                            tables[table].name);
+        }
+
+        // the whole row is dropped if it does not fit, unless the logger
+        // blocks
+        std::size_t numChunks = n == 0 ? 1 : (n + chunkSize - 1) / chunkSize;
+        if (!isBlocking.load(std::memory_order_relaxed) &&
+            queue.getCapacity() - queue.getSize() < numChunks) {
+            numDropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        Chunk chunk;
+        chunk.table = table;
+        chunk.t = t;
+        for (std::size_t c = 0; c < numChunks; ++c) {
+            int offset = c * chunkSize;
+            chunk.offset = offset;
+            for (int i = offset; i < n && i < offset + chunkSize; ++i) {
+                chunk.values[i - offset] = values[i];
+            }
+            // fails only if the logger is closed while it waits
+            if (!queue.push(chunk)) return false;
+        }
+        return true;
+    }
+
+    /**
+     * Write the remaining rows, synchronize and close the file. Rows that are
+     * appended afterwards are ignored. May be called from any thread.
+     */
+    void close();
+
+    /**
+     * Rows that were written to the file and rows that were dropped.
+     */
+    std::uint64_t getNumWrittenRows() const;
+    std::uint64_t getNumDroppedRows() const;
+
+ private:
+    static constexpr int chunkSize = 30;
+
+    struct Chunk {
+        std::uint32_t table;
+        std::uint32_t offset; // column of the first value
+        double t;
+        double values[chunkSize];
+    };
+
+    struct Table {
+        std::string name;
+        std::vector<std::string> columnLabels;
+        std::vector<double> row; // row that is assembled from chunks
+    };
+
+    void writeChunk(const Chunk& chunk);
+    void synchronize();
+    void run();
+
+    std::string fileName;
+    Parameters parameters;
+    std::vector<Table> tables;
+    SPSCQueue<Chunk> queue;
+    std::FILE* file;
+    std::thread writerThread;
+    std::mutex closeMutex;
+    bool isStarted;
+    std::atomic<bool> isBlocking;
+    std::atomic<std::uint64_t> numWritten;
+    std::atomic<std::uint64_t> numDropped;
+};
+
+/**
+ * \brief Reads the records of a file that was written by BinaryLogger, one at
+ * a time.
+ */
+class Common_API BinaryLogReader {
+ public:
+    BinaryLogReader(const std::string& fileName);
+    ~BinaryLogReader();
+
+    BinaryLogReader(const BinaryLogReader&) = delete;
+    BinaryLogReader& operator=(const BinaryLogReader&) = delete;
+
+    int getNumTables() const { return tableNames.size(); }
+    const std::string& getTableName(int table) const;
+    const std::vector<std::string>& getColumnLabels(int table) const;
+
+    /**
+     * Read the next record. Returns false at the end of the file (a truncated
+     * record is ignored).
+     */
+    bool next(int& table, double& t, std::vector<double>& values);
+
+ private:
+    std::FILE* file;
+    std::vector<std::string> tableNames;
+    std::vector<std::vector<std::string>> columnLabels;
+};
+
+} // namespace OpenSimRT
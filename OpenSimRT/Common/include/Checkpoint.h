@@ -0,0 +1,171 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file Checkpoint.h
+ *
+ * \brief Serialization of the state of stateful components (e.g., filter
+ * buffers, optimizer seeds) and periodic checkpoints to the disk, so that an
+ * analysis can resume after a restart.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#pragma once
+
+#include "TripleBuffer.h"
+#include "internal/CommonExports.h"
+#include <SimTKcommon.h>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace OpenSimRT {
+
+/**
+ * \brief Serializes values in a binary buffer (native byte order). Components
+ * write their state with saveState(CheckpointWriter&) and read it back in the
+ * same order with loadState(CheckpointReader&).
+ */
+class Common_API CheckpointWriter {
+ public:
+    void write(bool value);
+    void write(int value);
+    void write(double value);
+    void write(const std::string& value);
+    void write(const SimTK::Vector& value);
+    void write(const SimTK::Matrix& value);
+
+    const std::string& getData() const { return data; }
+    void clear() { data.clear(); }
+
+ private:
+    void writeBytes(const void* bytes, std::size_t size);
+
+    std::string data;
+};
+
+/**
+ * \brief Reads the values of a CheckpointWriter. Throws if the data are
+ * exhausted (e.g., a checkpoint of a different version).
+ */
+class Common_API CheckpointReader {
+ public:
+    CheckpointReader(const std::string& data);
+
+    void read(bool& value);
+    void read(int& value);
+    void read(double& value);
+    void read(std::string& value);
+    void read(SimTK::Vector& value);
+    void read(SimTK::Matrix& value);
+
+    bool isEmpty() const { return position == data.size(); }
+
+ private:
+    void readBytes(void* bytes, std::size_t size);
+
+    std::string data;
+    std::size_t position;
+};
+
+/**
+ * \brief Writes periodic checkpoints that consist of named sections (e.g., the
+ * state of each stage of the pipeline). Each section is updated by a single
+ * thread through a TripleBuffer, thus update() does not block on the disk or
+ * on the other threads. A background thread writes the latest sections every
+ * interval seconds, if any was updated, into a temporary file that replaces
+ * the checkpoint file, so that a crash during writing leaves the previous
+ * checkpoint intact.
+ *
+ * ****************************************************************************
+ * Example code:
+ * ****************************************************************************
+ *
+ * Checkpointer checkpointer("state.ckpt", 1.0);
+ * int filterSection = checkpointer.addSection("filter");
+ * checkpointer.start();
+ *
+ * CheckpointWriter writer; // thread of the filter
+ * filter.saveState(writer);
+ * checkpointer.update(filterSection, writer.getData());
+ *
+ * // after a restart
+ * auto sections = Checkpointer::load("state.ckpt");
+ * CheckpointReader reader(sections.at("filter"));
+ * filter.loadState(reader);
+ */
+class Common_API Checkpointer {
+ public:
+    Checkpointer(const std::string& fileName, double interval);
+    ~Checkpointer();
+
+    Checkpointer(const Checkpointer&) = delete;
+    Checkpointer& operator=(const Checkpointer&) = delete;
+
+    /**
+     * Add a section and return its index. Must be called before start().
+     */
+    int addSection(const std::string& name);
+
+    /**
+     * Start the background thread.
+     */
+    void start();
+
+    /**
+     * Update the data of a section (one thread per section).
+     */
+    void update(int section, const std::string& data);
+
+    /**
+     * Write the latest sections and stop the background thread.
+     */
+    void close();
+
+    /**
+     * Number of checkpoints that were written.
+     */
+    std::uint64_t getNumCheckpoints() const;
+
+    /**
+     * Write or read a checkpoint file (section name -> data).
+     */
+    static void save(const std::string& fileName,
+                     const std::map<std::string, std::string>& sections);
+    static std::map<std::string, std::string> load(const std::string& fileName);
+
+ private:
+    // write the sections that were updated (background thread)
+    void writeUpdates();
+    void run();
+
+    std::string fileName;
+    double interval;
+    std::vector<std::string> names;
+    std::vector<std::unique_ptr<TripleBuffer<std::string>>> sections;
+    std::thread writerThread;
+    bool isStarted;
+    std::atomic<bool> isClosing;
+    std::atomic<std::uint64_t> numCheckpoints;
+};
+
+} // namespace OpenSimRT
@@ -0,0 +1,120 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file ClockModel.h
+ *
+ * \brief Online estimation of the offset and skew of a device clock with
+ * respect to the host clock, so that timestamps of independent devices are
+ * expressed in a common time base.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#pragma once
+
+#include "internal/CommonExports.h"
+#include <cstddef>
+
+namespace OpenSimRT {
+
+/**
+ * \brief Maps the timestamps of a device to the host clock with the linear
+ * model hostTime = offset + rate * deviceTime, where rate = 1 / (1 + skew). The
+ * parameters are estimated by recursive least squares from pairs of device
+ * timestamps and host receive times, with a forgetting factor that tracks
+ * slow changes (e.g., temperature). The receive times include the transmission
+ * latency, thus the mapped timestamps include the mean latency, which is
+ * similar for all devices of the same network.
+ *
+ * Samples that are delayed more than outlierThreshold (e.g., a burst after a
+ * Wi-Fi stall) are not used for the estimation. If maximumOutliers
+ * consecutive samples are outliers, the device clock is considered reset and
+ * the estimation restarts.
+ *
+ * ****************************************************************************
+ * Example code:
+ * ****************************************************************************
+ *
+ * ClockModel clock({0.9999, 1e-4, 2e-3, 0.05, 300});
+ * // for each received sample
+ * double t = clock.update(deviceTime, hostReceiveTime);
+ * manager.appendPack(std::make_pair(t, ...));
+ */
+class Common_API ClockModel {
+ public:
+    struct Parameters {
+        double forgettingFactor; // weight of the previous samples (0.9999)
+        double skewDeviation;    // prior standard deviation of the skew (1e-4)
+        double latencyDeviation; // standard deviation of the latency (2e-3)
+        double outlierThreshold; // maximum latency deviation in seconds (0.05)
+        int maximumOutliers;     // consecutive outliers before reset (300)
+    };
+
+    ClockModel(const Parameters& parameters = {0.9999, 1e-4, 2e-3, 0.05, 300});
+
+    /**
+     * Update the estimation with a device timestamp and the host time that the
+     * sample was received (seconds). Returns the timestamp in the host clock.
+     */
+    double update(double deviceTime, double hostTime);
+
+    /**
+     * Map a device timestamp to the host clock with the current estimation.
+     */
+    double toHostTime(double deviceTime) const;
+
+    /**
+     * Difference hostTime - deviceTime at the latest device timestamp.
+     */
+    double getOffset() const;
+
+    /**
+     * Relative rate difference of the device clock (positive if it is fast).
+     */
+    double getSkew() const { return 1 / theta[1] - 1; }
+
+    /**
+     * Number of samples used for the estimation and rejected as outliers.
+     */
+    std::size_t getNumSamples() const { return numSamples; }
+    std::size_t getNumOutliers() const { return numOutliers; }
+
+    void reset();
+
+ private:
+    // restart the estimation from the next sample
+    void restart();
+
+    Parameters parameters;
+
+    // timestamps of the first sample (the model is expressed relative to them
+    // for numerical conditioning)
+    double deviceReference;
+    double hostReference;
+    double latestDeviceTime;
+
+    // [offset, rate] and their covariance
+    double theta[2];
+    double P[2][2];
+
+    std::size_t numSamples;
+    std::size_t numOutliers;
+    int consecutiveOutliers;
+};
+
+} // namespace OpenSimRT
@@ -0,0 +1,245 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file FrameArena.h
+ *
+ * \brief Per-thread bump allocator for the temporaries of a frame, released
+ * at once at the frame boundary.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#pragma once
+
+#include "internal/CommonExports.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace OpenSimRT {
+
+/**
+ * \brief A bump (arena) allocator. Allocation advances an offset in a block
+ * of memory and nothing is freed individually; reset() or rewind() release
+ * everything allocated after a point at once.
+ *
+ * When a block is full, a larger block is appended and kept for the next
+ * frames, thus after a warm-up frame of maximum size the arena does not
+ * allocate from the heap. Destructors are not called, therefore create() and
+ * allocateArray() accept only trivially destructible types. Containers with
+ * ArenaAllocator may hold any type, but must be destroyed before the arena is
+ * rewound past their memory.
+ *
+ * A FrameArena is not thread-safe; each thread uses its own arena (see
+ * FrameContext).
+ */
+class Common_API FrameArena {
+ public:
+    /**
+     * Position of the arena (see getMarker() and rewind()).
+     */
+    struct Marker {
+        std::size_t block;
+        std::size_t offset;
+    };
+
+    /**
+     * Rewinds the arena to its position at construction when destroyed, thus
+     * the allocations of a scope are released at its end.
+     */
+    class Scope {
+     public:
+        explicit Scope(FrameArena& arena)
+                : arena(arena), marker(arena.getMarker()) {}
+        ~Scope() { arena.rewind(marker); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+     private:
+        FrameArena& arena;
+        Marker marker;
+    };
+
+    /**
+     * Create an arena with a first block of capacity bytes.
+     */
+    explicit FrameArena(std::size_t capacity = 64 * 1024);
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    /**
+     * Allocate size bytes aligned to alignment (a power of two).
+     */
+    void* allocate(std::size_t size,
+                   std::size_t alignment = alignof(std::max_align_t));
+
+    /**
+     * Allocate an array of n value-initialized objects.
+     */
+    template <typename T> T* allocateArray(std::size_t n) {
+        static_assert(std::is_trivially_destructible<T>::value,
+                      "the arena does not call destructors");
+        auto p = static_cast<T*>(allocate(n * sizeof(T), alignof(T)));
+        for (std::size_t i = 0; i < n; ++i) new (p + i) T();
+        return p;
+    }
+
+    /**
+     * Construct an object in the arena.
+     */
+    template <typename T, typename... Args> T* create(Args&&... args) {
+        static_assert(std::is_trivially_destructible<T>::value,
+                      "the arena does not call destructors");
+        return new (allocate(sizeof(T), alignof(T)))
+                T(std::forward<Args>(args)...);
+    }
+
+    Marker getMarker() const { return {current, offset}; }
+
+    /**
+     * Release the allocations after the marker (the blocks are kept).
+     */
+    void rewind(const Marker& marker);
+
+    /**
+     * Release all allocations (the blocks are kept).
+     */
+    void reset() { rewind({0, 0}); }
+
+    /**
+     * Bytes in use, including the alignment padding and the unused end of
+     * the filled blocks.
+     */
+    std::size_t getUsed() const;
+    /**
+     * Maximum of getUsed() since construction.
+     */
+    std::size_t getPeakUsed() const { return peakUsed; }
+    /**
+     * Total size of the blocks.
+     */
+    std::size_t getCapacity() const;
+    std::size_t getNumBlocks() const { return blocks.size(); }
+
+ private:
+    struct Block {
+        std::unique_ptr<char[]> data;
+        std::size_t size;
+    };
+
+    static Block createBlock(std::size_t size);
+
+    std::vector<Block> blocks;
+    std::size_t current;    // block of the next allocation
+    std::size_t offset;     // in the current block
+    std::size_t usedBefore; // size of the blocks before the current
+    std::size_t peakUsed;
+};
+
+/**
+ * \brief Standard allocator over a FrameArena. Deallocation is a no-op; the
+ * memory is released when the arena is rewound or reset.
+ */
+template <typename T> class ArenaAllocator {
+ public:
+    typedef T value_type;
+
+    explicit ArenaAllocator(FrameArena& arena) noexcept : arena(&arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept
+            : arena(other.getArena()) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T*, std::size_t) noexcept {}
+
+    FrameArena* getArena() const { return arena; }
+
+ private:
+    FrameArena* arena;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+    return a.getArena() == b.getArena();
+}
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+    return !(a == b);
+}
+
+/**
+ * A std::vector whose storage is allocated from an arena.
+ */
+template <typename T> using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+/**
+ * \brief Context of the frame that is processed by the calling thread. Each
+ * thread has its own arena, which is created on first use and reset at the
+ * beginning of each frame. The modules allocate their per-frame temporaries
+ * from getArena(), preferably within a FrameArena::Scope so that nested
+ * calls release their memory early. The pipeline threads of the analysis
+ * call beginFrame() before each frame; threads that never call it should use
+ * a Scope for every allocation.
+ *
+ * ****************************************************************************
+ * Example code:
+ * ****************************************************************************
+ *
+ * // module
+ * auto& arena = FrameContext::getArena();
+ * FrameArena::Scope scope(arena);
+ * ArenaVector<int> indices{ArenaAllocator<int>(arena)};
+ * indices.reserve(n);
+ *
+ * // pipeline thread
+ * while (running) {
+ *     FrameContext::beginFrame();
+ *     ...
+ * }
+ */
+class Common_API FrameContext {
+ public:
+    /**
+     * Arena of the calling thread.
+     */
+    static FrameArena& getArena();
+
+    /**
+     * Release the temporaries of the previous frame of the calling thread.
+     */
+    static void beginFrame();
+
+    /**
+     * Number of calls of beginFrame() by the calling thread.
+     */
+    static std::uint64_t getFrameNumber();
+
+    /**
+     * Initial capacity of the arenas that are created afterwards (default
+     * 64 KiB).
+     */
+    static void setArenaCapacity(std::size_t bytes);
+};
+
+} // namespace OpenSimRT
@@ -0,0 +1,106 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file LoadGovernor.h
+ *
+ * \brief Selects a degradation level of a real-time computation, so that its
+ * latency does not exceed the period of the input data.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#pragma once
+
+#include "internal/CommonExports.h"
+#include <cstddef>
+
+namespace OpenSimRT {
+
+/**
+ * \brief A feedback controller for load shedding. The latency of each frame is
+ * compared to the period of the input data; when the computation cannot keep
+ * up, the degradation level is increased (e.g., a cheaper approximation is
+ * used), and when there is enough headroom it is decreased again. Level 0
+ * denotes full quality and maximumLevel the cheapest computation.
+ *
+ * The latency is smoothed by an exponential moving average. The level is
+ * increased as soon as the average exceeds degradeThreshold * period and
+ * decreased after recoveryFrames consecutive frames below recoverThreshold *
+ * period. The gap between the thresholds (hysteresis) and the hold-off after
+ * each transition, during which the average is re-initialized with the
+ * latency of the new level, prevent oscillations.
+ *
+ * ****************************************************************************
+ * Example code:
+ * ****************************************************************************
+ *
+ * LoadGovernor governor({3, 0.9, 0.6, 0.2, 50, 5});
+ * while (...) {
+ *     auto start = ...;
+ *     compute(frame, governor.getLevel()); // cheaper for higher levels
+ *     governor.update(elapsed(start), period);
+ * }
+ */
+class Common_API LoadGovernor {
+ public:
+    struct Parameters {
+        int maximumLevel;        // cheapest degradation level
+        double degradeThreshold; // fraction of the period (0.9)
+        double recoverThreshold; // fraction of the period (0.6)
+        double smoothingFactor;  // weight of the latest latency (0.2)
+        int recoveryFrames;      // frames with headroom before recovery (50)
+        int holdFrames;          // frames without transition after one (5)
+    };
+
+    LoadGovernor(const Parameters& parameters);
+
+    /**
+     * Update with the latency of the latest frame and the period of the input
+     * data (in the same units). Returns the level for the next frame.
+     */
+    int update(double latency, double period);
+
+    /**
+     * Level that must be applied to the next frame.
+     */
+    int getLevel() const { return level; }
+
+    /**
+     * Smoothed latency.
+     */
+    double getAverageLatency() const { return averageLatency; }
+
+    /**
+     * Number of level changes (degradations and recoveries).
+     */
+    std::size_t getNumTransitions() const { return numTransitions; }
+
+    void reset();
+
+ private:
+    void setLevel(int newLevel);
+
+    Parameters parameters;
+    int level;
+    double averageLatency;
+    int framesWithHeadroom;
+    int framesSinceTransition;
+    std::size_t numTransitions;
+};
+
+} // namespace OpenSimRT
@@ -0,0 +1,132 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file MultilayerPerceptron.h
+ *
+ * \brief A small fully connected neural network for real-time inference.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#pragma once
+
+#include "internal/CommonExports.h"
+#include <SimTKcommon.h>
+#include <string>
+#include <vector>
+
+namespace OpenSimRT {
+
+/**
+ * \brief A fully connected feed-forward neural network (multilayer
+ * perceptron) implemented in pure C++ without any external runtime.
+ *
+ * Inputs are normalized (zero mean, unit standard deviation) and outputs are
+ * de-normalized using the statistics of the training data, which are stored
+ * along with the weights. The weights of each layer are stored in row-major
+ * order, so that the forward pass is a sequence of matrix-vector products
+ * (GEMV) that are vectorized with AVX/FMA when available. The forward pass
+ * uses pre-allocated buffers and does not allocate memory, thus `evaluate()`
+ * is not thread-safe for the same instance.
+ *
+ * The network can be trained offline with `fit()` (mini-batch Adam on the
+ * mean squared error) and stored/loaded as a plain text file:
+ *
+ *    OpenSimRT_MLP 1
+ *    input_mean <n values>
+ *    input_std <n values>
+ *    output_mean <m values>
+ *    output_std <m values>
+ *    layers <L>
+ *    layer <input size> <output size> <activation>
+ *    <output size x input size weights (row-major)>
+ *    <output size biases>
+ *    ...
+ */
+class Common_API MultilayerPerceptron {
+ public:
+    enum class Activation { Linear, ReLU, Tanh };
+
+    struct Layer {
+        int inputSize;
+        int outputSize;
+        Activation activation;
+        std::vector<double> W; // row-major (outputSize x inputSize)
+        std::vector<double> b; // outputSize
+    };
+
+    struct TrainingParameters {
+        int epochs;          // number of passes over the data set
+        int batchSize;       // samples per update
+        double learningRate; // Adam step size
+        unsigned int seed;   // shuffling seed
+    };
+
+ public:
+    MultilayerPerceptron() = default;
+    /**
+     * Create a network with the given layer sizes (input, hidden...,
+     * output). Weights are initialized randomly (He/Xavier).
+     */
+    MultilayerPerceptron(const std::vector<int>& layerSizes,
+                         Activation hiddenActivation,
+                         Activation outputActivation, unsigned int seed = 0);
+    /**
+     * Load a network from file.
+     */
+    explicit MultilayerPerceptron(const std::string& fileName);
+
+    /**
+     * Store the network to file.
+     */
+    void save(const std::string& fileName) const;
+
+    int getInputSize() const;
+    int getOutputSize() const;
+    const std::vector<Layer>& getLayers() const;
+
+    /**
+     * Forward pass. The output vector is resized if needed.
+     */
+    void evaluate(const SimTK::Vector& x, SimTK::Vector& y);
+    SimTK::Vector evaluate(const SimTK::Vector& x);
+
+    /**
+     * Train the network on the rows of X (inputs) and Y (targets). The
+     * normalization statistics are computed from the data. Returns the mean
+     * squared error (normalized space) of the last epoch.
+     */
+    double fit(const SimTK::Matrix& X, const SimTK::Matrix& Y,
+               const TrainingParameters& parameters);
+
+    /**
+     * y = W x + b, where W is stored in row-major order.
+     */
+    static void gemv(const double* W, const double* x, const double* b,
+                     double* y, int rows, int cols);
+
+ private:
+    // allocate the forward pass buffers
+    void allocateBuffers();
+
+    std::vector<Layer> layers;
+    std::vector<double> inputMean, inputStd, outputMean, outputStd;
+    std::vector<std::vector<double>> activations; // forward pass buffers
+};
+
+} // namespace OpenSimRT
@@ -62,6 +62,15 @@ struct Common_API OpenSimUtils {
     static MomentArmFunctionT
     getMomentArmFromDynamicLibrary(const OpenSim::Model& model,
                                    std::string libraryPath);
+    // Read the tables of a binary log (see BinaryLogger) in the order they
+    // were added to the logger.
+    static std::vector<std::pair<std::string, OpenSim::TimeSeriesTable>>
+    readBinaryLog(const std::string& logFilePath);
+    // Convert a binary log to one file per table (outputPrefix + table name +
+    // extension), where the extension is .sto or .csv.
+    static void convertBinaryLog(const std::string& logFilePath,
+                                 const std::string& outputPrefix,
+                                 const std::string& extension = ".sto");
 
     /**
      * Update the state of the osim model by assigning the `q` and `qDot`
@@ -0,0 +1,172 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file Profiler.h
+ *
+ * \brief Scoped profiling zones and counters that are recorded in per-thread
+ * buffers and exported in the Chrome Trace Event format.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#pragma once
+
+#include "internal/CommonExports.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#endif
+
+namespace OpenSimRT {
+
+/**
+ * \brief A process-wide profiler for the hot paths of the real-time analysis.
+ * Zones (e.g., the solve() of each module) are recorded with their start time
+ * and duration, and counters (e.g., the depth of a queue) with their value.
+ *
+ * Each thread records to its own buffer with a fixed capacity, thus recording
+ * is lock-free and does not allocate. The buffer of a thread is allocated
+ * when the thread records its first event; events that do not fit are
+ * discarded (see getNumDropped()). The names must be string literals (or
+ * outlive the profiler), since only the pointer is stored. Timestamps are
+ * read from the time-stamp counter on x86 (steady_clock elsewhere) and
+ * converted to microseconds on export.
+ *
+ * The trace is written in the Chrome Trace Event JSON format, which can be
+ * opened with chrome://tracing or https://ui.perfetto.dev. clear() and the
+ * export should be called while the instrumented threads do not record
+ * (e.g., after the analysis is terminated, or after setEnabled(false)).
+ *
+ * The instrumentation macros are compiled only if OPENSIMRT_PROFILER is
+ * defined (CMake option USE_PROFILER), thus they have no cost otherwise.
+ * Recording can be also switched at runtime with setEnabled().
+ *
+ * ****************************************************************************
+ * Example code:
+ * ****************************************************************************
+ *
+ * Output InverseKinematics::solve(const Input& input) {
+ *     PROFILE_ZONE("ik"); // until the end of the scope
+ *     ...
+ *     PROFILE_COUNTER("ik_iterations", iterations);
+ * }
+ *
+ * PROFILE_THREAD("acquisition"); // once per thread
+ * ...
+ * Profiler::exportChromeTrace("trace.json");
+ */
+class Common_API Profiler {
+ public:
+    typedef std::uint64_t Ticks;
+
+    /**
+     * Current timestamp in ticks.
+     */
+    static Ticks now() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) ||            \
+        defined(_M_IX86)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+#endif
+    }
+
+    /**
+     * Enable or disable the recording of events at runtime (enabled by
+     * default).
+     */
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+
+    /**
+     * Maximum number of events of each thread that records its first event
+     * afterwards (default 65536).
+     */
+    static void setCapacity(std::size_t numEvents);
+
+    /**
+     * Name of the calling thread in the trace.
+     */
+    static void setThreadName(const std::string& name);
+
+    static void recordZone(const char* name, Ticks start, Ticks end);
+    static void recordCounter(const char* name, double value);
+
+    /**
+     * Number of events that were recorded and discarded (all threads).
+     */
+    static std::size_t getNumEvents();
+    static std::size_t getNumDropped();
+
+    /**
+     * Remove the events of all threads.
+     */
+    static void clear();
+
+    /**
+     * Export the events of all threads in the Chrome Trace Event format.
+     */
+    static void exportChromeTrace(const std::string& fileName);
+};
+
+/**
+ * \brief Records a zone from construction to destruction.
+ */
+class ScopedZone {
+ public:
+    explicit ScopedZone(const char* name)
+            : name(name), start(Profiler::now()) {}
+    ~ScopedZone() { Profiler::recordZone(name, start, Profiler::now()); }
+    ScopedZone(const ScopedZone&) = delete;
+    ScopedZone& operator=(const ScopedZone&) = delete;
+
+ private:
+    const char* name;
+    Profiler::Ticks start;
+};
+
+} // namespace OpenSimRT
+
+#define PROFILER_CONCATENATE_(a, b) a##b
+#define PROFILER_CONCATENATE(a, b) PROFILER_CONCATENATE_(a, b)
+
+#ifdef OPENSIMRT_PROFILER
+// record the enclosing scope (can be used more than once per scope)
+#define PROFILE_ZONE(name)                                                     \
+    OpenSimRT::ScopedZone PROFILER_CONCATENATE(profilerZone, __LINE__)(name)
+// record the enclosing function
+#define PROFILE_FUNCTION() PROFILE_ZONE(__func__)
+// record the value of a counter
+#define PROFILE_COUNTER(name, value)                                           \
+    OpenSimRT::Profiler::recordCounter(name, static_cast<double>(value))
+// name the calling thread in the trace
+#define PROFILE_THREAD(name) OpenSimRT::Profiler::setThreadName(name)
+#else
+#define PROFILE_ZONE(name) static_cast<void>(0)
+#define PROFILE_FUNCTION() static_cast<void>(0)
+#define PROFILE_COUNTER(name, value) static_cast<void>(0)
+#define PROFILE_THREAD(name) static_cast<void>(0)
+#endif
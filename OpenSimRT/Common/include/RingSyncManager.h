@@ -0,0 +1,674 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file RingSyncManager.h
+ *
+ * \brief Synchronization of measurements from multiple sensors, based on
+ * per-stream ring buffers instead of a data table.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#pragma once
+
+#include "Checkpoint.h"
+#include "Exception.h"
+#include "Profiler.h"
+#include "TypeHelpers.h"
+#include <SimTKcommon.h>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace OpenSimRT {
+
+/**
+ * \brief Describes how the samples of a stream are resampled. Quaternion
+ * streams (w, x, y, z as SimTK::Quaternion::asVec4()) are interpolated on the
+ * unit sphere (SLERP or normalized lerp), thus the output is a unit
+ * quaternion. Vector streams are interpolated linearly or with a cubic
+ * Hermite spline, whose tangents are the finite differences of the
+ * neighboring samples (Catmull-Rom).
+ */
+struct StreamDescriptor {
+    enum class Type { VECTOR, QUATERNION };
+    enum class Interpolation { LINEAR, CUBIC_HERMITE, SLERP, NLERP };
+
+    Type type = Type::VECTOR;
+    Interpolation interpolation = Interpolation::LINEAR;
+
+    static StreamDescriptor
+    vector(Interpolation interpolation = Interpolation::LINEAR) {
+        return {Type::VECTOR, interpolation};
+    }
+    static StreamDescriptor
+    quaternion(Interpolation interpolation = Interpolation::SLERP) {
+        return {Type::QUATERNION, interpolation};
+    }
+};
+
+/**
+ * \brief A SyncManager with the same appendPack()/getPack() interface, whose
+ * cost per pack does not depend on the length of the history.
+ *
+ * Each std::pair of the first appended pack defines a stream (e.g., the
+ * quaternion of an IMU) that keeps its samples in a fixed-capacity ring
+ * buffer, sorted by time. A new sample is appended at the back (a late sample
+ * is moved to its position) or replaces a sample whose timestamp is closer
+ * than the threshold. The output at time t is the linear interpolation of
+ * each stream between the two samples that enclose t (binary search), thus
+ * the streams do not need to share timestamps. The interpolation of each
+ * stream is defined by a StreamDescriptor (default: linear). After each
+ * output, the samples that are older than the next output time are evicted
+ * from the front, except the ones that are needed for the interpolation.
+ *
+ * Non-finite samples are ignored. If a stream exceeds its capacity the oldest
+ * sample is dropped, and if the output time is no longer enclosed, the output
+ * is synchronized again with the latest samples.
+ *
+ * ****************************************************************************
+ * Example code:
+ * ****************************************************************************
+ *
+ * RingSyncManager manager(samplingRate, threshold);
+ * manager.setStreamDescriptors(driver.getStreamDescriptors());
+ * while (true) {
+ *     manager.appendPack(driver.asPack(driver.getData()));
+ *     auto pack = manager.getPack();
+ *     if (pack.second.empty()) continue;
+ *     ...
+ * }
+ */
+template <typename ETX = double> class RingSyncManager {
+ public:
+    RingSyncManager() = default;
+
+    /**
+     * @param samplingRate - Desired sampling rate of the manager output.
+     *
+     * @param threshold - timestamps of a stream that are closer than the
+     * threshold are considered the same.
+     *
+     * @param capacity - maximum number of samples per stream.
+     */
+    RingSyncManager(const ETX& samplingRate, const ETX& threshold,
+                    std::size_t capacity = 256);
+
+    /**
+     * Retrieve output from the manager. Returns an empty pack until all the
+     * streams enclose the output time and the latest sample is at least delay
+     * samples (of the output rate) ahead.
+     *
+     * @param delay - Delay in number of samples of the output entry. Default=1.
+     */
+    std::pair<ETX, std::vector<SimTK::Vector_<ETX>>> getPack(size_t delay = 1);
+
+    /**
+     * Append new samples. Accepts the same combinations as
+     * SyncManager::appendPack(), and every pack must have the same layout as
+     * the first one.
+     */
+    template <typename... Args> void appendPack(Args&&... args);
+
+    /**
+     * Set the interpolation of each stream (std::pair of a pack in order).
+     * Must be called before the first pack.
+     */
+    void setStreamDescriptors(const std::vector<StreamDescriptor>& descriptors);
+
+    // Number of samples that are held in the buffers
+    std::size_t getNumSamples() const;
+
+    // Number of samples that were dropped due to the capacity
+    std::size_t getNumDropped() const { return _numDropped; }
+
+    // Save or restore the pending samples and the output time (restart)
+    void saveState(CheckpointWriter& writer) const;
+    void loadState(CheckpointReader& reader);
+
+ private:
+    // ring buffer of a stream
+    struct Stream {
+        std::size_t pack = 0;  // argument of appendPack()
+        std::size_t width = 0; // number of values per sample
+        std::size_t head = 0;  // position of the oldest sample
+        std::size_t size = 0;  // number of samples
+        StreamDescriptor descriptor;
+        std::vector<ETX> times;
+        std::vector<ETX> values; // capacity x width
+
+        std::size_t position(std::size_t k) const {
+            return (head + k) % times.size();
+        }
+        const ETX& time(std::size_t k) const { return times[position(k)]; }
+        ETX* value(std::size_t k) { return &values[position(k) * width]; }
+        bool isFull() const { return size == times.size(); }
+
+        // samples before the output time that are needed for interpolation
+        std::size_t getNumPrevious() const {
+            typedef StreamDescriptor::Interpolation Interpolation;
+            return descriptor.interpolation == Interpolation::CUBIC_HERMITE
+                           ? 2
+                           : 1;
+        }
+        void popFront() {
+            head = position(1);
+            --size;
+        }
+
+        // index of the first sample with time >= t
+        std::size_t lowerBound(const ETX& t) const;
+    };
+
+    // apply f(pair, argumentIndex) for every std::pair in the arguments
+    template <typename F, typename... Args>
+    static void forEachPair(F&& f, const Args&... args);
+    template <typename F, typename A>
+    static void forEachPairOf(F& f, const A& arg, std::size_t pack);
+
+    // number of values and copy of std::pair::second
+    template <typename T> static std::size_t getWidth(const T& x);
+    template <typename T> static void copyValues(const T& x, ETX* out);
+
+    // create the streams from the layout of the first pack
+    template <typename... Args> void createStreams(const Args&... args);
+
+    // insert the sample that is stored in _sample
+    void insert(Stream& stream, const ETX& t);
+
+    // interpolation at t, returns false if t is not enclosed
+    bool interpolate(Stream& stream, const ETX& t, ETX* out);
+
+    // interpolation between samples k - 1 and k (0 < a < 1)
+    static void hermite(Stream& stream, std::size_t k, const ETX& a,
+                        ETX* out);
+    static void slerp(const ETX* q0, const ETX* q1, const ETX& a, bool isNlerp,
+                      ETX* out);
+    static void normalize(ETX* q);
+
+    // number of streams and validation of the descriptors
+    void checkDescriptors(std::size_t numStreams) const;
+
+    ETX _entryThreshold = 0;
+    ETX _samplingRate = 0;
+    std::size_t _capacity = 0;
+    std::size_t _numOfPacks = 0;
+    std::size_t _numDropped = 0;
+    double _currentTime = -SimTK::Infinity;
+    bool _isCurrentTimeSet = false;
+    std::vector<Stream> _streams;
+    std::vector<StreamDescriptor> _descriptors;
+    std::vector<std::size_t> _vectorSizePerPack;
+    std::vector<ETX> _sample; // scratch of appendPack()
+    std::vector<ETX> _row;    // scratch of getPack()
+};
+
+template <typename ETX>
+RingSyncManager<ETX>::RingSyncManager(const ETX& samplingRate,
+                                      const ETX& threshold,
+                                      std::size_t capacity)
+        : _entryThreshold(threshold), _samplingRate(samplingRate),
+          _capacity(capacity) {
+    if (capacity < 2) THROW_EXCEPTION("capacity must be at least two samples");
+}
+
+template <typename ETX>
+std::size_t RingSyncManager<ETX>::Stream::lowerBound(const ETX& t) const {
+    // samples usually arrive in order
+    if (size == 0 || time(size - 1) < t) return size;
+    std::size_t first = 0, count = size;
+    while (count > 0) {
+        std::size_t step = count / 2;
+        if (time(first + step) < t) {
+            first += step + 1;
+            count -= step + 1;
+        } else {
+            count = step;
+        }
+    }
+    return first;
+}
+
+template <typename ETX>
+std::pair<ETX, std::vector<SimTK::Vector_<ETX>>>
+RingSyncManager<ETX>::getPack(size_t delay) {
+    PROFILE_ZONE("RingSyncManager::getPack");
+    std::vector<SimTK::Vector_<ETX>> pack;
+    if (_streams.empty()) return std::make_pair(_currentTime, pack);
+
+    // start from the most recent time that is enclosed by all the streams
+    if (!_isCurrentTimeSet) {
+        ETX newest = SimTK::Infinity, oldest = -SimTK::Infinity;
+        for (const auto& stream : _streams) {
+            if (stream.size == 0) return std::make_pair(_currentTime, pack);
+            newest = std::min(newest, stream.time(stream.size - 1));
+            oldest = std::max(oldest, stream.time(0));
+        }
+        if (newest < oldest) return std::make_pair(_currentTime, pack);
+        _currentTime = newest;
+        _isCurrentTimeSet = true;
+    }
+
+    const ETX t = _currentTime;
+    ETX latest = -SimTK::Infinity;
+    for (const auto& stream : _streams) {
+        latest = std::max(latest, stream.time(stream.size - 1));
+    }
+    if (t + delay * (1 / _samplingRate) > latest) {
+        return std::make_pair(t, pack);
+    }
+
+    // re-sample each stream @ time 't'
+    std::size_t columnId = 0;
+    for (auto& stream : _streams) {
+        if (!interpolate(stream, t, &_row[columnId])) {
+            // samples that enclose t were dropped
+            if (stream.time(0) > t) _isCurrentTimeSet = false;
+            return std::make_pair(t, pack);
+        }
+        columnId += stream.width;
+    }
+
+    // create output
+    columnId = 0;
+    for (size_t i = 0; i < _numOfPacks; ++i) {
+        pack.push_back(SimTK::Vector_<ETX>(
+                static_cast<int>(_vectorSizePerPack[i]), &_row[columnId]));
+        columnId += _vectorSizePerPack[i];
+    }
+
+    // prepare next sample and evict the samples that are no longer needed
+    _currentTime += 1 / _samplingRate;
+    for (auto& stream : _streams) {
+        const auto numPrevious = stream.getNumPrevious();
+        while (stream.size > numPrevious &&
+               stream.time(numPrevious) <= _currentTime) {
+            stream.popFront();
+        }
+    }
+    return std::make_pair(t, std::move(pack));
+}
+
+template <typename ETX>
+template <typename... Args>
+void RingSyncManager<ETX>::appendPack(Args&&... args) {
+    PROFILE_ZONE("RingSyncManager::appendPack");
+    if (_streams.empty()) createStreams(args...);
+
+    std::size_t i = 0;
+    forEachPair(
+            [&](const auto& p, std::size_t) {
+                if (i == _streams.size() ||
+                    getWidth(p.second) != _streams[i].width) {
+                    THROW_EXCEPTION("pack does not match the streams");
+                }
+                copyValues(p.second, _sample.data());
+                insert(_streams[i++], p.first);
+            },
+            args...);
+    if (i != _streams.size()) {
+        THROW_EXCEPTION("pack does not match the streams");
+    }
+}
+
+template <typename ETX>
+void RingSyncManager<ETX>::setStreamDescriptors(
+        const std::vector<StreamDescriptor>& descriptors) {
+    if (!_streams.empty()) {
+        THROW_EXCEPTION("descriptors must be set before the first pack");
+    }
+    for (const auto& descriptor : descriptors) {
+        bool isQuaternion =
+                descriptor.interpolation ==
+                        StreamDescriptor::Interpolation::SLERP ||
+                descriptor.interpolation ==
+                        StreamDescriptor::Interpolation::NLERP;
+        if (isQuaternion !=
+            (descriptor.type == StreamDescriptor::Type::QUATERNION)) {
+            THROW_EXCEPTION("interpolation does not match the stream type");
+        }
+    }
+    _descriptors = descriptors;
+}
+
+template <typename ETX>
+std::size_t RingSyncManager<ETX>::getNumSamples() const {
+    std::size_t n = 0;
+    for (const auto& stream : _streams) n += stream.size;
+    return n;
+}
+
+template <typename ETX>
+template <typename F, typename... Args>
+void RingSyncManager<ETX>::forEachPair(F&& f, const Args&... args) {
+    std::size_t pack = 0;
+    (forEachPairOf(f, args, pack++), ...);
+}
+
+template <typename ETX>
+template <typename F, typename A>
+void RingSyncManager<ETX>::forEachPairOf(F& f, const A& arg,
+                                         std::size_t pack) {
+    if constexpr (is_pair<A>::value) {
+        f(arg, pack);
+    } else {
+        static_assert(is_container<A>::value,
+                      "Argument must be either std::pair or an STL-like "
+                      "container of std::pairs");
+        for (const auto& p : arg) {
+            static_assert(is_pair<std::remove_cv_t<
+                                  std::remove_reference_t<decltype(p)>>>::value,
+                          "Only std::pair is allowed");
+            f(p, pack);
+        }
+    }
+}
+
+template <typename ETX>
+template <typename T>
+std::size_t RingSyncManager<ETX>::getWidth(const T& x) {
+    if constexpr (is_simtk_vec<T>::value || is_simtk_vector<T>::value) {
+        return x.size();
+    } else {
+        static_assert(is_container<T>::value, "Invalid std::pair::second type");
+        std::size_t width = 0;
+        for (const auto& v : x) width += v.size();
+        return width;
+    }
+}
+
+template <typename ETX>
+template <typename T>
+void RingSyncManager<ETX>::copyValues(const T& x, ETX* out) {
+    if constexpr (is_simtk_vec<T>::value || is_simtk_vector<T>::value) {
+        for (int i = 0; i < x.size(); ++i) out[i] = x[i];
+    } else {
+        for (const auto& v : x) {
+            for (int i = 0; i < v.size(); ++i) *out++ = v[i];
+        }
+    }
+}
+
+template <typename ETX>
+template <typename... Args>
+void RingSyncManager<ETX>::createStreams(const Args&... args) {
+    if (_capacity == 0) THROW_EXCEPTION("manager is not initialized");
+    _numOfPacks = sizeof...(Args);
+    _vectorSizePerPack.assign(_numOfPacks, 0);
+    std::size_t numColumns = 0, maxWidth = 0;
+    forEachPair(
+            [&](const auto& p, std::size_t pack) {
+                Stream stream;
+                stream.pack = pack;
+                stream.width = getWidth(p.second);
+                if (_streams.size() < _descriptors.size()) {
+                    stream.descriptor = _descriptors[_streams.size()];
+                }
+                stream.times.resize(_capacity);
+                stream.values.resize(_capacity * stream.width);
+                _vectorSizePerPack[pack] += stream.width;
+                numColumns += stream.width;
+                maxWidth = std::max(maxWidth, stream.width);
+                _streams.push_back(std::move(stream));
+            },
+            args...);
+    checkDescriptors(_streams.size());
+    _sample.resize(maxWidth);
+    _row.resize(numColumns);
+}
+
+template <typename ETX>
+void RingSyncManager<ETX>::checkDescriptors(std::size_t numStreams) const {
+    if (!_descriptors.empty() && _descriptors.size() != numStreams) {
+        THROW_EXCEPTION("number of descriptors does not match the streams");
+    }
+    for (const auto& stream : _streams) {
+        if (stream.descriptor.type == StreamDescriptor::Type::QUATERNION &&
+            stream.width != 4) {
+            THROW_EXCEPTION("quaternion stream must have four values");
+        }
+    }
+}
+
+template <typename ETX>
+void RingSyncManager<ETX>::insert(Stream& stream, const ETX& t) {
+    if (!SimTK::isFinite(t)) return;
+    for (std::size_t i = 0; i < stream.width; ++i) {
+        if (!SimTK::isFinite(_sample[i])) return;
+    }
+
+    // replace a sample with the same timestamp (the closest one)
+    std::size_t k = stream.lowerBound(t);
+    const ETX ud = k < stream.size ? stream.time(k) - t : SimTK::Infinity;
+    const ETX ld = k > 0 ? t - stream.time(k - 1) : SimTK::Infinity;
+    if (ud < _entryThreshold || ld < _entryThreshold) {
+        std::size_t j = ld <= ud ? k - 1 : k;
+        std::copy_n(_sample.begin(), stream.width, stream.value(j));
+        return;
+    }
+
+    if (stream.isFull()) {
+        ++_numDropped;
+        if (k == 0) return; // older than the whole history
+        stream.popFront();
+        --k;
+    }
+
+    // shift the samples that are newer (late arrival)
+    for (std::size_t j = stream.size; j > k; --j) {
+        stream.times[stream.position(j)] = stream.time(j - 1);
+        std::copy_n(stream.value(j - 1), stream.width, stream.value(j));
+    }
+    stream.times[stream.position(k)] = t;
+    std::copy_n(_sample.begin(), stream.width, stream.value(k));
+    ++stream.size;
+}
+
+template <typename ETX>
+bool RingSyncManager<ETX>::interpolate(Stream& stream, const ETX& t,
+                                       ETX* out) {
+    typedef StreamDescriptor::Interpolation Interpolation;
+    const std::size_t k = stream.lowerBound(t);
+    if (k == stream.size) return false;
+    if (stream.time(k) == t) {
+        std::copy_n(stream.value(k), stream.width, out);
+        if (stream.descriptor.type == StreamDescriptor::Type::QUATERNION) {
+            normalize(out);
+        }
+        return true;
+    }
+    if (k == 0) return false;
+    const ETX t0 = stream.time(k - 1);
+    const ETX a = (t - t0) / (stream.time(k) - t0);
+    const ETX* x0 = stream.value(k - 1);
+    const ETX* x1 = stream.value(k);
+    switch (stream.descriptor.interpolation) {
+    case Interpolation::CUBIC_HERMITE:
+        hermite(stream, k, a, out);
+        break;
+    case Interpolation::SLERP:
+    case Interpolation::NLERP:
+        slerp(x0, x1, a,
+              stream.descriptor.interpolation == Interpolation::NLERP, out);
+        break;
+    default:
+        for (std::size_t i = 0; i < stream.width; ++i) {
+            out[i] = x0[i] + a * (x1[i] - x0[i]);
+        }
+    }
+    return true;
+}
+
+template <typename ETX>
+void RingSyncManager<ETX>::hermite(Stream& stream, std::size_t k, const ETX& a,
+                                   ETX* out) {
+    // Hermite basis, the tangents are scaled by the interval h
+    const ETX a2 = a * a, a3 = a2 * a;
+    const ETX h00 = 2 * a3 - 3 * a2 + 1, h10 = a3 - 2 * a2 + a;
+    const ETX h01 = -2 * a3 + 3 * a2, h11 = a3 - a2;
+    const ETX t0 = stream.time(k - 1), t1 = stream.time(k), h = t1 - t0;
+
+    // central differences, or one-sided at the ends of the history
+    const bool hasPrevious = k >= 2, hasNext = k + 1 < stream.size;
+    const ETX* x0 = stream.value(k - 1);
+    const ETX* x1 = stream.value(k);
+    const ETX* xp = hasPrevious ? stream.value(k - 2) : x0;
+    const ETX* xn = hasNext ? stream.value(k + 1) : x1;
+    const ETX s0 = h / ((hasPrevious ? stream.time(k - 2) : t0) - t1);
+    const ETX s1 = h / ((hasNext ? stream.time(k + 1) : t1) - t0);
+    for (std::size_t i = 0; i < stream.width; ++i) {
+        const ETX m0 = s0 * (xp[i] - x1[i]), m1 = s1 * (xn[i] - x0[i]);
+        out[i] = h00 * x0[i] + h10 * m0 + h01 * x1[i] + h11 * m1;
+    }
+}
+
+template <typename ETX>
+void RingSyncManager<ETX>::slerp(const ETX* q0, const ETX* q1, const ETX& a,
+                                 bool isNlerp, ETX* out) {
+    ETX dot = 0, n0 = 0, n1 = 0;
+    for (int i = 0; i < 4; ++i) {
+        dot += q0[i] * q1[i];
+        n0 += q0[i] * q0[i];
+        n1 += q1[i] * q1[i];
+    }
+
+    // unit quaternions, q and -q are the same orientation (shortest arc)
+    ETX w0 = 1 / std::sqrt(n0), w1 = (dot < 0 ? -1 : 1) / std::sqrt(n1);
+    ETX sum = 0, difference = 0;
+    for (int i = 0; i < 4; ++i) {
+        sum += (w0 * q0[i] + w1 * q1[i]) * (w0 * q0[i] + w1 * q1[i]);
+        difference += (w0 * q0[i] - w1 * q1[i]) * (w0 * q0[i] - w1 * q1[i]);
+    }
+
+    // angle between the quaternions (accurate also for small angles)
+    const ETX theta = 2 * std::atan2(std::sqrt(difference), std::sqrt(sum));
+    if (!isNlerp && theta > ETX(1e-6)) {
+        const ETX sinTheta = std::sin(theta);
+        w0 *= std::sin((1 - a) * theta) / sinTheta;
+        w1 *= std::sin(a * theta) / sinTheta;
+    } else { // lerp is accurate for small angles
+        w0 *= 1 - a;
+        w1 *= a;
+    }
+    for (int i = 0; i < 4; ++i) out[i] = w0 * q0[i] + w1 * q1[i];
+    normalize(out);
+}
+
+template <typename ETX> void RingSyncManager<ETX>::normalize(ETX* q) {
+    const ETX norm = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] +
+                               q[3] * q[3]);
+    for (int i = 0; i < 4; ++i) q[i] /= norm;
+}
+
+template <typename ETX>
+void RingSyncManager<ETX>::saveState(CheckpointWriter& writer) const {
+    writer.write(static_cast<double>(_entryThreshold));
+    writer.write(static_cast<double>(_samplingRate));
+    writer.write(static_cast<int>(_capacity));
+    writer.write(static_cast<int>(_numOfPacks));
+    writer.write(static_cast<int>(_numDropped));
+    writer.write(_currentTime);
+    writer.write(_isCurrentTimeSet);
+    writer.write(static_cast<int>(_streams.size()));
+    for (const auto& stream : _streams) {
+        writer.write(static_cast<int>(stream.pack));
+        writer.write(static_cast<int>(stream.width));
+        writer.write(static_cast<int>(stream.descriptor.type));
+        writer.write(static_cast<int>(stream.descriptor.interpolation));
+        SimTK::Vector t(static_cast<int>(stream.size));
+        SimTK::Matrix x(static_cast<int>(stream.size),
+                        static_cast<int>(stream.width));
+        for (std::size_t k = 0; k < stream.size; ++k) {
+            t[k] = stream.time(k);
+            const auto position = stream.position(k) * stream.width;
+            for (std::size_t i = 0; i < stream.width; ++i) {
+                x[k][i] = stream.values[position + i];
+            }
+        }
+        writer.write(t);
+        writer.write(x);
+    }
+}
+
+template <typename ETX>
+void RingSyncManager<ETX>::loadState(CheckpointReader& reader) {
+    double entryThreshold, samplingRate;
+    int capacity, numOfPacks, numDropped, numStreams;
+    reader.read(entryThreshold);
+    reader.read(samplingRate);
+    reader.read(capacity);
+    reader.read(numOfPacks);
+    reader.read(numDropped);
+    reader.read(_currentTime);
+    reader.read(_isCurrentTimeSet);
+    reader.read(numStreams);
+    if (capacity < 2 || numOfPacks < 0 || numStreams < 0) {
+        THROW_EXCEPTION("corrupted checkpoint");
+    }
+    _entryThreshold = entryThreshold;
+    _samplingRate = samplingRate;
+    _capacity = capacity;
+    _numOfPacks = numOfPacks;
+    _numDropped = numDropped;
+    _streams.clear();
+    _descriptors.clear();
+    _vectorSizePerPack.assign(_numOfPacks, 0);
+    std::size_t numColumns = 0, maxWidth = 0;
+    for (int s = 0; s < numStreams; ++s) {
+        int pack, width, type, interpolation;
+        SimTK::Vector t;
+        SimTK::Matrix x;
+        reader.read(pack);
+        reader.read(width);
+        reader.read(type);
+        reader.read(interpolation);
+        reader.read(t);
+        reader.read(x);
+        if (pack < 0 || pack >= numOfPacks || width < 0 ||
+            t.size() > capacity || x.nrow() != t.size() || x.ncol() != width) {
+            THROW_EXCEPTION("corrupted checkpoint");
+        }
+        Stream stream;
+        stream.pack = pack;
+        stream.width = width;
+        stream.descriptor.type = static_cast<StreamDescriptor::Type>(type);
+        stream.descriptor.interpolation =
+                static_cast<StreamDescriptor::Interpolation>(interpolation);
+        stream.times.resize(_capacity);
+        stream.values.resize(_capacity * stream.width);
+        stream.size = t.size();
+        for (std::size_t k = 0; k < stream.size; ++k) {
+            stream.times[k] = t[k];
+            for (std::size_t i = 0; i < stream.width; ++i) {
+                stream.values[k * stream.width + i] = x[k][i];
+            }
+        }
+        _vectorSizePerPack[pack] += stream.width;
+        numColumns += stream.width;
+        maxWidth = std::max(maxWidth, stream.width);
+        _descriptors.push_back(stream.descriptor);
+        _streams.push_back(std::move(stream));
+    }
+    checkDescriptors(_streams.size());
+    _sample.resize(maxWidth);
+    _row.resize(numColumns);
+}
+
+} // namespace OpenSimRT
@@ -0,0 +1,286 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file SPSCCircularBuffer.h
+ *
+ * \brief Implementation of a lock-free single-producer/single-consumer
+ * circular buffer with zero-copy retrieval of the latest elements.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#pragma once
+
+#include "AtomicWait.h"
+#include "CircularBuffer.h"
+#include "Exception.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace OpenSimRT {
+
+/**
+ * \brief A lock-free variant of the CircularBuffer for one producer and one
+ * consumer thread, with the same DataRetrievalMode semantics. Elements are
+ * appended with `add()` or moved in with `emplace()`, and the latest M
+ * elements are accessed in place with `peek(M)`, which returns a View (new-to-
+ * old) instead of a copy. Each element has a sequence number (the number of
+ * elements that were added before it), so that the consumer can detect
+ * elements that it has missed.
+ *
+ * The ring has 2 * history slots. While a View is alive, its elements are
+ * pinned: the producer never overwrites them, and discards the new element
+ * instead if the ring wraps around to the pinned elements. Note that this
+ * differs from the CircularBuffer, which always overwrites the oldest element:
+ * here the newest elements are lost while a View is held for too long. The
+ * discarded elements are counted (see getNumDropped()) and add() returns
+ * false. Thus, a View should be released as soon as the elements are
+ * processed. The producer can add at least `history` elements while a View is
+ * alive before any element is discarded.
+ *
+ * The consumer spins briefly and then sleeps on an atomic word (futex),
+ * instead of a condition variable. The producer issues a wake-up system call
+ * only if the consumer sleeps.
+ *
+ *                         Producer Thread | Consumer Thread
+ *                                         |
+ *                            +------------+-------------+
+ *                            |            |             |
+ *        add / emplace ----->|          Buffer          |----> peek(M) / get(M)
+ *                            |            |             |
+ *   setDataRetrievalMode --->+------------+-------------+
+ *                            <--------2 * history------->
+ *                                           <-----M----->
+ *
+ * ****************************************************************************
+ * Example code:
+ * ****************************************************************************
+ *
+ * SPSCCircularBuffer<100, Frame> buffer;
+ *
+ * void producerFunction() { // producer thread
+ *     while (...) buffer.emplace(std::move(frame));
+ *     buffer.setDataRetrievalMode(DataRetrievalMode::CONTINUOUS);
+ * }
+ *
+ * void consumerFunction() { // consumer thread
+ *     auto view = buffer.peek(M); // view[0] is the latest element
+ *     ...
+ *     view.release(); // or when it goes out of scope
+ * }
+ */
+template <int history, typename T> class SPSCCircularBuffer {
+    static_assert(history > 0, "history must be positive");
+
+ public:
+    /**
+     * Read-only access to the latest M elements of the buffer, ordered from
+     * new to old. The elements remain valid until the View is released or
+     * destroyed. Only one View can be alive at a time.
+     */
+    class View {
+     public:
+        View(View&& other) noexcept
+                : buffer(other.buffer), first(other.first),
+                  count(other.count) {
+            other.buffer = nullptr;
+        }
+        View(const View&) = delete;
+        View& operator=(const View&) = delete;
+        View& operator=(View&&) = delete;
+        ~View() { release(); }
+
+        int size() const { return count; }
+
+        /**
+         * The i-th latest element (i = 0 is the latest).
+         */
+        const T& operator[](int i) const {
+            return buffer->slots[getSequence(i) % capacity];
+        }
+
+        /**
+         * Sequence number of the i-th latest element.
+         */
+        std::uint64_t getSequence(int i) const { return first + count - 1 - i; }
+
+        /**
+         * Unpin the elements, so that the producer can overwrite them.
+         */
+        void release() {
+            if (buffer) buffer->pinned.store(NONE, std::memory_order_release);
+            buffer = nullptr;
+        }
+
+     private:
+        friend class SPSCCircularBuffer;
+        View(SPSCCircularBuffer* buffer, std::uint64_t first, int count)
+                : buffer(buffer), first(first), count(count) {}
+
+        SPSCCircularBuffer* buffer;
+        std::uint64_t first;
+        int count;
+    };
+
+    SPSCCircularBuffer()
+            : slots(capacity), lastRead(0), writeSequence(0), numDropped(0),
+              pinned(NONE), continuousModeFlag(false), epoch(0),
+              numWaiters(0) {}
+
+    SPSCCircularBuffer(const SPSCCircularBuffer&) = delete;
+    SPSCCircularBuffer& operator=(const SPSCCircularBuffer&) = delete;
+
+    /**
+     * Determine if the buffer has at least M values.
+     */
+    bool isSize(int M) const {
+        return M <= history &&
+               writeSequence.load(std::memory_order_acquire) >=
+                       static_cast<std::uint64_t>(M);
+    }
+
+    /**
+     * Set the mode for data retrieval from the buffer (see CircularBuffer).
+     * Wakes the consumer, thus it can be called at any moment.
+     */
+    void setDataRetrievalMode(DataRetrievalMode mode) {
+        continuousModeFlag.store(mode == DataRetrievalMode::CONTINUOUS,
+                                 std::memory_order_release);
+        notify();
+    }
+
+    /**
+     * Append data to the buffer (producer thread). Returns false if the
+     * element was discarded because the slot is pinned by a View.
+     */
+    bool add(const T& value) { return emplace(value); }
+    bool add(T&& value) { return emplace(std::move(value)); }
+
+    /**
+     * Construct an element from args and move it into the next slot.
+     */
+    template <typename... Args> bool emplace(Args&&... args) {
+        const auto sequence = writeSequence.load(std::memory_order_relaxed);
+        // the slot holds the element sequence - capacity, which must not be
+        // overwritten if it is pinned
+        const auto first = pinned.load(std::memory_order_seq_cst);
+        if (first != NONE && sequence >= first + capacity) {
+            numDropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        slots[sequence % capacity] = T(std::forward<Args>(args)...);
+        writeSequence.store(sequence + 1, std::memory_order_seq_cst);
+        notify();
+        return true;
+    }
+
+    /**
+     * Access the latest M elements without copying (consumer thread). Waits
+     * until the buffer has at least M elements and, in ON_ENTRY mode, until
+     * new data have been added since the previous retrieval.
+     */
+    View peek(int M) {
+        if (M <= 0 || M > history) {
+            THROW_EXCEPTION("M should be between [1, history]");
+        }
+        waitUntil([&]() {
+            const auto sequence = writeSequence.load(std::memory_order_acquire);
+            return sequence >= static_cast<std::uint64_t>(M) &&
+                   (continuousModeFlag.load(std::memory_order_acquire) ||
+                    sequence > lastRead);
+        });
+        while (true) {
+            const auto sequence = writeSequence.load(std::memory_order_seq_cst);
+            const auto first = sequence - M;
+            pinned.store(first, std::memory_order_seq_cst);
+            // the producer may have checked the previous pin before it wrote
+            // the element that is now the latest; the pin is valid if that
+            // write did not reach the pinned elements
+            if (writeSequence.load(std::memory_order_seq_cst) - first <
+                capacity) {
+                lastRead = sequence;
+                return View(this, first, M);
+            }
+        }
+    }
+
+    /**
+     * Retrieve a copy of the latest M elements (see peek()), ordered from new
+     * to old (default) or from old to new.
+     */
+    std::vector<T> get(int M, bool reverseOrder = false) {
+        auto view = peek(M);
+        std::vector<T> result;
+        result.reserve(M);
+        for (int i = 0; i < M; ++i) result.push_back(view[i]);
+        view.release();
+        if (reverseOrder) { std::reverse(result.begin(), result.end()); }
+        return result;
+    }
+
+    /**
+     * Number of elements that were added and discarded, respectively.
+     */
+    std::uint64_t getNumAdded() const {
+        return writeSequence.load(std::memory_order_acquire);
+    }
+    std::uint64_t getNumDropped() const {
+        return numDropped.load(std::memory_order_relaxed);
+    }
+
+ private:
+    static constexpr std::uint64_t capacity = 2 * history;
+    static constexpr std::uint64_t NONE =
+            std::numeric_limits<std::uint64_t>::max();
+
+    // the consumer sleeps on epoch, which changes on every notification
+    template <typename Predicate> void waitUntil(Predicate isReady) {
+        int spins = 0;
+        while (true) {
+            const auto current = epoch.load(std::memory_order_seq_cst);
+            if (isReady()) return;
+            if (++spins < 64) continue;
+            numWaiters.fetch_add(1, std::memory_order_seq_cst);
+            atomicWait(epoch, current);
+            numWaiters.fetch_sub(1, std::memory_order_seq_cst);
+        }
+    }
+
+    void notify() {
+        epoch.fetch_add(1, std::memory_order_seq_cst);
+        if (numWaiters.load(std::memory_order_seq_cst) > 0) {
+            atomicWakeAll(epoch);
+        }
+    }
+
+    std::vector<T> slots;
+    std::uint64_t lastRead; // consumer only
+    // producer and consumer state are kept in different cache lines
+    alignas(64) std::atomic<std::uint64_t> writeSequence;
+    std::atomic<std::uint64_t> numDropped;
+    alignas(64) std::atomic<std::uint64_t> pinned;
+    std::atomic<bool> continuousModeFlag;
+    alignas(64) std::atomic<std::uint32_t> epoch;
+    std::atomic<std::uint32_t> numWaiters;
+};
+
+} // namespace OpenSimRT
@@ -0,0 +1,325 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file SPSCQueue.h
+ *
+ * \brief Implementation of a bounded lock-free single-producer/single-consumer
+ * queue with a configurable overflow policy.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#pragma once
+
+#include "Exception.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace OpenSimRT {
+
+/**
+ * Behavior of a bounded queue when the producer pushes while the queue is
+ * full.
+ *
+ * - BLOCK waits until the consumer makes room (no data are lost, the producer
+ * is slowed down to the rate of the consumer).
+ *
+ * - DROP_OLDEST discards the oldest element of the queue (the consumer always
+ * gets the latest data).
+ *
+ * - DROP_NEWEST discards the element that is pushed.
+ */
+enum class OverflowPolicy { BLOCK, DROP_OLDEST, DROP_NEWEST };
+
+/**
+ * Convert "block", "drop_oldest" or "drop_newest" to OverflowPolicy.
+ */
+inline OverflowPolicy overflowPolicyFromString(const std::string& policy) {
+    if (policy == "block") return OverflowPolicy::BLOCK;
+    if (policy == "drop_oldest") return OverflowPolicy::DROP_OLDEST;
+    if (policy == "drop_newest") return OverflowPolicy::DROP_NEWEST;
+    THROW_EXCEPTION("unknown overflow policy " + policy);
+}
+
+/**
+ * \brief A bounded lock-free queue that connects one producer thread with one
+ * consumer thread (e.g., two stages of a pipeline). The elements are stored
+ * in a ring of slots, each with a sequence number that tells whether the slot
+ * is ready to be written or read (Vyukov's bounded queue). The capacity is
+ * rounded up to a power of two. The ring has at least two slots, since the
+ * sequence numbers of a single slot cannot tell a full from an empty queue.
+ *
+ * When the queue is full, the OverflowPolicy determines whether the producer
+ * waits, or which element is discarded. In DROP_OLDEST the producer acts as a
+ * second consumer that discards the front element, thus the read position is
+ * claimed with a compare-and-swap. Every discarded element is counted (see
+ * getNumDropped()), thus the elements that were pushed and later discarded
+ * are told apart from the elements that reached the consumer (see
+ * getNumPopped()).
+ *
+ * Blocking operations spin and yield instead of sleeping on a condition
+ * variable, so that no lock is taken in the real-time path. close() unblocks
+ * both ends, e.g., when the pipeline is terminated.
+ *
+ *     Producer Thread                                   Consumer Thread
+ *                     +-----+-----+-----+-----+-----+
+ *     push(x) ------->|     |  a  |  b  |  c  |     |-------> pop(x)
+ *                     +-----+-----+-----+-----+-----+
+ *                           ^ read            ^ write
+ *
+ * ****************************************************************************
+ * Example code:
+ * ****************************************************************************
+ *
+ * SPSCQueue<Frame> queue(4, OverflowPolicy::DROP_OLDEST);
+ *
+ * void producerFunction() { // producer thread
+ *     while (...) queue.push(frame);
+ *     queue.close(); // unblock the consumer
+ * }
+ *
+ * void consumerFunction() { // consumer thread
+ *     Frame frame;
+ *     while (queue.pop(frame)) { ... } // false when closed and empty
+ * }
+ */
+template <typename T> class SPSCQueue {
+ public:
+    SPSCQueue(std::size_t capacity,
+              OverflowPolicy policy = OverflowPolicy::BLOCK)
+            : policy(policy), writePosition(0), readPosition(0), numPopped(0),
+              numPushed(0), numDropped(0), closed(false) {
+        if (capacity == 0) THROW_EXCEPTION("capacity must be positive");
+        this->capacity = 1;
+        while (this->capacity < capacity) this->capacity <<= 1;
+        size = std::max<std::size_t>(this->capacity, 2);
+        mask = size - 1;
+        slots.reset(new Slot[size]);
+        for (std::size_t i = 0; i < size; ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    SPSCQueue(const SPSCQueue&) = delete;
+    SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+    /**
+     * Append an element (producer thread). Returns false if the element was
+     * discarded (DROP_NEWEST) or the queue is closed.
+     */
+    bool push(T value) {
+        return pushWith([&value](T& slot) { slot = std::move(value); });
+    }
+
+    /**
+     * Same as push, but the element is copied into the storage of the slot.
+     * Elements that own buffers (e.g., vectors) are then transferred without
+     * allocations, once the slots hold elements of the same size. On the
+     * contrary, moving an element hands over its buffers, which must be
+     * allocated again when the moved-from element is refilled.
+     */
+    bool pushCopy(const T& value) {
+        return pushWith([&value](T& slot) { slot = value; });
+    }
+
+    /**
+     * Retrieve the front element (consumer thread). Waits until an element is
+     * available. Returns false if the queue is closed and empty.
+     */
+    bool pop(T& value) {
+        return popWith([&value](T& slot) { value = std::move(slot); });
+    }
+
+    /**
+     * Same as pop, but the element is copied into value (see pushCopy).
+     */
+    bool popCopy(T& value) {
+        return popWith([&value](const T& slot) { value = slot; });
+    }
+
+    /**
+     * Retrieve the front element if available, without waiting.
+     */
+    bool tryPop(T& value) {
+        return tryPopWith([&value](T& slot) { value = std::move(slot); });
+    }
+
+    /**
+     * Same as tryPop, but the element is copied into value (see pushCopy).
+     */
+    bool tryPopCopy(T& value) {
+        return tryPopWith([&value](const T& slot) { value = slot; });
+    }
+
+    /**
+     * Unblock the producer and the consumer. Elements that are already in the
+     * queue can still be retrieved.
+     */
+    void close() { closed.store(true, std::memory_order_release); }
+    bool isClosed() const { return closed.load(std::memory_order_acquire); }
+
+    /**
+     * Approximate number of elements in the queue.
+     */
+    std::size_t getSize() const {
+        auto w = writePosition.load(std::memory_order_acquire);
+        auto r = readPosition.load(std::memory_order_acquire);
+        return w > r ? w - r : 0;
+    }
+    std::size_t getCapacity() const { return capacity; }
+    OverflowPolicy getOverflowPolicy() const { return policy; }
+    /**
+     * Change the overflow policy, while the queue is not used by any thread.
+     */
+    void setOverflowPolicy(OverflowPolicy policy) { this->policy = policy; }
+
+    /**
+     * Number of elements that were accepted by the queue, including those
+     * that were discarded afterwards (DROP_OLDEST).
+     */
+    std::size_t getNumPushed() const {
+        return numPushed.load(std::memory_order_relaxed);
+    }
+    /**
+     * Number of elements that were retrieved by the consumer.
+     */
+    std::size_t getNumPopped() const {
+        return numPopped.load(std::memory_order_relaxed);
+    }
+    /**
+     * Number of elements that were discarded due to overflow, either when
+     * pushed (DROP_NEWEST) or from the front of the queue (DROP_OLDEST).
+     */
+    std::size_t getNumDropped() const {
+        return numDropped.load(std::memory_order_relaxed);
+    }
+
+ private:
+    struct Slot {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    template <typename Assign> bool pushWith(Assign&& assign) {
+        while (true) {
+            if (closed.load(std::memory_order_acquire)) return false;
+            if (tryPush(assign)) {
+                numPushed.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            switch (policy) {
+            case OverflowPolicy::BLOCK:
+                std::this_thread::yield();
+                break;
+            case OverflowPolicy::DROP_OLDEST:
+                // drop only if the front slot is not being read (the slot is
+                // released in place, its value is overwritten later)
+                if (getSize() >= capacity && tryTake([](T&) {})) {
+                    numDropped.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    // the consumer is reading the front slot
+                    std::this_thread::yield();
+                }
+                break;
+            case OverflowPolicy::DROP_NEWEST:
+                numDropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+    }
+
+    template <typename Assign> bool tryPush(Assign& assign) {
+        // single producer, thus the write position is not contended
+        std::size_t position = writePosition.load(std::memory_order_relaxed);
+        if (position - readPosition.load(std::memory_order_acquire) >=
+            capacity) {
+            return false; // full (a single slot is used if capacity is one)
+        }
+        Slot& slot = slots[position & mask];
+        std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence != position) return false; // full
+        assign(slot.value);
+        slot.sequence.store(position + 1, std::memory_order_release);
+        writePosition.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    template <typename Assign> bool popWith(Assign&& assign) {
+        int spins = 0;
+        while (!tryPopWith(assign)) {
+            if (closed.load(std::memory_order_acquire)) {
+                return tryPopWith(assign);
+            }
+            if (++spins < 64) continue;
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    template <typename Assign> bool tryPopWith(Assign&& assign) {
+        if (!tryTake(assign)) return false;
+        numPopped.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // claim the front slot (consumer, or producer that discards the oldest)
+    template <typename Assign> bool tryTake(Assign&& assign) {
+        std::size_t position = readPosition.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true) {
+            slot = &slots[position & mask];
+            std::size_t sequence =
+                    slot->sequence.load(std::memory_order_acquire);
+            auto difference = static_cast<std::ptrdiff_t>(sequence) -
+                              static_cast<std::ptrdiff_t>(position + 1);
+            if (difference == 0) {
+                if (readPosition.compare_exchange_weak(
+                            position, position + 1,
+                            std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false; // empty
+            } else {
+                position = readPosition.load(std::memory_order_relaxed);
+            }
+        }
+        assign(slot->value);
+        slot->sequence.store(position + size, std::memory_order_release);
+        return true;
+    }
+
+    OverflowPolicy policy;
+    std::size_t capacity; // maximum number of elements
+    std::size_t size;     // number of slots
+    std::size_t mask;
+    std::unique_ptr<Slot[]> slots;
+    // positions are kept in different cache lines to avoid false sharing
+    alignas(64) std::atomic<std::size_t> writePosition;
+    alignas(64) std::atomic<std::size_t> readPosition;
+    std::atomic<std::size_t> numPopped;
+    alignas(64) std::atomic<std::size_t> numPushed;
+    std::atomic<std::size_t> numDropped;
+    std::atomic<bool> closed;
+};
+
+} // namespace OpenSimRT
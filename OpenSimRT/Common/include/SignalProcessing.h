@@ -30,9 +30,13 @@
 #include <SimTKcommon.h>
 #include <condition_variable>
 #include <mutex>
+#include <vector>
 
 namespace OpenSimRT {
 
+class CheckpointWriter;
+class CheckpointReader;
+
 /**
  * \brief A non-casual filter that uses a low pass recursive filter for removing
  * high frequency noise and splines for calculating higher order derivatives.
@@ -87,12 +91,42 @@ class Common_API LowPassSmoothFilter {
  public: /* public interface */
     LowPassSmoothFilter(const Parameters& parameters);
     Output filter(const Input& input);
+    /**
+     * Same as filter(input), but the result is written into output, whose
+     * vectors are reused when they have the right size. The memory buffer is
+     * shifted in place, thus only the splines (calculateDerivatives)
+     * allocate.
+     */
+    void filter(const Input& input, Output& output);
+    /**
+     * Save or restore the memory buffer (e.g., to resume after a restart
+     * without waiting for the buffer to fill again).
+     */
+    void saveState(CheckpointWriter& writer) const;
+    void loadState(CheckpointReader& reader);
+    /**
+     * Whether a sample at time t continues the signal in the memory buffer with
+     * the same sampling period (always true before the second sample).
+     */
+    bool isContinuousWith(double t) const;
+    /**
+     * Shift the time of the memory buffer, so that a sample at time t
+     * continues it (e.g., after a restored state). The buffered samples are
+     * treated as the most recent history of the signal.
+     */
+    void alignWith(double t);
 
  private: /* private data members */
     Parameters parameters;
     SimTK::Matrix time;
     SimTK::Matrix data;
     int initializationCounter;
+    // buffers reused across calls
+    std::vector<double> xRaw;
+    std::vector<double> xFiltered;
+    SimTK::Vector splineTime;
+    std::vector<int> firstDerivative;
+    std::vector<int> secondDerivative;
 };
 
 /**
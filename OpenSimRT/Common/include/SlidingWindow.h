@@ -19,78 +19,222 @@
  *
  * @file SlidingWindow.h
  *
- * \brief Basic implementation of a sliding window. Computes the mean value of a
- * fixed n-sized buffer.
- *
- * TODO: This implementation is very primitive and should be upgraded later on.
+ * \brief Implementation of a sliding window with constant time insertion and
+ * queries (mean, variance and equality of the latest or oldest elements).
  *
  * @author Filip Konstantinos <filip.k@ece.upatras.gr>
  */
 #pragma once
 
+#include "Exception.h"
+#include "TypeHelpers.h"
 #include "internal/CommonExports.h"
 #include <SimTKcommon.h>
-#include <numeric>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <vector>
 
 namespace OpenSimRT {
 
-/** @brief Basic sliding window implementation. New data are pushed in-front of
- * a fixed sized buffer, and old data are discarded. The size of the window is
- * determined from the number of elements passed in 'init()' member function or
- * by explicitely setting the size with 'setSize()' member function. The mean
- * value can be computed using the 'mean()' member function. */
-template <typename T> struct SlidingWindow {
-    SimTK::Array_<T> data; // sliding window data
-    std::size_t capacity;  // sliding window size
+/**
+ * @brief Sliding window of fixed capacity. New data are pushed in-front of the
+ * window and the oldest data are discarded. The capacity is determined from
+ * the number of elements passed in 'init()' member function or by explicitly
+ * setting it with 'setSize()' member function. If N > 0, the capacity is N and
+ * the elements are stored in a std::array.
+ *
+ * The elements are stored in a ring, thus insertion is O(1). For arithmetic
+ * types and SimTK::Vec, running sums (relative to a reference value, for
+ * numerical accuracy) provide the mean and the (element-wise) variance. The
+ * sums are recomputed each time the ring wraps around to remove the round-off
+ * error of the updates, which is amortized O(1) per insertion. Each element
+ * also stores the length of the run of equal elements that ends with it, so
+ * that the equality predicates are O(1).
+ *
+ * Elements are indexed from the oldest (0) to the latest (size() - 1).
+ */
+template <typename T, std::size_t N = 0> class SlidingWindow {
+    static constexpr bool hasStatistics =
+            std::is_arithmetic<T>::value || is_simtk_vec<T>::value;
+
+ public:
+    SlidingWindow() : capacity(N), head(0), count(0), numInserted(0) {
+        clearStatistics();
+    }
 
-    // set initial values
+    // set initial values (the capacity is equal to the number of elements)
     void init(SimTK::Array_<T>&& aData) {
-        data = std::forward<SimTK::Array_<T>>(aData);
-        capacity = data.size();
+        setSize(aData.size());
+        for (const auto& x : aData) insert(x);
     }
 
     // insert element
     void insert(const T& x) {
-        if (data.size() == capacity) data.erase(data.begin());
-        data.push_back(x);
+        if (capacity == 0) THROW_EXCEPTION("sliding window has no capacity");
+        const std::size_t position = (head + count) % capacity;
+        std::size_t run = 1;
+        if (count > 0 && back() == x) {
+            run = std::min(slots[previous(position)].run + 1, capacity);
+        }
+        if (count == capacity) {
+            if constexpr (hasStatistics) remove(slots[head].value);
+            head = next(head);
+        } else {
+            count++;
+        }
+        slots[position].value = x;
+        slots[position].run = run;
+        if constexpr (hasStatistics) {
+            add(x);
+            // remove the accumulated round-off error
+            if (++numInserted % capacity == 0) recomputeStatistics();
+        }
     }
 
-    // reserve space in memory
+    // set the capacity and remove all elements
     void setSize(const std::size_t& size) {
+        if (N > 0 && size != N) {
+            THROW_EXCEPTION("sliding window has compile-time capacity " +
+                            std::to_string(N));
+        }
+        if constexpr (N == 0) slots.resize(size);
         capacity = size;
-        data.reserve(size);
+        clear();
+    }
+
+    // remove all elements
+    void clear() {
+        head = 0;
+        count = 0;
+        numInserted = 0;
+        clearStatistics();
+    }
+
+    std::size_t size() const { return count; }
+    std::size_t getCapacity() const { return capacity; }
+    bool empty() const { return count == 0; }
+    bool isFull() const { return count == capacity; }
+
+    // i-th element, from the oldest (0) to the latest (size() - 1)
+    const T& operator[](const std::size_t& i) const {
+        return slots[(head + i) % capacity].value;
     }
+    const T& front() const { return slots[head].value; }
+    const T& back() const { return (*this)[count - 1]; }
 
     // compute mean value of the window
-    T mean() {
-        return 1.0 * std::accumulate(data.begin(), data.end(), T()) /
-               int(data.size());
+    T mean() const {
+        static_assert(hasStatistics, "mean requires arithmetic elements");
+        return reference + sum / static_cast<double>(count);
     }
-    // Determine if all elements in the window are equal to input value
-    bool equal(const T& x) {
-        for (const auto& e : data) {
-            if (e != x) return false;
+
+    // compute the (element-wise, population) variance of the window
+    T variance() const {
+        static_assert(hasStatistics, "variance requires arithmetic elements");
+        const T m = sum / static_cast<double>(count);
+        T result = sumSquares / static_cast<double>(count) - square(m);
+        // round-off may result in small negative values
+        if constexpr (std::is_arithmetic<T>::value) {
+            return std::max(result, T(0));
+        } else {
+            for (int i = 0; i < T::size(); ++i) {
+                result[i] = std::max(result[i], 0.0);
+            }
+            return result;
         }
-        return true;
     }
 
+    // Determine if all elements in the window are equal to input value
+    bool equal(const T& x) const { return nLastEqual(x, count); }
+
     // Determine if the n first elements are equal to input value.
-    bool nFirstEqual(const T& x, const size_t& n) const {
-        if (n > data.size()) throw std::runtime_error("Wrong input size");
-        for (size_t i = 0; i < n; ++i) {
-            if (data[i] != x) return false;
-        }
-        return true;
+    bool nFirstEqual(const T& x, const std::size_t& n) const {
+        if (n > count) THROW_EXCEPTION("Wrong input size");
+        if (n == 0) return true;
+        // the run of the n-th element covers all the previous elements
+        const auto& slot = slots[(head + n - 1) % capacity];
+        return slot.run >= n && slot.value == x;
     }
 
     // Determine if the last n elements are equal to input value.
-    bool nLastEqual(const T& x, const size_t& n) const {
-        if (n > data.size()) throw std::runtime_error("Wrong input size");
-        for (size_t i = 0; i < n; ++i) {
-            if (data[data.size() - i - 1] != x) return false;
+    bool nLastEqual(const T& x, const std::size_t& n) const {
+        if (n > count) THROW_EXCEPTION("Wrong input size");
+        if (n == 0) return true;
+        const auto& slot = slots[(head + count - 1) % capacity];
+        return slot.run >= n && slot.value == x;
+    }
+
+ private:
+    struct Slot {
+        T value;
+        std::size_t run; // number of equal elements that end with this one
+    };
+
+    std::size_t next(std::size_t i) const {
+        return i + 1 == capacity ? 0 : i + 1;
+    }
+    std::size_t previous(std::size_t i) const {
+        return i == 0 ? capacity - 1 : i - 1;
+    }
+
+    static T zero() { return T(0.0); }
+
+    static T square(const T& x) {
+        if constexpr (std::is_arithmetic<T>::value) {
+            return x * x;
+        } else {
+            T result = x;
+            for (int i = 0; i < T::size(); ++i) result[i] *= x[i];
+            return result;
+        }
+    }
+
+    void add(const T& x) {
+        if (count == 1) reference = x;
+        const T d = x - reference;
+        sum += d;
+        sumSquares += square(d);
+    }
+
+    void remove(const T& x) {
+        const T d = x - reference;
+        sum -= d;
+        sumSquares -= square(d);
+    }
+
+    void clearStatistics() {
+        if constexpr (hasStatistics) {
+            reference = zero();
+            sum = zero();
+            sumSquares = zero();
         }
-        return true;
     }
+
+    void recomputeStatistics() {
+        // use the mean as reference, so that the sums remain small
+        reference = mean();
+        sum = zero();
+        sumSquares = zero();
+        for (std::size_t i = 0; i < count; ++i) {
+            const T d = (*this)[i] - reference;
+            sum += d;
+            sumSquares += square(d);
+        }
+    }
+
+    std::conditional_t<N == 0, std::vector<Slot>, std::array<Slot, N>> slots;
+    std::size_t capacity;
+    std::size_t head; // position of the oldest element
+    std::size_t count;
+    std::size_t numInserted;
+
+    // sums of the differences from the reference value
+    T reference;
+    T sum;
+    T sumSquares;
 };
 
 } // namespace OpenSimRT
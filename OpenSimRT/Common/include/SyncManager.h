@@ -26,7 +26,9 @@
  */
 #pragma once
 
+#include "Checkpoint.h"
 #include "Exception.h"
+#include "Profiler.h"
 #include "TypeHelpers.h"
 #include "Utils.h"
 #include "internal/CommonExports.h"
@@ -112,6 +114,10 @@ template <typename ETX = double> class SyncManager {
     // Get read only reference to data table
     const OpenSim::DataTable& getTable();
 
+    // Save or restore the pending entries and the output time (restart)
+    void saveState(CheckpointWriter& writer) const;
+    void loadState(CheckpointReader& reader);
+
  private:
     /** (terminate call) Recursive function for determining if the element in
      * Args... list is an STL-like contairer of std::pairs or an std::pair.
@@ -179,6 +185,7 @@ SyncManager<ETX>::SyncManager(const ETX& samplingRate, const ETX& threshold) {
 template <typename ETX>
 std::pair<ETX, std::vector<SimTK::Vector_<ETX>>>
 SyncManager<ETX>::getPack(size_t delay) {
+    PROFILE_ZONE("SyncManager::getPack");
     const auto& v = _table.getIndependentColumn();
     if (!_isCurrentTimeSet) {
         interpolateNanValues();
@@ -238,6 +245,7 @@ SyncManager<ETX>::getPack(size_t delay) {
 template <typename ETX>
 template <typename... Args>
 void SyncManager<ETX>::appendPack(Args&&... args) {
+    PROFILE_ZONE("SyncManager::appendPack");
     // create tuple from args to allow different types
     using ArgsTuple = std::tuple<Args...>;
     ArgsTuple argTuple = {std::forward<Args>(args)...};
@@ -641,4 +649,67 @@ template <typename InputIterator>
 void SyncManager<ETX>::deleteRows(InputIterator first, InputIterator last) {
     while (first != last) { removeRow(*first++); }
 }
+
+template <typename ETX>
+void SyncManager<ETX>::saveState(CheckpointWriter& writer) const {
+    writer.write(_tableSizeIsSet);
+    writer.write(static_cast<double>(_entryThreshold));
+    writer.write(static_cast<int>(_numColumns));
+    writer.write(static_cast<int>(_offset));
+    writer.write(static_cast<int>(_numOfPacks));
+    writer.write(static_cast<int>(_packCounter));
+    writer.write(static_cast<double>(_samplingRate));
+    writer.write(_currentTime);
+    writer.write(_isCurrentTimeSet);
+    writer.write(static_cast<int>(_vectorSizePerPack.size()));
+    for (const auto& pack : _vectorSizePerPack) {
+        writer.write(static_cast<int>(pack.first));
+        writer.write(static_cast<int>(pack.second));
+    }
+    const auto& v = _table.getIndependentColumn();
+    writer.write(SimTK::Vector(static_cast<int>(v.size()), v.data()));
+    writer.write(SimTK::Matrix(_table.getMatrix()));
+}
+
+template <typename ETX>
+void SyncManager<ETX>::loadState(CheckpointReader& reader) {
+    double entryThreshold, samplingRate;
+    int numColumns, offset, numOfPacks, packCounter, numPacks;
+    reader.read(_tableSizeIsSet);
+    reader.read(entryThreshold);
+    reader.read(numColumns);
+    reader.read(offset);
+    reader.read(numOfPacks);
+    reader.read(packCounter);
+    reader.read(samplingRate);
+    reader.read(_currentTime);
+    reader.read(_isCurrentTimeSet);
+    reader.read(numPacks);
+    _entryThreshold = entryThreshold;
+    _numColumns = numColumns;
+    _offset = offset;
+    _numOfPacks = numOfPacks;
+    _packCounter = packCounter;
+    _samplingRate = samplingRate;
+    _vectorSizePerPack.clear();
+    for (int i = 0; i < numPacks; ++i) {
+        int pack, size;
+        reader.read(pack);
+        reader.read(size);
+        _vectorSizePerPack[pack] = size;
+    }
+
+    SimTK::Vector t;
+    SimTK::Matrix rows;
+    reader.read(t);
+    reader.read(rows);
+    if (rows.nrow() != t.size()) THROW_EXCEPTION("corrupted checkpoint");
+    _table = OpenSim::DataTable();
+    for (int i = 0; i < rows.nrow(); ++i) {
+        std::vector<ETX> row(rows.ncol());
+        for (int j = 0; j < rows.ncol(); ++j) row[j] = rows[i][j];
+        _table.appendRow(t[i], row);
+    }
+}
+
 } // namespace OpenSimRT
@@ -0,0 +1,184 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file Telemetry.h
+ *
+ * \brief Low-overhead latency histograms and counters for monitoring the
+ * real-time analysis.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#pragma once
+
+#include "internal/CommonExports.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace OpenSimRT {
+
+/**
+ * \brief A histogram with logarithmically spaced buckets that are linearly
+ * subdivided (as in HdrHistogram), thus the relative error of the reported
+ * percentiles is bounded (~3%) for any value in [0, 2^64). Values smaller
+ * than 64 are recorded exactly.
+ *
+ * Recording is wait-free and does not allocate; it must be performed by a
+ * single thread (e.g., the thread that executes a stage of the pipeline),
+ * while other threads may read the statistics at any time.
+ */
+class Common_API Histogram {
+ public:
+    Histogram();
+    Histogram(const Histogram&) = delete;
+    Histogram& operator=(const Histogram&) = delete;
+
+    void record(std::uint64_t value);
+    void reset();
+
+    std::uint64_t getCount() const;
+    std::uint64_t getMin() const;
+    std::uint64_t getMax() const;
+    double getMean() const;
+    /**
+     * Smallest recorded value (upper bound of its bucket) such that p percent
+     * of the values are less or equal, p in [0, 100].
+     */
+    std::uint64_t getPercentile(double p) const;
+
+ private:
+    static const int subBucketBits = 5;
+    static const int numBuckets = (64 - subBucketBits + 1) << subBucketBits;
+    static int bucketIndex(std::uint64_t value);
+    static std::uint64_t bucketUpperBound(int index);
+
+    std::unique_ptr<std::atomic<std::uint64_t>[]> buckets;
+    std::atomic<std::uint64_t> count;
+    std::atomic<std::uint64_t> sum;
+    std::atomic<std::uint64_t> min;
+    std::atomic<std::uint64_t> max;
+};
+
+/**
+ * \brief A registry of named histograms (e.g., the latency of each stage of
+ * the pipeline, the depth of a queue) and counters (e.g., dropped frames).
+ *
+ * Histograms and counters must be added before the threads that record to
+ * them are started; afterwards the registry is only read, thus it is not
+ * locked. Latencies are recorded in nanoseconds and reported in microseconds.
+ * A Snapshot of the statistics can be taken at any time and exported as CSV or
+ * JSON.
+ *
+ * ****************************************************************************
+ * Example code:
+ * ****************************************************************************
+ *
+ * Telemetry telemetry;
+ * auto& ikLatency = telemetry.addLatencyHistogram("ik");
+ * telemetry.addCounter("dropped", [&]() { return queue.getNumDropped(); });
+ * ...
+ * auto t0 = Telemetry::now();
+ * ik.solve(...);
+ * ikLatency.record(Telemetry::elapsed(t0)); // in thread
+ * ...
+ * telemetry.exportJSON("telemetry.json"); // at shutdown
+ */
+class Common_API Telemetry {
+ public:
+    typedef std::chrono::steady_clock Clock;
+    typedef std::function<std::uint64_t()> CounterFunction;
+
+    struct Statistics {
+        std::string name;
+        std::string unit;
+        std::uint64_t count;
+        double min;
+        double mean;
+        double p50;
+        double p90;
+        double p99;
+        double p999;
+        double max;
+    };
+    struct Counter {
+        std::string name;
+        std::uint64_t value;
+    };
+    struct Snapshot {
+        double duration; // since the creation of the telemetry (s)
+        std::vector<Statistics> histograms;
+        std::vector<Counter> counters;
+    };
+
+    Telemetry();
+    Telemetry(const Telemetry&) = delete;
+    Telemetry& operator=(const Telemetry&) = delete;
+
+    /**
+     * Histogram of durations that are recorded in nanoseconds.
+     */
+    Histogram& addLatencyHistogram(const std::string& name);
+    /**
+     * Histogram of dimensionless values (e.g., queue depth).
+     */
+    Histogram& addHistogram(const std::string& name,
+                            const std::string& unit = "");
+    /**
+     * Counter that is evaluated when a snapshot is taken.
+     */
+    void addCounter(const std::string& name, const CounterFunction& counter);
+
+    Snapshot getSnapshot() const;
+    void reset();
+
+    /**
+     * Export a snapshot in CSV (one row per histogram and counter) or JSON.
+     * exportFile selects the format from the extension of the file.
+     */
+    void exportCSV(const std::string& fileName) const;
+    void exportJSON(const std::string& fileName) const;
+    void exportFile(const std::string& fileName) const;
+
+    static Clock::time_point now() { return Clock::now(); }
+    /**
+     * Nanoseconds elapsed since start.
+     */
+    static std::uint64_t elapsed(const Clock::time_point& start) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       Clock::now() - start)
+                .count();
+    }
+
+ private:
+    struct Entry {
+        std::string name;
+        std::string unit;
+        double scale;
+        std::unique_ptr<Histogram> histogram;
+    };
+    std::vector<Entry> entries;
+    std::vector<std::pair<std::string, CounterFunction>> counters;
+    Clock::time_point startTime;
+};
+
+} // namespace OpenSimRT
@@ -0,0 +1,101 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file ThreadPolicy.h
+ *
+ * \brief Real-time configuration of threads (CPU pinning and SCHED_FIFO
+ * priority) and of the process memory (locking and prefaulting).
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#pragma once
+
+#include "internal/CommonExports.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace OpenSimRT {
+
+/**
+ * \brief Scheduling policy of a thread. The thread can be pinned to a set of
+ * cores (e.g., cores that are isolated from the visualizer and the loggers)
+ * and scheduled with SCHED_FIFO, so that it preempts any thread of normal
+ * priority as soon as it becomes ready.
+ *
+ * SCHED_FIFO requires privileges (root, CAP_SYS_NICE or an rtprio limit in
+ * /etc/security/limits.conf). Pinning and priorities are supported only on
+ * Linux; elsewhere apply() has no effect.
+ *
+ * ****************************************************************************
+ * Example code:
+ * ****************************************************************************
+ *
+ * ThreadPolicy policy{{2, 3}, 80}; // cores 2 and 3, SCHED_FIFO priority 80
+ * std::thread t([&]() {
+ *     policy.apply(); // applied to the calling thread
+ *     ...
+ * });
+ */
+struct Common_API ThreadPolicy {
+    std::vector<int> cpus; // cores of the thread (any core if empty)
+    int priority = 0;      // SCHED_FIFO priority in [1, 99], normal if 0
+
+    /**
+     * Apply the policy to the calling thread. Returns false and prints a
+     * warning if the operating system refuses (e.g., insufficient
+     * privileges), in which case the thread keeps its previous policy.
+     */
+    bool apply() const;
+
+    /**
+     * True if the policy does not change the default scheduling.
+     */
+    bool isDefault() const;
+};
+
+/**
+ * Parse a set of cores given as a comma separated list of cores and ranges,
+ * e.g., "0,2-3" -> {0, 2, 3}. An empty string or "*" denotes any core.
+ */
+Common_API std::vector<int> cpuSetFromString(const std::string& cpus);
+
+/**
+ * Parse the policies of a group of threads, where the threads are separated
+ * by '|', e.g., cpus = "2 | 3" and priorities = "80 | 70". If one of the
+ * strings has a single entry, it is used for all threads. An empty string
+ * results in the default policy.
+ */
+Common_API std::vector<ThreadPolicy>
+threadPoliciesFromString(const std::string& cpus,
+                         const std::string& priorities);
+
+/**
+ * Lock the current and future pages of the process into memory (mlockall), so
+ * that a real-time thread never waits for a page to be swapped in, and
+ * prefault prefaultHeapSize bytes of heap. The prefaulted memory is retained
+ * by the allocator (it is not trimmed or mapped separately), thus subsequent
+ * allocations up to this size do not cause page faults. It should be called
+ * after warm-up, when the memory of the threads has been allocated. Returns
+ * false and prints a warning if the memory could not be locked (e.g.,
+ * RLIMIT_MEMLOCK is too low). Supported only on Linux.
+ */
+Common_API bool lockMemory(std::size_t prefaultHeapSize = 0);
+
+} // namespace OpenSimRT
@@ -0,0 +1,133 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file ThreadPool.h
+ *
+ * \brief Implementation of a fixed-size pool of worker threads.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#pragma once
+
+#include "Exception.h"
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace OpenSimRT {
+
+/**
+ * \brief A fixed-size pool of worker threads that execute tasks from a shared
+ * FIFO queue. The workers are created once in the constructor and are reused
+ * for every submitted task, thus avoiding the cost of creating a thread each
+ * time a small parallel job must be executed (e.g., once per frame). Tasks are
+ * submitted with `push()`, which returns a std::future to the result of the
+ * task. Exceptions thrown by a task are propagated to the caller through the
+ * future. The destructor waits for the queued tasks to finish and joins the
+ * workers.
+ *
+ * ****************************************************************************
+ * Example code:
+ * ****************************************************************************
+ *
+ * ThreadPool pool(2);
+ * auto f1 = pool.push([&]() { return solveA(); });
+ * auto f2 = pool.push([&]() { return solveB(); });
+ * auto a = f1.get(); // blocks until solveA() returns
+ * auto b = f2.get();
+ */
+class ThreadPool {
+ public:
+    /**
+     * Create a pool of n worker threads.
+     */
+    explicit ThreadPool(std::size_t n) : stop(false) {
+        if (n == 0) THROW_EXCEPTION("ThreadPool requires at least one thread");
+        workers.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            workers.emplace_back([this]() { work(); });
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(monitor);
+            stop = true;
+        }
+        taskAvailable.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    /**
+     * Number of worker threads in the pool.
+     */
+    std::size_t size() const { return workers.size(); }
+
+    /**
+     * Submit a task for execution. Returns a future to the result of the
+     * task.
+     */
+    template <typename F>
+    std::future<std::invoke_result_t<F>> push(F&& f) {
+        typedef std::invoke_result_t<F> R;
+        auto task = std::make_shared<std::packaged_task<R()>>(
+                std::forward<F>(f));
+        auto result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(monitor);
+            if (stop) THROW_EXCEPTION("push on a stopped ThreadPool");
+            tasks.emplace([task]() { (*task)(); });
+        }
+        taskAvailable.notify_one();
+        return result;
+    }
+
+ private:
+    // worker loop
+    void work() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(monitor);
+                taskAvailable.wait(lock,
+                                   [&]() { return stop || !tasks.empty(); });
+                if (stop && tasks.empty()) return;
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+            task();
+        }
+    }
+
+    bool stop;
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+    std::mutex monitor;
+    std::condition_variable taskAvailable;
+};
+
+} // namespace OpenSimRT
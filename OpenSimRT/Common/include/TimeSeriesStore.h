@@ -0,0 +1,226 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TimeSeriesStore.h
+ *
+ * \brief Column-major time series with a fixed capacity, kept in memory or in
+ * a memory-mapped file.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#pragma once
+
+#include "Exception.h"
+#include "internal/CommonExports.h"
+#include <Common/TimeSeriesTable.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace OpenSimRT {
+
+/**
+ * \brief A time series (time and columns of doubles) that is stored column by
+ * column in a buffer with room for a fixed number of rows. Appending a row
+ * writes one value per column and never reallocates, columns are contiguous
+ * and accessed without copies, and a row is a strided view of the columns.
+ * Thus, it replaces OpenSim::TimeSeriesTable where rows are appended or read
+ * in a loop (TimeSeriesTable reallocates its matrix on every appended row).
+ *
+ * The buffer is either in memory or a memory-mapped file. A file-backed store
+ * is written by the operating system while rows are appended (see flush())
+ * and is opened again without parsing, thus large recordings that are read
+ * repeatedly (e.g., replay of a trial) can be converted once from .sto/.csv
+ * (see fromTable()) and then mapped in constant time. The time must be
+ * increasing, as in a TimeSeriesTable. A store is not thread-safe.
+ *
+ * File format (native byte order):
+ *
+ * header:  "OSRTTSS" | version (u32) | number of columns (u32) |
+ *          capacity (u64) | number of rows (u64) | data offset (u64) |
+ *          column labels
+ * data:    time (f64 x capacity) | for each column: values (f64 x capacity)
+ *
+ * where the labels are stored as length (u32) | characters and the data start
+ * at a multiple of 64 bytes.
+ *
+ * ****************************************************************************
+ * Example code:
+ * ****************************************************************************
+ *
+ * // logging
+ * TimeSeriesStore store(ik.initializeLogger().getColumnLabels(), 360000,
+ *                       "q.tss");
+ * while (...) store.appendRow(t, q); // any vector with operator[]
+ *
+ * // replay
+ * auto store = TimeSeriesStore::isStoreFile(fileName)
+ *                      ? TimeSeriesStore(fileName)
+ *                      : TimeSeriesStore::fromTable(TimeSeriesTable(fileName));
+ * for (std::size_t i = 0; i < store.getNumRows(); ++i) {
+ *     auto row = store.getRow(i);
+ *     ...
+ * }
+ * auto x = store.getColumn("pelvis_tx"); // x.data, x.size
+ */
+class Common_API TimeSeriesStore {
+ public:
+    /**
+     * Contiguous values of a column.
+     */
+    struct Column {
+        const double* data;
+        std::size_t size;
+
+        const double& operator[](std::size_t i) const { return data[i]; }
+        const double* begin() const { return data; }
+        const double* end() const { return data + size; }
+    };
+
+    /**
+     * Values of a row (one per column), stride elements apart in the buffer.
+     */
+    struct Row {
+        const double* data;
+        std::size_t stride;
+        int numColumns;
+
+        const double& operator[](int j) const { return data[j * stride]; }
+        int size() const { return numColumns; }
+    };
+
+    /**
+     * Create an empty store with room for capacity rows. The store is kept
+     * in memory if fileName is empty, otherwise the file is created (or
+     * replaced) and mapped.
+     */
+    TimeSeriesStore(const std::vector<std::string>& columnLabels,
+                    std::size_t capacity, const std::string& fileName = "");
+
+    /**
+     * Map the store of an existing file. Rows can be appended if the file is
+     * writable and the store has not reached its capacity.
+     */
+    explicit TimeSeriesStore(const std::string& fileName);
+
+    ~TimeSeriesStore();
+    TimeSeriesStore(TimeSeriesStore&& other) noexcept;
+    TimeSeriesStore& operator=(TimeSeriesStore&& other) noexcept;
+    TimeSeriesStore(const TimeSeriesStore&) = delete;
+    TimeSeriesStore& operator=(const TimeSeriesStore&) = delete;
+
+    /**
+     * True if the file is a store (as opposed to e.g., an .sto file).
+     */
+    static bool isStoreFile(const std::string& fileName);
+
+    /**
+     * Copy a table to a new store with capacity equal to its number of rows
+     * (in memory if fileName is empty).
+     */
+    static TimeSeriesStore fromTable(const OpenSim::TimeSeriesTable& table,
+                                     const std::string& fileName = "");
+
+    /**
+     * Copy the rows to a TimeSeriesTable.
+     */
+    OpenSim::TimeSeriesTable toTable() const;
+
+    /**
+     * Append a row. The values must have one element per column.
+     */
+    template <typename V> void appendRow(double t, const V& values) {
+        if (!isWritable) THROW_EXCEPTION("store is read-only");
+        if (static_cast<int>(values.size()) != numColumns) {
+            THROW_EXCEPTION("wrong number of values");
+        }
+        auto i = header->numRows;
+        if (i == capacity) THROW_EXCEPTION("store is full");
+        if (i > 0 && t <= data[i - 1]) {
+            THROW_EXCEPTION("time must be increasing");
+        }
+        data[i] = t;
+        for (int j = 0; j < numColumns; ++j) {
+            data[(j + 1) * capacity + i] = values[j];
+        }
+        header->numRows = i + 1;
+    }
+
+    std::size_t getNumRows() const { return header->numRows; }
+    std::size_t getCapacity() const { return capacity; }
+    int getNumColumns() const { return numColumns; }
+    const std::vector<std::string>& getColumnLabels() const {
+        return columnLabels;
+    }
+    /**
+     * Index of a column (throws if the label does not exist).
+     */
+    int getColumnIndex(const std::string& label) const;
+
+    double getTime(std::size_t i) const { return data[i]; }
+    Column getTimeColumn() const { return {data, header->numRows}; }
+    Column getColumn(int j) const {
+        return {data + (j + 1) * capacity, header->numRows};
+    }
+    Column getColumn(const std::string& label) const {
+        return getColumn(getColumnIndex(label));
+    }
+    Row getRow(std::size_t i) const {
+        return {data + capacity + i, capacity, numColumns};
+    }
+
+    /**
+     * Name of the mapped file (empty if the store is in memory).
+     */
+    const std::string& getFileName() const { return fileName; }
+
+    /**
+     * Write the appended rows of a file-backed store to the disk.
+     */
+    void flush();
+
+ private:
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t numColumns;
+        std::uint64_t capacity;
+        std::uint64_t numRows;
+        std::uint64_t dataOffset; // bytes from the beginning of the buffer
+    };
+
+    // memory or file mapping (platform specific)
+    struct Mapping;
+
+    // buffer of the header, the labels and the data
+    void createBuffer(std::size_t size);
+
+    std::string fileName;
+    std::vector<std::string> columnLabels;
+    std::unique_ptr<Mapping> mapping;
+    Header* header;
+    double* data; // time column, followed by the columns
+    std::size_t capacity;
+    int numColumns;
+    bool isWritable;
+};
+
+} // namespace OpenSimRT
@@ -0,0 +1,309 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TripleBuffer.h
+ *
+ * \brief Lock-free publication of the latest value of a producer thread to
+ * one (TripleBuffer) or several (SnapshotPublisher) consumer threads.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#pragma once
+
+#include "AtomicWait.h"
+#include "Exception.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace OpenSimRT {
+
+/**
+ * \brief A triple buffer passes the latest value from a writer thread to a
+ * reader thread without locks and without blocking either side. The writer
+ * fills the back buffer and swaps it with the middle buffer, the reader swaps
+ * the middle buffer with the front buffer when a new value is available. The
+ * swaps are single atomic exchanges of the buffer indices, thus a value is
+ * never read while it is written and the writer never waits for the reader.
+ * Values that are published faster than they are read are overwritten (only
+ * the latest is kept) and counted as skipped.
+ *
+ * Each value is tagged with a version (1, 2, ...), so that the reader can
+ * tell whether it is new and how many values it missed.
+ *
+ * ****************************************************************************
+ * Example code:
+ * ****************************************************************************
+ *
+ * TripleBuffer<Output> buffer;
+ *
+ * // writer thread
+ * buffer.getWriteBuffer() = output; // or buffer.write(output)
+ * buffer.publish();
+ *
+ * // reader thread
+ * if (buffer.update()) use(buffer.read());
+ */
+template <typename T> class TripleBuffer {
+ public:
+    TripleBuffer()
+            : state(1), back(0), writeVersion(0), front(2), readVersion(0),
+              numSkipped(0) {
+        for (auto& v : versions) v = 0;
+    }
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    /**
+     * Buffer that is filled by the writer before publish().
+     */
+    T& getWriteBuffer() { return buffers[back]; }
+
+    /**
+     * Make the write buffer available to the reader (writer thread).
+     */
+    void publish() {
+        versions[back] = ++writeVersion;
+        back = state.exchange(back | dirtyBit, std::memory_order_acq_rel) &
+               indexMask;
+    }
+
+    void write(const T& value) {
+        getWriteBuffer() = value;
+        publish();
+    }
+
+    /**
+     * True if a value was published after the latest update().
+     */
+    bool hasUpdate() const {
+        return state.load(std::memory_order_acquire) & dirtyBit;
+    }
+
+    /**
+     * Acquire the latest value, if a new one was published (reader thread).
+     * Returns false if there is no new value, in which case read() still
+     * returns the previous one.
+     */
+    bool update() {
+        if (!hasUpdate()) return false;
+        front = state.exchange(front, std::memory_order_acq_rel) & indexMask;
+        auto version = versions[front];
+        numSkipped += version - readVersion - 1;
+        readVersion = version;
+        return true;
+    }
+
+    /**
+     * Latest acquired value (reader thread). It is not modified by the writer
+     * until the next update().
+     */
+    const T& read() const { return buffers[front]; }
+
+    /**
+     * Version of the value returned by read() (0 if none).
+     */
+    std::uint64_t getVersion() const { return readVersion; }
+
+    /**
+     * Number of values that were overwritten before being read.
+     */
+    std::uint64_t getNumSkipped() const { return numSkipped; }
+
+ private:
+    static const int indexMask = 3;
+    static const int dirtyBit = 4;
+
+    T buffers[3];
+    std::uint64_t versions[3];
+    std::atomic<int> state; // index of the middle buffer and dirty bit
+    // the writer and the reader indices are kept in different cache lines
+    alignas(64) int back;
+    std::uint64_t writeVersion;
+    alignas(64) int front;
+    std::uint64_t readVersion;
+    std::uint64_t numSkipped;
+};
+
+/**
+ * \brief Publishes the latest value of a producer thread (e.g., the results
+ * of the real-time analysis) to several independent subscribers (e.g., the
+ * visualizer, the logger and a network publisher) that read at their own
+ * rate. Each subscriber owns a TripleBuffer, thus publish() never blocks,
+ * regardless of the number and the speed of the subscribers. A slow
+ * subscriber skips values instead of delaying the producer or the other
+ * subscribers.
+ *
+ * Subscribers either poll for new values or wait for them. Waiting subscribers
+ * sleep on the publication sequence (see AtomicWait.h) and publish() wakes
+ * them only if one is waiting. Optionally, a callback is invoked for every new value, on a thread of the publisher that
+ * is dedicated to the callback, so that a slow callback does not delay the
+ * producer either.
+ *
+ * Subscribers and callbacks must be added before the producer starts
+ * publishing. close() wakes up the waiting subscribers and terminates the
+ * callback threads.
+ *
+ * ****************************************************************************
+ * Example code:
+ * ****************************************************************************
+ *
+ * SnapshotPublisher<Output> publisher;
+ * auto& visualizer = publisher.subscribe();
+ * publisher.addCallback([](const Output& output) { send(output); });
+ *
+ * publisher.publish(output); // producer thread
+ *
+ * Output output; // visualizer thread
+ * while (visualizer.wait(output)) visualize(output);
+ */
+template <typename T> class SnapshotPublisher {
+ public:
+    typedef std::function<void(const T&)> Callback;
+
+    class Subscriber {
+        friend class SnapshotPublisher;
+
+     public:
+        /**
+         * Copy the latest value, if a new one was published since the
+         * previous call. Never blocks.
+         */
+        bool poll(T& value) {
+            if (!buffer.update()) return false;
+            value = buffer.read();
+            return true;
+        }
+
+        /**
+         * Wait until a new value is published and copy it. Returns false if
+         * the publisher was closed and there is no new value.
+         */
+        bool wait(T& value) {
+            while (true) {
+                // a value published after the load changes the sequence, thus
+                // atomicWait() returns immediately
+                const auto current =
+                        publisher.sequence.load(std::memory_order_seq_cst);
+                if (poll(value)) return true;
+                if (publisher.isClosed()) return false;
+                publisher.numWaiters.fetch_add(1, std::memory_order_seq_cst);
+                atomicWait(publisher.sequence, current);
+                publisher.numWaiters.fetch_sub(1, std::memory_order_seq_cst);
+            }
+        }
+
+        /**
+         * True if a value was published since the latest poll() or wait().
+         */
+        bool hasUpdate() const { return buffer.hasUpdate(); }
+
+        /**
+         * Latest value that was copied by poll() or wait().
+         */
+        const T& getLatest() const { return buffer.read(); }
+
+        std::uint64_t getVersion() const { return buffer.getVersion(); }
+        std::uint64_t getNumSkipped() const { return buffer.getNumSkipped(); }
+
+     private:
+        Subscriber(SnapshotPublisher& publisher) : publisher(publisher) {}
+
+        SnapshotPublisher& publisher;
+        TripleBuffer<T> buffer;
+    };
+
+    SnapshotPublisher()
+            : closed(false), version(0), sequence(0), numWaiters(0) {}
+    SnapshotPublisher(const SnapshotPublisher&) = delete;
+    SnapshotPublisher& operator=(const SnapshotPublisher&) = delete;
+
+    ~SnapshotPublisher() {
+        close();
+        for (auto& thread : callbackThreads) thread.join();
+    }
+
+    /**
+     * Add a subscriber that is owned by the publisher.
+     */
+    Subscriber& subscribe() {
+        subscribers.push_back(
+                std::unique_ptr<Subscriber>(new Subscriber(*this)));
+        return *subscribers.back();
+    }
+
+    /**
+     * Invoke the callback for every new value on a dedicated thread.
+     */
+    void addCallback(const Callback& callback) {
+        auto& subscriber = subscribe();
+        callbackThreads.emplace_back([&subscriber, callback]() {
+            T value;
+            while (subscriber.wait(value)) callback(value);
+        });
+    }
+
+    /**
+     * Publish a value to all subscribers (producer thread). Never blocks.
+     */
+    void publish(const T& value) {
+        for (auto& subscriber : subscribers) subscriber->buffer.write(value);
+        version.fetch_add(1, std::memory_order_release);
+        notify();
+    }
+
+    /**
+     * Wake up the waiting subscribers and terminate the callbacks.
+     */
+    void close() {
+        closed.store(true, std::memory_order_release);
+        notify();
+    }
+    bool isClosed() const { return closed.load(std::memory_order_acquire); }
+
+    /**
+     * Number of published values.
+     */
+    std::uint64_t getVersion() const {
+        return version.load(std::memory_order_acquire);
+    }
+
+ private:
+    // the waiting subscribers sleep on sequence, which changes on every
+    // notification (it wraps around, unlike version)
+    void notify() {
+        sequence.fetch_add(1, std::memory_order_seq_cst);
+        if (numWaiters.load(std::memory_order_seq_cst) > 0) {
+            atomicWakeAll(sequence);
+        }
+    }
+
+    std::vector<std::unique_ptr<Subscriber>> subscribers;
+    std::vector<std::thread> callbackThreads;
+    std::atomic<bool> closed;
+    std::atomic<std::uint64_t> version;
+    alignas(64) std::atomic<std::uint32_t> sequence;
+    std::atomic<std::uint32_t> numWaiters;
+};
+
+} // namespace OpenSimRT
@@ -98,8 +98,11 @@ class Common_API BasicModelVisualizer {
     // Update visualizer state.
     void update(const SimTK::Vector& q,
                 const SimTK::Vector& muscleActivations = SimTK::Vector());
+    // Update the decorator with the reaction of a joint (e.g., the element
+    // of JointReaction::getJointIndex()), drawn at the origin of the body on
+    // which the reaction is applied.
     void updateReactionForceDecorator(
-            const SimTK::Vector_<SimTK::SpatialVec>& reactionWrench,
+            const SimTK::SpatialVec& reactionWrench,
             const std::string& reactionOnBody,
             ForceDecorator* reactionForceDecorator);
     // Add decoration generator to the visualizer (take ownership of the
@@ -0,0 +1,68 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ */
+#include "AtomicWait.h"
+#include <chrono>
+#include <climits>
+#include <thread>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "Synchronization.lib")
+#endif
+#endif
+
+using namespace std;
+using namespace OpenSimRT;
+
+static_assert(sizeof(atomic<uint32_t>) == sizeof(uint32_t),
+              "the atomic word must have the size of the futex word");
+
+/*******************************************************************************/
+
+void OpenSimRT::atomicWait(const atomic<uint32_t>& word, uint32_t value) {
+#if defined(__linux__)
+    // returns immediately if the word differs from value (EAGAIN)
+    syscall(SYS_futex, reinterpret_cast<const uint32_t*>(&word),
+            FUTEX_WAIT_PRIVATE, value, nullptr, nullptr, 0);
+#elif defined(_WIN32)
+    auto address = const_cast<atomic<uint32_t>*>(&word);
+    WaitOnAddress(address, &value, sizeof(value), INFINITE);
+#else
+    if (word.load(memory_order_acquire) == value) {
+        this_thread::sleep_for(chrono::microseconds(100));
+    }
+#endif
+}
+
+void OpenSimRT::atomicWakeAll(atomic<uint32_t>& word) {
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE_PRIVATE,
+            INT_MAX, nullptr, nullptr, 0);
+#elif defined(_WIN32)
+    WakeByAddressAll(&word);
+#else
+    (void) word;
+#endif
+}
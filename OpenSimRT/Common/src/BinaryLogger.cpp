@@ -0,0 +1,229 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ */
+#include "BinaryLogger.h"
+#include <chrono>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+using namespace OpenSimRT;
+
+static const char magic[] = "OSRTBLOG";
+static const uint32_t version = 1;
+
+static void writeValue(FILE* file, uint32_t value) {
+    fwrite(&value, sizeof(value), 1, file);
+}
+
+static void writeString(FILE* file, const string& value) {
+    writeValue(file, value.size());
+    fwrite(value.data(), 1, value.size(), file);
+}
+
+static bool readValue(FILE* file, uint32_t& value) {
+    return fread(&value, sizeof(value), 1, file) == 1;
+}
+
+static string readString(FILE* file) {
+    uint32_t size;
+    if (!readValue(file, size)) THROW_EXCEPTION("corrupted log header");
+    string value(size, '\0');
+    if (fread(&value[0], 1, size, file) != size) {
+        THROW_EXCEPTION("corrupted log header");
+    }
+    return value;
+}
+
+/*******************************************************************************/
+
+BinaryLogger::BinaryLogger(const string& fileName,
+                           const Parameters& parameters)
+        : fileName(fileName), parameters(parameters),
+          queue(parameters.queueCapacity, OverflowPolicy::BLOCK),
+          file(nullptr), isStarted(false), isBlocking(false), numWritten(0),
+          numDropped(0) {
+    if (parameters.queueCapacity == 0) {
+        THROW_EXCEPTION("queue capacity must be positive");
+    }
+}
+
+BinaryLogger::~BinaryLogger() { close(); }
+
+int BinaryLogger::addTable(const string& name,
+                           const vector<string>& columnLabels) {
+    if (isStarted) THROW_EXCEPTION("tables must be added before start()");
+    tables.push_back({name, columnLabels, vector<double>(columnLabels.size())});
+    return tables.size() - 1;
+}
+
+void BinaryLogger::start() {
+    if (isStarted) THROW_EXCEPTION("logger is already started");
+    file = fopen(fileName.c_str(), "wb");
+    if (!file) THROW_EXCEPTION("cannot open " + fileName);
+
+    // header
+    fwrite(magic, 1, 8, file);
+    writeValue(file, version);
+    writeValue(file, tables.size());
+    for (const auto& table : tables) {
+        writeString(file, table.name);
+        writeValue(file, table.columnLabels.size());
+        for (const auto& label : table.columnLabels) writeString(file, label);
+    }
+    synchronize();
+
+    isStarted = true;
+    writerThread = thread(&BinaryLogger::run, this);
+}
+
+void BinaryLogger::close() {
+    lock_guard<mutex> lock(closeMutex);
+    if (!isStarted || queue.isClosed()) return;
+    // the writer writes the remaining rows before it terminates
+    queue.close();
+    writerThread.join();
+    synchronize();
+    fclose(file);
+    file = nullptr;
+}
+
+void BinaryLogger::setOverflowPolicy(OverflowPolicy policy) {
+    if (policy == OverflowPolicy::DROP_OLDEST) {
+        THROW_EXCEPTION("rows that are queued cannot be dropped");
+    }
+    isBlocking.store(policy == OverflowPolicy::BLOCK, memory_order_relaxed);
+}
+
+uint64_t BinaryLogger::getNumWrittenRows() const { return numWritten.load(); }
+
+uint64_t BinaryLogger::getNumDroppedRows() const { return numDropped.load(); }
+
+void BinaryLogger::writeChunk(const Chunk& chunk) {
+    auto& table = tables[chunk.table];
+    int n = table.row.size();
+    int count = min(chunkSize, n - static_cast<int>(chunk.offset));
+    if (count > 0) {
+        memcpy(&table.row[chunk.offset], chunk.values, count * sizeof(double));
+    }
+
+    // the row is complete when its last chunk arrives
+    if (chunk.offset + count < n) return;
+    writeValue(file, chunk.table);
+    fwrite(&chunk.t, sizeof(double), 1, file);
+    if (n > 0) fwrite(table.row.data(), sizeof(double), n, file);
+    numWritten.fetch_add(1, memory_order_relaxed);
+}
+
+void BinaryLogger::synchronize() {
+    fflush(file);
+#ifdef _WIN32
+    _commit(_fileno(file));
+#else
+    fsync(fileno(file));
+#endif
+}
+
+void BinaryLogger::run() {
+    auto lastSync = chrono::steady_clock::now();
+    auto syncInterval = chrono::duration<double>(parameters.syncInterval);
+    Chunk chunk;
+    while (true) {
+        bool isEmpty = !queue.tryPop(chunk);
+        if (!isEmpty) {
+            writeChunk(chunk);
+        } else if (queue.isClosed()) {
+            break;
+        }
+
+        // periodic synchronization, at most syncInterval of data are lost
+        if (chrono::steady_clock::now() - lastSync >= syncInterval) {
+            synchronize();
+            lastSync = chrono::steady_clock::now();
+        }
+        if (isEmpty) this_thread::sleep_for(chrono::milliseconds(1));
+    }
+
+    // rows that were pushed before close()
+    while (queue.tryPop(chunk)) writeChunk(chunk);
+}
+
+/*******************************************************************************/
+
+BinaryLogReader::BinaryLogReader(const string& fileName) {
+    file = fopen(fileName.c_str(), "rb");
+    if (!file) THROW_EXCEPTION("cannot open " + fileName);
+    try {
+        char header[8];
+        uint32_t fileVersion, numTables;
+        if (fread(header, 1, 8, file) != 8 || memcmp(header, magic, 8) != 0) {
+            THROW_EXCEPTION(fileName + " is not a binary log");
+        }
+        if (!readValue(file, fileVersion) || fileVersion != version) {
+            THROW_EXCEPTION("unsupported binary log version");
+        }
+        if (!readValue(file, numTables)) {
+            THROW_EXCEPTION("corrupted log header");
+        }
+        for (uint32_t i = 0; i < numTables; ++i) {
+            tableNames.push_back(readString(file));
+            uint32_t numColumns;
+            if (!readValue(file, numColumns)) {
+                THROW_EXCEPTION("corrupted log header");
+            }
+            vector<string> labels;
+            for (uint32_t j = 0; j < numColumns; ++j) {
+                labels.push_back(readString(file));
+            }
+            columnLabels.push_back(labels);
+        }
+    } catch (...) {
+        fclose(file);
+        throw;
+    }
+}
+
+BinaryLogReader::~BinaryLogReader() { fclose(file); }
+
+const string& BinaryLogReader::getTableName(int table) const {
+    return tableNames.at(table);
+}
+
+const vector<string>& BinaryLogReader::getColumnLabels(int table) const {
+    return columnLabels.at(table);
+}
+
+bool BinaryLogReader::next(int& table, double& t, vector<double>& values) {
+    uint32_t index;
+    if (!readValue(file, index)) return false;
+    if (index >= tableNames.size()) THROW_EXCEPTION("corrupted log record");
+    auto n = columnLabels[index].size();
+    values.resize(n);
+    if (fread(&t, sizeof(double), 1, file) != 1 ||
+        fread(values.data(), sizeof(double), n, file) != n) {
+        return false; // truncated record
+    }
+    table = index;
+    return true;
+}
@@ -0,0 +1,267 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ */
+#include "Checkpoint.h"
+#include "Exception.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std;
+using namespace OpenSimRT;
+
+static const char magic[] = "OSRTCKPT";
+static const uint32_t version = 1;
+
+/*******************************************************************************/
+
+void CheckpointWriter::writeBytes(const void* bytes, size_t size) {
+    data.append(static_cast<const char*>(bytes), size);
+}
+
+void CheckpointWriter::write(bool value) { write(static_cast<int>(value)); }
+
+void CheckpointWriter::write(int value) {
+    auto v = static_cast<int32_t>(value);
+    writeBytes(&v, sizeof(v));
+}
+
+void CheckpointWriter::write(double value) {
+    writeBytes(&value, sizeof(value));
+}
+
+void CheckpointWriter::write(const string& value) {
+    write(static_cast<int>(value.size()));
+    writeBytes(value.data(), value.size());
+}
+
+void CheckpointWriter::write(const SimTK::Vector& value) {
+    write(value.size());
+    for (int i = 0; i < value.size(); ++i) write(value[i]);
+}
+
+void CheckpointWriter::write(const SimTK::Matrix& value) {
+    write(value.nrow());
+    write(value.ncol());
+    for (int i = 0; i < value.nrow(); ++i) {
+        for (int j = 0; j < value.ncol(); ++j) write(value[i][j]);
+    }
+}
+
+/*******************************************************************************/
+
+CheckpointReader::CheckpointReader(const string& data)
+        : data(data), position(0) {}
+
+void CheckpointReader::readBytes(void* bytes, size_t size) {
+    if (position + size > data.size()) {
+        THROW_EXCEPTION("checkpoint data are exhausted");
+    }
+    memcpy(bytes, data.data() + position, size);
+    position += size;
+}
+
+void CheckpointReader::read(bool& value) {
+    int v;
+    read(v);
+    value = v != 0;
+}
+
+void CheckpointReader::read(int& value) {
+    int32_t v;
+    readBytes(&v, sizeof(v));
+    value = v;
+}
+
+void CheckpointReader::read(double& value) {
+    readBytes(&value, sizeof(value));
+}
+
+void CheckpointReader::read(string& value) {
+    int size;
+    read(size);
+    if (size < 0) THROW_EXCEPTION("corrupted checkpoint");
+    value.resize(size);
+    if (size > 0) readBytes(&value[0], size);
+}
+
+void CheckpointReader::read(SimTK::Vector& value) {
+    int size;
+    read(size);
+    if (size < 0) THROW_EXCEPTION("corrupted checkpoint");
+    value.resize(size);
+    for (int i = 0; i < size; ++i) read(value[i]);
+}
+
+void CheckpointReader::read(SimTK::Matrix& value) {
+    int nrow, ncol;
+    read(nrow);
+    read(ncol);
+    if (nrow < 0 || ncol < 0) THROW_EXCEPTION("corrupted checkpoint");
+    value.resize(nrow, ncol);
+    for (int i = 0; i < nrow; ++i) {
+        for (int j = 0; j < ncol; ++j) read(value[i][j]);
+    }
+}
+
+/*******************************************************************************/
+
+Checkpointer::Checkpointer(const string& fileName, double interval)
+        : fileName(fileName), interval(interval), isStarted(false),
+          isClosing(false), numCheckpoints(0) {
+    if (interval <= 0) THROW_EXCEPTION("checkpoint interval must be positive");
+}
+
+Checkpointer::~Checkpointer() { close(); }
+
+int Checkpointer::addSection(const string& name) {
+    if (isStarted) THROW_EXCEPTION("sections must be added before start()");
+    names.push_back(name);
+    sections.push_back(unique_ptr<TripleBuffer<string>>(
+            new TripleBuffer<string>()));
+    return sections.size() - 1;
+}
+
+void Checkpointer::start() {
+    if (isStarted) THROW_EXCEPTION("checkpointer is already started");
+    isStarted = true;
+    writerThread = thread(&Checkpointer::run, this);
+}
+
+void Checkpointer::update(int section, const string& data) {
+    sections.at(section)->write(data);
+}
+
+void Checkpointer::close() {
+    if (!isStarted || isClosing.exchange(true)) return;
+    writerThread.join();
+}
+
+uint64_t Checkpointer::getNumCheckpoints() const {
+    return numCheckpoints.load();
+}
+
+void Checkpointer::writeUpdates() {
+    bool isUpdated = false;
+    for (auto& section : sections) isUpdated |= section->update();
+    if (!isUpdated) return;
+
+    // sections that have not been updated yet are omitted
+    map<string, string> latest;
+    for (int i = 0; i < sections.size(); ++i) {
+        if (sections[i]->getVersion() > 0) {
+            latest[names[i]] = sections[i]->read();
+        }
+    }
+    save(fileName, latest);
+    numCheckpoints++;
+}
+
+void Checkpointer::run() {
+    auto lastCheckpoint = chrono::steady_clock::now();
+    auto period = chrono::duration<double>(interval);
+    while (!isClosing.load()) {
+        this_thread::sleep_for(chrono::milliseconds(10));
+        if (chrono::steady_clock::now() - lastCheckpoint < period) continue;
+        lastCheckpoint = chrono::steady_clock::now();
+        try {
+            writeUpdates();
+        } catch (const std::exception& e) {
+            // a failed checkpoint does not stop the analysis
+            cout << "warning: " << e.what() << endl;
+        }
+    }
+
+    // latest state at shutdown
+    try {
+        writeUpdates();
+    } catch (const std::exception& e) {
+        cout << "warning: " << e.what() << endl;
+    }
+}
+
+void Checkpointer::save(const string& fileName,
+                        const map<string, string>& sections) {
+    // the previous checkpoint is replaced only if the new one is complete
+    auto temporaryFileName = fileName + ".tmp";
+    FILE* file = fopen(temporaryFileName.c_str(), "wb");
+    if (!file) THROW_EXCEPTION("cannot open " + temporaryFileName);
+    CheckpointWriter writer;
+    writer.write(static_cast<int>(sections.size()));
+    for (const auto& section : sections) {
+        writer.write(section.first);
+        writer.write(section.second);
+    }
+    const auto& data = writer.getData();
+    bool isWritten = fwrite(magic, 1, 8, file) == 8 &&
+                     fwrite(&version, sizeof(version), 1, file) == 1 &&
+                     fwrite(data.data(), 1, data.size(), file) == data.size();
+    fflush(file);
+#ifdef _WIN32
+    _commit(_fileno(file));
+#else
+    fsync(fileno(file));
+#endif
+    fclose(file);
+    if (!isWritten) THROW_EXCEPTION("cannot write " + temporaryFileName);
+#ifdef _WIN32
+    remove(fileName.c_str()); // rename does not replace files on Windows
+#endif
+    if (rename(temporaryFileName.c_str(), fileName.c_str()) != 0) {
+        THROW_EXCEPTION("cannot replace " + fileName);
+    }
+}
+
+map<string, string> Checkpointer::load(const string& fileName) {
+    FILE* file = fopen(fileName.c_str(), "rb");
+    if (!file) THROW_EXCEPTION("cannot open " + fileName);
+    char header[8];
+    uint32_t fileVersion = 0;
+    bool isValid = fread(header, 1, 8, file) == 8 &&
+                   memcmp(header, magic, 8) == 0 &&
+                   fread(&fileVersion, sizeof(fileVersion), 1, file) == 1 &&
+                   fileVersion == version;
+    string data;
+    char buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.append(buffer, n);
+    }
+    fclose(file);
+    if (!isValid) THROW_EXCEPTION(fileName + " is not a checkpoint");
+
+    CheckpointReader reader(data);
+    int numSections;
+    reader.read(numSections);
+    map<string, string> sections;
+    for (int i = 0; i < numSections; ++i) {
+        string name, section;
+        reader.read(name);
+        reader.read(section);
+        sections[name] = section;
+    }
+    return sections;
+}
@@ -0,0 +1,111 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ */
+#include "ClockModel.h"
+#include "Exception.h"
+#include <cmath>
+
+using namespace std;
+using namespace OpenSimRT;
+
+/*******************************************************************************/
+
+ClockModel::ClockModel(const Parameters& parameters)
+        : parameters(parameters) {
+    if (parameters.forgettingFactor <= 0 || parameters.forgettingFactor > 1) {
+        THROW_EXCEPTION("forgetting factor must be in (0, 1]");
+    }
+    if (parameters.skewDeviation <= 0 || parameters.latencyDeviation <= 0 ||
+        parameters.outlierThreshold <= 0) {
+        THROW_EXCEPTION("deviations and outlier threshold must be positive");
+    }
+    reset();
+}
+
+void ClockModel::reset() {
+    restart();
+    numOutliers = 0;
+}
+
+void ClockModel::restart() {
+    deviceReference = 0;
+    hostReference = 0;
+    latestDeviceTime = 0;
+
+    // the rate is close to one, while the offset is determined by the first
+    // sample (the covariance is relative to the variance of the latency)
+    const double variance =
+            parameters.latencyDeviation * parameters.latencyDeviation;
+    theta[0] = 0;
+    theta[1] = 1;
+    P[0][0] = 1 / variance;
+    P[0][1] = P[1][0] = 0;
+    P[1][1] = parameters.skewDeviation * parameters.skewDeviation / variance;
+
+    numSamples = 0;
+    consecutiveOutliers = 0;
+}
+
+double ClockModel::update(double deviceTime, double hostTime) {
+    if (numSamples == 0) {
+        deviceReference = deviceTime;
+        hostReference = hostTime;
+    }
+    latestDeviceTime = deviceTime;
+    const double x[2] = {1, deviceTime - deviceReference};
+    const double y = hostTime - hostReference;
+    const double residual = y - (theta[0] + theta[1] * x[1]);
+
+    // samples that were delayed are not used
+    if (numSamples > 0 && abs(residual) > parameters.outlierThreshold) {
+        numOutliers++;
+        if (++consecutiveOutliers >= parameters.maximumOutliers) {
+            // the device clock was reset (e.g., new /time command)
+            restart();
+            return update(deviceTime, hostTime);
+        }
+        return toHostTime(deviceTime);
+    }
+    consecutiveOutliers = 0;
+
+    // recursive least squares with forgetting factor
+    const double lambda = parameters.forgettingFactor;
+    const double Px[2] = {P[0][0] * x[0] + P[0][1] * x[1],
+                          P[1][0] * x[0] + P[1][1] * x[1]};
+    const double denominator = lambda + x[0] * Px[0] + x[1] * Px[1];
+    const double k[2] = {Px[0] / denominator, Px[1] / denominator};
+    theta[0] += k[0] * residual;
+    theta[1] += k[1] * residual;
+    for (int i = 0; i < 2; ++i) {
+        for (int j = 0; j < 2; ++j) {
+            P[i][j] = (P[i][j] - k[i] * Px[j]) / lambda;
+        }
+    }
+    P[0][1] = P[1][0] = 0.5 * (P[0][1] + P[1][0]); // keep symmetric
+    numSamples++;
+    return toHostTime(deviceTime);
+}
+
+double ClockModel::toHostTime(double deviceTime) const {
+    return hostReference + theta[0] + theta[1] * (deviceTime - deviceReference);
+}
+
+double ClockModel::getOffset() const {
+    return toHostTime(latestDeviceTime) - latestDeviceTime;
+}
@@ -0,0 +1,126 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ */
+#include "FrameArena.h"
+#include "Exception.h"
+#include <algorithm>
+#include <atomic>
+
+using namespace std;
+using namespace OpenSimRT;
+
+/*******************************************************************************/
+
+FrameArena::FrameArena(size_t capacity)
+        : current(0), offset(0), usedBefore(0), peakUsed(0) {
+    if (capacity == 0) THROW_EXCEPTION("capacity must be positive");
+    blocks.push_back(createBlock(capacity));
+}
+
+FrameArena::Block FrameArena::createBlock(size_t size) {
+    return {unique_ptr<char[]>(new char[size]), size};
+}
+
+void* FrameArena::allocate(size_t size, size_t alignment) {
+    if (alignment == 0 || (alignment & (alignment - 1)) != 0) {
+        THROW_EXCEPTION("alignment must be a power of two");
+    }
+    while (true) {
+        auto base = reinterpret_cast<uintptr_t>(blocks[current].data.get());
+        auto blockSize = blocks[current].size;
+        auto aligned = (base + offset + alignment - 1) & ~(alignment - 1);
+        auto end = aligned - base;
+        if (end <= blockSize && size <= blockSize - end) {
+            offset = end + size;
+            peakUsed = max(peakUsed, usedBefore + offset);
+            return reinterpret_cast<void*>(aligned);
+        }
+
+        // continue in the next block, inserting a new one if the next is
+        // missing or too small (the later blocks are kept for other frames)
+        auto required = size + alignment;
+        if (current + 1 == blocks.size()) {
+            blocks.push_back(createBlock(max(2 * blockSize, required)));
+        } else if (blocks[current + 1].size < required) {
+            blocks.insert(blocks.begin() + current + 1,
+                          createBlock(max(2 * blockSize, required)));
+        }
+        usedBefore += blockSize;
+        current++;
+        offset = 0;
+    }
+}
+
+void FrameArena::rewind(const Marker& marker) {
+    if (marker.block > current ||
+        (marker.block == current && marker.offset > offset)) {
+        THROW_EXCEPTION("marker is after the current position");
+    }
+    while (current > marker.block) {
+        current--;
+        usedBefore -= blocks[current].size;
+    }
+    offset = marker.offset;
+}
+
+size_t FrameArena::getUsed() const { return usedBefore + offset; }
+
+size_t FrameArena::getCapacity() const {
+    size_t capacity = 0;
+    for (const auto& block : blocks) capacity += block.size;
+    return capacity;
+}
+
+/*******************************************************************************/
+
+namespace {
+
+atomic<size_t> arenaCapacity{64 * 1024};
+
+struct ThreadContext {
+    FrameArena arena;
+    uint64_t frameNumber;
+
+    ThreadContext() : arena(arenaCapacity.load()), frameNumber(0) {}
+};
+
+// created on first use by each thread and destroyed at its exit
+ThreadContext& getThreadContext() {
+    thread_local ThreadContext context;
+    return context;
+}
+
+} // namespace
+
+FrameArena& FrameContext::getArena() { return getThreadContext().arena; }
+
+void FrameContext::beginFrame() {
+    auto& context = getThreadContext();
+    context.arena.reset();
+    context.frameNumber++;
+}
+
+uint64_t FrameContext::getFrameNumber() {
+    return getThreadContext().frameNumber;
+}
+
+void FrameContext::setArenaCapacity(size_t bytes) {
+    if (bytes == 0) THROW_EXCEPTION("capacity must be positive");
+    arenaCapacity = bytes;
+}
@@ -0,0 +1,87 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ */
+#include "LoadGovernor.h"
+#include "Exception.h"
+
+using namespace std;
+using namespace OpenSimRT;
+
+/*******************************************************************************/
+
+LoadGovernor::LoadGovernor(const Parameters& parameters)
+        : parameters(parameters) {
+    if (parameters.maximumLevel < 0) {
+        THROW_EXCEPTION("maximum level must be non-negative");
+    }
+    if (parameters.recoverThreshold <= 0 ||
+        parameters.recoverThreshold >= parameters.degradeThreshold) {
+        THROW_EXCEPTION("recover threshold must be positive and smaller than "
+                        "the degrade threshold");
+    }
+    if (parameters.smoothingFactor <= 0 || parameters.smoothingFactor > 1) {
+        THROW_EXCEPTION("smoothing factor must be in (0, 1]");
+    }
+    reset();
+}
+
+void LoadGovernor::reset() {
+    level = 0;
+    averageLatency = -1;
+    framesWithHeadroom = 0;
+    framesSinceTransition = 0;
+    numTransitions = 0;
+}
+
+int LoadGovernor::update(double latency, double period) {
+    // the period is unknown (e.g., first frame)
+    if (!(period > 0)) return level;
+
+    // the average is re-initialized after a transition, since the latency of
+    // the previous level is not representative
+    if (averageLatency < 0) {
+        averageLatency = latency;
+    } else {
+        averageLatency += parameters.smoothingFactor *
+                          (latency - averageLatency);
+    }
+    if (++framesSinceTransition <= parameters.holdFrames) return level;
+
+    if (averageLatency > parameters.degradeThreshold * period) {
+        framesWithHeadroom = 0;
+        if (level < parameters.maximumLevel) setLevel(level + 1);
+    } else if (averageLatency < parameters.recoverThreshold * period) {
+        if (++framesWithHeadroom >= parameters.recoveryFrames && level > 0) {
+            setLevel(level - 1);
+        }
+    } else {
+        framesWithHeadroom = 0;
+    }
+    return level;
+}
+
+void LoadGovernor::setLevel(int newLevel) {
+    level = newLevel;
+    averageLatency = -1;
+    framesWithHeadroom = 0;
+    framesSinceTransition = 0;
+    numTransitions++;
+}
+
+/*******************************************************************************/
@@ -0,0 +1,430 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ */
+#include "MultilayerPerceptron.h"
+#include "Exception.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <numeric>
+#include <random>
+#include <sstream>
+
+#if defined(__AVX__) && defined(__FMA__)
+#    include <immintrin.h>
+#endif
+
+using namespace std;
+using namespace SimTK;
+using namespace OpenSimRT;
+
+/*******************************************************************************/
+
+string activationToString(const MultilayerPerceptron::Activation& a) {
+    switch (a) {
+    case MultilayerPerceptron::Activation::ReLU: return "relu";
+    case MultilayerPerceptron::Activation::Tanh: return "tanh";
+    default: return "linear";
+    }
+}
+
+MultilayerPerceptron::Activation activationFromString(const string& name) {
+    if (name == "relu") return MultilayerPerceptron::Activation::ReLU;
+    if (name == "tanh") return MultilayerPerceptron::Activation::Tanh;
+    if (name == "linear") return MultilayerPerceptron::Activation::Linear;
+    THROW_EXCEPTION("unsupported activation: " + name);
+}
+
+// apply activation function in-place
+void activate(vector<double>& a, const MultilayerPerceptron::Activation& f) {
+    switch (f) {
+    case MultilayerPerceptron::Activation::ReLU:
+        for (auto& x : a) x = (x > 0.0) ? x : 0.0;
+        break;
+    case MultilayerPerceptron::Activation::Tanh:
+        for (auto& x : a) x = std::tanh(x);
+        break;
+    default: break;
+    }
+}
+
+// derivative of the activation function expressed by its output
+double activationDerivative(double a,
+                            const MultilayerPerceptron::Activation& f) {
+    switch (f) {
+    case MultilayerPerceptron::Activation::ReLU: return (a > 0.0) ? 1.0 : 0.0;
+    case MultilayerPerceptron::Activation::Tanh: return 1.0 - a * a;
+    default: return 1.0;
+    }
+}
+
+// read a vector of known size from a stream preceded by a label
+vector<double> readLabeledVector(istream& in, const string& label, int size) {
+    string token;
+    in >> token;
+    if (token != label) THROW_EXCEPTION("expected " + label + " got " + token);
+    vector<double> v(size);
+    for (auto& x : v) in >> x;
+    return v;
+}
+
+void writeLabeledVector(ostream& out, const string& label,
+                        const vector<double>& v) {
+    out << label;
+    for (const auto& x : v) out << " " << x;
+    out << "\n";
+}
+
+/*******************************************************************************/
+
+MultilayerPerceptron::MultilayerPerceptron(const vector<int>& layerSizes,
+                                           Activation hiddenActivation,
+                                           Activation outputActivation,
+                                           unsigned int seed) {
+    if (layerSizes.size() < 2)
+        THROW_EXCEPTION("at least input and output size must be provided");
+
+    mt19937 generator(seed);
+    for (size_t l = 0; l + 1 < layerSizes.size(); ++l) {
+        Layer layer;
+        layer.inputSize = layerSizes[l];
+        layer.outputSize = layerSizes[l + 1];
+        layer.activation = (l + 2 == layerSizes.size()) ? outputActivation
+                                                        : hiddenActivation;
+        // He initialization for ReLU and Xavier otherwise
+        double gain = (layer.activation == Activation::ReLU) ? 2.0 : 1.0;
+        normal_distribution<double> distribution(
+                0.0, std::sqrt(gain / layer.inputSize));
+        layer.W.resize(layer.inputSize * layer.outputSize);
+        for (auto& w : layer.W) w = distribution(generator);
+        layer.b.assign(layer.outputSize, 0.0);
+        layers.push_back(layer);
+    }
+
+    inputMean.assign(getInputSize(), 0.0);
+    inputStd.assign(getInputSize(), 1.0);
+    outputMean.assign(getOutputSize(), 0.0);
+    outputStd.assign(getOutputSize(), 1.0);
+    allocateBuffers();
+}
+
+MultilayerPerceptron::MultilayerPerceptron(const string& fileName) {
+    ifstream in(fileName);
+    if (!in.is_open()) THROW_EXCEPTION("cannot open file: " + fileName);
+
+    string header;
+    int version;
+    in >> header >> version;
+    if (header != "OpenSimRT_MLP" || version != 1)
+        THROW_EXCEPTION("unsupported network file: " + fileName);
+
+    // normalization statistics are written before the layers, but their size
+    // is known only from the layers, thus store the lines and parse later
+    vector<string> statistics(4);
+    for (auto& line : statistics) {
+        in >> ws;
+        getline(in, line);
+    }
+
+    string token;
+    int numLayers;
+    in >> token >> numLayers;
+    if (token != "layers") THROW_EXCEPTION("expected layers got " + token);
+    for (int l = 0; l < numLayers; ++l) {
+        Layer layer;
+        string activation;
+        in >> token >> layer.inputSize >> layer.outputSize >> activation;
+        if (token != "layer") THROW_EXCEPTION("expected layer got " + token);
+        layer.activation = activationFromString(activation);
+        layer.W.resize(layer.inputSize * layer.outputSize);
+        layer.b.resize(layer.outputSize);
+        for (auto& w : layer.W) in >> w;
+        for (auto& b : layer.b) in >> b;
+        if (l > 0 && layers.back().outputSize != layer.inputSize)
+            THROW_EXCEPTION("inconsistent layer sizes");
+        layers.push_back(layer);
+    }
+    if (!in) THROW_EXCEPTION("corrupted network file: " + fileName);
+
+    istringstream inputMeanStream(statistics[0]), inputStdStream(statistics[1]),
+            outputMeanStream(statistics[2]), outputStdStream(statistics[3]);
+    inputMean =
+            readLabeledVector(inputMeanStream, "input_mean", getInputSize());
+    inputStd = readLabeledVector(inputStdStream, "input_std", getInputSize());
+    outputMean =
+            readLabeledVector(outputMeanStream, "output_mean", getOutputSize());
+    outputStd =
+            readLabeledVector(outputStdStream, "output_std", getOutputSize());
+    allocateBuffers();
+}
+
+void MultilayerPerceptron::save(const string& fileName) const {
+    ofstream out(fileName);
+    if (!out.is_open()) THROW_EXCEPTION("cannot open file: " + fileName);
+    out << setprecision(17);
+    out << "OpenSimRT_MLP 1\n";
+    writeLabeledVector(out, "input_mean", inputMean);
+    writeLabeledVector(out, "input_std", inputStd);
+    writeLabeledVector(out, "output_mean", outputMean);
+    writeLabeledVector(out, "output_std", outputStd);
+    out << "layers " << layers.size() << "\n";
+    for (const auto& layer : layers) {
+        out << "layer " << layer.inputSize << " " << layer.outputSize << " "
+            << activationToString(layer.activation) << "\n";
+        for (int r = 0; r < layer.outputSize; ++r) {
+            for (int c = 0; c < layer.inputSize; ++c) {
+                out << layer.W[r * layer.inputSize + c]
+                    << ((c + 1 < layer.inputSize) ? " " : "\n");
+            }
+        }
+        for (int r = 0; r < layer.outputSize; ++r) {
+            out << layer.b[r] << ((r + 1 < layer.outputSize) ? " " : "\n");
+        }
+    }
+}
+
+int MultilayerPerceptron::getInputSize() const {
+    return layers.empty() ? 0 : layers.front().inputSize;
+}
+
+int MultilayerPerceptron::getOutputSize() const {
+    return layers.empty() ? 0 : layers.back().outputSize;
+}
+
+const vector<MultilayerPerceptron::Layer>&
+MultilayerPerceptron::getLayers() const {
+    return layers;
+}
+
+void MultilayerPerceptron::allocateBuffers() {
+    activations.resize(layers.size() + 1);
+    activations[0].resize(getInputSize());
+    for (size_t l = 0; l < layers.size(); ++l) {
+        activations[l + 1].resize(layers[l].outputSize);
+    }
+}
+
+void MultilayerPerceptron::evaluate(const Vector& x, Vector& y) {
+    if (x.size() != getInputSize()) {
+        THROW_EXCEPTION("wrong input size " + to_string(x.size()) +
+                        " != " + to_string(getInputSize()));
+    }
+
+    // normalize input
+    auto& a = activations[0];
+    for (int i = 0; i < x.size(); ++i) {
+        a[i] = (x[i] - inputMean[i]) / inputStd[i];
+    }
+
+    // forward pass
+    for (size_t l = 0; l < layers.size(); ++l) {
+        const auto& layer = layers[l];
+        gemv(layer.W.data(), activations[l].data(), layer.b.data(),
+             activations[l + 1].data(), layer.outputSize, layer.inputSize);
+        activate(activations[l + 1], layer.activation);
+    }
+
+    // de-normalize output
+    const auto& out = activations.back();
+    if (y.size() != getOutputSize()) y.resize(getOutputSize());
+    for (int i = 0; i < y.size(); ++i) {
+        y[i] = out[i] * outputStd[i] + outputMean[i];
+    }
+}
+
+Vector MultilayerPerceptron::evaluate(const Vector& x) {
+    Vector y(getOutputSize());
+    evaluate(x, y);
+    return y;
+}
+
+void MultilayerPerceptron::gemv(const double* W, const double* x,
+                                const double* b, double* y, int rows,
+                                int cols) {
+    for (int r = 0; r < rows; ++r) {
+        const double* w = W + r * cols;
+        int c = 0;
+#if defined(__AVX__) && defined(__FMA__)
+        __m256d acc0 = _mm256_setzero_pd();
+        __m256d acc1 = _mm256_setzero_pd();
+        for (; c + 8 <= cols; c += 8) {
+            acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(w + c),
+                                   _mm256_loadu_pd(x + c), acc0);
+            acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(w + c + 4),
+                                   _mm256_loadu_pd(x + c + 4), acc1);
+        }
+        double lanes[4];
+        _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+        double sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
+        // independent accumulators allow the compiler to vectorize the loop
+        double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+        for (; c + 4 <= cols; c += 4) {
+            s0 += w[c] * x[c];
+            s1 += w[c + 1] * x[c + 1];
+            s2 += w[c + 2] * x[c + 2];
+            s3 += w[c + 3] * x[c + 3];
+        }
+        double sum = (s0 + s1) + (s2 + s3);
+#endif
+        for (; c < cols; ++c) sum += w[c] * x[c];
+        y[r] = sum + b[r];
+    }
+}
+
+double MultilayerPerceptron::fit(const Matrix& X, const Matrix& Y,
+                                 const TrainingParameters& parameters) {
+    const int N = X.nrow();
+    const int n = getInputSize();
+    const int m = getOutputSize();
+    if (Y.nrow() != N || X.ncol() != n || Y.ncol() != m)
+        THROW_EXCEPTION("training data dimensions do not agree with network");
+    if (N == 0) THROW_EXCEPTION("empty training data");
+
+    // normalization statistics (constant columns are not scaled)
+    auto computeStatistics = [&](const Matrix& A, vector<double>& mean,
+                                 vector<double>& std) {
+        mean.assign(A.ncol(), 0.0);
+        std.assign(A.ncol(), 0.0);
+        for (int j = 0; j < A.ncol(); ++j) {
+            for (int i = 0; i < A.nrow(); ++i) mean[j] += A[i][j];
+            mean[j] /= A.nrow();
+            for (int i = 0; i < A.nrow(); ++i)
+                std[j] += pow(A[i][j] - mean[j], 2);
+            std[j] = sqrt(std[j] / A.nrow());
+            if (std[j] < 1e-8) std[j] = 1.0;
+        }
+    };
+    computeStatistics(X, inputMean, inputStd);
+    computeStatistics(Y, outputMean, outputStd);
+
+    // normalized data in row-major order
+    vector<double> Xn(N * n), Yn(N * m);
+    for (int i = 0; i < N; ++i) {
+        for (int j = 0; j < n; ++j)
+            Xn[i * n + j] = (X[i][j] - inputMean[j]) / inputStd[j];
+        for (int j = 0; j < m; ++j)
+            Yn[i * m + j] = (Y[i][j] - outputMean[j]) / outputStd[j];
+    }
+
+    // gradients and Adam moments
+    const double beta1 = 0.9, beta2 = 0.999, epsilon = 1e-8;
+    const size_t L = layers.size();
+    vector<vector<double>> gW(L), gb(L), mW(L), vW(L), mb(L), vb(L), delta(L);
+    for (size_t l = 0; l < L; ++l) {
+        gW[l].assign(layers[l].W.size(), 0.0);
+        mW[l].assign(layers[l].W.size(), 0.0);
+        vW[l].assign(layers[l].W.size(), 0.0);
+        gb[l].assign(layers[l].b.size(), 0.0);
+        mb[l].assign(layers[l].b.size(), 0.0);
+        vb[l].assign(layers[l].b.size(), 0.0);
+        delta[l].assign(layers[l].outputSize, 0.0);
+    }
+
+    vector<int> indices(N);
+    iota(indices.begin(), indices.end(), 0);
+    mt19937 generator(parameters.seed);
+    const int batchSize = max(1, min(parameters.batchSize, N));
+    int step = 0;
+    double loss = 0.0;
+    for (int epoch = 0; epoch < parameters.epochs; ++epoch) {
+        shuffle(indices.begin(), indices.end(), generator);
+        loss = 0.0;
+        for (int begin = 0; begin < N; begin += batchSize) {
+            int end = min(begin + batchSize, N);
+            for (size_t l = 0; l < L; ++l) {
+                fill(gW[l].begin(), gW[l].end(), 0.0);
+                fill(gb[l].begin(), gb[l].end(), 0.0);
+            }
+
+            // accumulate gradients
+            for (int k = begin; k < end; ++k) {
+                const double* xk = &Xn[indices[k] * n];
+                const double* yk = &Yn[indices[k] * m];
+
+                // forward
+                copy(xk, xk + n, activations[0].begin());
+                for (size_t l = 0; l < L; ++l) {
+                    gemv(layers[l].W.data(), activations[l].data(),
+                         layers[l].b.data(), activations[l + 1].data(),
+                         layers[l].outputSize, layers[l].inputSize);
+                    activate(activations[l + 1], layers[l].activation);
+                }
+
+                // output error (mean squared error)
+                const auto& out = activations.back();
+                for (int j = 0; j < m; ++j) {
+                    double e = out[j] - yk[j];
+                    loss += e * e / m;
+                    delta[L - 1][j] = 2.0 * e / m *
+                                      activationDerivative(
+                                              out[j], layers[L - 1].activation);
+                }
+
+                // backward
+                for (int l = L - 1; l >= 0; --l) {
+                    const auto& layer = layers[l];
+                    const auto& aPrev = activations[l];
+                    for (int r = 0; r < layer.outputSize; ++r) {
+                        double d = delta[l][r];
+                        gb[l][r] += d;
+                        double* g = &gW[l][r * layer.inputSize];
+                        for (int c = 0; c < layer.inputSize; ++c)
+                            g[c] += d * aPrev[c];
+                    }
+                    if (l == 0) break;
+                    for (int c = 0; c < layer.inputSize; ++c) {
+                        double sum = 0.0;
+                        for (int r = 0; r < layer.outputSize; ++r)
+                            sum += layer.W[r * layer.inputSize + c] *
+                                   delta[l][r];
+                        const auto& f = layers[l - 1].activation;
+                        delta[l - 1][c] =
+                                sum * activationDerivative(aPrev[c], f);
+                    }
+                }
+            }
+
+            // Adam update
+            ++step;
+            const double scale = 1.0 / (end - begin);
+            const double c1 = 1.0 - pow(beta1, step);
+            const double c2 = 1.0 - pow(beta2, step);
+            auto update = [&](vector<double>& w, const vector<double>& g,
+                              vector<double>& mt, vector<double>& vt) {
+                for (size_t i = 0; i < w.size(); ++i) {
+                    double gi = g[i] * scale;
+                    mt[i] = beta1 * mt[i] + (1.0 - beta1) * gi;
+                    vt[i] = beta2 * vt[i] + (1.0 - beta2) * gi * gi;
+                    w[i] -= parameters.learningRate * (mt[i] / c1) /
+                            (sqrt(vt[i] / c2) + epsilon);
+                }
+            };
+            for (size_t l = 0; l < L; ++l) {
+                update(layers[l].W, gW[l], mW[l], vW[l]);
+                update(layers[l].b, gb[l], mb[l], vb[l]);
+            }
+        }
+        loss /= N;
+    }
+    return loss;
+}
+
+/*******************************************************************************/
@@ -18,8 +18,12 @@
  * -----------------------------------------------------------------------------
  */
 #include "OpenSimUtils.h"
+#include "BinaryLogger.h"
 #include "DynamicLibraryLoader.h"
+#include "TimeSeriesStore.h"
 #include <Common/TimeSeriesTable.h>
+#include <OpenSim/Common/CSVFileAdapter.h>
+#include <OpenSim/Common/STOFileAdapter.h>
 
 using OpenSim::Actuator;
 using OpenSim::Model;
@@ -167,6 +171,60 @@ OpenSimUtils::getMomentArmFromDynamicLibrary(const Model& model,
     return calcMomentArm;
 }
 
+vector<std::pair<string, TimeSeriesTable>>
+OpenSimUtils::readBinaryLog(const string& logFilePath) {
+    int index;
+    double t;
+    vector<double> values;
+
+    // the records of each table are counted first, so that the rows are
+    // collected in stores of fixed capacity instead of tables that reallocate
+    // on every appended row
+    vector<size_t> numRecords;
+    {
+        BinaryLogReader reader(logFilePath);
+        numRecords.resize(reader.getNumTables(), 0);
+        while (reader.next(index, t, values)) numRecords[index]++;
+    }
+
+    BinaryLogReader reader(logFilePath);
+    vector<TimeSeriesStore> stores;
+    for (int i = 0; i < reader.getNumTables(); ++i) {
+        stores.emplace_back(reader.getColumnLabels(i), numRecords[i]);
+    }
+    while (reader.next(index, t, values)) {
+        auto& store = stores[index];
+        auto n = store.getNumRows();
+        // rows with repeated time (e.g., held results) are skipped, since the
+        // time of a TimeSeriesTable must be increasing, as well as rows that
+        // were logged after counting
+        if (n > 0 && store.getTime(n - 1) >= t) continue;
+        if (n == store.getCapacity()) continue;
+        store.appendRow(t, values);
+    }
+
+    vector<std::pair<string, TimeSeriesTable>> tables;
+    for (int i = 0; i < reader.getNumTables(); ++i) {
+        tables.push_back({reader.getTableName(i), stores[i].toTable()});
+    }
+    return tables;
+}
+
+void OpenSimUtils::convertBinaryLog(const string& logFilePath,
+                                    const string& outputPrefix,
+                                    const string& extension) {
+    for (const auto& table : readBinaryLog(logFilePath)) {
+        auto fileName = outputPrefix + table.first + extension;
+        if (extension == ".sto") {
+            OpenSim::STOFileAdapter::write(table.second, fileName);
+        } else if (extension == ".csv") {
+            OpenSim::CSVFileAdapter::write(table.second, fileName);
+        } else {
+            THROW_EXCEPTION("unsupported file extension " + extension);
+        }
+    }
+}
+
 void OpenSimUtils::updateState(const OpenSim::Model& model, SimTK::State& state,
                                const SimTK::Vector& q,
                                const SimTK::Vector& qDot) {
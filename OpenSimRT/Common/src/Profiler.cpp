@@ -0,0 +1,218 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ */
+#include "Profiler.h"
+#include "Exception.h"
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace OpenSimRT;
+
+/*******************************************************************************/
+
+namespace {
+
+struct Event {
+    const char* name;
+    Profiler::Ticks start;
+    Profiler::Ticks duration;
+    double value;
+    bool isCounter;
+};
+
+// written only by the owning thread; the size is published after the event
+struct ThreadBuffer {
+    int id;
+    string name;
+    size_t capacity;
+    unique_ptr<Event[]> events;
+    atomic<size_t> size{0};
+    atomic<size_t> numDropped{0};
+};
+
+struct Registry {
+    mutex monitor; // guards the list of buffers and the thread names
+    vector<unique_ptr<ThreadBuffer>> buffers;
+    atomic<bool> enabled{true};
+    atomic<size_t> capacity{65536};
+    // reference for the conversion of ticks to time
+    Profiler::Ticks startTicks;
+    chrono::steady_clock::time_point startTime;
+
+    Registry()
+            : startTicks(Profiler::now()),
+              startTime(chrono::steady_clock::now()) {}
+};
+
+// not destroyed at exit, since detached threads may still record
+Registry& getRegistry() {
+    static auto registry = new Registry();
+    return *registry;
+}
+
+thread_local ThreadBuffer* threadBuffer = nullptr;
+
+// the buffer is allocated once per thread, thus recording does not lock
+ThreadBuffer& getThreadBuffer() {
+    if (!threadBuffer) {
+        auto& registry = getRegistry();
+        lock_guard<mutex> lock(registry.monitor);
+        auto buffer = make_unique<ThreadBuffer>();
+        buffer->id = static_cast<int>(registry.buffers.size()) + 1;
+        buffer->name = "thread " + to_string(buffer->id);
+        buffer->capacity = registry.capacity.load();
+        buffer->events.reset(new Event[buffer->capacity]);
+        threadBuffer = buffer.get();
+        registry.buffers.push_back(move(buffer));
+    }
+    return *threadBuffer;
+}
+
+void record(const Event& event) {
+    if (!getRegistry().enabled.load(memory_order_relaxed)) return;
+    auto& buffer = getThreadBuffer();
+    const auto size = buffer.size.load(memory_order_relaxed);
+    if (size == buffer.capacity) {
+        buffer.numDropped.fetch_add(1, memory_order_relaxed);
+        return;
+    }
+    buffer.events[size] = event;
+    buffer.size.store(size + 1, memory_order_release);
+}
+
+string escape(const string& text) {
+    string result;
+    for (const auto& c : text) {
+        if (c == '"' || c == '\\') result += '\\';
+        result += c;
+    }
+    return result;
+}
+
+} // namespace
+
+/*******************************************************************************/
+
+void Profiler::setEnabled(bool enabled) { getRegistry().enabled = enabled; }
+
+bool Profiler::isEnabled() { return getRegistry().enabled; }
+
+void Profiler::setCapacity(size_t numEvents) {
+    if (numEvents == 0) THROW_EXCEPTION("capacity must be positive");
+    getRegistry().capacity = numEvents;
+}
+
+void Profiler::setThreadName(const string& name) {
+    auto& buffer = getThreadBuffer();
+    lock_guard<mutex> lock(getRegistry().monitor);
+    buffer.name = name;
+}
+
+void Profiler::recordZone(const char* name, Ticks start, Ticks end) {
+    record({name, start, end - start, 0, false});
+}
+
+void Profiler::recordCounter(const char* name, double value) {
+    record({name, now(), 0, value, true});
+}
+
+size_t Profiler::getNumEvents() {
+    auto& registry = getRegistry();
+    lock_guard<mutex> lock(registry.monitor);
+    size_t numEvents = 0;
+    for (const auto& buffer : registry.buffers) {
+        numEvents += buffer->size.load(memory_order_acquire);
+    }
+    return numEvents;
+}
+
+size_t Profiler::getNumDropped() {
+    auto& registry = getRegistry();
+    lock_guard<mutex> lock(registry.monitor);
+    size_t numDropped = 0;
+    for (const auto& buffer : registry.buffers) {
+        numDropped += buffer->numDropped.load(memory_order_relaxed);
+    }
+    return numDropped;
+}
+
+void Profiler::clear() {
+    auto& registry = getRegistry();
+    lock_guard<mutex> lock(registry.monitor);
+    for (auto& buffer : registry.buffers) {
+        buffer->size = 0;
+        buffer->numDropped = 0;
+    }
+}
+
+void Profiler::exportChromeTrace(const string& fileName) {
+    auto& registry = getRegistry();
+
+    // calibrate the rate of the ticks over at least 10ms
+    const auto minimumDuration = chrono::milliseconds(10);
+    auto elapsed = chrono::steady_clock::now() - registry.startTime;
+    if (elapsed < minimumDuration) {
+        this_thread::sleep_for(minimumDuration - elapsed);
+    }
+    const auto ticks = now();
+    elapsed = chrono::steady_clock::now() - registry.startTime;
+    const double ticksPerMicrosecond =
+            (ticks - registry.startTicks) /
+            chrono::duration<double, micro>(elapsed).count();
+    auto toMicroseconds = [&](Ticks t) {
+        return (static_cast<double>(t) - registry.startTicks) /
+               ticksPerMicrosecond;
+    };
+
+    ofstream file(fileName);
+    if (!file.is_open()) THROW_EXCEPTION("cannot open file " + fileName);
+    file << fixed << setprecision(3);
+    file << "{\n  \"displayTimeUnit\": \"ns\",\n  \"traceEvents\": [";
+    lock_guard<mutex> lock(registry.monitor);
+    bool isFirst = true;
+    for (const auto& buffer : registry.buffers) {
+        file << (isFirst ? "" : ",")
+             << "\n    {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, "
+             << "\"tid\": " << buffer->id << ", \"args\": {\"name\": \""
+             << escape(buffer->name) << "\"}}";
+        isFirst = false;
+        const auto size = buffer->size.load(memory_order_acquire);
+        for (size_t i = 0; i < size; ++i) {
+            const auto& event = buffer->events[i];
+            file << ",\n    {\"name\": \"" << escape(event.name) << "\", ";
+            if (event.isCounter) {
+                file << "\"ph\": \"C\", \"ts\": " << toMicroseconds(event.start)
+                     << ", \"pid\": 1, \"tid\": " << buffer->id
+                     << ", \"args\": {\"value\": " << event.value << "}}";
+            } else {
+                file << "\"cat\": \"zone\", \"ph\": \"X\", \"ts\": "
+                     << toMicroseconds(event.start)
+                     << ", \"dur\": " << event.duration / ticksPerMicrosecond
+                     << ", \"pid\": 1, \"tid\": " << buffer->id << "}";
+            }
+        }
+    }
+    file << "\n  ]\n}\n";
+}
@@ -18,7 +18,9 @@
  * -----------------------------------------------------------------------------
  */
 #include "SignalProcessing.h"
+#include "Checkpoint.h"
 #include "Exception.h"
+#include "Profiler.h"
 #include "Utils.h"
 #include <SimTKcommon/Scalar.h>
 #include <SimTKcommon/internal/BigMatrix.h>
@@ -111,34 +113,56 @@ LowPassSmoothFilter::LowPassSmoothFilter(const Parameters& parameters)
 
     time = Matrix(1, parameters.memory, 0.0);
     data = Matrix(parameters.numSignals, parameters.memory, 0.0);
+    xRaw.resize(parameters.memory);
+    xFiltered.resize(parameters.memory);
+    splineTime = Vector(1, 0.0);
+    firstDerivative = {0};
+    secondDerivative = {0, 0};
 }
 
 LowPassSmoothFilter::Output
 LowPassSmoothFilter::filter(const LowPassSmoothFilter::Input& input) {
-    // shift data column left and set last column as the new data
-    shiftColumnsLeft(Vector(1, input.t), time);
-    shiftColumnsLeft(input.x, data);
+    Output output;
+    filter(input, output);
+    return output;
+}
 
+void LowPassSmoothFilter::filter(const LowPassSmoothFilter::Input& input,
+                                 LowPassSmoothFilter::Output& output) {
+    PROFILE_ZONE("LowPassSmoothFilter::filter");
     // initialize variables
     int N = parameters.numSignals;
     int M = parameters.memory;
     int D = parameters.delay;
-    double dt = time[0][M - 1] - time[0][M - 2];
-    double dtPrev = time[0][M - 2] - time[0][M - 3];
+    if (input.x.size() != N) {
+        THROW_EXCEPTION("input has " + toString(input.x.size()) +
+                        " signals instead of " + toString(N));
+    }
+
+    // shift data column left and set last column as the new data (element
+    // access, since the column views of SimTK allocate)
+    for (int j = 1; j < M; ++j) {
+        time(0, j - 1) = time(0, j);
+        for (int i = 0; i < N; ++i) data(i, j - 1) = data(i, j);
+    }
+    time(0, M - 1) = input.t;
+    for (int i = 0; i < N; ++i) data(i, M - 1) = input.x[i];
+
+    double dt = time(0, M - 1) - time(0, M - 2);
+    double dtPrev = time(0, M - 2) - time(0, M - 3);
 
     // output
-    Output output;
-    output.t = time[0][M - D - 1];
-    output.x = Vector(N);
-    output.xDot = Vector(N);
-    output.xDDot = Vector(N);
+    output.t = time(0, M - D - 1);
+    output.x.resize(N);
+    output.xDot.resize(N);
+    output.xDDot.resize(N);
     output.isValid = true;
 
     // check if initialized
     if (initializationCounter > 0) {
         initializationCounter--;
         output.isValid = false;
-        return output;
+        return;
     }
 
     // check if dt is consistent
@@ -147,37 +171,68 @@ LowPassSmoothFilter::filter(const LowPassSmoothFilter::Input& input) {
     }
 
     // filter
+    splineTime[0] = output.t;
     for (int i = 0; i < N; i++) {
         // get raw signal
-        double* xRaw = new double[M];
-        double* xFiltered = new double[M];
-        for (int j = 0; j < M; j++) { xRaw[j] = data[i][j]; }
+        for (int j = 0; j < M; j++) { xRaw[j] = data(i, j); }
 
         // apply a low pass filter; O = M / 2 is used for the order of the FIR
         // filter, because internally the filter performs a convolution over
         // [-O, O] = 2 M / 2 = M.
         OpenSim::Signal::LowpassFIR(parameters.memory / 2, dt,
-                                    parameters.cutoffFrequency, M, xRaw,
-                                    xFiltered);
+                                    parameters.cutoffFrequency, M, &xRaw[0],
+                                    &xFiltered[0]);
 
         // calculate smooth splines
         if (parameters.calculateDerivatives) {
-            OpenSim::GCVSpline spline(parameters.splineOrder, M, &time[0][0],
-                                      xFiltered);
-            output.x[i] = spline.calcValue(Vector(1, output.t));
-            output.xDot[i] = spline.calcDerivative({0}, Vector(1, output.t));
+            OpenSim::GCVSpline spline(parameters.splineOrder, M, &time(0, 0),
+                                      &xFiltered[0]);
+            output.x[i] = spline.calcValue(splineTime);
+            output.xDot[i] = spline.calcDerivative(firstDerivative, splineTime);
             output.xDDot[i] =
-                    spline.calcDerivative({0, 0}, Vector(1, output.t));
+                    spline.calcDerivative(secondDerivative, splineTime);
         } else {
             output.x[i] = xFiltered[M - D - 1];
         }
+    }
+}
 
-        // free allocated memory
-        delete[] xRaw;
-        delete[] xFiltered;
+void LowPassSmoothFilter::saveState(CheckpointWriter& writer) const {
+    writer.write(time);
+    writer.write(data);
+    writer.write(initializationCounter);
+}
+
+void LowPassSmoothFilter::loadState(CheckpointReader& reader) {
+    Matrix checkpointTime, checkpointData;
+    int checkpointCounter;
+    reader.read(checkpointTime);
+    reader.read(checkpointData);
+    reader.read(checkpointCounter);
+    if (checkpointTime.ncol() != time.ncol() ||
+        checkpointData.nrow() != data.nrow() ||
+        checkpointData.ncol() != data.ncol()) {
+        THROW_EXCEPTION("checkpoint does not match the filter parameters");
     }
+    time = checkpointTime;
+    data = checkpointData;
+    initializationCounter = checkpointCounter;
+}
 
-    return output;
+bool LowPassSmoothFilter::isContinuousWith(double t) const {
+    // the sampling period is defined after two samples
+    int M = parameters.memory;
+    if (initializationCounter > M - 3) return true;
+    double dt = time[0][M - 1] - time[0][M - 2];
+    return abs(t - time[0][M - 1] - dt) <= 1e-5;
+}
+
+void LowPassSmoothFilter::alignWith(double t) {
+    int M = parameters.memory;
+    if (initializationCounter > M - 3) return;
+    double dt = time[0][M - 1] - time[0][M - 2];
+    double offset = t - dt - time[0][M - 1];
+    for (int j = 0; j < M; ++j) time[0][j] += offset;
 }
 
 /******************************************************************************/
@@ -188,6 +243,7 @@ StateSpaceFilter::StateSpaceFilter(const Parameters& parameters)
                        Vector(nc, 0.0), Vector(nc, 0.0), false}) {}
 
 StateSpaceFilter::Output StateSpaceFilter::filter(const Input& input) {
+    PROFILE_ZONE("StateSpaceFilter::filter");
     double t = input.t - 0.07; // compensate for filter lag
     Vector x(nc, &input.x[0]); // we copy because vector is transposed
     if (t < state.t) {
@@ -229,6 +285,7 @@ IIRFilter::IIRFilter(int n, const Vector& aa, const Vector& bb,
 }
 
 Vector IIRFilter::filter(const Vector& xn) {
+    PROFILE_ZONE("IIRFilter::filter");
     if (xn.size() != n) {
         THROW_EXCEPTION("input has incorrect dimensions " +
                         toString(xn.size()) + " != " + toString(n));
@@ -378,6 +435,7 @@ FIRFilter::FIRFilter(int n, const Vector& b, InitialValuePolicy policy)
         : n(n), b(b), m(b.size()), X(n, b.size(), 0.0), iv(policy) {}
 
 Vector FIRFilter::filter(const Vector& xn) {
+    PROFILE_ZONE("FIRFilter::filter");
     if (xn.size() != n) {
         THROW_EXCEPTION("input has incorrect dimensions " +
                         toString(xn.size()) + " !=" + toString(n));
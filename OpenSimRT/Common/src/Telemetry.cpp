@@ -0,0 +1,209 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ */
+#include "Telemetry.h"
+#include "Exception.h"
+#include <cmath>
+#include <fstream>
+#include <limits>
+
+using namespace std;
+using namespace OpenSimRT;
+
+/*******************************************************************************/
+
+Histogram::Histogram()
+        : buckets(new atomic<uint64_t>[numBuckets]), count(0), sum(0),
+          min(numeric_limits<uint64_t>::max()), max(0) {
+    for (int i = 0; i < numBuckets; ++i) buckets[i] = 0;
+}
+
+int Histogram::bucketIndex(uint64_t value) {
+    const uint64_t subBuckets = 1 << subBucketBits;
+    if (value < 2 * subBuckets) return static_cast<int>(value);
+
+    // position of the most significant bit
+    int msb = 0;
+    for (uint64_t v = value; v > 1; v >>= 1) msb++;
+
+    // the subBucketBits + 1 most significant bits select the bucket
+    int shift = msb - subBucketBits;
+    return ((msb - subBucketBits) << subBucketBits) +
+           static_cast<int>(value >> shift);
+}
+
+uint64_t Histogram::bucketUpperBound(int index) {
+    const int subBuckets = 1 << subBucketBits;
+    if (index < 2 * subBuckets) return index;
+    int msb = (index >> subBucketBits) + subBucketBits - 1;
+    uint64_t subBucket = (index & (subBuckets - 1)) + subBuckets;
+    int shift = msb - subBucketBits;
+    return ((subBucket + 1) << shift) - 1;
+}
+
+void Histogram::record(uint64_t value) {
+    // single writer, thus relaxed read-modify-write is sufficient
+    buckets[bucketIndex(value)].fetch_add(1, memory_order_relaxed);
+    sum.fetch_add(value, memory_order_relaxed);
+    if (value < min.load(memory_order_relaxed)) {
+        min.store(value, memory_order_relaxed);
+    }
+    if (value > max.load(memory_order_relaxed)) {
+        max.store(value, memory_order_relaxed);
+    }
+    count.fetch_add(1, memory_order_release);
+}
+
+void Histogram::reset() {
+    for (int i = 0; i < numBuckets; ++i) buckets[i] = 0;
+    count = 0;
+    sum = 0;
+    min = numeric_limits<uint64_t>::max();
+    max = 0;
+}
+
+uint64_t Histogram::getCount() const {
+    return count.load(memory_order_acquire);
+}
+
+uint64_t Histogram::getMin() const { return getCount() ? min.load() : 0; }
+
+uint64_t Histogram::getMax() const { return max.load(); }
+
+double Histogram::getMean() const {
+    auto n = getCount();
+    return n ? static_cast<double>(sum.load()) / n : 0.0;
+}
+
+uint64_t Histogram::getPercentile(double p) const {
+    // the count is recomputed from the buckets, since they may be updated
+    // while reading
+    uint64_t total = 0;
+    for (int i = 0; i < numBuckets; ++i) {
+        total += buckets[i].load(memory_order_relaxed);
+    }
+    if (total == 0) return 0;
+
+    p = std::min(std::max(p, 0.0), 100.0);
+    auto target = std::max<uint64_t>(
+            1, static_cast<uint64_t>(ceil(p / 100.0 * total)));
+    uint64_t cumulative = 0;
+    for (int i = 0; i < numBuckets; ++i) {
+        cumulative += buckets[i].load(memory_order_relaxed);
+        if (cumulative >= target) {
+            return std::min(bucketUpperBound(i), getMax());
+        }
+    }
+    return getMax();
+}
+
+/*******************************************************************************/
+
+Telemetry::Telemetry() : startTime(Clock::now()) {}
+
+Histogram& Telemetry::addLatencyHistogram(const string& name) {
+    entries.push_back(
+            {name, "us", 1e-3, unique_ptr<Histogram>(new Histogram())});
+    return *entries.back().histogram;
+}
+
+Histogram& Telemetry::addHistogram(const string& name, const string& unit) {
+    entries.push_back(
+            {name, unit, 1.0, unique_ptr<Histogram>(new Histogram())});
+    return *entries.back().histogram;
+}
+
+void Telemetry::addCounter(const string& name, const CounterFunction& counter) {
+    counters.push_back({name, counter});
+}
+
+Telemetry::Snapshot Telemetry::getSnapshot() const {
+    Snapshot snapshot;
+    snapshot.duration =
+            chrono::duration<double>(Clock::now() - startTime).count();
+    for (const auto& entry : entries) {
+        const auto& h = *entry.histogram;
+        const auto& s = entry.scale;
+        snapshot.histograms.push_back(
+                {entry.name, entry.unit, h.getCount(), s * h.getMin(),
+                 s * h.getMean(), s * h.getPercentile(50),
+                 s * h.getPercentile(90), s * h.getPercentile(99),
+                 s * h.getPercentile(99.9), s * h.getMax()});
+    }
+    for (const auto& counter : counters) {
+        snapshot.counters.push_back({counter.first, counter.second()});
+    }
+    return snapshot;
+}
+
+void Telemetry::reset() {
+    for (auto& entry : entries) entry.histogram->reset();
+    startTime = Clock::now();
+}
+
+void Telemetry::exportCSV(const string& fileName) const {
+    ofstream file(fileName);
+    if (!file.is_open()) THROW_EXCEPTION("cannot open file " + fileName);
+    auto snapshot = getSnapshot();
+    file << "name,unit,count,min,mean,p50,p90,p99,p99.9,max\n";
+    for (const auto& h : snapshot.histograms) {
+        file << h.name << "," << h.unit << "," << h.count << "," << h.min
+             << "," << h.mean << "," << h.p50 << "," << h.p90 << "," << h.p99
+             << "," << h.p999 << "," << h.max << "\n";
+    }
+    for (const auto& c : snapshot.counters) {
+        file << c.name << ",," << c.value << ",,,,,,,\n";
+    }
+}
+
+void Telemetry::exportJSON(const string& fileName) const {
+    ofstream file(fileName);
+    if (!file.is_open()) THROW_EXCEPTION("cannot open file " + fileName);
+    auto snapshot = getSnapshot();
+    file << "{\n  \"duration\": " << snapshot.duration << ",\n";
+    file << "  \"histograms\": [";
+    for (int i = 0; i < snapshot.histograms.size(); ++i) {
+        const auto& h = snapshot.histograms[i];
+        file << (i ? "," : "") << "\n    {\"name\": \"" << h.name
+             << "\", \"unit\": \"" << h.unit << "\", \"count\": " << h.count
+             << ", \"min\": " << h.min << ", \"mean\": " << h.mean
+             << ", \"p50\": " << h.p50 << ", \"p90\": " << h.p90
+             << ", \"p99\": " << h.p99 << ", \"p99.9\": " << h.p999
+             << ", \"max\": " << h.max << "}";
+    }
+    file << "\n  ],\n  \"counters\": {";
+    for (int i = 0; i < snapshot.counters.size(); ++i) {
+        const auto& c = snapshot.counters[i];
+        file << (i ? "," : "") << "\n    \"" << c.name << "\": " << c.value;
+    }
+    file << "\n  }\n}\n";
+}
+
+void Telemetry::exportFile(const string& fileName) const {
+    auto extension = fileName.substr(fileName.find_last_of('.') + 1);
+    if (extension == "json") {
+        exportJSON(fileName);
+    } else if (extension == "csv") {
+        exportCSV(fileName);
+    } else {
+        THROW_EXCEPTION("unsupported telemetry file format " + extension);
+    }
+}
+
+/*******************************************************************************/
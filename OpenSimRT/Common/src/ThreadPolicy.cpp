@@ -0,0 +1,173 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ */
+#include "ThreadPolicy.h"
+#include "Exception.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#ifdef __linux__
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+using namespace OpenSimRT;
+
+/*******************************************************************************/
+
+bool ThreadPolicy::isDefault() const { return cpus.empty() && priority == 0; }
+
+bool ThreadPolicy::apply() const {
+    if (priority < 0 || priority > 99) {
+        THROW_EXCEPTION(
+                "SCHED_FIFO priority must be in [0, 99] (0: SCHED_OTHER)");
+    }
+    if (isDefault()) return true;
+#ifdef __linux__
+    bool success = true;
+    auto self = pthread_self();
+    if (!cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (const auto& cpu : cpus) CPU_SET(cpu, &set);
+        int error = pthread_setaffinity_np(self, sizeof(set), &set);
+        if (error) {
+            cout << "warning: cannot set thread affinity: " << strerror(error)
+                 << endl;
+            success = false;
+        }
+    }
+    if (priority > 0) {
+        sched_param parameters;
+        parameters.sched_priority = priority;
+        int error = pthread_setschedparam(self, SCHED_FIFO, &parameters);
+        if (error) {
+            cout << "warning: cannot set SCHED_FIFO priority " << priority
+                 << ": " << strerror(error) << endl;
+            success = false;
+        }
+    }
+    return success;
+#else
+    cout << "warning: thread policies are supported only on Linux" << endl;
+    return false;
+#endif
+}
+
+/*******************************************************************************/
+
+vector<int> OpenSimRT::cpuSetFromString(const string& cpus) {
+    vector<int> set;
+    istringstream stream(cpus);
+    string token;
+    while (getline(stream, token, ',')) {
+        // trim white space
+        auto begin = token.find_first_not_of(" \t");
+        if (begin == string::npos) continue;
+        token = token.substr(begin, token.find_last_not_of(" \t") - begin + 1);
+        if (token == "*") return {};
+
+        try {
+            auto dash = token.find('-');
+            int first = stoi(token.substr(0, dash));
+            int last = dash == string::npos ? first
+                                            : stoi(token.substr(dash + 1));
+            if (first < 0 || last < first) throw invalid_argument(token);
+            for (int cpu = first; cpu <= last; ++cpu) set.push_back(cpu);
+        } catch (const logic_error&) {
+            THROW_EXCEPTION("invalid cpu set " + cpus);
+        }
+    }
+    return set;
+}
+
+vector<ThreadPolicy>
+OpenSimRT::threadPoliciesFromString(const string& cpus,
+                                    const string& priorities) {
+    auto split = [](const string& s) {
+        vector<string> tokens;
+        istringstream stream(s);
+        string token;
+        while (getline(stream, token, '|')) tokens.push_back(token);
+        if (tokens.empty()) tokens.push_back("");
+        return tokens;
+    };
+    auto cpuTokens = split(cpus);
+    auto priorityTokens = split(priorities);
+    if (cpuTokens.size() != 1 && priorityTokens.size() != 1 &&
+        cpuTokens.size() != priorityTokens.size()) {
+        THROW_EXCEPTION("cpu sets and priorities of different threads");
+    }
+
+    vector<ThreadPolicy> policies(max(cpuTokens.size(), priorityTokens.size()));
+    for (int i = 0; i < policies.size(); ++i) {
+        const auto& c = cpuTokens[cpuTokens.size() == 1 ? 0 : i];
+        const auto& p = priorityTokens[priorityTokens.size() == 1 ? 0 : i];
+        policies[i].cpus = cpuSetFromString(c);
+        istringstream stream(p);
+        if (!(stream >> policies[i].priority)) policies[i].priority = 0;
+        if (policies[i].priority < 0 || policies[i].priority > 99) {
+            THROW_EXCEPTION(
+                    "SCHED_FIFO priority must be in [0, 99] (0: SCHED_OTHER)");
+        }
+    }
+    return policies;
+}
+
+/*******************************************************************************/
+
+bool OpenSimRT::lockMemory(size_t prefaultHeapSize) {
+#ifdef __linux__
+    if (mlockall(MCL_CURRENT | MCL_FUTURE)) {
+        cout << "warning: cannot lock memory: " << strerror(errno) << endl;
+        return false;
+    }
+    if (prefaultHeapSize == 0) return true;
+
+    // keep the freed memory in the heap instead of returning it to the
+    // operating system, and serve large allocations from the heap
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+
+    // touch every page, so that it is mapped (and locked) now
+    auto buffer = static_cast<volatile char*>(malloc(prefaultHeapSize));
+    if (!buffer) {
+        cout << "warning: cannot prefault " << prefaultHeapSize
+             << " bytes of heap" << endl;
+        return false;
+    }
+    const long pageSize = sysconf(_SC_PAGESIZE);
+    for (size_t i = 0; i < prefaultHeapSize; i += pageSize) buffer[i] = 0;
+    free(const_cast<char*>(buffer));
+    return true;
+#else
+    cout << "warning: memory locking is supported only on Linux" << endl;
+    return false;
+#endif
+}
+
+/*******************************************************************************/
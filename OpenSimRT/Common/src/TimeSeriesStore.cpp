@@ -0,0 +1,308 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ */
+#include "TimeSeriesStore.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+using namespace OpenSimRT;
+
+static const char magic[8] = "OSRTTSS";
+static const uint32_t version = 1;
+
+/*******************************************************************************/
+
+struct TimeSeriesStore::Mapping {
+    char* base = nullptr;
+    size_t size = 0;
+    unique_ptr<uint64_t[]> memory; // buffer of a store that is in memory
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE fileMapping = nullptr;
+#else
+    int file = -1;
+#endif
+
+    bool map(size_t bufferSize, bool writable) {
+        size = bufferSize;
+#ifdef _WIN32
+        ULARGE_INTEGER s;
+        s.QuadPart = bufferSize;
+        fileMapping = CreateFileMappingA(
+                file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+                s.HighPart, s.LowPart, nullptr);
+        if (!fileMapping) return false;
+        base = static_cast<char*>(
+                MapViewOfFile(fileMapping,
+                              writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0,
+                              bufferSize));
+#else
+        void* p = mmap(nullptr, bufferSize,
+                       writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                       MAP_SHARED, file, 0);
+        base = p == MAP_FAILED ? nullptr : static_cast<char*>(p);
+#endif
+        return base != nullptr;
+    }
+
+    ~Mapping() {
+#ifdef _WIN32
+        if (base && !memory) UnmapViewOfFile(base);
+        if (fileMapping) CloseHandle(fileMapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+        if (base && !memory) munmap(base, size);
+        if (file >= 0) close(file);
+#endif
+    }
+};
+
+TimeSeriesStore::TimeSeriesStore(const vector<string>& columnLabels,
+                                 size_t capacity, const string& fileName)
+        : fileName(fileName), columnLabels(columnLabels),
+          mapping(new Mapping()), header(nullptr), data(nullptr),
+          capacity(capacity), numColumns(columnLabels.size()),
+          isWritable(true) {
+    size_t labelsSize = 0;
+    for (const auto& label : columnLabels) {
+        labelsSize += sizeof(uint32_t) + label.size();
+    }
+    size_t dataOffset = (sizeof(Header) + labelsSize + 63) / 64 * 64;
+    createBuffer(dataOffset + (numColumns + 1) * capacity * sizeof(double));
+
+    // header and labels
+    header = reinterpret_cast<Header*>(mapping->base);
+    memcpy(header->magic, magic, sizeof(magic));
+    header->version = version;
+    header->numColumns = numColumns;
+    header->capacity = capacity;
+    header->numRows = 0;
+    header->dataOffset = dataOffset;
+    char* p = mapping->base + sizeof(Header);
+    for (const auto& label : columnLabels) {
+        uint32_t length = label.size();
+        memcpy(p, &length, sizeof(length));
+        memcpy(p + sizeof(length), label.data(), length);
+        p += sizeof(length) + length;
+    }
+    data = reinterpret_cast<double*>(mapping->base + dataOffset);
+}
+
+TimeSeriesStore::TimeSeriesStore(const string& fileName)
+        : fileName(fileName), mapping(new Mapping()), header(nullptr),
+          data(nullptr), capacity(0), numColumns(0), isWritable(true) {
+    // the file is mapped read-only if it is not writable
+    size_t size = 0;
+#ifdef _WIN32
+    auto& file = mapping->file;
+    file = CreateFileA(fileName.c_str(), GENERIC_READ | GENERIC_WRITE,
+                       FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                       FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        isWritable = false;
+        file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                           nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                           nullptr);
+    }
+    LARGE_INTEGER fileSize;
+    if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize)) {
+        THROW_EXCEPTION("cannot open " + fileName);
+    }
+    size = fileSize.QuadPart;
+#else
+    auto& file = mapping->file;
+    file = open(fileName.c_str(), O_RDWR);
+    if (file < 0) {
+        isWritable = false;
+        file = open(fileName.c_str(), O_RDONLY);
+    }
+    struct stat status;
+    if (file < 0 || fstat(file, &status) != 0) {
+        THROW_EXCEPTION("cannot open " + fileName);
+    }
+    size = status.st_size;
+#endif
+    if (size < sizeof(Header) || !mapping->map(size, isWritable)) {
+        THROW_EXCEPTION(fileName + " is not a time series store");
+    }
+
+    // validate the header against the size of the file
+    header = reinterpret_cast<Header*>(mapping->base);
+    const uint64_t maxValues = size / sizeof(double);
+    const uint64_t numSeries = uint64_t(header->numColumns) + 1; // and time
+    if (memcmp(header->magic, magic, sizeof(magic)) != 0 ||
+        header->version != version || header->dataOffset < sizeof(Header) ||
+        header->dataOffset > size ||
+        header->dataOffset % sizeof(double) != 0 ||
+        header->numRows > header->capacity ||
+        header->capacity > maxValues / numSeries ||
+        header->dataOffset + numSeries * header->capacity * sizeof(double) >
+                size) {
+        THROW_EXCEPTION(fileName + " is not a valid time series store");
+    }
+    capacity = header->capacity;
+    numColumns = header->numColumns;
+
+    // labels
+    const char* p = mapping->base + sizeof(Header);
+    const char* end = mapping->base + header->dataOffset;
+    for (int j = 0; j < numColumns; ++j) {
+        uint32_t length;
+        if (static_cast<size_t>(end - p) < sizeof(length)) {
+            THROW_EXCEPTION("corrupted labels");
+        }
+        memcpy(&length, p, sizeof(length));
+        p += sizeof(length);
+        if (static_cast<size_t>(end - p) < length) {
+            THROW_EXCEPTION("corrupted labels");
+        }
+        columnLabels.emplace_back(p, length);
+        p += length;
+    }
+    data = reinterpret_cast<double*>(mapping->base + header->dataOffset);
+}
+
+TimeSeriesStore::~TimeSeriesStore() = default;
+
+TimeSeriesStore::TimeSeriesStore(TimeSeriesStore&& other) noexcept
+        : fileName(move(other.fileName)),
+          columnLabels(move(other.columnLabels)),
+          mapping(move(other.mapping)), header(other.header), data(other.data),
+          capacity(other.capacity), numColumns(other.numColumns),
+          isWritable(other.isWritable) {
+    other.header = nullptr;
+    other.data = nullptr;
+    other.capacity = 0;
+    other.numColumns = 0;
+}
+
+TimeSeriesStore& TimeSeriesStore::operator=(TimeSeriesStore&& other) noexcept {
+    if (this != &other) {
+        fileName = move(other.fileName);
+        columnLabels = move(other.columnLabels);
+        mapping = move(other.mapping);
+        header = other.header;
+        data = other.data;
+        capacity = other.capacity;
+        numColumns = other.numColumns;
+        isWritable = other.isWritable;
+        other.header = nullptr;
+        other.data = nullptr;
+        other.capacity = 0;
+        other.numColumns = 0;
+    }
+    return *this;
+}
+
+void TimeSeriesStore::createBuffer(size_t size) {
+    if (fileName.empty()) {
+        mapping->memory.reset(new uint64_t[(size + 7) / 8]());
+        mapping->base = reinterpret_cast<char*>(mapping->memory.get());
+        mapping->size = size;
+        return;
+    }
+#ifdef _WIN32
+    mapping->file = CreateFileA(fileName.c_str(), GENERIC_READ | GENERIC_WRITE,
+                                FILE_SHARE_READ, nullptr, CREATE_ALWAYS,
+                                FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (mapping->file == INVALID_HANDLE_VALUE) {
+        THROW_EXCEPTION("cannot create " + fileName);
+    }
+    // the file is extended by the creation of the mapping
+#else
+    mapping->file = open(fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (mapping->file < 0) THROW_EXCEPTION("cannot create " + fileName);
+    if (ftruncate(mapping->file, size) != 0) {
+        THROW_EXCEPTION("cannot resize " + fileName);
+    }
+#endif
+    if (!mapping->map(size, true)) THROW_EXCEPTION("cannot map " + fileName);
+}
+
+bool TimeSeriesStore::isStoreFile(const string& fileName) {
+    FILE* file = fopen(fileName.c_str(), "rb");
+    if (!file) return false;
+    char header[sizeof(magic)];
+    bool isStore = fread(header, 1, sizeof(header), file) == sizeof(header) &&
+                   memcmp(header, magic, sizeof(magic)) == 0;
+    fclose(file);
+    return isStore;
+}
+
+TimeSeriesStore
+TimeSeriesStore::fromTable(const OpenSim::TimeSeriesTable& table,
+                           const string& fileName) {
+    const auto& times = table.getIndependentColumn();
+    const auto& matrix = table.getMatrix();
+    TimeSeriesStore store(table.getColumnLabels(), times.size(), fileName);
+    // the time of a TimeSeriesTable is increasing, thus the columns are
+    // copied directly
+    auto n = times.size();
+    copy(times.begin(), times.end(), store.data);
+    for (int j = 0; j < store.numColumns; ++j) {
+        auto column = store.data + (j + 1) * n;
+        for (int i = 0; i < n; ++i) column[i] = matrix(i, j);
+    }
+    store.header->numRows = n;
+    return store;
+}
+
+OpenSim::TimeSeriesTable TimeSeriesStore::toTable() const {
+    auto n = getNumRows();
+    if (n == 0) {
+        OpenSim::TimeSeriesTable table;
+        table.setColumnLabels(columnLabels);
+        return table;
+    }
+    SimTK::Matrix matrix(n, numColumns);
+    for (int j = 0; j < numColumns; ++j) {
+        auto column = getColumn(j);
+        for (int i = 0; i < n; ++i) matrix(i, j) = column[i];
+    }
+    auto times = getTimeColumn();
+    return OpenSim::TimeSeriesTable(vector<double>(times.begin(), times.end()),
+                                    matrix, columnLabels);
+}
+
+int TimeSeriesStore::getColumnIndex(const string& label) const {
+    auto it = find(columnLabels.begin(), columnLabels.end(), label);
+    if (it == columnLabels.end()) THROW_EXCEPTION("no column " + label);
+    return distance(columnLabels.begin(), it);
+}
+
+void TimeSeriesStore::flush() {
+    if (fileName.empty()) return;
+#ifdef _WIN32
+    FlushViewOfFile(mapping->base, 0);
+    FlushFileBuffers(mapping->file);
+#else
+    msync(mapping->base, mapping->size, MS_SYNC);
+#endif
+}
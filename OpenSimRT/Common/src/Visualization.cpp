@@ -148,11 +148,10 @@ void BasicModelVisualizer::update(const Vector& q,
 }
 
 void BasicModelVisualizer::updateReactionForceDecorator(
-        const Vector_<SpatialVec>& reactionWrench, const string& reactionOnBody,
+        const SpatialVec& reactionWrench, const string& reactionOnBody,
         ForceDecorator* reactionForceDecorator) {
-    auto bodyIndex = model.getBodySet().getIndex(reactionOnBody, 0);
-    const auto& body = model.getBodySet()[bodyIndex];
-    auto force = -reactionWrench[bodyIndex](1); // mirror force (1)
+    const auto& body = model.getBodySet().get(reactionOnBody);
+    auto force = -reactionWrench[1]; // mirror force (1)
     auto joint = body.findStationLocationInGround(state, Vec3(0));
     reactionForceDecorator->update(joint, force);
 }
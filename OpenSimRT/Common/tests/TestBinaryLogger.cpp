@@ -0,0 +1,190 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestBinaryLogger.cpp
+ *
+ * \brief Logs tables of different widths from a producer thread, reads the
+ * file back and tests that every written row is intact and in order, and that
+ * a truncated record (crash) is ignored. A blocking logger (replay) must not
+ * drop rows.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "BinaryLogger.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+using namespace OpenSimRT;
+
+// value of a column of a row, so that the rows can be verified
+double value(int table, int row, int column) {
+    return 1000.0 * row + 10.0 * column + table;
+}
+
+vector<string> labels(const string& prefix, int n) {
+    vector<string> columnLabels;
+    for (int i = 0; i < n; ++i) columnLabels.push_back(prefix + to_string(i));
+    return columnLabels;
+}
+
+// reads the file and returns the number of valid records
+int verify(const string& fileName, const vector<int>& widths) {
+    BinaryLogReader reader(fileName);
+    if (reader.getNumTables() != widths.size()) {
+        THROW_EXCEPTION("wrong number of tables");
+    }
+    for (int i = 0; i < widths.size(); ++i) {
+        if (reader.getColumnLabels(i) != labels(reader.getTableName(i),
+                                                widths[i])) {
+            THROW_EXCEPTION("wrong column labels");
+        }
+    }
+
+    int numRecords = 0, table;
+    double t;
+    vector<double> values;
+    vector<double> previousTime(widths.size(), -1);
+    while (reader.next(table, t, values)) {
+        if (t <= previousTime[table]) THROW_EXCEPTION("rows out of order");
+        previousTime[table] = t;
+        int row = static_cast<int>(t);
+        for (int j = 0; j < values.size(); ++j) {
+            if (values[j] != value(table, row, j)) {
+                THROW_EXCEPTION("corrupted row");
+            }
+        }
+        numRecords++;
+    }
+    return numRecords;
+}
+
+void run() {
+    const string fileName = "TestBinaryLogger.bin";
+    const vector<int> widths = {3, 92, 0}; // 92 values span several chunks
+    const int numPacedRows = 1000;
+    const int numRows = 20000;
+
+    BinaryLogger logger(fileName, {1024, 0.1});
+    logger.addTable("q", labels("q", widths[0]));
+    logger.addTable("fm", labels("fm", widths[1]));
+    logger.addTable("empty", labels("empty", widths[2]));
+    logger.start();
+
+    // producer, paced (e.g., 1 kHz) and then as fast as possible, so that the
+    // queue overflows
+    vector<vector<double>> rows(widths.size());
+    for (int i = 0; i < widths.size(); ++i) rows[i].resize(widths[i]);
+    auto appendRows = [&](int row) {
+        for (int i = 0; i < widths.size(); ++i) {
+            for (int j = 0; j < widths[i]; ++j) rows[i][j] = value(i, row, j);
+            logger.appendRow(i, row, rows[i]);
+        }
+    };
+    int row = 0;
+    for (; row < numPacedRows; ++row) {
+        appendRows(row);
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    if (logger.getNumDroppedRows() != 0) {
+        THROW_EXCEPTION("rows were dropped at a sustainable rate");
+    }
+    auto start = chrono::steady_clock::now();
+    for (; row < numRows; ++row) appendRows(row);
+    auto duration = chrono::duration<double, micro>(
+                            chrono::steady_clock::now() - start)
+                            .count();
+    logger.close();
+
+    auto written = logger.getNumWrittenRows();
+    auto dropped = logger.getNumDroppedRows();
+    cout << "appendRow: "
+         << duration / ((numRows - numPacedRows) * widths.size()) << " us"
+         << endl;
+    cout << "written: " << written << " dropped: " << dropped << endl;
+    if (written + dropped != numRows * widths.size()) {
+        THROW_EXCEPTION("rows were lost");
+    }
+    if (logger.appendRow(0, numRows, rows[0])) {
+        THROW_EXCEPTION("row appended after close");
+    }
+    if (verify(fileName, widths) != written) {
+        THROW_EXCEPTION("wrong number of records");
+    }
+
+    // a crash in the middle of a record
+    ifstream in(fileName, ios::binary);
+    string content((istreambuf_iterator<char>(in)),
+                   istreambuf_iterator<char>());
+    in.close();
+    ofstream out(fileName, ios::binary | ios::trunc);
+    out.write(content.data(), content.size() - 8);
+    out.close();
+    if (verify(fileName, widths) != written - 1) {
+        THROW_EXCEPTION("truncated record was not ignored");
+    }
+    remove(fileName.c_str());
+}
+
+void runBlocking() {
+    const string fileName = "TestBinaryLoggerBlocking.bin";
+    const vector<int> widths = {3, 92};
+    const int numRows = 20000;
+
+    // small queue, thus the producer outpaces the writer
+    BinaryLogger logger(fileName, {16, 0.1});
+    logger.addTable("q", labels("q", widths[0]));
+    logger.addTable("fm", labels("fm", widths[1]));
+    logger.setOverflowPolicy(OverflowPolicy::BLOCK);
+    logger.start();
+    vector<vector<double>> rows(widths.size());
+    for (int i = 0; i < widths.size(); ++i) rows[i].resize(widths[i]);
+    for (int row = 0; row < numRows; ++row) {
+        for (int i = 0; i < widths.size(); ++i) {
+            for (int j = 0; j < widths[i]; ++j) rows[i][j] = value(i, row, j);
+            if (!logger.appendRow(i, row, rows[i])) {
+                THROW_EXCEPTION("blocking logger dropped a row");
+            }
+        }
+    }
+    logger.close();
+
+    if (logger.getNumDroppedRows() != 0 ||
+        logger.getNumWrittenRows() != numRows * widths.size()) {
+        THROW_EXCEPTION("blocking logger lost rows");
+    }
+    if (verify(fileName, widths) != numRows * widths.size()) {
+        THROW_EXCEPTION("wrong number of records");
+    }
+    remove(fileName.c_str());
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+        runBlocking();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
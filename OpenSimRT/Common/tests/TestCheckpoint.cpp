@@ -0,0 +1,168 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestCheckpoint.cpp
+ *
+ * \brief Checkpoints a LowPassSmoothFilter through a file and tests that the
+ * restored filter produces identical results without refilling its memory,
+ * also when the signal resumes after a gap (restart).
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "Checkpoint.h"
+#include "Exception.h"
+#include "SignalProcessing.h"
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+using namespace std;
+using namespace OpenSimRT;
+
+const double dt = 0.01;
+
+SimTK::Vector signal(double t) {
+    SimTK::Vector x(3);
+    for (int j = 0; j < x.size(); ++j) x[j] = sin(2 * SimTK::Pi * (j + 1) * t);
+    return x;
+}
+
+bool isEqual(const SimTK::Vector& a, const SimTK::Vector& b) {
+    if (a.size() != b.size()) return false;
+    for (int i = 0; i < a.size(); ++i) {
+        if (a[i] != b[i]) return false;
+    }
+    return true;
+}
+
+void testSerialization() {
+    SimTK::Matrix m(2, 3);
+    for (int i = 0; i < m.nrow(); ++i) {
+        for (int j = 0; j < m.ncol(); ++j) m[i][j] = 10 * i + j;
+    }
+    CheckpointWriter writer;
+    writer.write(true);
+    writer.write(-7);
+    writer.write(0.25);
+    writer.write(string("filter"));
+    writer.write(signal(0.1));
+    writer.write(m);
+
+    CheckpointReader reader(writer.getData());
+    bool b;
+    int i;
+    double d;
+    string s;
+    SimTK::Vector v;
+    SimTK::Matrix n;
+    reader.read(b);
+    reader.read(i);
+    reader.read(d);
+    reader.read(s);
+    reader.read(v);
+    reader.read(n);
+    if (!b || i != -7 || d != 0.25 || s != "filter" ||
+        !isEqual(v, signal(0.1)) || n.nrow() != 2 || n.ncol() != 3 ||
+        n[1][2] != 12 || !reader.isEmpty()) {
+        THROW_EXCEPTION("values were not restored");
+    }
+    try {
+        reader.read(i);
+    } catch (const std::exception&) { return; }
+    THROW_EXCEPTION("exhausted checkpoint was not detected");
+}
+
+void testFilter() {
+    const string fileName = "TestCheckpoint.ckpt";
+    LowPassSmoothFilter::Parameters parameters{3, 35, 6, 14, 3, true};
+    LowPassSmoothFilter filter(parameters);
+    const int numSamples = 200, checkpointSample = 100;
+    int i = 0;
+    for (; i < checkpointSample; ++i) filter.filter({i * dt, signal(i * dt)});
+
+    // checkpoint through a file
+    {
+        Checkpointer checkpointer(fileName, 0.1);
+        int section = checkpointer.addSection("filter");
+        checkpointer.start();
+        CheckpointWriter writer;
+        filter.saveState(writer);
+        checkpointer.update(section, writer.getData());
+        checkpointer.close();
+        if (checkpointer.getNumCheckpoints() == 0) {
+            THROW_EXCEPTION("checkpoint was not written");
+        }
+    }
+    auto sections = Checkpointer::load(fileName);
+    remove(fileName.c_str());
+
+    // the restored filter is valid from the first sample
+    LowPassSmoothFilter restored(parameters);
+    CheckpointReader reader(sections.at("filter"));
+    restored.loadState(reader);
+    if (!restored.isContinuousWith(i * dt)) {
+        THROW_EXCEPTION("restored filter is not continuous");
+    }
+    for (; i < numSamples; ++i) {
+        auto expected = filter.filter({i * dt, signal(i * dt)});
+        auto output = restored.filter({i * dt, signal(i * dt)});
+        if (!output.isValid || output.t != expected.t ||
+            !isEqual(output.x, expected.x) ||
+            !isEqual(output.xDot, expected.xDot) ||
+            !isEqual(output.xDDot, expected.xDDot)) {
+            THROW_EXCEPTION("restored filter differs");
+        }
+    }
+
+    // the signal resumes after a gap
+    LowPassSmoothFilter resumed(parameters);
+    CheckpointReader gapReader(sections.at("filter"));
+    resumed.loadState(gapReader);
+    double t = 5.0;
+    if (resumed.isContinuousWith(t)) THROW_EXCEPTION("gap was not detected");
+    resumed.alignWith(t);
+    auto output = resumed.filter({t, signal(checkpointSample * dt)});
+    if (!output.isValid || abs(output.t - (t - parameters.delay * dt)) > 1e-9) {
+        THROW_EXCEPTION("filter was not aligned with the resumed signal");
+    }
+
+    // a filter with different parameters
+    parameters.numSignals = 2;
+    LowPassSmoothFilter other(parameters);
+    CheckpointReader otherReader(sections.at("filter"));
+    try {
+        other.loadState(otherReader);
+    } catch (const std::exception&) { return; }
+    THROW_EXCEPTION("mismatched checkpoint was restored");
+}
+
+void run() {
+    testSerialization();
+    testFilter();
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
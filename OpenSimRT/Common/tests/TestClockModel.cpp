@@ -0,0 +1,108 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestClockModel.cpp
+ *
+ * \brief Simulates devices with different clock offsets and skews that send
+ * samples at 60Hz over a network with random latency for two hours, and tests
+ * that the mapped timestamps of the devices remain synchronized, also after a
+ * Wi-Fi stall and a reset of a device clock.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "ClockModel.h"
+#include "Exception.h"
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace OpenSimRT;
+
+struct Device {
+    double offset; // device time at host time zero
+    double skew;   // relative rate difference
+    double deviceTime(double t) const { return offset + (1 + skew) * t; }
+};
+
+void run() {
+    const double rate = 60, duration = 2 * 3600, meanLatency = 0.003;
+    vector<Device> devices = {{1.0e9, 50e-6}, {1.0e9 + 0.2, -40e-6},
+                              {1.0e9 - 3.1, 0}};
+    vector<ClockModel> clocks(devices.size());
+    mt19937 generator(0);
+    exponential_distribution<double> jitter(1 / (meanLatency - 0.001));
+
+    double maxError = 0, maxRawDrift = 0;
+    const int numSamples = static_cast<int>(duration * rate);
+    for (int i = 0; i < numSamples; ++i) {
+        const double t = i / rate; // sampling instant (host clock)
+
+        // a Wi-Fi stall of 2s delivers the samples in a burst
+        bool isStalled = t > 1800 && t < 1802;
+
+        // the second device clock is reset after one hour
+        if (i == numSamples / 2) devices[1].offset += 5;
+
+        vector<double> mapped;
+        for (size_t d = 0; d < devices.size(); ++d) {
+            double latency = 0.001 + jitter(generator);
+            if (isStalled) latency += 1802 - t;
+            mapped.push_back(
+                    clocks[d].update(devices[d].deviceTime(t), t + latency));
+        }
+        maxRawDrift = max(maxRawDrift, abs(devices[0].deviceTime(t) -
+                                           devices[0].offset - t));
+
+        // after convergence, the timestamps of the devices agree with the
+        // sampling instant (plus the mean latency)
+        if (t < 60 || (i >= numSamples / 2 && i < numSamples / 2 + 3600)) {
+            continue;
+        }
+        for (const auto& m : mapped) {
+            maxError = max(maxError, abs(m - t - meanLatency));
+        }
+    }
+
+    for (size_t d = 0; d < devices.size(); ++d) {
+        cout << "device " << d << ": skew " << clocks[d].getSkew()
+             << " (true " << devices[d].skew << "), outliers "
+             << clocks[d].getNumOutliers() << endl;
+        if (abs(clocks[d].getSkew() - devices[d].skew) > 1e-6) {
+            THROW_EXCEPTION("skew was not estimated");
+        }
+    }
+    cout << "raw drift: " << maxRawDrift << "s, max error: " << maxError << "s"
+         << endl;
+    if (maxError > 0.001) THROW_EXCEPTION("devices are not synchronized");
+    if (clocks[0].getNumOutliers() == 0) {
+        THROW_EXCEPTION("stall was not rejected");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,146 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestFrameArena.cpp
+ *
+ * \brief Tests the alignment, the rewinding and the growth of the frame arena,
+ * and that frames of the same size do not allocate from the heap after the
+ * first frame.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#define OPENSIMRT_ALLOCATION_HOOK
+#include "AllocationCounter.h"
+#include "Exception.h"
+#include "FrameArena.h"
+#include <iostream>
+#include <thread>
+
+using namespace std;
+using namespace OpenSimRT;
+
+struct alignas(64) CacheLine {
+    double x[8];
+};
+
+void testAlignmentAndRewind() {
+    FrameArena arena(256);
+    arena.allocate(1, 1);
+    for (size_t alignment : {2, 8, 16, 64}) {
+        auto p = reinterpret_cast<uintptr_t>(arena.allocate(3, alignment));
+        if (p % alignment != 0) THROW_EXCEPTION("misaligned allocation");
+    }
+    auto line = arena.create<CacheLine>();
+    if (reinterpret_cast<uintptr_t>(line) % alignof(CacheLine) != 0) {
+        THROW_EXCEPTION("misaligned object");
+    }
+
+    // a scope releases its allocations, also from the blocks it added
+    auto used = arena.getUsed();
+    {
+        FrameArena::Scope scope(arena);
+        auto x = arena.allocateArray<double>(1000);
+        for (int i = 0; i < 1000; ++i) {
+            if (x[i] != 0) THROW_EXCEPTION("array is not initialized");
+            x[i] = i;
+        }
+        if (arena.getNumBlocks() < 2) THROW_EXCEPTION("arena did not grow");
+    }
+    if (arena.getUsed() != used) THROW_EXCEPTION("scope was not released");
+    if (arena.getPeakUsed() < used + 1000 * sizeof(double)) {
+        THROW_EXCEPTION("wrong peak usage");
+    }
+
+    arena.reset();
+    if (arena.getUsed() != 0) THROW_EXCEPTION("arena was not reset");
+
+    bool thrown = false;
+    try {
+        arena.allocate(8, 3);
+    } catch (exception&) { thrown = true; }
+    if (!thrown) THROW_EXCEPTION("invalid alignment was accepted");
+}
+
+// a frame with temporaries of different sizes (the last exceeds the first
+// block)
+double processFrame(int frame) {
+    auto& arena = FrameContext::getArena();
+    double sum = 0;
+    for (int n : {10, 100, 1000, 20000}) {
+        FrameArena::Scope scope(arena);
+        ArenaVector<double> x{ArenaAllocator<double>(arena)};
+        x.reserve(n);
+        for (int i = 0; i < n; ++i) x.push_back(frame + i);
+        auto y = arena.allocateArray<int>(n);
+        for (int i = 0; i < n; ++i) sum += x[i] + y[i];
+    }
+    return sum;
+}
+
+void testNoAllocationsAfterWarmUp() {
+    if (!AllocationCounter::isInstalled()) {
+        THROW_EXCEPTION("allocation hook is not installed");
+    }
+    FrameContext::setArenaCapacity(4096);
+
+    // the thread that processes the frames
+    double sum = 0;
+    uint64_t allocations = 0, numFrames = 0;
+    thread worker([&]() {
+        uint64_t before = 0;
+        for (int frame = 0; frame < 100; ++frame) {
+            if (frame == 1) before = AllocationCounter::getThreadAllocations();
+            FrameContext::beginFrame();
+            sum += processFrame(frame);
+        }
+        allocations = AllocationCounter::getThreadAllocations() - before;
+        numFrames = FrameContext::getFrameNumber();
+        const auto& arena = FrameContext::getArena();
+        cout << "arena: " << arena.getCapacity() << " bytes in "
+             << arena.getNumBlocks() << " blocks (peak "
+             << arena.getPeakUsed() << ")" << endl;
+    });
+    worker.join();
+    cout << "allocations after warm-up: " << allocations << endl;
+    if (allocations != 0) THROW_EXCEPTION("frame allocated");
+    if (numFrames != 100) THROW_EXCEPTION("wrong frame number");
+    if (sum == 0) THROW_EXCEPTION("frames were not processed");
+
+    // each thread has its own arena
+    FrameContext::getArena().allocate(128);
+    size_t otherUsed = 1;
+    thread other([&]() { otherUsed = FrameContext::getArena().getUsed(); });
+    other.join();
+    if (otherUsed != 0) THROW_EXCEPTION("arena is shared between threads");
+}
+
+void run() {
+    testAlignmentAndRewind();
+    testNoAllocationsAfterWarmUp();
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
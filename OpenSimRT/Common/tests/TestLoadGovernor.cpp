@@ -0,0 +1,94 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestLoadGovernor.cpp
+ *
+ * \brief Simulates a computation whose cost decreases with the degradation
+ * level and whose load increases temporarily, and tests that the governor
+ * degrades until the latency fits the period and recovers afterwards.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "Exception.h"
+#include "LoadGovernor.h"
+#include <iostream>
+#include <random>
+
+using namespace std;
+using namespace OpenSimRT;
+
+void run() {
+    const double period = 10; // ms
+    // latency of each level under nominal load
+    const double cost[] = {7, 5, 4, 2};
+    LoadGovernor governor({3, 0.9, 0.6, 0.2, 50, 5});
+
+    mt19937 generator(0);
+    normal_distribution<double> noise(0, 0.3);
+    auto simulate = [&](double load, int frames) {
+        int late = 0;
+        for (int i = 0; i < frames; ++i) {
+            double latency =
+                    load * cost[governor.getLevel()] + noise(generator);
+            if (latency > period) late++;
+            governor.update(latency, period);
+        }
+        return late;
+    };
+
+    // nominal load fits the period at full quality
+    simulate(1.0, 500);
+    if (governor.getLevel() != 0) {
+        THROW_EXCEPTION("degraded under nominal load");
+    }
+
+    // doubled load (e.g., a background process) fits only at level 2
+    simulate(2.0, 100);
+    int late = simulate(2.0, 500);
+    cout << "overload level: " << governor.getLevel()
+         << " late frames: " << late << endl;
+    if (governor.getLevel() != 2) {
+        THROW_EXCEPTION("wrong level under overload");
+    }
+    if (late != 0) THROW_EXCEPTION("frames exceed the period in steady state");
+
+    // the load is removed and the full quality is recovered
+    simulate(1.0, 1000);
+    cout << "recovered level: " << governor.getLevel()
+         << " transitions: " << governor.getNumTransitions() << endl;
+    if (governor.getLevel() != 0) THROW_EXCEPTION("did not recover");
+
+    // no oscillation between levels under steady load
+    simulate(2.0, 100);
+    auto steady = governor.getNumTransitions();
+    simulate(2.0, 2000);
+    if (governor.getNumTransitions() != steady) {
+        THROW_EXCEPTION("level oscillates under steady load");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
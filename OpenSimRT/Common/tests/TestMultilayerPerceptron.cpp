@@ -0,0 +1,175 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestMultilayerPerceptron.cpp
+ *
+ * \brief Tests the forward pass of the multilayer perceptron against a
+ * hand-computed network, the matrix-vector product against a naive one, that
+ * training reduces the error on a small synthetic map and that a stored
+ * network is loaded with bit-identical outputs.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "Exception.h"
+#include "MultilayerPerceptron.h"
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+using namespace std;
+using namespace SimTK;
+using namespace OpenSimRT;
+
+typedef MultilayerPerceptron::Activation Activation;
+
+void testForwardPass() {
+    // 2 inputs -> 3 hidden (ReLU) -> 2 outputs (linear)
+    const string fileName = "TestMultilayerPerceptronHand.txt";
+    {
+        ofstream out(fileName);
+        out << "OpenSimRT_MLP 1\n"
+            << "input_mean 1 2\n"
+            << "input_std 2 4\n"
+            << "output_mean 10 -10\n"
+            << "output_std 3 0.5\n"
+            << "layers 2\n"
+            << "layer 2 3 relu\n"
+            << "1 -2\n0.5 0.5\n-1 3\n"
+            << "0.5 -0.25 0\n"
+            << "layer 3 2 linear\n"
+            << "1 2 -1\n0.5 0 4\n"
+            << "0.1 -0.2\n";
+    }
+    MultilayerPerceptron mlp(fileName);
+    remove(fileName.c_str());
+    if (mlp.getInputSize() != 2 || mlp.getOutputSize() != 2 ||
+        mlp.getLayers().size() != 2) {
+        THROW_EXCEPTION("wrong network dimensions");
+    }
+
+    // normalized input (1, 1), hidden relu(-0.5, 0.75, 2) = (0, 0.75, 2),
+    // output (-0.4, 7.8) and de-normalized (-0.4 * 3 + 10, 7.8 * 0.5 - 10)
+    Vector x(2);
+    x[0] = 3;
+    x[1] = 6;
+    auto y = mlp.evaluate(x);
+    if (abs(y[0] - 8.8) > 1e-12 || abs(y[1] + 6.1) > 1e-12) {
+        THROW_EXCEPTION("wrong forward pass");
+    }
+
+    // the output is resized if needed
+    Vector z;
+    mlp.evaluate(x, z);
+    if (z.size() != 2 || z[0] != y[0] || z[1] != y[1]) {
+        THROW_EXCEPTION("wrong forward pass with output argument");
+    }
+}
+
+void testGemv() {
+    // sizes that exercise the vectorized loop and its remainder
+    mt19937 generator(0);
+    uniform_real_distribution<double> uniform(-1.0, 1.0);
+    for (int cols : {1, 3, 4, 8, 13, 19}) {
+        const int rows = 7;
+        vector<double> W(rows * cols), x(cols), b(rows), y(rows);
+        for (auto& w : W) w = uniform(generator);
+        for (auto& v : x) v = uniform(generator);
+        for (auto& v : b) v = uniform(generator);
+        MultilayerPerceptron::gemv(W.data(), x.data(), b.data(), y.data(),
+                                   rows, cols);
+        for (int r = 0; r < rows; ++r) {
+            double expected = b[r];
+            for (int c = 0; c < cols; ++c) expected += W[r * cols + c] * x[c];
+            if (abs(y[r] - expected) > 1e-12) THROW_EXCEPTION("wrong gemv");
+        }
+    }
+}
+
+// mean squared error over the samples and outputs
+double calcError(MultilayerPerceptron& mlp, const Matrix& X, const Matrix& Y) {
+    Vector x(X.ncol()), y;
+    double error = 0.0;
+    for (int i = 0; i < X.nrow(); ++i) {
+        for (int j = 0; j < X.ncol(); ++j) x[j] = X[i][j];
+        mlp.evaluate(x, y);
+        for (int j = 0; j < Y.ncol(); ++j) error += pow(y[j] - Y[i][j], 2);
+    }
+    return error / (X.nrow() * Y.ncol());
+}
+
+void testFitAndSaveLoad() {
+    // y = (sin(2 x0) + x1^2, x0 x1)
+    const int N = 200;
+    mt19937 generator(1);
+    uniform_real_distribution<double> uniform(-1.0, 1.0);
+    Matrix X(N, 2), Y(N, 2);
+    for (int i = 0; i < N; ++i) {
+        X[i][0] = uniform(generator);
+        X[i][1] = uniform(generator);
+        Y[i][0] = sin(2 * X[i][0]) + X[i][1] * X[i][1];
+        Y[i][1] = X[i][0] * X[i][1];
+    }
+
+    MultilayerPerceptron mlp({2, 16, 16, 2}, Activation::Tanh,
+                             Activation::Linear, 1);
+    auto errorBefore = calcError(mlp, X, Y);
+    auto loss = mlp.fit(X, Y, {200, 16, 1e-2, 0});
+    auto errorAfter = calcError(mlp, X, Y);
+    cout << "error before: " << errorBefore << " after: " << errorAfter
+         << " (training loss " << loss << ")" << endl;
+    if (!(errorAfter < 0.1 * errorBefore)) {
+        THROW_EXCEPTION("training did not reduce the error");
+    }
+
+    // 17 significant digits restore the weights exactly
+    const string fileName = "TestMultilayerPerceptron.txt";
+    mlp.save(fileName);
+    MultilayerPerceptron loaded(fileName);
+    remove(fileName.c_str());
+    Vector x(2), y, yLoaded;
+    for (int i = 0; i < N; ++i) {
+        x[0] = X[i][0];
+        x[1] = X[i][1];
+        mlp.evaluate(x, y);
+        loaded.evaluate(x, yLoaded);
+        for (int j = 0; j < 2; ++j) {
+            if (y[j] != yLoaded[j]) {
+                THROW_EXCEPTION("loaded network is not bit-identical");
+            }
+        }
+    }
+}
+
+void run() {
+    testForwardPass();
+    testGemv();
+    testFitAndSaveLoad();
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
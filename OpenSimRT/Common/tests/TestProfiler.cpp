@@ -0,0 +1,147 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestProfiler.cpp
+ *
+ * \brief Records nested zones and counters from several threads, and tests the
+ * exported Chrome trace and the overhead of a zone.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#ifndef OPENSIMRT_PROFILER
+#define OPENSIMRT_PROFILER
+#endif
+#include "Exception.h"
+#include "Profiler.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace OpenSimRT;
+
+size_t countOccurrences(const string& text, const string& pattern) {
+    size_t count = 0;
+    for (auto i = text.find(pattern); i != string::npos;
+         i = text.find(pattern, i + 1)) {
+        count++;
+    }
+    return count;
+}
+
+void work(int microseconds) {
+    auto end = chrono::steady_clock::now() + chrono::microseconds(microseconds);
+    while (chrono::steady_clock::now() < end) {}
+}
+
+void frame(int i) {
+    PROFILE_FUNCTION();
+    {
+        PROFILE_ZONE("ik");
+        work(50);
+    }
+    PROFILE_ZONE("id"); // second zone in the same scope
+    work(20);
+    PROFILE_COUNTER("queue_depth", i % 4);
+}
+
+void testTrace() {
+    const int numThreads = 3, numFrames = 100;
+    vector<thread> threads;
+    for (int t = 0; t < numThreads; ++t) {
+        threads.emplace_back([t]() {
+            Profiler::setThreadName("stage \"" + to_string(t) + "\"");
+            for (int i = 0; i < numFrames; ++i) frame(i);
+        });
+    }
+    for (auto& thread : threads) thread.join();
+
+    // 3 zones and a counter per frame
+    if (Profiler::getNumEvents() != 4 * numThreads * numFrames ||
+        Profiler::getNumDropped() != 0) {
+        THROW_EXCEPTION("wrong number of events");
+    }
+
+    const string fileName = "TestProfiler.json";
+    Profiler::exportChromeTrace(fileName);
+    ifstream file(fileName);
+    stringstream stream;
+    stream << file.rdbuf();
+    const auto trace = stream.str();
+    remove(fileName.c_str());
+    const size_t n = numThreads * numFrames;
+    if (countOccurrences(trace, "\"ph\": \"X\"") != 3 * n ||
+        countOccurrences(trace, "\"ph\": \"C\"") != n ||
+        countOccurrences(trace, "\"name\": \"frame\"") != n ||
+        trace.find("stage \\\"2\\\"") == string::npos) {
+        THROW_EXCEPTION("wrong trace");
+    }
+
+    // the duration of the ik zone is ~50us
+    auto i = trace.find("\"name\": \"ik\"");
+    auto duration = stod(trace.substr(trace.find("\"dur\": ", i) + 7));
+    cout << "ik zone: " << duration << "us" << endl;
+    if (duration < 45 || duration > 5000) THROW_EXCEPTION("wrong duration");
+}
+
+void testCapacityAndOverhead() {
+    Profiler::clear();
+    Profiler::setCapacity(1000);
+    const int numZones = 100000;
+    double duration;
+    thread recorder([&]() {
+        auto start = chrono::steady_clock::now();
+        for (int i = 0; i < numZones; ++i) { PROFILE_ZONE("empty"); }
+        duration = chrono::duration<double, nano>(chrono::steady_clock::now() -
+                                                  start)
+                           .count();
+    });
+    recorder.join();
+    cout << "zone overhead: " << duration / numZones << "ns" << endl;
+    if (Profiler::getNumEvents() != 1000 ||
+        Profiler::getNumDropped() != numZones - 1000) {
+        THROW_EXCEPTION("events must be discarded when the buffer is full");
+    }
+
+    Profiler::clear();
+    Profiler::setEnabled(false);
+    frame(0);
+    Profiler::setEnabled(true);
+    if (Profiler::getNumEvents() != 0) THROW_EXCEPTION("profiler is disabled");
+}
+
+void run() {
+    testTrace();
+    testCapacityAndOverhead();
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
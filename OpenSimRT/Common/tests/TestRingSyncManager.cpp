@@ -0,0 +1,334 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestRingSyncManager.cpp
+ *
+ * \brief Tests the resampling of streams with different rates (linear, cubic
+ * Hermite and quaternion interpolation), late and duplicate samples, overflow
+ * and checkpoints of the RingSyncManager, and
+ * compares the cost per pack with the SyncManager for increasing history
+ * lengths (output delay).
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "RingSyncManager.h"
+#include "SyncManager.h"
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace OpenSimRT;
+
+typedef vector<pair<double, SimTK::Vector>> Pack;
+
+// a linear signal is reproduced exactly by linear interpolation
+SimTK::Vector signal(double t, int width, int stream) {
+    SimTK::Vector x(width);
+    for (int j = 0; j < width; ++j) x[j] = (j + 1) * t + stream;
+    return x;
+}
+
+void checkSignal(const SimTK::Vector& x, int offset, double t, int width,
+                 int stream) {
+    auto expected = signal(t, width, stream);
+    for (int j = 0; j < width; ++j) {
+        if (abs(x[offset + j] - expected[j]) > 1e-9) {
+            THROW_EXCEPTION("wrong value of stream " + to_string(stream) +
+                            " at " + to_string(t));
+        }
+    }
+}
+
+/**
+ * A stream at 100Hz and two streams at 120Hz and 90Hz (container of pairs)
+ * with offsets are resampled at 50Hz. The latest sample of each stream is
+ * appended at 360Hz, thus most samples are appended more than once.
+ */
+void testResampling() {
+    const double rate = 50;
+    RingSyncManager<> manager(rate, 1e-4);
+    double previous = -1;
+    int numOutputs = 0;
+    for (int i = 0; i < 3600; ++i) {
+        double t = i / 360.0;
+        double tA = floor(t * 100) / 100, tB = 0.004 + floor(t * 120) / 120,
+               tC = 0.002 + floor(t * 90) / 90;
+        manager.appendPack(
+                make_pair(tA, SimTK::Vec3(&signal(tA, 3, 0)[0])),
+                Pack{{tB, signal(tB, 4, 1)}, {tC, signal(tC, 2, 2)}});
+        auto pack = manager.getPack();
+        if (pack.second.empty()) continue;
+        if (pack.second.size() != 2 || pack.second[0].size() != 3 ||
+            pack.second[1].size() != 6) {
+            THROW_EXCEPTION("wrong layout of the output");
+        }
+        if (previous >= 0 && abs(pack.first - previous - 1 / rate) > 1e-9) {
+            THROW_EXCEPTION("output is not sampled at the sampling rate");
+        }
+        checkSignal(pack.second[0], 0, pack.first, 3, 0);
+        checkSignal(pack.second[1], 0, pack.first, 4, 1);
+        checkSignal(pack.second[1], 4, pack.first, 2, 2);
+        previous = pack.first;
+        numOutputs++;
+    }
+    if (numOutputs < 490) THROW_EXCEPTION("too few outputs");
+
+    // the history is bounded by the output delay
+    if (manager.getNumDropped() != 0 || manager.getNumSamples() > 12) {
+        THROW_EXCEPTION("history was not evicted");
+    }
+    cout << "resampling: " << numOutputs << " outputs, "
+         << manager.getNumSamples() << " samples in history" << endl;
+}
+
+// rotation about a fixed axis with constant angular velocity (w, x, y, z)
+SimTK::Vector quaternion(double t) {
+    const double angle = 2 * SimTK::Pi * t, axis[3] = {0.6, 0, 0.8};
+    SimTK::Vector q(4);
+    q[0] = cos(angle / 2);
+    for (int j = 0; j < 3; ++j) q[j + 1] = sin(angle / 2) * axis[j];
+    return q;
+}
+
+/**
+ * Quaternions at 100Hz are resampled at 60Hz. SLERP reproduces the rotation,
+ * SLERP and NLERP preserve the unit length, while linear interpolation does
+ * not.
+ */
+void testQuaternionResampling() {
+    typedef StreamDescriptor::Interpolation Interpolation;
+    const vector<string> names = {"lerp", "cubic", "slerp", "nlerp"};
+    for (auto interpolation :
+         {Interpolation::SLERP, Interpolation::NLERP, Interpolation::LINEAR}) {
+        RingSyncManager<> manager(60, 1e-4);
+        if (interpolation == Interpolation::LINEAR) {
+            manager.setStreamDescriptors({StreamDescriptor::vector()});
+        } else {
+            manager.setStreamDescriptors(
+                    {StreamDescriptor::quaternion(interpolation)});
+        }
+        double maxNormError = 0, maxError = 0;
+        for (int i = 0; i < 300; ++i) {
+            double t = i / 100.0;
+            manager.appendPack(make_pair(t, quaternion(t)));
+            auto pack = manager.getPack();
+            if (pack.second.empty()) continue;
+            const auto& q = pack.second[0];
+            const auto expected = quaternion(pack.first);
+            double norm = 0;
+            for (int j = 0; j < 4; ++j) {
+                norm += q[j] * q[j];
+                maxError = max(maxError, abs(q[j] - expected[j]));
+            }
+            maxNormError = max(maxNormError, abs(sqrt(norm) - 1));
+        }
+        cout << names[static_cast<int>(interpolation)] << ": max error "
+             << maxError << ", max norm error " << maxNormError << endl;
+        if (interpolation == Interpolation::LINEAR) {
+            if (maxNormError < 1e-5) THROW_EXCEPTION("lerp preserved the norm");
+        } else {
+            if (maxNormError > 1e-12) THROW_EXCEPTION("quaternion is not unit");
+            double tolerance =
+                    interpolation == Interpolation::SLERP ? 1e-9 : 1e-4;
+            if (maxError > tolerance) {
+                THROW_EXCEPTION("wrong interpolated quaternion");
+            }
+        }
+    }
+
+    // interpolation of a quaternion requires four values
+    RingSyncManager<> manager(60, 1e-4);
+    manager.setStreamDescriptors({StreamDescriptor::quaternion()});
+    try {
+        manager.appendPack(make_pair(0.0, SimTK::Vec3(0.0)));
+    } catch (const std::exception&) { return; }
+    THROW_EXCEPTION("invalid quaternion stream was accepted");
+}
+
+/**
+ * Cubic Hermite interpolation of samples at 100Hz reproduces a quadratic
+ * signal, while linear interpolation does not.
+ */
+void testCubicHermite() {
+    auto signal = [](double t) { return SimTK::Vec1(3 * t * t - t + 1); };
+    RingSyncManager<> manager(30, 1e-4);
+    manager.setStreamDescriptors(
+            {StreamDescriptor::vector(
+                     StreamDescriptor::Interpolation::CUBIC_HERMITE),
+             StreamDescriptor::vector()});
+    double maxCubicError = 0, maxLinearError = 0;
+    for (int i = 0; i < 300; ++i) {
+        double t = i / 100.0;
+        manager.appendPack(make_pair(t, signal(t)), make_pair(t, signal(t)));
+        auto pack = manager.getPack();
+        if (pack.second.empty()) continue;
+        double expected = signal(pack.first)[0];
+        maxCubicError = max(maxCubicError, abs(pack.second[0][0] - expected));
+        maxLinearError = max(maxLinearError, abs(pack.second[1][0] - expected));
+    }
+    if (maxCubicError > 1e-9 || maxLinearError < 1e-5) {
+        THROW_EXCEPTION("cubic Hermite does not reproduce a quadratic signal");
+    }
+}
+
+/**
+ * Late samples are moved to their position, samples with the same timestamp
+ * replace each other and non-finite samples are ignored.
+ */
+void testLateAndDuplicateSamples() {
+    RingSyncManager<> manager(100, 1e-4);
+    auto append = [&](double t, double value) {
+        manager.appendPack(make_pair(t, SimTK::Vec1(value)));
+    };
+    append(0.00, 0);
+    append(0.02, 0); // replaced below
+    append(0.01, 1); // late
+    append(0.02 + 5e-5, 2);
+    append(0.03, SimTK::NaN);
+    append(0.04, 4);
+    if (manager.getNumSamples() != 4) {
+        THROW_EXCEPTION("late or duplicate samples were not merged");
+    }
+
+    // output starts from the newest sample
+    auto pack = manager.getPack(0);
+    if (pack.first != 0.04 || pack.second[0][0] != 4) {
+        THROW_EXCEPTION("wrong first output");
+    }
+    append(0.06, 6);
+    pack = manager.getPack(0);
+    if (abs(pack.first - 0.05) > 1e-12 || abs(pack.second[0][0] - 5) > 1e-9) {
+        THROW_EXCEPTION("wrong interpolated output");
+    }
+}
+
+/**
+ * A stream that stops while the other fills its buffer. When the stream
+ * resumes, the output is synchronized again with the latest samples.
+ */
+void testOverflow() {
+    RingSyncManager<> manager(100, 1e-4, 16);
+    double last = -1;
+    for (int i = 0; i < 200; ++i) {
+        double t = i / 100.0;
+        double tB = (i < 50 || i > 100) ? t : 0.49;
+        manager.appendPack(make_pair(t, SimTK::Vec1(t)),
+                           make_pair(tB, SimTK::Vec1(tB)));
+        auto pack = manager.getPack();
+        if (!pack.second.empty()) last = pack.first;
+    }
+    if (manager.getNumDropped() == 0) THROW_EXCEPTION("nothing was dropped");
+    if (last < 1.9) THROW_EXCEPTION("output was not synchronized again");
+    if (manager.getNumSamples() > 2 * 16) THROW_EXCEPTION("capacity exceeded");
+}
+
+/**
+ * A restored manager continues with identical outputs.
+ */
+void testCheckpoint() {
+    RingSyncManager<> manager(50, 1e-4), restored;
+    auto append = [](RingSyncManager<>& m, int i) {
+        double tA = i / 100.0, tB = 0.004 + i / 120.0;
+        m.appendPack(Pack{{tA, signal(tA, 3, 0)}, {tB, signal(tB, 2, 1)}});
+    };
+    for (int i = 0; i < 100; ++i) {
+        append(manager, i);
+        manager.getPack();
+    }
+    CheckpointWriter writer;
+    manager.saveState(writer);
+    CheckpointReader reader(writer.getData());
+    restored.loadState(reader);
+    for (int i = 100; i < 200; ++i) {
+        append(manager, i);
+        append(restored, i);
+        auto expected = manager.getPack(), output = restored.getPack();
+        if (output.first != expected.first ||
+            output.second.size() != expected.second.size() ||
+            (!output.second.empty() &&
+             (output.second[0] - expected.second[0]).normRMS() != 0)) {
+            THROW_EXCEPTION("restored manager differs");
+        }
+    }
+}
+
+/**
+ * Mean cost [us] of appendPack() and getPack() for 8 IMUs with 4 streams
+ * (quaternion, accelerometer, gyroscope, magnetometer) at 60Hz, when the
+ * output is delayed by history samples.
+ */
+template <typename Manager> double benchmark(size_t history, int numPacks) {
+    const double rate = 60;
+    Manager manager(rate, 1e-4);
+    Pack pack;
+    double duration = 0;
+    for (int i = 0; i < numPacks + (int) history; ++i) {
+        pack.clear();
+        for (int imu = 0; imu < 8; ++imu) {
+            double t = i / rate + imu * 1e-3;
+            pack.push_back({t, signal(t, 4, imu)});
+            for (int sensor = 0; sensor < 3; ++sensor) {
+                pack.push_back({t, signal(t, 3, imu)});
+            }
+        }
+        auto start = chrono::steady_clock::now();
+        manager.appendPack(pack);
+        manager.getPack(history);
+        auto end = chrono::steady_clock::now();
+
+        // exclude the first packs, before the output starts
+        if (i >= (int) history) {
+            duration += chrono::duration<double, micro>(end - start).count();
+        }
+    }
+    return duration / numPacks;
+}
+
+void testBenchmark() {
+    cout << "history   SyncManager [us/pack]   RingSyncManager [us/pack]"
+         << endl;
+    for (size_t history : {4, 16, 64, 128}) {
+        cout << setw(7) << history << setw(24)
+             << benchmark<SyncManager<>>(history, 200) << setw(28)
+             << benchmark<RingSyncManager<>>(history, 2000) << endl;
+    }
+}
+
+void run() {
+    testResampling();
+    testQuaternionResampling();
+    testCubicHermite();
+    testLateAndDuplicateSamples();
+    testOverflow();
+    testCheckpoint();
+    testBenchmark();
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,193 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestSPSCCircularBuffer.cpp
+ *
+ * \brief Tests that the lock-free circular buffer delivers consistent elements
+ * under contention, and compares the throughput of the producer and the
+ * consumer with the mutex-based CircularBuffer.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "CircularBuffer.h"
+#include "Exception.h"
+#include "SPSCCircularBuffer.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace OpenSimRT;
+
+const int numElements = 200000;
+const int width = 32; // e.g., the samples of an IMU
+
+// each element is filled with its index, thus a torn element is detected
+typedef vector<double> Element;
+
+void testConsistency() {
+    SPSCCircularBuffer<16, Element> buffer;
+    thread producer([&]() {
+        for (int i = 0; i < numElements; ++i) {
+            buffer.emplace(width, static_cast<double>(i));
+        }
+        buffer.setDataRetrievalMode(DataRetrievalMode::CONTINUOUS);
+    });
+
+    size_t numReads = 0;
+    uint64_t previous = 0;
+    while (true) {
+        auto view = buffer.peek(8);
+        if (view.getSequence(0) < previous) {
+            THROW_EXCEPTION("sequence numbers are not increasing");
+        }
+        previous = view.getSequence(0);
+        for (int i = 0; i < view.size(); ++i) {
+            const auto& element = view[i];
+            if (element.size() != width) THROW_EXCEPTION("torn element");
+            for (const auto& x : element) {
+                if (x != element[0]) THROW_EXCEPTION("torn element");
+            }
+            if (i > 0 && element[0] >= view[i - 1][0]) {
+                THROW_EXCEPTION("elements are not ordered from new to old");
+            }
+        }
+        numReads++;
+        if (buffer.getNumAdded() + buffer.getNumDropped() == numElements &&
+            previous + 1 == buffer.getNumAdded()) {
+            break;
+        }
+    }
+    producer.join();
+
+    // the latest element is retrieved in CONTINUOUS mode
+    auto latest = buffer.get(3, true);
+    if (latest.back()[0] != latest.front()[0] + 2) {
+        THROW_EXCEPTION("get(M, true) must return the elements old-to-new");
+    }
+    cout << "reads: " << numReads << ", dropped: " << buffer.getNumDropped()
+         << endl;
+}
+
+void testOnEntry() {
+    SPSCCircularBuffer<4, double> buffer;
+    if (buffer.isSize(1)) THROW_EXCEPTION("buffer must be empty");
+    thread producer([&]() {
+        for (int i = 1; i <= 10; ++i) {
+            buffer.add(i);
+            this_thread::sleep_for(chrono::milliseconds(2));
+        }
+    });
+    // every retrieval waits for a new element
+    double previous = 0;
+    for (int i = 0; i < 5; ++i) {
+        auto view = buffer.peek(1);
+        if (view[0] <= previous) THROW_EXCEPTION("element is not new");
+        previous = view[0];
+    }
+    producer.join();
+    try {
+        buffer.peek(5);
+        THROW_EXCEPTION("M > history must be rejected");
+    } catch (exception& e) {
+        if (string(e.what()).find("between") == string::npos) throw;
+    }
+}
+
+void testPinning() {
+    SPSCCircularBuffer<4, double> buffer;
+    for (int i = 0; i < 4; ++i) buffer.add(i);
+    {
+        // the producer can add history elements while the view is alive
+        auto view = buffer.peek(4);
+        for (int i = 4; i < 8; ++i) {
+            if (!buffer.add(i)) THROW_EXCEPTION("element was discarded");
+        }
+        if (buffer.add(8)) THROW_EXCEPTION("pinned element was overwritten");
+        if (view[0] != 3 || view[3] != 0 || view.getSequence(3) != 0) {
+            THROW_EXCEPTION("pinned elements were modified");
+        }
+    }
+    // unlike the CircularBuffer, the newest element was discarded
+    if (!buffer.add(9) || buffer.getNumDropped() != 1 ||
+        buffer.getNumAdded() != 9) {
+        THROW_EXCEPTION("elements are not unpinned");
+    }
+    auto view = buffer.peek(2);
+    if (view[0] != 9 || view[1] != 7 || view.getSequence(0) != 8) {
+        THROW_EXCEPTION("wrong latest elements");
+    }
+}
+
+// the producer adds elements as fast as possible, while the consumer copies
+// the latest M elements
+template <typename Buffer> void benchmark(const string& name, int M) {
+    Buffer buffer;
+    buffer.setDataRetrievalMode(DataRetrievalMode::CONTINUOUS);
+    Element element(width, 0.0);
+    buffer.add(element);
+    for (int i = 1; i < M; ++i) buffer.add(element);
+
+    atomic<bool> isFinished(false);
+    auto start = chrono::high_resolution_clock::now();
+    thread producer([&]() {
+        for (int i = 0; i < numElements; ++i) {
+            element[0] = i;
+            buffer.add(element);
+        }
+        isFinished = true;
+    });
+    size_t numReads = 0;
+    double latest = 0;
+    while (!isFinished) {
+        auto data = buffer.get(M);
+        if (data[0][0] < latest) THROW_EXCEPTION("element is older");
+        latest = data[0][0];
+        numReads++;
+    }
+    producer.join();
+    auto duration = chrono::duration<double, micro>(
+                            chrono::high_resolution_clock::now() - start)
+                            .count();
+    cout << name << " (M = " << M << "): " << duration / numElements
+         << " us/add, " << duration / numReads << " us/get" << endl;
+}
+
+void run() {
+    testConsistency();
+    testOnEntry();
+    testPinning();
+    for (int M : {1, 8}) {
+        benchmark<CircularBuffer<16, Element>>("CircularBuffer", M);
+        benchmark<SPSCCircularBuffer<16, Element>>("SPSCCircularBuffer", M);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
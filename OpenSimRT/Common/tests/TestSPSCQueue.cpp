@@ -0,0 +1,137 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestSPSCQueue.cpp
+ *
+ * \brief Tests the ordering and the overflow policies of the lock-free
+ * single-producer/single-consumer queue, and that elements with buffers are
+ * copied through the queue without allocations.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#define OPENSIMRT_ALLOCATION_HOOK
+#include "AllocationCounter.h"
+#include "SPSCQueue.h"
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace OpenSimRT;
+
+/**
+ * A fast producer and a slow consumer. Every element is either received (in
+ * order) or counted as dropped.
+ */
+void testPolicy(OverflowPolicy policy, size_t capacity, int n) {
+    SPSCQueue<int> queue(capacity, policy);
+    vector<int> received;
+    thread producer([&]() {
+        for (int i = 0; i < n; ++i) queue.push(i);
+        queue.close();
+    });
+    thread consumer([&]() {
+        int value;
+        while (queue.pop(value)) {
+            received.push_back(value);
+            this_thread::sleep_for(chrono::microseconds(50));
+        }
+    });
+    producer.join();
+    consumer.join();
+
+    for (int i = 1; i < received.size(); ++i) {
+        if (received[i] <= received[i - 1]) {
+            THROW_EXCEPTION("elements are not in order");
+        }
+    }
+    if (received.size() + queue.getNumDropped() != n) {
+        THROW_EXCEPTION("received and dropped elements do not add up to " +
+                        to_string(n));
+    }
+    // elements that are discarded from the front were pushed but not popped
+    if (queue.getNumPopped() != received.size()) {
+        THROW_EXCEPTION("wrong number of popped elements");
+    }
+    auto numRejected = policy == OverflowPolicy::DROP_OLDEST
+                               ? 0
+                               : queue.getNumDropped();
+    if (queue.getNumPushed() + numRejected != n) {
+        THROW_EXCEPTION("wrong number of pushed elements");
+    }
+    if (policy == OverflowPolicy::BLOCK && queue.getNumDropped() != 0) {
+        THROW_EXCEPTION("blocking queue dropped elements");
+    }
+    if (policy == OverflowPolicy::DROP_OLDEST && received.back() != n - 1) {
+        THROW_EXCEPTION("latest element was not received");
+    }
+    if (policy == OverflowPolicy::DROP_NEWEST && received.front() != 0) {
+        THROW_EXCEPTION("first element was not received");
+    }
+    if (queue.getSize() > capacity) THROW_EXCEPTION("capacity exceeded");
+    cout << "capacity: " << capacity << " received: " << received.size()
+         << " dropped: " << queue.getNumDropped() << endl;
+}
+
+/**
+ * Vectors of the same size are passed through a queue that drops the oldest
+ * elements. After the slots are filled once, pushCopy and popCopy reuse the
+ * buffers of the slots and of the received vector.
+ */
+void testCopyWithoutAllocations() {
+    const int n = 1000, warmUp = 16;
+    SPSCQueue<vector<double>> queue(4, OverflowPolicy::DROP_OLDEST);
+    vector<double> sent(100), received(100);
+    uint64_t allocations = 0;
+    for (int i = 0; i < n; ++i) {
+        auto before = AllocationCounter::getThreadAllocations();
+        sent[0] = i;
+        queue.pushCopy(sent);
+        if (i % 2 == 0) queue.tryPopCopy(received);
+        if (i >= warmUp) {
+            allocations += AllocationCounter::getThreadAllocations() - before;
+        }
+    }
+    if (queue.getNumDropped() == 0) THROW_EXCEPTION("no element was dropped");
+    cout << "allocations after warm-up: " << allocations << endl;
+    if (!AllocationCounter::isInstalled()) {
+        THROW_EXCEPTION("allocation hook is not installed");
+    }
+    if (allocations != 0) THROW_EXCEPTION("copy through the queue allocated");
+}
+
+void run() {
+    // a queue of capacity one holds only the latest element
+    for (size_t capacity : {1, 4}) {
+        testPolicy(OverflowPolicy::BLOCK, capacity, 1000);
+        testPolicy(OverflowPolicy::DROP_OLDEST, capacity, 1000);
+        testPolicy(OverflowPolicy::DROP_NEWEST, capacity, 1000);
+    }
+    testCopyWithoutAllocations();
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
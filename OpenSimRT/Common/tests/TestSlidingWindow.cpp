@@ -0,0 +1,150 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestSlidingWindow.cpp
+ *
+ * \brief Compares the incremental statistics and equality predicates of the
+ * sliding window with a direct evaluation over the window elements.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "Exception.h"
+#include "SlidingWindow.h"
+#include <SimTKcommon.h>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <iostream>
+#include <random>
+
+using namespace std;
+using namespace OpenSimRT;
+using namespace SimTK;
+
+enum class Phase { SWING, STANCE };
+
+void testStatistics() {
+    const size_t capacity = 50;
+    SlidingWindow<double> window;
+    window.setSize(capacity);
+    SlidingWindow<Vec3, capacity> vecWindow;
+    deque<double> reference;
+    mt19937 generator(0);
+    normal_distribution<double> noise(0, 0.1);
+
+    double maxError = 0;
+    for (int i = 0; i < 100000; ++i) {
+        // large offset to test the accuracy of the running sums
+        double x = 1000 + sin(0.01 * i) + noise(generator);
+        window.insert(x);
+        vecWindow.insert(Vec3(x));
+        reference.push_back(x);
+        if (reference.size() > capacity) reference.pop_front();
+
+        double mean = 0, variance = 0;
+        for (auto r : reference) mean += r;
+        mean /= reference.size();
+        for (auto r : reference) variance += (r - mean) * (r - mean);
+        variance /= reference.size();
+
+        if (window.size() != reference.size() ||
+            window.front() != reference.front() ||
+            window.back() != reference.back()) {
+            THROW_EXCEPTION("wrong window elements");
+        }
+        maxError = max({maxError, abs(window.mean() - mean),
+                        abs(window.variance() - variance),
+                        abs(vecWindow.mean()[2] - mean),
+                        abs(vecWindow.variance()[1] - variance)});
+    }
+    cout << "max error of mean and variance: " << maxError << endl;
+    if (maxError > 1e-9) THROW_EXCEPTION("statistics are not accurate");
+}
+
+void testEquality() {
+    const size_t capacity = 7;
+    SlidingWindow<Phase> window;
+    window.init(Array_<Phase>(capacity, Phase::SWING));
+    deque<Phase> reference(capacity, Phase::SWING);
+    mt19937 generator(1);
+    bernoulli_distribution isStance(0.3);
+
+    for (int i = 0; i < 10000; ++i) {
+        Phase x = isStance(generator) ? Phase::STANCE : Phase::SWING;
+        window.insert(x);
+        reference.push_back(x);
+        reference.pop_front();
+        for (auto value : {Phase::SWING, Phase::STANCE}) {
+            for (size_t n = 0; n <= capacity; ++n) {
+                bool first = true, last = true;
+                for (size_t j = 0; j < n; ++j) {
+                    first &= reference[j] == value;
+                    last &= reference[capacity - 1 - j] == value;
+                }
+                if (window.nFirstEqual(value, n) != first ||
+                    window.nLastEqual(value, n) != last) {
+                    THROW_EXCEPTION("wrong equality predicate");
+                }
+            }
+            if (window.equal(value) != window.nFirstEqual(value, capacity)) {
+                THROW_EXCEPTION("wrong equality predicate");
+            }
+        }
+    }
+    try {
+        window.nFirstEqual(Phase::SWING, capacity + 1);
+        THROW_EXCEPTION("n > size must be rejected");
+    } catch (exception& e) {
+        if (string(e.what()).find("Wrong input size") == string::npos) throw;
+    }
+}
+
+// insertion and mean of a window with 1000 elements
+void benchmark() {
+    const int capacity = 1000, numSamples = 100000;
+    SlidingWindow<Vec3> window;
+    window.setSize(capacity);
+    double sum = 0;
+    auto start = chrono::high_resolution_clock::now();
+    for (int i = 0; i < numSamples; ++i) {
+        window.insert(Vec3(static_cast<double>(i)));
+        sum += window.mean()[0];
+    }
+    auto duration = chrono::duration<double, micro>(
+                            chrono::high_resolution_clock::now() - start)
+                            .count();
+    cout << "insert and mean: " << duration / numSamples << " us (" << sum
+         << ")" << endl;
+}
+
+void run() {
+    testStatistics();
+    testEquality();
+    benchmark();
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestTelemetry.cpp
+ *
+ * \brief Tests the percentiles of the telemetry histograms against the exact
+ * percentiles of the recorded values.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "Exception.h"
+#include "Telemetry.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace OpenSimRT;
+
+void run() {
+    // log-normal latencies around 1 ms (in ns)
+    mt19937_64 generator(0);
+    lognormal_distribution<double> distribution(log(1e6), 0.5);
+    Telemetry telemetry;
+    auto& histogram = telemetry.addLatencyHistogram("stage");
+    vector<uint64_t> values;
+    for (int i = 0; i < 100000; ++i) {
+        auto value = static_cast<uint64_t>(distribution(generator));
+        values.push_back(value);
+        histogram.record(value);
+    }
+    sort(values.begin(), values.end());
+
+    // relative error is bounded by the resolution of the buckets
+    for (double p : {50.0, 90.0, 99.0, 99.9}) {
+        int rank = static_cast<int>(ceil(p / 100 * values.size()));
+        auto exact = values[rank - 1];
+        auto estimate = histogram.getPercentile(p);
+        auto error = fabs((double) estimate - exact) / exact;
+        cout << "p" << p << ": " << exact << " ~ " << estimate << endl;
+        if (error > 1.0 / 32) {
+            THROW_EXCEPTION("percentile error exceeds the resolution");
+        }
+    }
+    if (histogram.getMin() != values.front() ||
+        histogram.getMax() != values.back()) {
+        THROW_EXCEPTION("wrong min or max");
+    }
+
+    // small values are exact
+    Histogram depth;
+    for (int i = 0; i < 64; ++i) depth.record(i);
+    if (depth.getPercentile(50) != 31 || depth.getPercentile(100) != 63) {
+        THROW_EXCEPTION("wrong percentile of small values");
+    }
+
+    auto snapshot = telemetry.getSnapshot();
+    if (snapshot.histograms[0].count != values.size()) {
+        THROW_EXCEPTION("wrong number of recorded values");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,144 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestThreadPolicy.cpp
+ *
+ * \brief Tests the parsing of thread policies and that a policy is applied
+ * to the calling thread: the affinity and the scheduling policy are read back
+ * from the operating system. SCHED_FIFO requires privileges, otherwise the
+ * thread must keep SCHED_OTHER.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "Exception.h"
+#include "ThreadPolicy.h"
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace std;
+using namespace OpenSimRT;
+
+void testParsing() {
+    if (cpuSetFromString("0, 2-4") != vector<int>{0, 2, 3, 4}) {
+        THROW_EXCEPTION("wrong cpu set");
+    }
+    if (!cpuSetFromString("*").empty() || !cpuSetFromString("").empty()) {
+        THROW_EXCEPTION("any core is not an empty cpu set");
+    }
+    auto policies = threadPoliciesFromString("1 | 2-3", "80");
+    if (policies.size() != 2 || policies[1].cpus != vector<int>{2, 3} ||
+        policies[0].priority != 80 || policies[1].priority != 80) {
+        THROW_EXCEPTION("wrong thread policies");
+    }
+    if (!threadPoliciesFromString("", "")[0].isDefault()) {
+        THROW_EXCEPTION("empty strings do not result in the default policy");
+    }
+    bool isThrown = false;
+    try {
+        threadPoliciesFromString("1 | 2 | 3", "80 | 70");
+    } catch (exception&) { isThrown = true; }
+    if (!isThrown) THROW_EXCEPTION("mismatched thread policies were accepted");
+
+    // priorities out of range
+    for (const auto& priority : {"-1", "100"}) {
+        try {
+            threadPoliciesFromString("", priority);
+            THROW_EXCEPTION("priority " + string(priority) + " was accepted");
+        } catch (exception& e) {
+            if (string(e.what()).find("[0, 99]") == string::npos) throw;
+        }
+    }
+}
+
+#ifdef __linux__
+void testApply() {
+    // pin to the last core that the process may use
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed)) {
+        THROW_EXCEPTION("cannot read the affinity of the process");
+    }
+    int cpu = CPU_SETSIZE - 1;
+    while (cpu >= 0 && !CPU_ISSET(cpu, &allowed)) --cpu;
+    if (cpu < 0) THROW_EXCEPTION("no allowed core");
+
+    ThreadPolicy policy{{cpu}, 80};
+    bool isApplied = false;
+    int schedulingPolicy = -1;
+    sched_param parameters;
+    cpu_set_t affinity;
+    thread t([&]() {
+        isApplied = policy.apply();
+        pthread_getschedparam(pthread_self(), &schedulingPolicy, &parameters);
+        CPU_ZERO(&affinity);
+        pthread_getaffinity_np(pthread_self(), sizeof(affinity), &affinity);
+    });
+    t.join();
+
+    // pinning to an allowed core does not require privileges
+    if (CPU_COUNT(&affinity) != 1 || !CPU_ISSET(cpu, &affinity)) {
+        THROW_EXCEPTION("thread is not pinned to core " + to_string(cpu));
+    }
+    if (isApplied) {
+        if (schedulingPolicy != SCHED_FIFO || parameters.sched_priority != 80) {
+            THROW_EXCEPTION("SCHED_FIFO priority 80 was not applied");
+        }
+    } else {
+        cout << "SCHED_FIFO could not be applied (insufficient privileges)"
+             << endl;
+        if (schedulingPolicy != SCHED_OTHER) {
+            THROW_EXCEPTION("thread did not keep its previous policy");
+        }
+    }
+
+    // the default policy leaves the thread unchanged
+    thread d([&]() {
+        isApplied = ThreadPolicy().apply();
+        pthread_getschedparam(pthread_self(), &schedulingPolicy, &parameters);
+    });
+    d.join();
+    if (!isApplied || schedulingPolicy != SCHED_OTHER) {
+        THROW_EXCEPTION("default policy changed the scheduling");
+    }
+}
+#endif
+
+void run() {
+    testParsing();
+#ifdef __linux__
+    testApply();
+#endif
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,147 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestTimeSeriesStore.cpp
+ *
+ * \brief Tests the row and column views of a file-backed time series store,
+ * reopening the file, appending to a reopened store and the conversion to and
+ * from a TimeSeriesTable.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "TimeSeriesStore.h"
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace OpenSimRT;
+
+// row i has time 0.01 i and values (j + 1) i
+void verify(const TimeSeriesStore& store, size_t numRows) {
+    if (store.getNumRows() != numRows) THROW_EXCEPTION("wrong number of rows");
+    if (store.getColumnLabels() != vector<string>{"a", "b", "c"}) {
+        THROW_EXCEPTION("wrong labels");
+    }
+    for (size_t i = 0; i < numRows; ++i) {
+        if (store.getTime(i) != 0.01 * i) THROW_EXCEPTION("wrong time");
+        auto row = store.getRow(i);
+        if (row.size() != 3) THROW_EXCEPTION("wrong row size");
+        for (int j = 0; j < row.size(); ++j) {
+            if (row[j] != (j + 1.0) * i) THROW_EXCEPTION("wrong row value");
+        }
+    }
+    auto b = store.getColumn("b");
+    if (b.size != numRows) THROW_EXCEPTION("wrong column size");
+    size_t i = 0;
+    for (const auto& value : b) {
+        if (value != 2.0 * i++) THROW_EXCEPTION("wrong column value");
+    }
+}
+
+void expectThrow(const string& message, const function<void()>& f) {
+    bool thrown = false;
+    try {
+        f();
+    } catch (exception&) { thrown = true; }
+    if (!thrown) THROW_EXCEPTION(message);
+}
+
+void run() {
+    const string fileName = "TestTimeSeriesStore.tss";
+    const size_t capacity = 1000;
+
+    // append to a file-backed store
+    {
+        TimeSeriesStore store({"a", "b", "c"}, capacity, fileName);
+        vector<double> values(3);
+        for (size_t i = 0; i < capacity; ++i) {
+            for (int j = 0; j < 3; ++j) values[j] = (j + 1.0) * i;
+            store.appendRow(0.01 * i, values);
+        }
+        verify(store, capacity);
+        expectThrow("full store accepted a row",
+                    [&]() { store.appendRow(100, values); });
+        store.flush();
+    }
+    if (!TimeSeriesStore::isStoreFile(fileName)) {
+        THROW_EXCEPTION("file is not recognized as a store");
+    }
+
+    // the reopened file has the same rows
+    {
+        TimeSeriesStore store(fileName);
+        verify(store, capacity);
+
+        // conversion to and from a TimeSeriesTable
+        auto table = store.toTable();
+        if (table.getNumRows() != capacity || table.getNumColumns() != 3) {
+            THROW_EXCEPTION("wrong table dimensions");
+        }
+        verify(TimeSeriesStore::fromTable(table), capacity);
+    }
+
+    // rows are appended to a reopened store until it is full
+    {
+        TimeSeriesStore store({"a", "b", "c"}, 10, fileName);
+        vector<double> values(3);
+        for (size_t i = 0; i < 5; ++i) {
+            for (int j = 0; j < 3; ++j) values[j] = (j + 1.0) * i;
+            store.appendRow(0.01 * i, values);
+        }
+    }
+    {
+        TimeSeriesStore store(fileName);
+        vector<double> values(3);
+        expectThrow("time that is not increasing was accepted",
+                    [&]() { store.appendRow(0.0, values); });
+        expectThrow("row of wrong size was accepted",
+                    [&]() { store.appendRow(1.0, vector<double>(2)); });
+        for (size_t i = 5; i < 10; ++i) {
+            for (int j = 0; j < 3; ++j) values[j] = (j + 1.0) * i;
+            store.appendRow(0.01 * i, values);
+        }
+        verify(store, 10);
+    }
+    verify(TimeSeriesStore(fileName), 10);
+
+    // a file that is not a store
+    {
+        ofstream out(fileName, ios::trunc);
+        out << "time\ta\tb\tc\n";
+    }
+    if (TimeSeriesStore::isStoreFile(fileName)) {
+        THROW_EXCEPTION("text file is recognized as a store");
+    }
+    expectThrow("text file was opened as a store",
+                [&]() { TimeSeriesStore store(fileName); });
+    remove(fileName.c_str());
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,154 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestTripleBuffer.cpp
+ *
+ * \brief Tests that subscribers of different speeds receive consistent
+ * snapshots in order, while the producer publishes without blocking, and that
+ * waiting subscribers are woken up by every publication (ping-pong).
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "TripleBuffer.h"
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace OpenSimRT;
+
+// a snapshot that is torn if any element differs from the version
+typedef vector<uint64_t> Snapshot;
+
+void checkSnapshot(const Snapshot& snapshot, uint64_t version,
+                   uint64_t& previousVersion) {
+    for (const auto& value : snapshot) {
+        if (value != version) THROW_EXCEPTION("torn snapshot");
+    }
+    if (version <= previousVersion) THROW_EXCEPTION("snapshots out of order");
+    previousVersion = version;
+}
+
+void testWaitWakesUp() {
+    // each thread waits for the value of the other, thus a missed wake-up
+    // blocks the test
+    const int n = 10000;
+    SnapshotPublisher<int> ping, pong;
+    auto& pingSubscriber = ping.subscribe();
+    auto& pongSubscriber = pong.subscribe();
+    thread echo([&]() {
+        int value;
+        while (pingSubscriber.wait(value)) pong.publish(value);
+    });
+
+    auto start = chrono::steady_clock::now();
+    for (int i = 1; i <= n; ++i) {
+        ping.publish(i);
+        int value = 0;
+        if (!pongSubscriber.wait(value) || value != i) {
+            THROW_EXCEPTION("wrong value after wait");
+        }
+    }
+    auto duration = chrono::duration<double, micro>(
+                            chrono::steady_clock::now() - start)
+                            .count();
+    ping.close();
+    echo.join();
+    cout << "round trip: " << duration / n << " us" << endl;
+}
+
+void testSubscribers() {
+    const uint64_t n = 100000;
+    SnapshotPublisher<Snapshot> publisher;
+    auto& fast = publisher.subscribe();
+    auto& slow = publisher.subscribe();
+    uint64_t numCallbacks = 0, callbackVersion = 0;
+    publisher.addCallback([&](const Snapshot& snapshot) {
+        checkSnapshot(snapshot, snapshot[0], callbackVersion);
+        numCallbacks++;
+    });
+
+    // subscribers
+    uint64_t numFast = 0, numSlow = 0;
+    thread fastThread([&]() {
+        Snapshot snapshot;
+        uint64_t previous = 0;
+        while (!publisher.isClosed() || fast.hasUpdate()) {
+            if (fast.poll(snapshot)) {
+                checkSnapshot(snapshot, fast.getVersion(), previous);
+                numFast++;
+            }
+        }
+    });
+    thread slowThread([&]() {
+        Snapshot snapshot;
+        uint64_t previous = 0;
+        while (slow.wait(snapshot)) {
+            checkSnapshot(snapshot, slow.getVersion(), previous);
+            numSlow++;
+            this_thread::sleep_for(chrono::microseconds(200));
+        }
+    });
+
+    // producer
+    Snapshot snapshot(64);
+    auto start = chrono::steady_clock::now();
+    for (uint64_t version = 1; version <= n; ++version) {
+        for (auto& value : snapshot) value = version;
+        publisher.publish(snapshot);
+    }
+    auto duration = chrono::duration<double, micro>(
+                            chrono::steady_clock::now() - start)
+                            .count();
+    publisher.close();
+    fastThread.join();
+    slowThread.join();
+
+    cout << "publish: " << duration / n << " us" << endl;
+    cout << "fast subscriber: " << numFast << " read "
+         << fast.getNumSkipped() << " skipped" << endl;
+    cout << "slow subscriber: " << numSlow << " read "
+         << slow.getNumSkipped() << " skipped" << endl;
+
+    // every published snapshot is either read or skipped, and the latest one
+    // is always received
+    if (numFast + fast.getNumSkipped() != n || fast.getVersion() != n) {
+        THROW_EXCEPTION("fast subscriber missed the latest snapshot");
+    }
+    if (numSlow + slow.getNumSkipped() != n || slow.getVersion() != n) {
+        THROW_EXCEPTION("slow subscriber missed the latest snapshot");
+    }
+    if (publisher.getVersion() != n) THROW_EXCEPTION("wrong version");
+    if (numSlow >= n) THROW_EXCEPTION("slow subscriber delayed the producer");
+}
+
+void run() {
+    testWaitWakesUp();
+    testSubscribers();
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
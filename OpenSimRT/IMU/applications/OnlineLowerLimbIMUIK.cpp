@@ -27,9 +27,9 @@
 #include "INIReader.h"
 #include "InverseKinematics.h"
 #include "NGIMUInputDriver.h"
+#include "RingSyncManager.h"
 #include "Settings.h"
 #include "SignalProcessing.h"
-#include "SyncManager.h"
 #include "Visualization.h"
 #include <Actuators/Thelen2003Muscle.h>
 #include <OpenSim/Common/CSVFileAdapter.h>
@@ -70,6 +70,11 @@ void run() {
     auto syncRate = ini.getReal(section, "SYNC_MANAGER_RATE", 0);
     auto syncThreshold = ini.getReal(section, "SYNC_MANAGER_THRESHOLD", 0);
 
+    // real-time configuration of the listening thread
+    auto listenThreadPolicy = threadPoliciesFromString(
+            ini.getString(section, "LISTEN_THREAD_CPUS", ""),
+            ini.getString(section, "LISTEN_THREAD_PRIORITY", ""))[0];
+
     // subject data
     auto subjectDir = DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
     auto modelFile = subjectDir + ini.getString(section, "MODEL_FILE", "");
@@ -89,6 +94,7 @@ void run() {
                       vector<string>(LISTEN_PORTS.size(), LISTEN_IP),
                       LISTEN_PORTS);
     driver.setupTransmitters(IMU_IP, SEND_PORTS, LISTEN_IP, LISTEN_PORTS);
+    driver.setThreadPolicy(listenThreadPolicy);
     thread listen(&NGIMUInputDriver::startListening, &driver);
     auto imuLogger = driver.initializeLogger();
 
@@ -110,7 +116,8 @@ void run() {
     LowPassSmoothFilter filter(filterParam);
 
     // sync manager
-    SyncManager manager(syncRate, syncThreshold);
+    RingSyncManager manager(syncRate, syncThreshold);
+    manager.setStreamDescriptors(driver.getStreamDescriptors());
 
     // initialize ik (lower constraint weight and accuracy -> faster tracking)
     InverseKinematics ik(model, {}, imuTasks, SimTK::Infinity, 1e-5);
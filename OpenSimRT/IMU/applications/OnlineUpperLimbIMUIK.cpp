@@ -27,9 +27,9 @@
 #include "INIReader.h"
 #include "InverseKinematics.h"
 #include "NGIMUInputDriver.h"
+#include "RingSyncManager.h"
 #include "Settings.h"
 #include "SignalProcessing.h"
-#include "SyncManager.h"
 #include "Visualization.h"
 #include <Actuators/Schutte1993Muscle_Deprecated.h>
 #include <OpenSim/Common/CSVFileAdapter.h>
@@ -69,6 +69,11 @@ void run() {
     auto syncRate = ini.getReal(section, "SYNC_MANAGER_RATE", 0);
     auto syncThreshold = ini.getReal(section, "SYNC_MANAGER_THRESHOLD", 0);
 
+    // real-time configuration of the listening thread
+    auto listenThreadPolicy = threadPoliciesFromString(
+            ini.getString(section, "LISTEN_THREAD_CPUS", ""),
+            ini.getString(section, "LISTEN_THREAD_PRIORITY", ""))[0];
+
     // subject data
     auto subjectDir = DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
     auto modelFile = subjectDir + ini.getString(section, "MODEL_FILE", "");
@@ -91,6 +96,7 @@ void run() {
     auto imuLogger = driver.initializeLogger();
 
     // start listening
+    driver.setThreadPolicy(listenThreadPolicy);
     thread listen(&NGIMUInputDriver::startListening, &driver);
 
     // imu calibrator
@@ -101,7 +107,8 @@ void run() {
     clb.calibrateIMUTasks(imuTasks);
 
     // sensor data synchronization
-    SyncManager manager(syncRate, syncThreshold);
+    RingSyncManager manager(syncRate, syncThreshold);
+    manager.setStreamDescriptors(driver.getStreamDescriptors());
 
     // setup filters
     LowPassSmoothFilter::Parameters filterParam;
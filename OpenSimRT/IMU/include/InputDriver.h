@@ -28,8 +28,10 @@
  */
 #pragma once
 
-#include "CircularBuffer.h"
+#include "SPSCCircularBuffer.h"
+#include "ThreadPolicy.h"
 #include "internal/IMUExports.h"
+#include <cstdint>
 #include <map>
 #include <vector>
 
@@ -72,6 +74,23 @@ template <typename T> class IMU_API InputDriver {
      */
     virtual IMUDataList getData() const = 0;
 
+    /**
+     * Real-time configuration (CPU pinning, SCHED_FIFO priority) of the
+     * listening thread. Must be set before startListening().
+     */
+    void setThreadPolicy(const ThreadPolicy& policy) { threadPolicy = policy; }
+
+    /**
+     * Number of samples that were discarded by the buffers of all ports.
+     */
+    std::uint64_t getNumDroppedSamples() const {
+        std::uint64_t numDropped = 0;
+        for (const auto& port : buffer) {
+            numDropped += port.second->getNumDropped();
+        }
+        return numDropped;
+    }
+
  protected:
     InputDriver() noexcept {};                           // ctor
     InputDriver& operator=(const InputDriver&) = delete; // deleted assign ctor
@@ -84,11 +103,19 @@ template <typename T> class IMU_API InputDriver {
     std::vector<std::shared_ptr<ListenerAdapter<T>>> listeners;
 
     /**
-     * A map with thread-safe buffers to store IMU data from each port.
+     * A map with lock-free buffers to store IMU data from each port (the
+     * listening thread is the producer and the caller of getData() is the
+     * consumer). Samples that arrive while the consumer holds a View of the
+     * buffer for too long are discarded (see getNumDroppedSamples()).
      */
-    mutable std::map<int,
-                     std::unique_ptr<CircularBuffer<CIRCULAR_BUFFER_SIZE, T>>>
+    mutable std::map<
+            int, std::unique_ptr<SPSCCircularBuffer<CIRCULAR_BUFFER_SIZE, T>>>
             buffer;
+
+    /**
+     * Policy of the listening thread.
+     */
+    ThreadPolicy threadPolicy;
 };
 
 } // namespace OpenSimRT
@@ -27,6 +27,7 @@
 #pragma once
 #include "InputDriver.h"
 #include "NGIMUData.h"
+#include "RingSyncManager.h"
 #include "ip/UdpSocket.h"
 #include <Common/TimeSeriesTable.h>
 #include <vector>
@@ -67,6 +68,13 @@ class IMU_API NGIMUInputDriver : public InputDriver<NGIMUData> {
                            const std::string& localIP,
                            const std::vector<int>& localPorts);
 
+    /**
+     * Map the timestamps of each IMU to the host clock, by estimating the
+     * drift of its clock from the receive times (default: true). Must be
+     * called after setupInput() and before startListening().
+     */
+    void setClockCorrection(bool isClockCorrected);
+
     /**
      * Attaches sockets to listeners. (Implements the startListening function
      * of the base class.)
@@ -104,6 +112,12 @@ class IMU_API NGIMUInputDriver : public InputDriver<NGIMUData> {
      */
     static DataPack asPack(const IMUDataList& imuDataList);
 
+    /**
+     * Describe the interpolation of each std::pair in asPack() for the
+     * RingSyncManager (SLERP for quaternions, linear for sensor values).
+     */
+    std::vector<StreamDescriptor> getStreamDescriptors() const;
+
     /**
      * Create an NGIMUData logger. Data from all sensors are stored with a
      * common timestamp.
@@ -27,7 +27,7 @@
 #pragma once
 #include "InputDriver.h"
 #include "NGIMUData.h"
-#include <Common/TimeSeriesTable.h>
+#include "TimeSeriesStore.h"
 #include <condition_variable>
 #include <thread>
 
@@ -40,6 +40,8 @@ class IMU_API NGIMUInputFromFileDriver : public InputDriver<NGIMUData> {
  public:
     /**
      * Create a NGIMU driver that streams data from file at a constant rate.
+     * The file is either a table (e.g., .sto), which is loaded in memory, or
+     * a TimeSeriesStore file, which is mapped without parsing.
      */
     NGIMUInputFromFileDriver(const std::string& fileName,
                              const double& sendRate);
@@ -90,11 +92,11 @@ class IMU_API NGIMUInputFromFileDriver : public InputDriver<NGIMUData> {
     void stopListening() override {}
 
  private:
-    OpenSim::TimeSeriesTable table;
+    TimeSeriesStore store;
     double rate;
 
     // buffers
-    SimTK::RowVector frame;
+    SimTK::Vector frame;
     double time;
 
     // thread related variables
@@ -27,12 +27,14 @@
  */
 #pragma once
 
+#include "ClockModel.h"
 #include "IMUListener.h"
 #include "NGIMUData.h"
 #include "osc/OscOutboundPacketStream.h"
 #include "osc/OscPacketListener.h"
 #include "osc/OscReceivedElements.h"
 #include "osc/OscTypes.h"
+#include <atomic>
 #include <bitset>
 
 namespace OpenSimRT {
@@ -46,6 +48,8 @@ class IMU_API NGIMUListener : public osc::OscPacketListener,
     NGIMUListener();            // ctor
     ~NGIMUListener() = default; // dtor
     osc::uint64 timeTag;        // timeTag of the received bundle
+    // map timeTags to the host clock (read by the listening thread)
+    std::atomic<bool> isClockCorrected;
 
  protected:
     /**
@@ -65,6 +69,8 @@ class IMU_API NGIMUListener : public osc::OscPacketListener,
 
  private:
     NGIMUData data;
+    ClockModel clock;  // drift of the IMU clock with respect to the host
+    double bundleTime; // timeTag in the host clock
     std::bitset<4> bundleReadyFlags; // number of bitset flags equal to the
                                      // message addresses required to fill a
                                      // NGIMUData object
@@ -19,6 +19,7 @@
  */
 #include "NGIMUInputDriver.h"
 #include "NGIMUListener.h"
+#include "Profiler.h"
 
 using namespace std;
 using namespace osc;
@@ -76,8 +77,8 @@ void NGIMUInputDriver::setupInput(const std::vector<std::string>& imuLabels,
         listeners[i]->driver.reset(this);
 
         // initialize manager buffer
-        buffer[ports[i]] =
-                make_unique<CircularBuffer<CIRCULAR_BUFFER_SIZE, NGIMUData>>();
+        buffer[ports[i]] = make_unique<
+                SPSCCircularBuffer<CIRCULAR_BUFFER_SIZE, NGIMUData>>();
     }
 }
 
@@ -106,7 +107,17 @@ void NGIMUInputDriver::setupTransmitters(
     }
 }
 
+void NGIMUInputDriver::setClockCorrection(bool isClockCorrected) {
+    for (auto& listener : listeners) {
+        static_pointer_cast<NGIMUListener>(listener)->isClockCorrected.store(
+                isClockCorrected, std::memory_order_relaxed);
+    }
+}
+
 void NGIMUInputDriver::startListening() {
+    // startListening blocks, thus it is executed by the listening thread
+    threadPolicy.apply();
+    PROFILE_THREAD("imu listener");
     for (int i = 0; i < listeners.size(); ++i) {
         // get IP and port info from listener
         const auto& ip = listeners[i]->ip;
@@ -128,7 +139,8 @@ void NGIMUInputDriver::stopListening() { mux.Break(); }
 NGIMUInputDriver::IMUDataList NGIMUInputDriver::getData() const {
     IMUDataList list;
     for (const auto& listener : listeners) {
-        list.push_back(buffer[listener->port]->get(CIRCULAR_BUFFER_SIZE)[0]);
+        // copy only the latest element
+        list.push_back(buffer[listener->port]->peek(1)[0]);
     }
     return list;
 }
@@ -167,6 +179,16 @@ NGIMUInputDriver::asPack(const IMUDataList& imuDataFrame) {
     return pack;
 }
 
+vector<StreamDescriptor> NGIMUInputDriver::getStreamDescriptors() const {
+    // same order as NGIMUData::getAsPack()
+    vector<StreamDescriptor> descriptors;
+    for (size_t i = 0; i < listeners.size(); ++i) {
+        descriptors.push_back(StreamDescriptor::quaternion());
+        descriptors.insert(descriptors.end(), 6, StreamDescriptor::vector());
+    }
+    return descriptors;
+}
+
 TimeSeriesTable NGIMUInputDriver::initializeLogger() const {
     vector<string> suffixes = {
             "_q1",       "_q2",       "_q3",      "_q4",        "_ax",
@@ -26,20 +26,28 @@ using namespace SimTK;
 
 NGIMUInputFromFileDriver::NGIMUInputFromFileDriver(const std::string& fileName,
                                                    const double& sendRate)
-        : table(fileName), rate(sendRate), terminationFlag(false) {}
+        : store(TimeSeriesStore::isStoreFile(fileName)
+                        ? TimeSeriesStore(fileName)
+                        : TimeSeriesStore::fromTable(
+                                  OpenSim::TimeSeriesTable(fileName))),
+          rate(sendRate), frame(store.getNumColumns(), 0.0),
+          terminationFlag(false) {}
 
 NGIMUInputFromFileDriver::~NGIMUInputFromFileDriver() { t.join(); }
 
 void NGIMUInputFromFileDriver::startListening() {
     static auto f = [&]() {
+        threadPolicy.apply();
         try {
-            for (int i = 0; i < table.getNumRows(); ++i) {
+            for (int i = 0; i < store.getNumRows(); ++i) {
                 if (shouldTerminate())
                     THROW_EXCEPTION("File stream terminated.");
                 {
                     std::lock_guard<std::mutex> lock(mu);
-                    time = table.getIndependentColumn()[i];
-                    frame = table.getMatrix()[i];
+                    // copy from the columns of the row without allocation
+                    time = store.getTime(i);
+                    auto row = store.getRow(i);
+                    for (int j = 0; j < row.size(); ++j) frame[j] = row[j];
                     newRow = true;
                 }
                 cond.notify_one();
@@ -88,7 +96,7 @@ NGIMUInputFromFileDriver::getData() const {
     cond.wait(lock,
               [&]() { return (newRow == true) || terminationFlag.load(); });
     newRow = false;
-    return fromVector(frame.getAsVector());
+    return fromVector(frame);
 }
 
 std::pair<double, std::vector<NGIMUData>> NGIMUInputFromFileDriver::getFrame() {
@@ -101,5 +109,5 @@ std::pair<double, Vector> NGIMUInputFromFileDriver::getFrameAsVector() const {
     cond.wait(lock,
               [&]() { return (newRow == true) || terminationFlag.load(); });
     newRow = false;
-    return std::make_pair(time, frame.getAsVector());
+    return std::make_pair(time, frame);
 }
@@ -19,16 +19,33 @@
  */
 #include "NGIMUListener.h"
 #include "Exception.h"
+#include "Profiler.h"
+#include "TimeConversion.h"
 
 using namespace std;
 using namespace osc;
+using namespace std::chrono;
 using namespace OpenSimRT;
 
-NGIMUListener::NGIMUListener() { bundleReadyFlags.reset(); }
+NGIMUListener::NGIMUListener() : isClockCorrected(true), bundleTime(0) {
+    bundleReadyFlags.reset();
+}
 
 void NGIMUListener::ProcessBundle(const ReceivedBundle& b,
                                   const IpEndpointName& remoteEndpoint) {
+    PROFILE_ZONE("NGIMUListener::ProcessBundle");
     timeTag = b.TimeTag();
+
+    // get a double representation of the timeTag containing the number of
+    // seconds since Unix epoch time and the fractinoal part of the NTP
+    // timeStamp. The IMU clock drifts from the clocks of the other IMUs,
+    // thus the timeTag is mapped to the host clock based on the receive time.
+    bundleTime = ntp2double(timeTag);
+    if (isClockCorrected.load(std::memory_order_relaxed)) {
+        auto receiveTime =
+                duration<double>(system_clock::now().time_since_epoch());
+        bundleTime = clock.update(bundleTime, receiveTime.count());
+    }
     for (ReceivedBundle::const_iterator i = b.ElementsBegin();
          i != b.ElementsEnd(); ++i) {
         if (i->IsBundle())
@@ -43,18 +60,13 @@ void NGIMUListener::ProcessMessage(const ReceivedMessage& m,
     // every time this function runs, it processes only one message, i.e.
     // /quaternions or /sensors, etc.
     try {
-        // get a double representation of the current timeStamp containing the
-        // number of seconds since Unix epoch time and the fractinoal part of
-        // the NTP timeStamp.
-        auto time = ntp2double(timeTag);
-
         // get /quaternions
         if (strcmp(m.AddressPattern(), "/quaternion") == 0) {
             ReceivedMessageArgumentStream args = m.ArgumentStream();
             float q1, q2, q3, q4;
             args >> q1 >> q2 >> q3 >> q4 >> osc::EndMessage;
             data.quaternion = NGIMUData::Quaternion{
-                    time, SimTK::Quaternion(q1, q2, q3, q4)};
+                    bundleTime, SimTK::Quaternion(q1, q2, q3, q4)};
             bundleReadyFlags.set(0);
         }
 
@@ -71,7 +83,7 @@ void NGIMUListener::ProcessMessage(const ReceivedMessage& m,
             data.sensors.gyroscope = SimTK::Vec3(gX, gY, gZ);
             data.sensors.magnetometer = SimTK::Vec3(mX, mY, mZ);
             data.sensors.barometer = SimTK::Vec1(barometer);
-            data.sensors.timeStamp = time;
+            data.sensors.timeStamp = bundleTime;
             bundleReadyFlags.set(1);
         }
 
@@ -81,7 +93,7 @@ void NGIMUListener::ProcessMessage(const ReceivedMessage& m,
             float ax, ay, az; // linear acceleration
             args >> ax >> ay >> az >> osc::EndMessage;
             data.linear = NGIMUData::LinearAcceleration{
-                    time, SimTK::Vec3(ax, ay, az)};
+                    bundleTime, SimTK::Vec3(ax, ay, az)};
             bundleReadyFlags.set(2);
         }
 
@@ -90,7 +102,7 @@ void NGIMUListener::ProcessMessage(const ReceivedMessage& m,
             ReceivedMessageArgumentStream args = m.ArgumentStream();
             float x;
             args >> x >> osc::EndMessage;
-            data.altitude = NGIMUData::Altitude{time, SimTK::Vec1(x)};
+            data.altitude = NGIMUData::Altitude{bundleTime, SimTK::Vec1(x)};
             bundleReadyFlags.set(3);
         }
 
@@ -0,0 +1,66 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file ConvertBinaryLog.cpp
+ *
+ * \brief Converts a binary log of BinaryLogger (e.g., the results of
+ * RealTimeAnalysis) to one .sto or .csv file per table.
+ *
+ * Usage: ConvertBinaryLog <log file> [output prefix] [.sto | .csv]
+ *
+ * The default prefix is the log file without its extension, followed by '_'
+ * (e.g., results.bin -> results_q.sto, results_tau.sto, ...).
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "BinaryLogger.h"
+#include "Exception.h"
+#include "OpenSimUtils.h"
+#include <iostream>
+
+using namespace std;
+using namespace OpenSimRT;
+
+void run(int argc, char* argv[]) {
+    if (argc < 2 || argc > 4) {
+        THROW_EXCEPTION("usage: ConvertBinaryLog <log file> [output prefix] "
+                        "[.sto | .csv]");
+    }
+    string logFile = argv[1];
+    string outputPrefix =
+            argc > 2 ? argv[2]
+                     : logFile.substr(0, logFile.find_last_of('.')) + "_";
+    string extension = argc > 3 ? argv[3] : ".sto";
+
+    BinaryLogReader reader(logFile);
+    for (int i = 0; i < reader.getNumTables(); ++i) {
+        cout << outputPrefix + reader.getTableName(i) + extension << endl;
+    }
+    OpenSimUtils::convertBinaryLog(logFile, outputPrefix, extension);
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run(argc, argv);
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,215 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TrainMuscleOptimizationSurrogate.cpp
+ *
+ * \brief Builds a data set of (q, tau) -> am pairs by solving the muscle
+ * optimization on recorded trials and trains the network that is used by
+ * MuscleOptimizationSurrogate. The data set is augmented by perturbing the
+ * generalized forces, so that the network is exposed to a wider range of
+ * loading conditions than those of the recorded trials.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "Exception.h"
+#include "INIReader.h"
+#include "MultilayerPerceptron.h"
+#include "MuscleOptimization.h"
+#include "MuscleOptimizationSurrogate.h"
+#include "OpenSimUtils.h"
+#include "Settings.h"
+#include "Utils.h"
+#include <Actuators/Thelen2003Muscle.h>
+#include <chrono>
+#include <iostream>
+
+using namespace std;
+using namespace OpenSim;
+using namespace SimTK;
+using namespace OpenSimRT;
+
+void run() {
+    INIReader ini(INI_FILE);
+    auto section = "TRAIN_SO_SURROGATE";
+    auto subjectDir = DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
+    auto modelFile = subjectDir + ini.getString(section, "MODEL_FILE", "");
+    auto ikFiles = ini.getVector(section, "IK_FILES", vector<string>());
+    auto idFiles = ini.getVector(section, "ID_FILES", vector<string>());
+    auto networkFile = subjectDir + ini.getString(section, "NETWORK_FILE", "");
+#ifndef WIN32
+    auto momentArmLibraryPath =
+            LIBRARY_OUTPUT_PATH + "/" +
+            ini.getString(section, "MOMENT_ARM_LIBRARY", "");
+#else
+    auto momentArmLibraryPath =
+            ini.getString(section, "MOMENT_ARM_LIBRARY", "");
+#endif
+
+    // so parameters
+    auto convergenceTolerance =
+            ini.getReal(section, "CONVERGENCE_TOLERANCE", 0);
+    auto memoryHistory = ini.getInteger(section, "MEMORY_HISTORY", 0);
+    auto maximumIterations = ini.getInteger(section, "MAXIMUM_ITERATIONS", 0);
+    auto objectiveExponent = ini.getInteger(section, "OBJECTIVE_EXPONENT", 0);
+    auto numberOfThreads = ini.getInteger(section, "NUMBER_OF_THREADS", 0);
+
+    // data augmentation
+    auto augmentations = ini.getInteger(section, "AUGMENTATIONS", 0);
+    auto tauNoise = ini.getReal(section, "TAU_NOISE", 0.0);
+
+    // network and training parameters
+    auto hiddenLayers = ini.getVector(section, "HIDDEN_LAYERS", vector<int>());
+    MultilayerPerceptron::TrainingParameters trainingParameters;
+    trainingParameters.epochs = ini.getInteger(section, "EPOCHS", 0);
+    trainingParameters.batchSize = ini.getInteger(section, "BATCH_SIZE", 0);
+    trainingParameters.learningRate = ini.getReal(section, "LEARNING_RATE", 0);
+    trainingParameters.seed = ini.getInteger(section, "SEED", 0);
+
+    if (ikFiles.size() != idFiles.size() || ikFiles.empty()) {
+        THROW_EXCEPTION("IK_FILES and ID_FILES must be non-empty and of the "
+                        "same size");
+    }
+
+    Object::RegisterType(Thelen2003Muscle());
+    Model model(modelFile);
+    model.initSystem();
+    auto calcMomentArm = OpenSimUtils::getMomentArmFromDynamicLibrary(
+            model, momentArmLibraryPath);
+
+    MuscleOptimization::OptimizationParameters optimizationParameters;
+    optimizationParameters.convergenceTolerance = convergenceTolerance;
+    optimizationParameters.memoryHistory = memoryHistory;
+    optimizationParameters.maximumIterations = maximumIterations;
+    optimizationParameters.objectiveExponent = objectiveExponent;
+    MuscleOptimization so(model, optimizationParameters, calcMomentArm);
+
+    // build the data set by solving the muscle optimization in batch mode
+    vector<Vector> inputs, targets;
+    Random::Gaussian random(0.0, tauNoise);
+    random.setSeed(trainingParameters.seed);
+    for (int k = 0; k < ikFiles.size(); ++k) {
+        auto qTable =
+                OpenSimUtils::getMultibodyTreeOrderedCoordinatesFromStorage(
+                        model, subjectDir + ikFiles[k], 0.01);
+        auto tauTable =
+                OpenSimUtils::getMultibodyTreeOrderedCoordinatesFromStorage(
+                        model, subjectDir + idFiles[k], 0.01);
+        for (int a = 0; a <= augmentations; ++a) {
+            // perturb the generalized forces (relative noise)
+            auto perturbedTauTable = tauTable;
+            if (a > 0) {
+                auto& tauMatrix = perturbedTauTable.updMatrix();
+                for (int i = 0; i < tauMatrix.nrow(); ++i) {
+                    for (int j = 0; j < tauMatrix.ncol(); ++j) {
+                        tauMatrix[i][j] *= 1.0 + random.getValue();
+                    }
+                }
+            }
+
+            auto t1 = chrono::high_resolution_clock::now();
+            auto batch = so.solveBatch(qTable, perturbedTauTable,
+                                       numberOfThreads);
+            auto t2 = chrono::high_resolution_clock::now();
+            cout << ikFiles[k] << " (" << a << "/" << augmentations
+                 << "): " << qTable.getNumRows() << " frames in "
+                 << chrono::duration_cast<chrono::milliseconds>(t2 - t1)
+                            .count()
+                 << " ms" << endl;
+
+            for (int i = 0; i < qTable.getNumRows(); ++i) {
+                auto q = qTable.getRowAtIndex(i).getAsVector();
+                auto tau = perturbedTauTable.getRowAtIndex(i).getAsVector();
+                inputs.push_back(MuscleOptimizationSurrogate::
+                                         createNetworkInput(q, tau));
+                targets.push_back(batch.am.getRowAtIndex(i).getAsVector());
+            }
+        }
+    }
+
+    Matrix X(inputs.size(), inputs[0].size());
+    Matrix Y(targets.size(), targets[0].size());
+    for (int i = 0; i < inputs.size(); ++i) {
+        X[i] = ~inputs[i];
+        Y[i] = ~targets[i];
+    }
+
+    // train
+    vector<int> layerSizes{X.ncol()};
+    layerSizes.insert(layerSizes.end(), hiddenLayers.begin(),
+                      hiddenLayers.end());
+    layerSizes.push_back(Y.ncol());
+    MultilayerPerceptron network(layerSizes,
+                                 MultilayerPerceptron::Activation::ReLU,
+                                 MultilayerPerceptron::Activation::Linear,
+                                 trainingParameters.seed);
+    auto t1 = chrono::high_resolution_clock::now();
+    auto loss = network.fit(X, Y, trainingParameters);
+    auto t2 = chrono::high_resolution_clock::now();
+    cout << "Trained on " << X.nrow() << " samples in "
+         << chrono::duration_cast<chrono::seconds>(t2 - t1).count()
+         << " s, loss: " << loss << endl;
+    network.save(networkFile);
+
+    // evaluate the surrogate on the (unperturbed) first trial
+    MuscleOptimizationSurrogate::Parameters surrogateParameters;
+    surrogateParameters.networkFile = networkFile;
+    surrogateParameters.projectionIterations =
+            ini.getInteger(section, "PROJECTION_ITERATIONS", 0);
+    surrogateParameters.projectionTolerance =
+            ini.getReal(section, "PROJECTION_TOLERANCE", 0);
+    surrogateParameters.fallbackThreshold =
+            ini.getReal(section, "FALLBACK_THRESHOLD", 0);
+    MuscleOptimizationSurrogate surrogate(model, surrogateParameters,
+                                          calcMomentArm);
+    auto qTable = OpenSimUtils::getMultibodyTreeOrderedCoordinatesFromStorage(
+            model, subjectDir + ikFiles[0], 0.01);
+    auto tauTable = OpenSimUtils::getMultibodyTreeOrderedCoordinatesFromStorage(
+            model, subjectDir + idFiles[0], 0.01);
+    int accurate = 0;
+    double sumResidual = 0, sumDelayUS = 0;
+    for (int i = 0; i < qTable.getNumRows(); ++i) {
+        double t = qTable.getIndependentColumn()[i];
+        auto q = qTable.getRowAtIndex(i).getAsVector();
+        auto tau = tauTable.getRowAtIndex(i).getAsVector();
+
+        auto t1 = chrono::high_resolution_clock::now();
+        auto output = surrogate.solve({t, q, tau});
+        auto t2 = chrono::high_resolution_clock::now();
+        sumDelayUS +=
+                chrono::duration_cast<chrono::microseconds>(t2 - t1).count();
+
+        sumResidual += output.residualNorm;
+        if (surrogate.isAccurate(output)) accurate++;
+    }
+    int n = qTable.getNumRows();
+    cout << "Surrogate mean delay: " << sumDelayUS / n << " us" << endl;
+    cout << "Surrogate mean residual: " << sumResidual / n << " Nm" << endl;
+    cout << "Frames below fallback threshold: " << accurate << "/" << n
+         << endl;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
@@ -25,6 +25,7 @@
  */
 #pragma once
 
+#include "KinematicsContext.h"
 #include "internal/RealTimeExports.h"
 #include <OpenSim/Simulation/Model/ExternalForce.h>
 #include <OpenSim/Simulation/Model/Force.h>
@@ -52,12 +53,25 @@ class RealTime_API ExternalWrench : public OpenSim::Force {
         SimTK::Vec3 torque;
         SimTK::Vector toVector() const;
         void fromVector(const SimTK::Vector& in);
+        /**
+         * Write or read the size() values at an offset of a vector, which
+         * must be large enough (no allocation).
+         */
+        void toVector(SimTK::Vector& out, int offset) const;
+        void fromVector(const SimTK::Vector& in, int offset);
         static int size();
     };
 
  public: /* public interface */
     ExternalWrench(const Parameters& parameters);
     Input& getInput();
+    /**
+     * Add the wrench to the body forces. This is used when the wrench does
+     * not apply its force through the force subsystem (e.g., in a
+     * KinematicsContext).
+     */
+    void addInBodyForces(const SimTK::State& state,
+                         SimTK::Vector_<SimTK::SpatialVec>& bodyForces) const;
 
  public: /* public static interface */
     /**
@@ -90,14 +104,25 @@ class RealTime_API ExternalWrench : public OpenSim::Force {
     void computeForce(const SimTK::State& state,
                       SimTK::Vector_<SimTK::SpatialVec>& bodyForces,
                       SimTK::Vector& generalizedForces) const override;
+    /**
+     * Find the frames of the parameters once, since looking up a component
+     * by path allocates.
+     */
+    void extendConnectToModel(OpenSim::Model& model) override;
 
  private: /* private data members */
     Parameters parameters;
     Input input;
+    SimTK::ReferencePtr<const OpenSim::PhysicalFrame> appliedToBody;
+    SimTK::ReferencePtr<const OpenSim::PhysicalFrame> forceExpressedInBody;
+    SimTK::ReferencePtr<const OpenSim::PhysicalFrame> pointExpressedInBody;
 };
 
 /**
  * \brief Performs inverse dynamics calculations.
+ *
+ * The kinematics are realized on a KinematicsContext, which can be shared with
+ * other analyses (e.g., JointReaction) that are evaluated on the same frame.
  */
 class RealTime_API InverseDynamics {
  public: /* public data structures */
@@ -117,7 +142,19 @@ class RealTime_API InverseDynamics {
     InverseDynamics(
             const OpenSim::Model& model,
             const std::vector<ExternalWrench::Parameters>& wrenchParameters);
+    /**
+     * Use a shared context. The external wrenches are added to the shared
+     * model, thus the context must not be initialized yet.
+     */
+    InverseDynamics(
+            const std::shared_ptr<KinematicsContext>& context,
+            const std::vector<ExternalWrench::Parameters>& wrenchParameters);
     Output solve(const Input& input);
+    /**
+     * Same as solve(input), but output.tau is reused when it has the right
+     * size.
+     */
+    void solve(const Input& input, Output& output);
     /**
      * Initialize inverse dynamics log storage. Use this to create a
      * TimeSeriesTable that can be appended with the computed generalized
@@ -126,8 +163,7 @@ class RealTime_API InverseDynamics {
     OpenSim::TimeSeriesTable initializeLogger();
 
  private: /* private data members */
-    OpenSim::Model model;
-    SimTK::State state;
+    std::shared_ptr<KinematicsContext> context;
     std::vector<ExternalWrench*> externalWrenches;
 };
 
@@ -25,6 +25,7 @@
  */
 #pragma once
 
+#include "ModelContext.h"
 #include "internal/RealTimeExports.h"
 #include <OpenSim/Common/MarkerData.h>
 #include <OpenSim/Simulation/Model/Model.h>
@@ -34,6 +35,9 @@
 
 namespace OpenSimRT {
 
+class CheckpointWriter;
+class CheckpointReader;
+
 /**
  * \brief Solves the inverse kinematics problem.
  *
@@ -86,6 +90,14 @@ class RealTime_API InverseKinematics {
                       const std::vector<MarkerTask>& markerTasks,
                       const std::vector<IMUTask>& imuTasks,
                       double constraintsWeight, double accuracy);
+    /**
+     * Constructor that shares a finalized model (see ModelContext), thus the
+     * model is not cloned and initialized again.
+     */
+    InverseKinematics(std::shared_ptr<const ModelContext> modelContext,
+                      const std::vector<MarkerTask>& markerTasks,
+                      const std::vector<IMUTask>& imuTasks,
+                      double constraintsWeight, double accuracy);
     /**
      * Track an input frame (marker and/or IMU target positions/orientation).
      */
@@ -95,6 +107,13 @@ class RealTime_API InverseKinematics {
      * TimeSeriesTable that can be appended with the computed kinematics.
      */
     OpenSim::TimeSeriesTable initializeLogger();
+    /**
+     * Save or restore the last solution, which is the initial guess of the
+     * next frame. After loadState() the next frame is tracked from the restored
+     * pose instead of a full assembly.
+     */
+    void saveState(CheckpointWriter& writer) const;
+    void loadState(CheckpointReader& reader);
 
  public: /* static methods */
     /**
@@ -157,7 +176,7 @@ class RealTime_API InverseKinematics {
                            bool isIMU);
 
  private: /* private members */
-    OpenSim::Model model;
+    std::shared_ptr<const ModelContext> modelContext;
     SimTK::State state;
     SimTK::ReferencePtr<SimTK::Assembler> assembler;
     SimTK::ReferencePtr<SimTK::Markers> markerAssemblyConditions;
@@ -35,6 +35,26 @@ namespace OpenSimRT {
  * \brief Calculates the joint reaction loads as applied on child bodies
  * expressed in ground.
  *
+ * The kinematics are realized on a KinematicsContext, which can be shared with
+ * other analyses (e.g., InverseDynamics) that are evaluated on the same frame.
+ *
+ * The reactions can be limited to a subset of the joints (e.g., hip and knee).
+ * The reaction of a joint is the Newton-Euler residual (inertial minus applied
+ * forces) of the subtree of bodies that are outboard of the joint, thus only
+ * the residuals of the bodies in the subtrees of the requested joints are
+ * evaluated. The accelerations are still obtained from the forward dynamics of
+ * the whole model, thus the selection does not reduce that part of the cost.
+ *
+ * The mobilizer reactions of all joints are used instead for models with
+ * constraints (or reversed joints), since the constraint forces are not local
+ * to a subtree, and for joints whose coordinates are actuated by force
+ * elements of the model (e.g., CoordinateLimitForce). The same holds for a
+ * frame with non-zero mobility forces at the mobilizer of a selected joint,
+ * since these are transmitted by the mobilizer but are not reaction forces.
+ * E.g., muscles with moving path points that depend on the knee angle
+ * (gait1992) apply mobility forces at the knees at every frame with muscle
+ * forces. Mobility forces within a subtree cancel out.
+ *
  * TODO: implement re-express in different frame of interest
  */
 class RealTime_API JointReaction {
@@ -48,20 +68,49 @@ class RealTime_API JointReaction {
     };
     struct Output {
         double t;
+        // reaction on the child body of each selected joint, applied at the
+        // joint center (child frame origin) and expressed in ground; element
+        // i corresponds to getJointNames()[i] (not to a mobilized body index)
         SimTK::Vector_<SimTK::SpatialVec> reactionWrench; // [m, f]^T
+        SimTK::Vector_<SimTK::Vec3> reactionPoint;        // in ground
     };
 
  public: /* public interface */
+    /**
+     * The reactions are computed for the joints in jointNames (in the given
+     * order), or for all joints of the model if jointNames is empty.
+     */
     JointReaction(
             const OpenSim::Model& model,
-            const std::vector<ExternalWrench::Parameters>& wrenchParameters);
+            const std::vector<ExternalWrench::Parameters>& wrenchParameters,
+            const std::vector<std::string>& jointNames = {});
+    /**
+     * Use a shared context. The external wrenches are added to the shared
+     * model, thus the context must not be initialized yet.
+     */
+    JointReaction(
+            const std::shared_ptr<KinematicsContext>& context,
+            const std::vector<ExternalWrench::Parameters>& wrenchParameters,
+            const std::vector<std::string>& jointNames = {});
     Output solve(const Input& input);
+    /**
+     * Same as solve(input), but the vectors of output are reused when they
+     * have the right size.
+     */
+    void solve(const Input& input, Output& output);
     /**
      * Transform the joint reactions into a Vector arranged as
      * [force[0], moment[0], point[0], ..., force[n - 1], moment[n -
-     * 1], point[n - 1]].
+     * 1], point[n - 1]], where n is the number of selected joints.
+     */
+    SimTK::Vector asForceMomentPoint(const Output& jrOutput) const;
+    void asForceMomentPoint(const Output& jrOutput, SimTK::Vector& out) const;
+    const std::vector<std::string>& getJointNames() const;
+    /**
+     * Index of a selected joint in the vectors of Output, or -1 if the joint
+     * is not selected.
      */
-    SimTK::Vector asForceMomentPoint(const Output& jrOutput);
+    int getJointIndex(const std::string& jointName) const;
     /**
      * Initialize inverse dynamics log storage. Use this to create a
      * TimeSeriesTable that can be appended with the computed generalized
@@ -70,9 +119,30 @@ class RealTime_API JointReaction {
     OpenSim::TimeSeriesTable initializeLogger();
 
  private: /* private data members */
-    OpenSim::Model model;
-    SimTK::State state;
+    std::shared_ptr<KinematicsContext> context;
     std::vector<ExternalWrench*> externalWrenches;
+
+    // selected joints
+    std::vector<std::string> jointNames;
+    std::vector<int> jointIndices;
+    std::vector<SimTK::MobilizedBodyIndex> jointMobilizedBodies;
+    std::vector<bool> isJointReversed;
+    std::vector<int> jointMobilities; // u indices of their mobilizers
+
+    // mobilized bodies that are outboard of the selected joints, in
+    // decreasing order (tip to base)
+    bool isSelectionInitialized;
+    bool useMobilizerReactionForces;
+    std::vector<SimTK::MobilizedBodyIndex> subtreeBodies;
+    std::vector<bool> isSubtreeBody;
+    SimTK::Vector_<SimTK::SpatialVec> subtreeForces;
+
+ private: /* private methods */
+    /**
+     * Resolves the mobilized bodies of the selected joints after the system
+     * of the context is initialized.
+     */
+    void initializeSelection();
 };
 
 } // namespace OpenSimRT
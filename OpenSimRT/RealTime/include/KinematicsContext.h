@@ -0,0 +1,153 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file KinematicsContext.h
+ *
+ * \brief A model and state shared between analyses, realized once per frame.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#pragma once
+
+#include "internal/RealTimeExports.h"
+#include <OpenSim/Simulation/Model/Force.h>
+#include <OpenSim/Simulation/Model/Model.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace OpenSimRT {
+
+/**
+ * \brief Applies the loads provided by the analysis that is currently
+ * evaluated on the shared model (see KinematicsContext).
+ */
+class RealTime_API ContextForce : public OpenSim::Force {
+    OpenSim_DECLARE_CONCRETE_OBJECT(ContextForce, OpenSim::Force);
+
+ public:
+    SimTK::Vector_<SimTK::SpatialVec> bodyForces;
+    SimTK::Vector mobilityForces;
+
+ protected:
+    void computeForce(const SimTK::State& state,
+                      SimTK::Vector_<SimTK::SpatialVec>& bodyForces,
+                      SimTK::Vector& generalizedForces) const override;
+};
+
+/**
+ * \brief Shared-state pipeline context. A single model and state are shared
+ * by the analyses that run in the same thread (e.g., InverseDynamics and
+ * JointReaction, or GRFMPrediction and a GaitPhaseDetector), so that the
+ * kinematic stages (Position and Velocity) are realized once per frame
+ * instead of once per analysis.
+ *
+ * Each analysis adds its own components (e.g., stations, contact geometry) to
+ * the shared model before the context is initialized. Loads that differ
+ * between analyses (external wrenches, muscle forces) are not applied through
+ * the force elements of the model; all actuators of the shared model are
+ * disabled and each analysis provides its loads to a ContextForce through
+ * clearLoads() / updBodyForces() / updMobilityForces(), which invalidate only
+ * the Dynamics stage. Force elements that are common to all analyses (e.g.,
+ * gravity, passive springs) are applied as usual.
+ *
+ * The context is not thread-safe. Analyses that run in different threads must
+ * use different contexts.
+ *
+ * ****************************************************************************
+ * Example code:
+ * ****************************************************************************
+ *
+ * auto context = std::make_shared<KinematicsContext>(model);
+ * InverseDynamics id(context, wrenchParameters);
+ * JointReaction jr(context, wrenchParameters);
+ * context->initialize();
+ * ...
+ * auto idOutput = id.solve({t, q, qDot, qDDot, wrenches}); // realizes q, qDot
+ * auto jrOutput = jr.solve({t, q, qDot, fm, wrenches}); // reuses kinematics
+ */
+class RealTime_API KinematicsContext {
+ public:
+    KinematicsContext(const OpenSim::Model& model);
+    KinematicsContext(const KinematicsContext&) = delete;
+    KinematicsContext& operator=(const KinematicsContext&) = delete;
+
+    /**
+     * Access to the shared model in order to add components. Throws if the
+     * context is already initialized.
+     */
+    OpenSim::Model& updModel();
+    const OpenSim::Model& getModel() const;
+    const SimTK::State& getState() const;
+
+    /**
+     * Initialize the system of the shared model. Called automatically upon
+     * the first update() if not called explicitly.
+     */
+    void initialize();
+    bool isInitialized() const;
+
+    /**
+     * Coordinate names in multibody tree order, cached upon initialization
+     * (throws if the context is not initialized).
+     */
+    const std::vector<std::string>&
+    getCoordinateNamesInMultibodyTreeOrder() const;
+
+    /**
+     * Update the generalized coordinates and speeds (multibody tree order)
+     * and realize the state up to the Velocity stage. Calls with the same
+     * frame data (e.g., from the second analysis of the frame) do not
+     * realize the state again.
+     */
+    void update(double t, const SimTK::Vector& q, const SimTK::Vector& qDot);
+
+    /**
+     * Clear the loads of the previous analysis and invalidate the Dynamics
+     * stage. The loads can be then provided with updBodyForces() and
+     * updMobilityForces().
+     */
+    void clearLoads();
+    SimTK::Vector_<SimTK::SpatialVec>& updBodyForces();
+    SimTK::Vector& updMobilityForces();
+    const SimTK::Vector& getMobilityForces() const;
+
+    /**
+     * Realize the shared state to the given stage (e.g., Dynamics or
+     * Acceleration) using the current loads.
+     */
+    void realize(const SimTK::Stage& stage);
+
+    /**
+     * Number of times the kinematic stages have been realized (i.e., number
+     * of distinct frames).
+     */
+    int getNumKinematicRealizations() const;
+
+ private:
+    OpenSim::Model model;
+    SimTK::State state;
+    SimTK::ReferencePtr<ContextForce> contextForce;
+    std::vector<std::string> coordinateNames;
+    bool initialized;
+    bool isFrameValid;
+    int numKinematicRealizations;
+};
+
+} // namespace OpenSimRT
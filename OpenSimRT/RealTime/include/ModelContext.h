@@ -0,0 +1,103 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ *
+ * @file ModelContext.h
+ *
+ * \brief A model that is finalized once and shared (read-only) by the
+ * analyses, with cached metadata.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#pragma once
+
+#include "internal/RealTimeExports.h"
+#include <OpenSim/Simulation/Model/Model.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace OpenSimRT {
+
+/**
+ * \brief Immutable model shared by the analyses. The model is cloned and its
+ * system is initialized once, and the metadata that the analyses and the
+ * loggers derive from it (e.g., coordinates in multibody tree order, muscle
+ * names) are cached, instead of cloning and initializing the model in every
+ * analysis and for every logger.
+ *
+ * Analyses that only read the model or realize their own state on the shared
+ * system (InverseKinematics, MuscleOptimization, MarkerReconstruction) share
+ * the context; Simbody systems can be realized concurrently from different
+ * threads, given that each thread owns its state. Analyses that add
+ * components to the model (e.g., KinematicsContext) must use a copy of the
+ * model (cloneModel()).
+ *
+ * ****************************************************************************
+ * Example code:
+ * ****************************************************************************
+ *
+ * auto modelContext = std::make_shared<ModelContext>(model); // once
+ * InverseKinematics ik(modelContext, markerTasks, imuTasks, Infinity, 1e-5);
+ * MuscleOptimization so(modelContext, soParameters, momentArmFunction);
+ * auto kinematics = std::make_shared<KinematicsContext>(
+ *         modelContext->getModel()); // copy for ID and JR
+ */
+class RealTime_API ModelContext {
+ public:
+    ModelContext(const OpenSim::Model& model);
+    ModelContext(const ModelContext&) = delete;
+    ModelContext& operator=(const ModelContext&) = delete;
+
+    /**
+     * The finalized model (initialized system) and its default state.
+     */
+    const OpenSim::Model& getModel() const;
+    const SimTK::State& getDefaultState() const;
+
+    /**
+     * A copy of the model that can be modified (not initialized).
+     */
+    std::unique_ptr<OpenSim::Model> cloneModel() const;
+
+    /**
+     * Cached metadata.
+     */
+    const std::vector<std::string>&
+    getCoordinateNamesInMultibodyTreeOrder() const;
+    const std::vector<std::string>& getCoordinateNames() const;
+    const std::vector<std::string>& getMuscleNames() const;
+    const std::vector<std::string>& getActuatorNames() const;
+
+    /**
+     * Time spent to clone and initialize the model (s).
+     */
+    double getInitializationTime() const;
+
+ private:
+    std::unique_ptr<OpenSim::Model> model;
+    SimTK::State defaultState;
+    std::vector<std::string> coordinateNamesInMultibodyTreeOrder;
+    std::vector<std::string> coordinateNames;
+    std::vector<std::string> muscleNames;
+    std::vector<std::string> actuatorNames;
+    double initializationTime;
+};
+
+} // namespace OpenSimRT
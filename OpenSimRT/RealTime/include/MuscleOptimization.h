@@ -25,25 +25,61 @@
  */
 #pragma once
 
+#include "ModelContext.h"
 #include "OpenSimUtils.h"
+#include "ThreadPool.h"
 #include "internal/RealTimeExports.h"
 #include <OpenSim/Simulation/Model/Model.h>
 #include <functional>
+#include <memory>
 
 namespace OpenSimRT {
 
 // forward declaration
 class TorqueBasedTarget;
+class CheckpointWriter;
+class CheckpointReader;
 
 /**
  * \brief Solves the muscle optimization problem.
+ *
+ * Coordinates that are not spanned by any muscle are excluded from the
+ * problem, since they cannot be balanced by muscle forces.
+ *
+ * The problem is block-separable when groups of muscles span disjoint groups
+ * of coordinates (e.g., right leg, left leg and trunk). If enabled, the
+ * independent blocks are detected from the sparsity pattern of the moment arm
+ * matrix upon construction and each block is solved as a smaller problem. The
+ * results are merged into the same Output. The blocks are solved in the
+ * calling thread, unless OpenSimRT is configured with USE_THREAD_SAFE_IPOPT
+ * (Ipopt built with a thread-safe linear solver, e.g., MA27 or Pardiso) and
+ * numberOfThreads > 1, in which case they are distributed to a pool of worker
+ * threads.
  */
 class RealTime_API MuscleOptimization {
  public:
-    OpenSim::Model model;
+    /**
+     * Independent sub-problem of the muscle optimization. Coordinate indices
+     * refer to the rows of the moment arm matrix (multibody tree order) and
+     * muscle indices to its columns.
+     */
+    struct Block {
+        std::vector<int> coordinateIndices;
+        std::vector<int> muscleIndices;
+        std::unique_ptr<TorqueBasedTarget> target;
+        std::unique_ptr<SimTK::Optimizer> optimizer;
+        SimTK::Vector parameterSeeds;
+    };
+
+    std::shared_ptr<const OpenSim::Model> model; // read-only
     SimTK::ReferencePtr<SimTK::Optimizer> optimizer;
     SimTK::ReferencePtr<TorqueBasedTarget> target;
     SimTK::Vector parameterSeeds;
+    std::vector<Block> blocks; // empty when the problem is solved as a whole
+    // coordinates that are not spanned by any muscle and thus are excluded
+    // from the problem (their generalized forces are not balanced)
+    std::vector<int> unspannedCoordinateIndices;
+    std::unique_ptr<ThreadPool> pool; // workers for the blocks (if any)
     struct Input {
         double t;
         SimTK::Vector q;
@@ -60,18 +96,80 @@ class RealTime_API MuscleOptimization {
         int memoryHistory;           // 50
         int maximumIterations;       // 50
         int objectiveExponent;       // 2
+        bool useBlockDecomposition = true; // solve independent blocks
+        // threads used for the blocks (only with USE_THREAD_SAFE_IPOPT)
+        int numberOfThreads = 1;
+    };
+    struct BatchOutput {
+        OpenSim::TimeSeriesTable am;
+        OpenSim::TimeSeriesTable fm;
     };
+    OptimizationParameters optimizationParameters;
 
  public:
     MuscleOptimization(const OpenSim::Model& model,
                        const OptimizationParameters& optimizationParameters,
                        const MomentArmFunctionT& momentArmFunction);
+    /**
+     * Constructor that shares a finalized model (see ModelContext).
+     */
+    MuscleOptimization(std::shared_ptr<const ModelContext> modelContext,
+                       const OptimizationParameters& optimizationParameters,
+                       const MomentArmFunctionT& momentArmFunction);
     Output solve(const Input& input);
+    /**
+     * Change the convergence tolerance and the iteration limit of the
+     * optimizer (and the optimizers of the blocks) between frames, e.g., to
+     * trade accuracy for latency when the analysis falls behind.
+     */
+    void setConvergenceCriteria(double convergenceTolerance,
+                                int maximumIterations);
+    /**
+     * Solve the muscle optimization for all frames of a trial (offline). The
+     * generalized coordinates and forces are provided as tables in multibody
+     * tree order with matching rows. If OpenSimRT is configured with
+     * USE_THREAD_SAFE_IPOPT, frames are split into contiguous chunks that are
+     * distributed to worker threads (0: hardware concurrency), otherwise a
+     * single worker solves all frames, since Ipopt is not thread-safe.
+     * Each worker owns its own TorqueBasedTarget and Optimizer and
+     * warm-starts along its chunk, starting a few frames earlier so that the
+     * first frames of a chunk are not solved from a cold start. Results are
+     * stored in tables created by initializeMuscleLogger().
+     */
+    BatchOutput solveBatch(const OpenSim::TimeSeriesTable& qTable,
+                           const OpenSim::TimeSeriesTable& tauTable,
+                           int numberOfThreads = 0);
+    /**
+     * Detect the independent blocks of the problem from the sparsity pattern
+     * of the moment arm matrix R (coordinates x muscles). The first six rows
+     * (pelvis) are ignored. Only blocks with at least one coordinate and one
+     * muscle are returned as pairs of {coordinate indices, muscle indices},
+     * thus coordinates that are not spanned by any muscle (see
+     * findUnspannedCoordinates()) and muscles that do not span any coordinate
+     * are not part of any block.
+     */
+    static std::vector<std::pair<std::vector<int>, std::vector<int>>>
+    findIndependentBlocks(const SimTK::Matrix& R);
+    /**
+     * Coordinates (rows of R, except the pelvis) with no non-zero moment arm.
+     */
+    static std::vector<int> findUnspannedCoordinates(const SimTK::Matrix& R);
     /**
      * Initialize muscle optimization log storage. Use this to create a
      * TimeSeriesTable that can be appended with the computed kinematics.
      */
     OpenSim::TimeSeriesTable initializeMuscleLogger();
+    /**
+     * Save or restore the parameter seeds (warm start of the next frame). The
+     * seeds of the blocks are copied from parameterSeeds on each solve.
+     */
+    void saveState(CheckpointWriter& writer) const;
+    void loadState(CheckpointReader& reader);
+
+ private:
+    MuscleOptimization(std::shared_ptr<const OpenSim::Model> model,
+                       const OptimizationParameters& optimizationParameters,
+                       const MomentArmFunctionT& momentArmFunction);
 };
 
 /**
@@ -86,16 +184,28 @@ class RealTime_API MuscleOptimization {
 class RealTime_API TorqueBasedTarget : public SimTK::OptimizerSystem {
  public:
     int p;
-    SimTK::ReferencePtr<OpenSim::Model> model;
+    SimTK::ReferencePtr<const OpenSim::Model> model;
     SimTK::State state;
     SimTK::Matrix R;
     SimTK::Vector fMax, tau;
     MomentArmFunctionT calcMomentArm;
+    std::vector<int> coordinateIndices; // rows of R included in the problem
+    std::vector<int> muscleIndices;     // columns of R included in the problem
 
  public:
-    TorqueBasedTarget(OpenSim::Model* model, int objectiveExponent,
+    TorqueBasedTarget(const OpenSim::Model* model, int objectiveExponent,
                       const MomentArmFunctionT& momentArmFunction);
+    TorqueBasedTarget(const OpenSim::Model* model, int objectiveExponent,
+                      const MomentArmFunctionT& momentArmFunction,
+                      const std::vector<int>& coordinateIndices,
+                      const std::vector<int>& muscleIndices);
     void prepareForOptimization(const MuscleOptimization::Input& input);
+    /**
+     * Extract the sub-problem from the full moment arm matrix and generalized
+     * forces (multibody tree order, including the pelvis).
+     */
+    void prepareForOptimization(const SimTK::Matrix& RFull,
+                                const SimTK::Vector& tauFull);
     SimTK::Vector extractMuscleForces(const SimTK::Vector& x) const;
 
  protected:
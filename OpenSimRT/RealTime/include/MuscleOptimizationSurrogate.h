@@ -0,0 +1,89 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file MuscleOptimizationSurrogate.h
+ *
+ * \brief Learned approximation of the muscle optimization problem.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#pragma once
+
+#include "MultilayerPerceptron.h"
+#include "MuscleOptimization.h"
+#include "internal/RealTimeExports.h"
+
+namespace OpenSimRT {
+
+/**
+ * \brief Approximates the solution of the muscle optimization with a neural
+ * network that is trained offline on solutions of MuscleOptimization (see
+ * TrainMuscleOptimizationSurrogate application).
+ *
+ * The network maps the generalized coordinates and forces, excluding the
+ * pelvis, [q(6:), tau(6:)] to the muscle activations am. The prediction is
+ * not guaranteed to satisfy the constraints of the problem, thus it is
+ * projected onto the feasible set {a : R diag(fMax) a = tau, a >= 0} with
+ * Dykstra's alternating projections (in activation space, so that the
+ * correction is distributed proportional to the strength of each muscle). The
+ * residual (R fm - tau) of the projected solution is reported, so that the
+ * caller can fall back to the exact solver when it exceeds a threshold (see
+ * isAccurate()).
+ */
+class RealTime_API MuscleOptimizationSurrogate {
+ public:
+    struct Parameters {
+        std::string networkFile;    // trained MultilayerPerceptron
+        int projectionIterations;   // 20
+        double projectionTolerance; // 1e-3 (Nm)
+        double fallbackThreshold;   // 1.0 (Nm), max residual norm
+    };
+    struct Output {
+        double t;
+        SimTK::Vector am;
+        SimTK::Vector fm;
+        SimTK::Vector residuals; // R fm - tau (coordinates excluding pelvis)
+        double residualNorm;
+    };
+
+    Parameters parameters;
+    MultilayerPerceptron network;
+    MomentArmFunctionT calcMomentArm;
+    SimTK::Vector fMax;
+
+ public:
+    MuscleOptimizationSurrogate(const OpenSim::Model& model,
+                                const Parameters& parameters,
+                                const MomentArmFunctionT& momentArmFunction);
+    Output solve(const MuscleOptimization::Input& input);
+    /**
+     * True if the residual of the solution is below the fallback threshold.
+     */
+    bool isAccurate(const Output& output) const;
+    /**
+     * The input of the network [q(6:), tau(6:)].
+     */
+    static SimTK::Vector createNetworkInput(const SimTK::Vector& q,
+                                            const SimTK::Vector& tau);
+
+ private:
+    SimTK::Vector x; // network input buffer
+};
+
+} // namespace OpenSimRT
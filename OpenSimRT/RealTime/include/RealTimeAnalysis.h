@@ -27,16 +27,25 @@
  */
 #pragma once
 
-#include "CircularBuffer.h"
+#include "BinaryLogger.h"
+#include "Checkpoint.h"
 #include "InverseDynamics.h"
 #include "InverseKinematics.h"
 #include "JointReaction.h"
+#include "LoadGovernor.h"
+#include "ModelContext.h"
 #include "MuscleOptimization.h"
+#include "MuscleOptimizationSurrogate.h"
 #include "OpenSimUtils.h"
-#include "RealTimeAnalysis.h"
+#include "SPSCQueue.h"
 #include "SignalProcessing.h"
+#include "Telemetry.h"
+#include "ThreadPolicy.h"
+#include "TripleBuffer.h"
 #include "internal/RealTimeExports.h"
 #include <atomic>
+#include <memory>
+#include <thread>
 
 namespace OpenSimRT {
 /**
@@ -57,11 +66,47 @@ typedef std::function<MotionCaptureInput()> DataAcquisitionFunction;
 
 /**
  * @brief Provides a convinient interface for performing RT musculoskeletal
- * analysis. It creates one thread for the data acquisition, IK and filtering,
- * and one processing thread for the rest the analysis (ID, SO and JR).
+ * analysis. The analysis is a pipeline of stages (acquisition, IK, filtering,
+ * ID, SO, JR and publishing of the results) that are grouped into threads
+ * connected by bounded lock-free queues. By default, one thread performs the
+ * data acquisition, IK and filtering, and one processing thread performs the
+ * rest of the analysis (ID, SO and JR).
  */
 class RealTime_API RealTimeAnalysis {
  public:
+    /**
+     * Stages of the analysis, in the order of execution.
+     */
+    enum class PipelineStage { ACQUIRE, IK, FILTER, ID, SO, JR, PUBLISH };
+
+    /**
+     * Quality of the analysis of a frame, from full quality to the cheapest
+     * analysis. If load shedding is enabled, a LoadGovernor compares the
+     * latency of the thread of SO to the acquisition period and lowers the
+     * quality when the thread falls behind, so that the output rate is
+     * sustained. The results of SO and JR that are not solved at a frame are
+     * held from the latest frame that they were solved.
+     */
+    enum class QualityLevel {
+        FULL,         // SO and JR with nominal settings on every frame
+        RELAXED_SO,   // SO with relaxed convergence criteria
+        SKIP_JR,      // relaxed SO, JR is not solved
+        DECIMATED_SO, // relaxed SO on every k-th frame, JR is not solved
+        NO_SO         // SO and JR are not solved
+    };
+
+    /**
+     * Bounded queue (see SPSCQueue) that connects two consecutive threads of
+     * the pipeline, thus the throughput is limited by the slowest thread
+     * rather than the sum of all stages. The overflow policy determines what
+     * happens when the producer thread is faster than the consumer (see
+     * getNumDroppedFrames()).
+     */
+    struct QueueParameters {
+        int capacity;                  // 1
+        OverflowPolicy overflowPolicy; // DROP_OLDEST
+    };
+
     struct FilteredData {
         double t;
         SimTK::Vector q;
@@ -73,7 +118,8 @@ class RealTime_API RealTimeAnalysis {
          * Assigns the struct fields of FilteredData from SimTK::Vectors. The
          * first nq elements of the input SimTK::Vectors contain the filtered
          * generalized coordinates (and derivatives), and the rest elements
-         * correspond to the filtered wrench data.
+         * correspond to the filtered wrench data. The existing storage is
+         * reused (no allocation in the steady state).
          */
         void fromVector(const double& time, const SimTK::Vector& x,
                         const SimTK::Vector& xd, const SimTK::Vector& xdd,
@@ -96,10 +142,27 @@ class RealTime_API RealTimeAnalysis {
         SimTK::Vector am;
         SimTK::Vector fm;
         SimTK::Vector residuals;
+        bool isSurrogateSolution; // SO solved by the surrogate
+        double surrogateResidual; // residual norm of the surrogate (or NaN)
 
         // JRA
         SimTK::Vector_<SimTK::SpatialVec> reactionWrenches;
         SimTK::Vector reactionWrenchVector; // alternative representation
+
+        // load shedding level applied to the frame
+        QualityLevel qualityLevel = QualityLevel::FULL;
+    };
+
+    /**
+     * Data of a frame that flow through the stages of the pipeline.
+     */
+    struct Frame {
+        Telemetry::Clock::time_point acquisitionTime; // sample arrival
+        MotionCaptureInput acquisitionData;
+        InverseKinematics::Output pose;
+        FilteredData filteredData;
+        Output output;
+        std::uint64_t workerTime; // time of JR in a worker (ns)
     };
 
     struct Parameters {
@@ -115,13 +178,90 @@ class RealTime_API RealTimeAnalysis {
         double ikConstraintsWeight;
         double ikAccuracy;
 
+        // pipeline layout; the stages of each thread are executed in order and
+        // consecutive threads are connected by queues (one QueueParameters per
+        // connection, or a single one for all connections)
+        std::vector<std::vector<PipelineStage>> pipelineThreads = {
+                {PipelineStage::ACQUIRE, PipelineStage::IK,
+                 PipelineStage::FILTER},
+                {PipelineStage::ID, PipelineStage::SO, PipelineStage::JR,
+                 PipelineStage::PUBLISH}};
+        std::vector<QueueParameters> pipelineQueues = {
+                {1, OverflowPolicy::DROP_OLDEST}};
+
+        // real-time configuration of the threads (one ThreadPolicy per
+        // thread, or a single one for all threads); if lockMemory is set, the
+        // memory is locked and prefaultHeapSize bytes of heap are prefaulted
+        // after warmUpFrames frames have been published
+        std::vector<ThreadPolicy> pipelineThreadPolicies = {ThreadPolicy()};
+
+        // JR has no state across frames, thus consecutive frames can be
+        // solved concurrently; if jointReactionWorkers > 1, the thread of JR
+        // (which must not contain other stages) dispatches the frames to the
+        // workers and passes the results to the next thread in order (e.g.,
+        // "acquire ik filter | id so | jr | publish")
+        int jointReactionWorkers = 1;
+        bool lockMemory = false;
+        std::size_t prefaultHeapSize = 0;
+        int warmUpFrames = 100;
+
         // id + jr parameters
         std::vector<ExternalWrench::Parameters> wrenchParameters;
+        std::vector<std::string> reactionJoints; // jr joints, all if empty
 
         // so parameters
         bool solveMuscleOptimization;
         MuscleOptimization::OptimizationParameters muscleOptimizationParameters;
         MomentArmFunctionT momentArmFunction;
+
+        // so surrogate (optional), the exact solver is used when the residual
+        // of the surrogate exceeds the threshold
+        bool useMuscleOptimizationSurrogate = false;
+        MuscleOptimizationSurrogate::Parameters
+                muscleOptimizationSurrogateParameters;
+
+        // load shedding (optional); the maximum level of the governor is the
+        // cheapest QualityLevel that may be applied
+        bool useLoadShedding = false;
+        LoadGovernor::Parameters loadGovernorParameters = {
+                static_cast<int>(QualityLevel::NO_SO), 0.9, 0.6, 0.2, 50, 5};
+        double relaxedConvergenceTolerance = 10; // so at RELAXED_SO and below
+        int relaxedMaximumIterations = 15;
+        int decimationFactor = 3; // so is solved every k-th frame
+
+        // asynchronous logging of the results to a binary file (optional),
+        // with one table per logger of initializeLoggers(); the file can be
+        // converted with OpenSimUtils::convertBinaryLog
+        std::string binaryLogFile;
+        BinaryLogger::Parameters binaryLoggerParameters = {4096, 1.0};
+
+        // periodic checkpoints of the state of the stages (optional); each
+        // thread serializes the state of its stages every checkpointInterval
+        // seconds (one section per stage) and a background thread writes the
+        // latest sections to checkpointFile; if restoreFromCheckpoint is set,
+        // the state is restored from the file before the threads start
+        std::string checkpointFile;
+        double checkpointInterval = 1.0;
+        bool restoreFromCheckpoint = false;
+    };
+
+    /**
+     * Duration of a step of the construction of the analysis.
+     */
+    struct StartupStep {
+        std::string name;
+        double duration; // s
+    };
+
+    /**
+     * Results and performance of a replay.
+     */
+    struct ReplayReport {
+        int numFrames;                 // frames that were published
+        double duration;               // wall-clock time (s)
+        double framesPerSecond;        // throughput
+        Telemetry::Snapshot telemetry; // per-stage time breakdown
+        std::vector<Output> results;   // results of every frame, in order
     };
 
     struct Loggers {
@@ -148,13 +288,26 @@ class RealTime_API RealTimeAnalysis {
     virtual ~RealTimeAnalysis() = default; // dtor
 
     /**
-     * Start the simulation. It creates one thread for acquiring data, solving
-     * IK and filtering, and one thread for performing the rest of the analysis
-     * (ID, SO and JR). The threads are detached and terminated when simulation
-     * ends or signaled from the main thread.
+     * Start the simulation. It creates one thread for each group of stages in
+     * Parameters::pipelineThreads. The threads are detached and terminated
+     * when simulation ends or signaled from the main thread.
      */
     void run();
 
+    /**
+     * Replay a recorded trial as fast as possible, instead of run(). Every
+     * frame that is provided by the data acquisition function, until it
+     * throws at the end of the trial, goes through all stages in order. The
+     * queues and the binary log are lossless (block) during the replay (their
+     * policies are restored afterwards), load shedding is disabled and nothing
+     * waits for real time, thus the results are reproducible and the
+     * throughput is the maximum sustainable rate of the pipeline. Blocks until
+     * all frames are processed. The binary log, if any, is closed afterwards.
+     * If collectResults is false, ReplayReport::results is empty (e.g., for
+     * long trials, or when the results are received by a subscriber).
+     */
+    ReplayReport replay(bool collectResults = true);
+
     /**
      * Check the termination flag if it has been raised.
      */
@@ -165,59 +318,276 @@ class RealTime_API RealTimeAnalysis {
      */
     void shouldTerminate(bool flag);
 
+    typedef SnapshotPublisher<Output>::Subscriber ResultsSubscriber;
+    typedef SnapshotPublisher<Output>::Callback ResultsCallback;
+
     /**
-     * Thread safe fetch function of analysis results.
+     * Thread safe fetch function of analysis results. Waits until new results
+     * are published; if the analysis is terminated, the latest results are
+     * returned. Intended for a single consumer (e.g., the main thread), other
+     * consumers should use their own subscriber.
      */
     Output getResults();
 
     /**
-     * Initialize module loggers.
+     * Add an independent subscriber of the results, that polls or waits for
+     * new results at its own rate. The results are published without locks
+     * (see SnapshotPublisher), thus the analysis is never blocked by the
+     * subscribers. Must be called before run().
+     */
+    ResultsSubscriber& subscribeToResults();
+
+    /**
+     * Invoke the callback for every new result on a dedicated thread, thus a
+     * slow callback does not delay the analysis. Must be called before run().
+     */
+    void addResultsCallback(const ResultsCallback& callback);
+
+    /**
+     * Initialize module loggers. The loggers accumulate the results in
+     * memory, Parameters::binaryLogFile should be preferred for long sessions.
      */
     Loggers initializeLoggers();
 
+    /**
+     * Number of frames that were dropped by each queue of the pipeline.
+     */
+    std::vector<std::size_t> getNumDroppedFrames() const;
+
+    /**
+     * Snapshot of the latency of each stage, the end-to-end latency (from
+     * the arrival of a sample to the publication of its results), the depth
+     * of the queues and the number of dropped frames. Latencies are in
+     * microseconds.
+     */
+    Telemetry::Snapshot getTelemetry() const;
+
+    /**
+     * Export the telemetry in CSV or JSON format (based on the extension of
+     * the file), e.g., at shutdown.
+     */
+    void exportTelemetry(const std::string& fileName) const;
+
+    /**
+     * Time spent in each step of the construction (e.g., the initialization
+     * of the model and of each analysis).
+     */
+    const std::vector<StartupStep>& getStartupTimes() const;
+
+    /**
+     * Index of a joint in Output::reactionWrenches, or -1 if the joint is not
+     * selected (see Parameters::reactionJoints).
+     */
+    int getReactionJointIndex(const std::string& jointName) const;
+
+    /**
+     * Parse a pipeline layout, where the threads are separated by '|' and the
+     * stages by white space, e.g., "acquire ik filter | id so jr publish".
+     */
+    static std::vector<std::vector<PipelineStage>>
+    pipelineThreadsFromString(const std::string& layout);
+
  protected:
     /**
-     * This function is meant to be used in a separate thread to handle the data
-     * acquisition.
+     * Stages of the pipeline. A stage returns false if the frame must not be
+     * processed further (e.g., the filter is not initialized yet).
+     */
+    virtual bool acquire(Frame& frame);
+    virtual bool solveIK(Frame& frame);
+    virtual bool filter(Frame& frame);
+    virtual bool solveID(Frame& frame);
+    virtual bool solveSO(Frame& frame);
+    virtual bool solveJR(Frame& frame);
+    virtual bool publish(Frame& frame);
+
+    /**
+     * This function is meant to be used in a separate thread to execute the
+     * stages of the i-th group of Parameters::pipelineThreads.
+     */
+    void runPipelineThread(int i);
+
+    /**
+     * Thread of JR when Parameters::jointReactionWorkers > 1. Frames are
+     * dispatched to the workers round-robin and collected in the same order,
+     * thus the next thread receives them in the order of acquisition.
      */
-    virtual void acquisition();
+    void runJointReactionDispatcher(int i);
+    void runJointReactionWorker(int w);
 
     /**
-     * This function is meant to be used in a separate thread to handle the data
-     * processing.
+     * Create the threads of the pipeline (and the JR workers).
      */
-    virtual void processing();
+    std::vector<std::thread> createPipelineThreads();
 
     /**
-     * Prepare the input data for filtering.
+     * Input and output of a JR analysis, which are reused across frames.
      */
-    SimTK::Vector prepareUnfilteredData(
+    struct JointReactionBuffers {
+        JointReaction::Input input;
+        JointReaction::Output output;
+    };
+
+    /**
+     * Solve JR with the given analysis, unless JR is shed at the frame.
+     */
+    void solveJointReaction(Frame& frame, JointReaction& analysis,
+                            JointReactionBuffers& buffers);
+
+    /**
+     * Replace the reactions of a frame at which JR is shed with the latest
+     * reactions, or hold the reactions of the frame. Called in the order of
+     * the frames by the thread of JR (after the workers, if any).
+     */
+    void holdJointReaction(Frame& frame);
+
+    /**
+     * Prepare the input data for filtering. The result is written into v,
+     * which is reused when it has the right size.
+     */
+    void prepareUnfilteredData(
             const SimTK::Vector& q,
-            const std::vector<ExternalWrench::Input>& externalWrenches) const;
+            const std::vector<ExternalWrench::Input>& externalWrenches,
+            SimTK::Vector& v) const;
+
+    /**
+     * Solve the muscle optimization with the surrogate, if enabled, and fall
+     * back to the exact solver when the residual of the surrogate exceeds the
+     * threshold. The residual norm of the surrogate (NaN if not used) is
+     * returned in surrogateResidual.
+     */
+    MuscleOptimization::Output
+    solveMuscleOptimization(const MuscleOptimization::Input& input,
+                            bool& isSurrogateSolution,
+                            double& surrogateResidual);
+
+    /**
+     * Update the load governor with the latency of a frame (ns) and return the
+     * quality level of the next frame.
+     */
+    QualityLevel updateLoadGovernor(std::uint64_t latency);
+
+    /**
+     * Append the results to the binary log (thread of publish).
+     */
+    void logResults(const Output& result);
+
+    /**
+     * Record the time of a startup step that began at start.
+     */
+    void recordStartupStep(const std::string& name,
+                           const Telemetry::Clock::time_point& start);
+
+    /**
+     * Serialize or restore the state of a stage (nothing for stateless
+     * stages). Derived classes that add state to a stage (e.g., a phase
+     * detector) should extend these.
+     */
+    virtual void saveStageState(PipelineStage stage, CheckpointWriter& writer);
+    virtual void loadStageState(PipelineStage stage, CheckpointReader& reader);
+
+    /**
+     * Update the checkpoint sections of the stages of the i-th thread.
+     */
+    void updateCheckpoint(int i);
+
+    /**
+     * Restore the state of the stages from Parameters::checkpointFile.
+     */
+    void restoreCheckpoint();
 
-    OpenSim::Model model;
+    // the model is finalized once and shared by the analyses that do not
+    // modify it (IK, SO), the kinematics contexts use copies of it
+    std::shared_ptr<const ModelContext> modelContext;
+    const OpenSim::Model& model;
+    std::vector<StartupStep> startupTimes;
     Parameters parameters; // RealTimeAnalysis parameters
     Loggers log;           // loggers
-    Output output;         // analysis results
     double previousAcquisitionTime;
     double previousProcessingTime;
 
+    // kinematics shared by the analyses of the processing thread (ID, JR),
+    // if they run in the same thread
+    std::shared_ptr<KinematicsContext> processingContext;
+
     // modules
     SimTK::ReferencePtr<LowPassSmoothFilter> lowPassFilter;
     SimTK::ReferencePtr<InverseKinematics> inverseKinematics;
     SimTK::ReferencePtr<InverseDynamics> inverseDynamics;
     SimTK::ReferencePtr<MuscleOptimization> muscleOptimization;
+    SimTK::ReferencePtr<MuscleOptimizationSurrogate>
+            muscleOptimizationSurrogate;
     SimTK::ReferencePtr<JointReaction> jointReaction;
 
-    // data buffer
-    CircularBuffer<1, LowPassSmoothFilter::Output> buffer;
+    // load shedding; the governor runs in the thread of SO and the results of
+    // the stages that are shed are held (each is accessed by one thread)
+    SimTK::ReferencePtr<LoadGovernor> loadGovernor;
+    int loadSheddingThread;
+    std::atomic<double> acquisitionPeriod;
+    bool isMuscleOptimizationRelaxed;
+    int numMuscleOptimizationFrames;
+    Output heldMuscleOptimization;
+    Output heldJointReaction;
+    JointReactionBuffers jointReactionBuffers;
+
+    // inputs and outputs of the analyses, reused across frames so that the
+    // steady state of the stages does not allocate (each is accessed by the
+    // thread of its stage)
+    LowPassSmoothFilter::Input filterInput;
+    LowPassSmoothFilter::Output filterOutput;
+    InverseDynamics::Input inverseDynamicsInput;
+    InverseDynamics::Output inverseDynamicsOutput;
+    MuscleOptimization::Input muscleOptimizationInput;
+
+    // queues between consecutive threads of the pipeline; the frames are
+    // copied into the slots (see SPSCQueue::pushCopy), thus their buffers are
+    // reused
+    std::vector<std::unique_ptr<SPSCQueue<Frame>>> queues;
+
+    // JR workers, each with its own analysis (and kinematics context on a copy
+    // of the shared model) and lossless queues that connect it with the
+    // thread of JR
+    struct JointReactionWorker {
+        std::unique_ptr<JointReaction> jointReaction;
+        std::unique_ptr<SPSCQueue<Frame>> input;
+        std::unique_ptr<SPSCQueue<Frame>> output;
+        JointReactionBuffers buffers;
+    };
+    std::vector<std::unique_ptr<JointReactionWorker>> jointReactionWorkers;
+    int jointReactionThread;
+
+    // telemetry (histograms are recorded by the thread of the stage)
+    Telemetry telemetry;
+    std::vector<Histogram*> stageLatency;
+    std::vector<Histogram*> queueDepth;
+    SimTK::ReferencePtr<Histogram> endToEndLatency;
+    SimTK::ReferencePtr<Histogram> qualityLevel;
+
+    // publication of the results (the main subscriber serves getResults)
+    SnapshotPublisher<Output> resultsPublisher;
+    SimTK::ReferencePtr<ResultsSubscriber> mainResultsSubscriber;
+
+    // replay (the results are collected by the thread of the last stage)
+    bool isReplaying;
+    bool isCollectingReplayResults;
+    int numReplayFrames;
+    std::vector<Output> replayResults;
+
+    // binary log of the results, the rows are appended by the thread of
+    // publish and written by the background thread of the logger
+    struct LogTables {
+        int q, qDot, qDDot, tau, fm, am, residuals, jr;
+    };
+    std::unique_ptr<BinaryLogger> binaryLogger;
+    LogTables logTables;
+
+    // checkpoints (one section per stage), the memory of a restored filter is
+    // aligned with the first sample after the restart
+    std::unique_ptr<Checkpointer> checkpointer;
+    std::vector<int> checkpointSections;
+    bool isCheckpointerStarted;
+    bool isFilterRestored;
 
     // termination flag
     std::atomic_bool terminationFlag;
-
-    // thread synch variables
-    std::mutex mu;
-    std::condition_variable cond;
-    std::atomic_bool notifyParentThread;
 };
 } // namespace OpenSimRT
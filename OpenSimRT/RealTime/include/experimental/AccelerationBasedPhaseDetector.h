@@ -28,6 +28,7 @@
 
 #include "GRFMPrediction.h"
 #include "GaitPhaseDetector.h"
+#include "KinematicsContext.h"
 #include "SignalProcessing.h"
 #include <SimTKcommon.h>
 #include <Simulation/Model/Model.h>
@@ -71,6 +72,14 @@ class RealTime_API AccelerationBasedPhaseDetector : public GaitPhaseDetector {
     // ctor
     AccelerationBasedPhaseDetector(const OpenSim::Model& otherModel,
                                    const Parameters& parameters);
+    /**
+     * Use a shared context (e.g., with GRFMPrediction). The station points
+     * are added to the shared model, thus the context must not be initialized
+     * yet.
+     */
+    AccelerationBasedPhaseDetector(
+            const std::shared_ptr<KinematicsContext>& context,
+            const Parameters& parameters);
 
     /**
      * Update detector using the kinematic data.
@@ -78,8 +87,7 @@ class RealTime_API AccelerationBasedPhaseDetector : public GaitPhaseDetector {
     void updDetector(const GRFMPrediction::Input& input);
 
  private:
-    OpenSim::Model model;
-    SimTK::State state;
+    std::shared_ptr<KinematicsContext> context;
     Parameters parameters;
 
     // buffers with size = consecutive values. Hold values for both heel and
@@ -27,6 +27,7 @@
 #pragma once
 
 #include "GaitPhaseDetector.h"
+#include "KinematicsContext.h"
 #include <OpenSim/Simulation/Model/HuntCrossleyForce.h>
 #include <OpenSim/Simulation/Model/Model.h>
 #include <string>
@@ -59,6 +60,15 @@ class RealTime_API ContactForceBasedPhaseDetector : public GaitPhaseDetector {
     // ctor
     ContactForceBasedPhaseDetector(const OpenSim::Model&,
                                    const Parameters& parameters);
+    /**
+     * Use a shared context (e.g., with GRFMPrediction). The contact elements
+     * are added to the shared model, thus the context must not be initialized
+     * yet. The contact forces are only monitored and do not act on the shared
+     * model.
+     */
+    ContactForceBasedPhaseDetector(
+            const std::shared_ptr<KinematicsContext>& context,
+            const Parameters& parameters);
     /**
      * Update detector using the kinematic data.
      */
@@ -69,8 +79,7 @@ class RealTime_API ContactForceBasedPhaseDetector : public GaitPhaseDetector {
     SimTK::ReferencePtr<OpenSim::HuntCrossleyForce> rightContactForce;
     SimTK::ReferencePtr<OpenSim::HuntCrossleyForce> leftContactForce;
 
-    OpenSim::Model model;
-    SimTK::State state;
+    std::shared_ptr<KinematicsContext> context;
     Parameters parameters;
 };
 } // namespace OpenSimRT
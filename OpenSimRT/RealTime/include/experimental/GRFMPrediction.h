@@ -28,6 +28,7 @@
 
 #include "Exception.h"
 #include "InverseDynamics.h"
+#include "KinematicsContext.h"
 #include "SlidingWindow.h"
 #include "internal/RealTimeExports.h"
 #include <OpenSim/Simulation/Model/Model.h>
@@ -100,6 +101,13 @@ class RealTime_API GRFMPrediction {
 
     GRFMPrediction(const OpenSim::Model&, const Parameters&,
                    GaitPhaseDetector*); // ctor
+    /**
+     * Use a shared context (e.g., with the phase detector). The station
+     * points are added to the shared model, thus the context must not be
+     * initialized yet.
+     */
+    GRFMPrediction(const std::shared_ptr<KinematicsContext>&, const Parameters&,
+                   GaitPhaseDetector*);
 
     /**
      * Select the name of the method used to compute the total reaction loads
@@ -128,8 +136,7 @@ class RealTime_API GRFMPrediction {
     // gait direction based on the average direction of the pelvis anterior axis
     SlidingWindow<SimTK::Vec3> gaitDirectionBuffer;
 
-    OpenSim::Model model;
-    SimTK::State state;
+    std::shared_ptr<KinematicsContext> context;
     Parameters parameters;
 
     // gait phase detection
@@ -142,6 +149,13 @@ class RealTime_API GRFMPrediction {
     SimTK::ReferencePtr<OpenSim::Station> toeStationR;
     SimTK::ReferencePtr<OpenSim::Station> toeStationL;
 
+    // buffers of computeTotalReactionComponents, they are resized only in the
+    // first frame
+    SimTK::Vector tau;
+    SimTK::Vector_<SimTK::SpatialVec> spatialGenForces;
+    SimTK::Vector_<SimTK::SpatialVec> bodyVelocities;
+    SimTK::Vector_<SimTK::SpatialVec> bodyAccelerations;
+
     /**
      * Compute the rotation matrix required to transform the estimated total
      * GRF&M from the global reference frame to the the average heading
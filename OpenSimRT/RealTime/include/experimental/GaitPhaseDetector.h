@@ -34,6 +34,9 @@
 
 namespace OpenSimRT {
 
+class CheckpointWriter;
+class CheckpointReader;
+
 /**
  *  Interface class for event detection algorithms and gait-cycle related state.
  */
@@ -74,6 +77,13 @@ class RealTime_API GaitPhaseDetector {
      */
     const double getSingleSupportDuration();
 
+    /**
+     * Save or restore the event times, the gait phase state and the leg phase
+     * windows, so that the detector is ready immediately after a restart.
+     */
+    void saveState(CheckpointWriter& writer) const;
+    void loadState(CheckpointReader& reader);
+
  protected:
     // Function type for event detection methods in a Sliding Window.
     template <typename T>
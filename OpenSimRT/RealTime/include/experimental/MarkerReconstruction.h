@@ -25,6 +25,7 @@
  */
 #pragma once
 
+#include "FrameArena.h"
 #include "InverseKinematics.h"
 #include "internal/RealTimeExports.h"
 #include <Common/TimeSeriesTable.h>
@@ -50,6 +51,12 @@ class RealTime_API MarkerReconstruction {
     MarkerReconstruction(
             const OpenSim::Model& model,
             const std::vector<InverseKinematics::MarkerTask>& markerTasks);
+    /**
+     * Construct from a shared finalized model (see ModelContext).
+     */
+    MarkerReconstruction(
+            std::shared_ptr<const ModelContext> modelContext,
+            const std::vector<InverseKinematics::MarkerTask>& markerTasks);
 
     /**
      * Initialize internal state. Returns true if it's initialized when input is
@@ -75,6 +82,10 @@ class RealTime_API MarkerReconstruction {
     OpenSim::TimeSeriesTable_<SimTK::Vec3> initializeLogger();
 
  private:
+    MarkerReconstruction(
+            std::shared_ptr<const OpenSim::Model> model,
+            const std::vector<InverseKinematics::MarkerTask>& markerTasks);
+
     // A table alias that keeps track of the distances among markers in the same
     // body based on their location defined in the osim model.
     typedef std::map<std::string, std::map<std::string, SimTK::Vec3>>
@@ -100,30 +111,32 @@ class RealTime_API MarkerReconstruction {
 
     /**
      *  Find intersection of two spheres, i.e. a circle in the 3D space.
+     *  Returns false if the spheres do not intersect.
      */
-    Circle* sphereSphereIntersection(const Sphere& c1, const Sphere& c2);
+    bool sphereSphereIntersection(const Sphere& c1, const Sphere& c2,
+                                  Circle& circle);
 
     /**
      * Given a point, find its closest point in the circumference of a
      * given circle lying in the 3D space.
      */
-    SimTK::Vec3 closestPointToCircle(const SimTK::Vec3& vec, const Circle* c);
+    SimTK::Vec3 closestPointToCircle(const SimTK::Vec3& vec, const Circle& c);
 
     /**
      * Find the closests N markers (indexes) to the missing marker.
      *
-     * @param [mMarkerName]: name of the missing marker
+     * @param [i]: index of the missing marker
      * @param [currentObservations] - Array with positions of the markers in
      * current frame.
      * @param [numMarkers] - N closest markers
+     * @param [arena] - arena of the frame that holds the returned indices
      *
-     * @return [id1] - reference to the index of the closest marker.
-     * @return [id2] - reference to the index of the second closest marker.
+     * @return [indices] - indices of the closest markers, closest first.
      */
-    std::vector<int>
-    findClosestMarkers(const std::string& mMarkerName,
+    ArenaVector<int>
+    findClosestMarkers(int i,
                        const SimTK::Array_<SimTK::Vec3>& currentObservations,
-                       int numMarkers);
+                       int numMarkers, FrameArena& arena);
     /**
      * Overloaded function of the marker reconstruction method. Case where no
      * valid markers exist in the same body. Returns the previously known
@@ -157,11 +170,18 @@ class RealTime_API MarkerReconstruction {
      * the known markers from the previous frame to the current frame.
      */
     void reconstructionMethod(SimTK::Array_<SimTK::Vec3>& currentObservations,
-                              const int& i, const std::vector<int>& indices);
-    OpenSim::Model model;
+                              const int& i, const ArenaVector<int>& indices);
+    std::shared_ptr<const OpenSim::Model> model; // read-only
     DistanceTable markerDistanceTable;
     std::multimap<std::string, std::string> markersPerBodyMap;
     std::vector<std::string> observationOrder;
+    // per marker, the other markers in the same body ordered by distance
+    std::vector<std::vector<int>> markersByDistance;
+    // buffers of the SVD (same size in each frame)
+    SimTK::Matrix covariance;
+    SimTK::Matrix leftVectors;
+    SimTK::Matrix rightVectors;
+    SimTK::Vector singularValues;
     SimTK::Array_<SimTK::Vec3> previousObservations;
     bool isInitialized;
 };
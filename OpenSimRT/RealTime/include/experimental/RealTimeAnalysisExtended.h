@@ -51,9 +51,8 @@ typedef std::function<void(const double& t, const SimTK::Vector& q,
 /**
  * @brief Extends the facade RealTimeAnalysis class to include the experimental
  * features. Provides a convinient interface for performing RT musculoskeletal
- * analysis. It creates one thread for the data acquisition, marker
- * reconstruction IK and filtering, and one processing thread for the rest the
- * analysis (GRF&M prediction, ID, SO and JR).
+ * analysis. The marker reconstruction is performed in the IK stage and the
+ * GRF&M prediction in the filter stage of the pipeline.
  */
 class RealTime_API RealTimeAnalysisExtended : public RealTimeAnalysis {
  public:
@@ -73,6 +72,9 @@ class RealTime_API RealTimeAnalysisExtended : public RealTimeAnalysis {
         PhaseDetectorUpdateMethod detectorUpdateMethod;
         // reference to detector
         SimTK::ReferencePtr<GaitPhaseDetector> phaseDetector;
+        // kinematics shared by GRFMPrediction and the phase detector in the
+        // acquisition thread (optional, must not be initialized)
+        std::shared_ptr<KinematicsContext> acquisitionContext;
         // detector update function (with external measurements)
         ExternalPhaseDetectorUpdateFunction externalPhaseDetectorUpdateFunction;
         // detector update function (with internal estimations)
@@ -86,27 +88,34 @@ class RealTime_API RealTimeAnalysisExtended : public RealTimeAnalysis {
 
  private:
     /**
-     * This function is meant to be used in a separate thread to handle the data
-     * acquisition. It performs the IK and filtering of the generalized
-     * coordinates. Overrides the base acquisition function in order to include
-     * the experimental features.
+     * Reconstructs the missing markers before solving the IK. Requires at
+     * least one valid frame with all markers positions.
      */
-    void acquisition() override;
+    bool solveIK(Frame& frame) override;
 
     /**
-     * This function is meant to be used in a separate thread to handle the data
-     * processing. It performs the ID, SO and JR analysis. Overrides the base
-     * processing function in order to include the experimental features.
+     * Filters the IK results and predicts the ground reaction forces and
+     * moments (if enabled).
      */
-    void processing() override;
+    bool filter(Frame& frame) override;
+
+    /**
+     * The state of the phase detector is part of the filter stage, since the
+     * detector is updated by the GRF&M prediction.
+     */
+    void saveStageState(PipelineStage stage,
+                        CheckpointWriter& writer) override;
+    void loadStageState(PipelineStage stage,
+                        CheckpointReader& reader) override;
 
     // modules
     SimTK::ReferencePtr<GRFMPrediction> grfmPrediction;
     SimTK::ReferencePtr<MarkerReconstruction> markerReconstruction;
 
-    Parameters parameters;
+    // telemetry of the experimental modules
+    SimTK::ReferencePtr<Histogram> markerReconstructionLatency;
+    SimTK::ReferencePtr<Histogram> grfmPredictionLatency;
 
-    // data buffer
-    CircularBuffer<1, FilteredData> buffer;
+    Parameters parameters;
 };
 } // namespace OpenSimRT
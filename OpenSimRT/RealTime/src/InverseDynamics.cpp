@@ -20,6 +20,7 @@
 #include "InverseDynamics.h"
 #include "Exception.h"
 #include "OpenSimUtils.h"
+#include "Profiler.h"
 #include "Utils.h"
 #include <OpenSim/Simulation/Model/BodySet.h>
 #include <OpenSim/Simulation/Model/Muscle.h>
@@ -57,6 +58,22 @@ void ExternalWrench::Input::fromVector(const Vector& in) {
     torque[2] = in[8];
 }
 
+void ExternalWrench::Input::toVector(Vector& out, int offset) const {
+    for (int i = 0; i < 3; ++i) {
+        out[offset + i] = point[i];
+        out[offset + 3 + i] = force[i];
+        out[offset + 6 + i] = torque[i];
+    }
+}
+
+void ExternalWrench::Input::fromVector(const Vector& in, int offset) {
+    for (int i = 0; i < 3; ++i) {
+        point[i] = in[offset + i];
+        force[i] = in[offset + 3 + i];
+        torque[i] = in[offset + 6 + i];
+    }
+}
+
 int ExternalWrench::Input::size() { return 9; }
 
 ExternalWrench::ExternalWrench(const ExternalWrench::Parameters& parameters)
@@ -64,39 +81,44 @@ ExternalWrench::ExternalWrench(const ExternalWrench::Parameters& parameters)
 
 ExternalWrench::Input& ExternalWrench::getInput() { return input; }
 
-void ExternalWrench::computeForce(const State& state,
-                                  Vector_<SpatialVec>& bodyForces,
-                                  Vector& generalizedForces) const {
-    // get references
-    const auto& engine = getModel().getSimbodyEngine();
-    const auto& appliedToBody =
-            getModel().getBodySet().get(parameters.appliedToBody);
-    const auto& forceExpressedInBody = getModel().getComponent<PhysicalFrame>(
-            parameters.forceExpressedInBody);
-    const auto& pointExpressedInBody = getModel().getComponent<PhysicalFrame>(
-            parameters.pointExpressedInBody);
+void ExternalWrench::extendConnectToModel(Model& model) {
+    Super::extendConnectToModel(model);
+    appliedToBody.reset(&model.getBodySet().get(parameters.appliedToBody));
+    forceExpressedInBody.reset(&model.getComponent<PhysicalFrame>(
+            parameters.forceExpressedInBody));
+    pointExpressedInBody.reset(&model.getComponent<PhysicalFrame>(
+            parameters.pointExpressedInBody));
+}
 
+void ExternalWrench::addInBodyForces(const State& state,
+                                     Vector_<SpatialVec>& bodyForces) const {
     // re-express point in applied body frame
     Vec3 point = input.point;
-    point = pointExpressedInBody.findStationLocationInAnotherFrame(
-            state, point, appliedToBody);
+    point = pointExpressedInBody->findStationLocationInAnotherFrame(
+            state, point, *appliedToBody);
 
     // re-express force in ground frame
     Vec3 force = input.force;
-    force = forceExpressedInBody.expressVectorInGround(state, force);
+    force = forceExpressedInBody->expressVectorInGround(state, force);
 
     // add-in force to the corresponding slot in bodyForces
     getModel().getMatterSubsystem().addInStationForce(
-            state, appliedToBody.getMobilizedBodyIndex(), point, force,
+            state, appliedToBody->getMobilizedBodyIndex(), point, force,
             bodyForces);
 
     // re-express torque in ground frame
     Vec3 torque = input.torque;
-    torque = forceExpressedInBody.expressVectorInGround(state, torque);
+    torque = forceExpressedInBody->expressVectorInGround(state, torque);
 
     // add-in torque in the corresponding slot in bodyForces
     getModel().getMatterSubsystem().addInBodyTorque(
-            state, appliedToBody.getMobilizedBodyIndex(), torque, bodyForces);
+            state, appliedToBody->getMobilizedBodyIndex(), torque, bodyForces);
+}
+
+void ExternalWrench::computeForce(const State& state,
+                                  Vector_<SpatialVec>& bodyForces,
+                                  Vector& generalizedForces) const {
+    addInBodyForces(state, bodyForces);
 }
 
 vector<string>
@@ -178,28 +200,42 @@ TimeSeriesTable ExternalWrench::initializeLogger() {
 InverseDynamics::InverseDynamics(
         const OpenSim::Model& otherModel,
         const vector<ExternalWrench::Parameters>& wrenchParameters)
-        : model(*otherModel.clone()) {
-    // add externally applied forces
+        : InverseDynamics(make_shared<KinematicsContext>(otherModel),
+                          wrenchParameters) {
+    context->initialize();
+}
+
+InverseDynamics::InverseDynamics(
+        const shared_ptr<KinematicsContext>& context,
+        const vector<ExternalWrench::Parameters>& wrenchParameters)
+        : context(context) {
+    // add externally applied forces; these are applied as loads of the
+    // context, since the shared model may be used by other analyses
     for (int i = 0; i < wrenchParameters.size(); ++i) {
         auto wrench = new ExternalWrench(wrenchParameters[i]);
+        wrench->set_appliesForce(false);
         externalWrenches.push_back(wrench);
-        model.addForce(wrench);
+        context->updModel().addForce(wrench);
     }
 
-    // disable muscles, otherwise they apply passive forces
-    state = model.initSystem();
-    for (int i = 0; i < model.getMuscles().getSize(); ++i) {
-        model.updMuscles()[i].setAppliesForce(state, false);
-    }
+    // NOTE: muscles do not apply forces since the actuators of the shared
+    // model are disabled by the context
 }
 
 InverseDynamics::Output
 InverseDynamics::solve(const InverseDynamics::Input& input) {
-    // update state
-    state.updTime() = input.t;
-    state.updQ() = input.q;
-    state.updU() = input.qDot;
-    state.updUDot() = input.qDDot;
+    Output output;
+    solve(input, output);
+    return output;
+}
+
+void InverseDynamics::solve(const InverseDynamics::Input& input,
+                            InverseDynamics::Output& output) {
+    PROFILE_ZONE("InverseDynamics::solve");
+    // update state (realized once per frame for all analyses of the context)
+    context->update(input.t, input.q, input.qDot);
+    const auto& model = context->getModel();
+    const auto& state = context->getState();
 
     // update external wrenches
     if (input.externalWrenches.size() != externalWrenches.size()) {
@@ -208,12 +244,14 @@ InverseDynamics::solve(const InverseDynamics::Input& input) {
                         " != " + toString(externalWrenches.size()));
     }
 
+    context->clearLoads();
     for (int i = 0; i < input.externalWrenches.size(); ++i) {
         externalWrenches[i]->getInput() = input.externalWrenches[i];
+        externalWrenches[i]->addInBodyForces(state, context->updBodyForces());
     }
 
     // realize to dynamics stage so that all model forces are computed
-    model.getMultibodySystem().realize(state, Stage::Dynamics);
+    context->realize(Stage::Dynamics);
 
     // get applied mobility (generalized) forces generated by components of the
     // model, like actuators
@@ -227,19 +265,21 @@ InverseDynamics::solve(const InverseDynamics::Input& input) {
                                                           Stage::Dynamics);
 
     // perform inverse dynamics
-    Output output;
     output.t = input.t;
     model.getMultibodySystem()
             .getMatterSubsystem()
             .calcResidualForceIgnoringConstraints(state, appliedMobilityForces,
                                                   appliedBodyForces,
                                                   input.qDDot, output.tau);
-    return output;
 }
 
 TimeSeriesTable InverseDynamics::initializeLogger() {
+    // the names are cached by an initialized context
     auto columnNames =
-            OpenSimUtils::getCoordinateNamesInMultibodyTreeOrder(model);
+            context->isInitialized()
+                    ? context->getCoordinateNamesInMultibodyTreeOrder()
+                    : OpenSimUtils::getCoordinateNamesInMultibodyTreeOrder(
+                              context->getModel());
 
     TimeSeriesTable q;
     q.setColumnLabels(columnNames);
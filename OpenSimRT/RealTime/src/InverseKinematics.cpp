@@ -18,8 +18,10 @@
  * -----------------------------------------------------------------------------
  */
 #include "InverseKinematics.h"
+#include "Checkpoint.h"
 #include "Exception.h"
 #include "OpenSimUtils.h"
+#include "Profiler.h"
 #include <OpenSim/Simulation/Model/BodySet.h>
 #include <OpenSim/Simulation/Model/MarkerSet.h>
 #include <OpenSim/Tools/IKCoordinateTask.h>
@@ -43,9 +45,18 @@ InverseKinematics::InverseKinematics(const OpenSim::Model& otherModel,
                                      const vector<MarkerTask>& markerTasks,
                                      const vector<IMUTask>& imuTasks,
                                      double constraintsWeight, double accuracy)
-        : model(*otherModel.clone()), assembled(false) {
-    // initialize model and assembler
-    state = model.initSystem();
+        : InverseKinematics(std::make_shared<ModelContext>(otherModel),
+                            markerTasks, imuTasks, constraintsWeight,
+                            accuracy) {}
+
+InverseKinematics::InverseKinematics(
+        std::shared_ptr<const ModelContext> modelContext,
+        const vector<MarkerTask>& markerTasks, const vector<IMUTask>& imuTasks,
+        double constraintsWeight, double accuracy)
+        : modelContext(modelContext), assembled(false) {
+    // the assembler realizes its own state on the shared system
+    const auto& model = modelContext->getModel();
+    state = modelContext->getDefaultState();
     assembler = new Assembler(model.getMultibodySystem());
     assembler->setAccuracy(accuracy);
     // assembler->setErrorTolerance(1e-3);
@@ -96,6 +107,7 @@ InverseKinematics::InverseKinematics(const OpenSim::Model& otherModel,
 }
 
 InverseKinematics::Output InverseKinematics::solve(const Input& input) {
+    PROFILE_ZONE("InverseKinematics::solve");
     state.updTime() = input.t;
     markerAssemblyConditions->moveAllObservations(input.markerObservations);
     imuAssemblyConditions->moveAllObservations(input.imuObservations);
@@ -111,14 +123,32 @@ InverseKinematics::Output InverseKinematics::solve(const Input& input) {
 }
 
 TimeSeriesTable InverseKinematics::initializeLogger() {
-    auto columnNames =
-            OpenSimUtils::getCoordinateNamesInMultibodyTreeOrder(model);
+    const auto& columnNames =
+            modelContext->getCoordinateNamesInMultibodyTreeOrder();
 
     TimeSeriesTable q;
     q.setColumnLabels(columnNames);
     return q;
 }
 
+void InverseKinematics::saveState(CheckpointWriter& writer) const {
+    writer.write(state.getQ());
+    writer.write(assembled);
+}
+
+void InverseKinematics::loadState(CheckpointReader& reader) {
+    Vector q;
+    bool wasAssembled;
+    reader.read(q);
+    reader.read(wasAssembled);
+    if (q.size() != state.getNQ()) {
+        THROW_EXCEPTION("checkpoint does not match the model coordinates");
+    }
+    state.updQ() = q;
+    assembler->initialize(state);
+    assembled = wasAssembled;
+}
+
 /******************************************************************************/
 
 void InverseKinematics::createMarkerTasksFromIKTaskSet(
@@ -19,7 +19,14 @@
  */
 #include "JointReaction.h"
 #include "Exception.h"
+#include "Profiler.h"
+#include <OpenSim/Actuators/SpringGeneralizedForce.h>
 #include <OpenSim/Simulation/Model/Actuator.h>
+#include <OpenSim/Simulation/Model/CoordinateLimitForce.h>
+#include <OpenSim/Simulation/Model/ExpressionBasedCoordinateForce.h>
+#include <OpenSim/Simulation/Model/Muscle.h>
+#include <algorithm>
+#include <set>
 
 using namespace std;
 using namespace OpenSim;
@@ -28,30 +35,87 @@ using namespace OpenSimRT;
 
 /*******************************************************************************/
 
+/**
+ * Newton-Euler residual (inertial minus applied forces) of a body as a spatial
+ * force [m, f] about the ground origin, expressed in ground. The applied
+ * forces are given at the body origin.
+ */
+static SpatialVec calcBodyResidual(const State& state,
+                                   const MobilizedBody& body,
+                                   const SpatialVec& appliedForce) {
+    const auto& massProperties = body.getBodyMassProperties(state);
+    const auto& massCenter = massProperties.getMassCenter();
+    const auto& R_GB = body.getBodyRotation(state);
+    const auto& w = body.getBodyAngularVelocity(state);
+    const auto& b = body.getBodyAngularAcceleration(state);
+    Inertia I_C = massProperties.calcCentralInertia().reexpress(~R_GB);
+    Vec3 p_C = body.findStationLocationInGround(state, massCenter);
+    Vec3 a_C = body.findStationAccelerationInGround(state, massCenter);
+    Vec3 p_B = body.getBodyOriginLocation(state);
+
+    Vec3 f = massProperties.getMass() * a_C;
+    Vec3 m = I_C * b + w % (I_C * w) + p_C % f;
+    return SpatialVec(m - appliedForce[0] - p_B % appliedForce[1],
+                      f - appliedForce[1]);
+}
+
+/*******************************************************************************/
+
 JointReaction::JointReaction(
         const OpenSim::Model& otherModel,
-        const vector<ExternalWrench::Parameters>& wrenchParameters)
-        : model(*otherModel.clone()) {
-    // add externally applied forces
+        const vector<ExternalWrench::Parameters>& wrenchParameters,
+        const vector<string>& jointNames)
+        : JointReaction(make_shared<KinematicsContext>(otherModel),
+                        wrenchParameters, jointNames) {
+    context->initialize();
+}
+
+JointReaction::JointReaction(
+        const shared_ptr<KinematicsContext>& context,
+        const vector<ExternalWrench::Parameters>& wrenchParameters,
+        const vector<string>& jointNames)
+        : context(context), jointNames(jointNames),
+          isSelectionInitialized(false), useMobilizerReactionForces(false) {
+    // select joints
+    const auto& joints = context->getModel().getJointSet();
+    if (this->jointNames.empty()) {
+        for (int i = 0; i < joints.getSize(); ++i) {
+            this->jointNames.push_back(joints[i].getName());
+        }
+    }
+    for (const auto& name : this->jointNames) {
+        if (!joints.contains(name)) {
+            THROW_EXCEPTION("joint " + name + " does not exist in the model");
+        }
+    }
+
+    // add externally applied forces; these are applied as loads of the
+    // context, since the shared model may be used by other analyses
     for (int i = 0; i < wrenchParameters.size(); ++i) {
         auto wrench = new ExternalWrench(wrenchParameters[i]);
+        wrench->set_appliesForce(false);
         externalWrenches.push_back(wrench);
-        model.addForce(wrench);
+        context->updModel().addForce(wrench);
     }
-
-    // init state
-    state = model.initSystem();
 }
 
 JointReaction::Output JointReaction::solve(const JointReaction::Input& input) {
+    Output output;
+    solve(input, output);
+    return output;
+}
+
+void JointReaction::solve(const JointReaction::Input& input,
+                          JointReaction::Output& output) {
+    PROFILE_ZONE("JointReaction::solve");
+    const auto& model = context->getModel();
     if (model.getActuators().getSize() != input.fm.size()) {
         THROW_EXCEPTION("actuators and provided muscle forces are of different "
                         "dimensions");
     }
-    // update state
-    state.updTime() = input.t;
-    state.updQ() = input.q;
-    state.updU() = input.qDot;
+    // update state (realized once per frame for all analyses of the context)
+    context->update(input.t, input.q, input.qDot);
+    const auto& state = context->getState();
 
     // update external wrenches
     if (input.externalWrenches.size() != externalWrenches.size()) {
@@ -60,57 +124,187 @@ JointReaction::Output JointReaction::solve(const JointReaction::Input& input) {
                         " != " + to_string(externalWrenches.size()));
     }
 
+    context->clearLoads();
     for (int i = 0; i < input.externalWrenches.size(); ++i) {
         externalWrenches[i]->getInput() = input.externalWrenches[i];
+        externalWrenches[i]->addInBodyForces(state, context->updBodyForces());
     }
 
-    // update muscle forces; here we iterate over the muscles and not
-    // actuators because we want to be in line with OpenSim's
+    // apply muscle forces along their paths; here we iterate over the muscles
+    // and not actuators because we want to be in line with OpenSim's
     // implementation, which considers only muscle forces
-    for (int i = 0; i < model.getMuscles().getSize(); ++i) {
-        const ScalarActuator* act =
-                dynamic_cast<const ScalarActuator*>(&model.getMuscles()[i]);
-        if (act) {
-            act->overrideActuation(state, true);
-            act->setOverrideActuation(state, input.fm[i]);
-        }
+    const auto& muscles = model.getMuscles();
+    for (int i = 0; i < muscles.getSize(); ++i) {
+        muscles[i].getGeometryPath().addInEquivalentForces(
+                state, input.fm[i], context->updBodyForces(),
+                context->updMobilityForces());
     }
 
-    // calculate all joint reaction forces and moments applied to child bodies,
-    // expressed in ground frame
-    int nb = model.getNumBodies();
-    Output output;
+    // calculate the reaction forces and moments applied to the child bodies
+    // of the selected joints, expressed in ground frame
+    context->realize(Stage::Acceleration);
+    if (!isSelectionInitialized) initializeSelection();
+    const auto& matter = model.getMatterSubsystem();
+    const auto& joints = model.getJointSet();
+    const int nj = jointMobilizedBodies.size();
     output.t = input.t;
-    output.reactionWrench = Vector_<SpatialVec>(nb);
-    model.getMultibodySystem().realize(state, Stage::Acceleration);
-    model.getMatterSubsystem().calcMobilizerReactionForces(
-            state, output.reactionWrench);
+    output.reactionWrench.resize(nj);
+    output.reactionPoint.resize(nj);
 
-    return output;
+    // mobility forces of the selected mobilizers (muscles and force elements
+    // of the model) are not part of the reactions
+    bool hasMobilityForces = false;
+    const auto& mobilityForces =
+            model.getMultibodySystem().getMobilityForces(state,
+                                                         Stage::Dynamics);
+    for (const auto& u : jointMobilities) {
+        hasMobilityForces |= mobilityForces[u] != 0.0;
+    }
+
+    if (useMobilizerReactionForces || hasMobilityForces) {
+        // reactions are at the mobilizer frame (i.e., child frame) origin
+        matter.calcMobilizerReactionForces(state, subtreeForces);
+        for (int i = 0; i < nj; ++i) {
+            const auto& joint = joints[jointIndices[i]];
+            output.reactionWrench[i] =
+                    isJointReversed[i]
+                            ? joint.calcReactionOnChildExpressedInGround(state)
+                            : subtreeForces[jointMobilizedBodies[i]];
+            output.reactionPoint[i] =
+                    joint.getChildFrame().getPositionInGround(state);
+        }
+        return;
+    }
+
+    // accumulate the residuals of the subtrees about the ground origin (tip
+    // to base); the children of a subtree body are also subtree bodies
+    const auto& appliedForces =
+            model.getMultibodySystem().getRigidBodyForces(state,
+                                                          Stage::Dynamics);
+    for (const auto& mbx : subtreeBodies) {
+        subtreeForces[mbx] = SpatialVec(Vec3(0), Vec3(0));
+    }
+    for (const auto& mbx : subtreeBodies) {
+        const auto& body = matter.getMobilizedBody(mbx);
+        subtreeForces[mbx] +=
+                calcBodyResidual(state, body, appliedForces[mbx]);
+        const auto& parent = body.getParentMobilizedBody();
+        if (isSubtreeBody[parent.getMobilizedBodyIndex()]) {
+            subtreeForces[parent.getMobilizedBodyIndex()] +=
+                    subtreeForces[mbx];
+        }
+    }
+
+    // shift the reactions to the joint centers
+    for (int i = 0; i < nj; ++i) {
+        const auto& F = subtreeForces[jointMobilizedBodies[i]];
+        Vec3 p = joints[jointIndices[i]].getChildFrame().getPositionInGround(
+                state);
+        output.reactionWrench[i] = SpatialVec(F[0] - p % F[1], F[1]);
+        output.reactionPoint[i] = p;
+    }
 }
 
-SimTK::Vector
-JointReaction::asForceMomentPoint(const JointReaction::Output& jrOutput) {
-    const int nj = model.getJointSet().getSize();
+void JointReaction::initializeSelection() {
+    const auto& model = context->getModel();
+    const auto& state = context->getState();
+    const auto& matter = model.getMatterSubsystem();
     const auto& joints = model.getJointSet();
-    const auto& ground = model.getGround();
+    const int nb = matter.getNumBodies();
 
-    Vector out(nj * 9);
-    for (int i = 0; i < nj; ++i) {
-        auto jointReaction =
-                joints[i].calcReactionOnChildExpressedInGround(state);
+    // constraint forces are not local to a subtree
+    for (ConstraintIndex c(0); c < matter.getNumConstraints(); ++c) {
+        if (!matter.getConstraint(c).isDisabled(state)) {
+            useMobilizerReactionForces = true;
+        }
+    }
+
+    // mobilized body of each joint; a joint whose child is not the outboard
+    // body of its mobilizer is reversed
+    vector<bool> isSelected(nb, false);
+    set<string> selectedCoordinates;
+    for (const auto& name : jointNames) {
+        jointIndices.push_back(joints.getIndex(name));
+        const auto& joint = joints[jointIndices.back()];
+        auto mbx = joint.getChildFrame().getMobilizedBodyIndex();
+        auto pbx = joint.getParentFrame().getMobilizedBodyIndex();
+        bool isReversed = mbx == 0;
+        if (!isReversed) {
+            const auto& parent =
+                    matter.getMobilizedBody(mbx).getParentMobilizedBody();
+            isReversed = parent.getMobilizedBodyIndex() != pbx;
+        }
+        jointMobilizedBodies.push_back(mbx);
+        isJointReversed.push_back(isReversed);
+        if (mbx != 0) {
+            const auto& body = matter.getMobilizedBody(mbx);
+            int u0 = body.getFirstUIndex(state);
+            for (int k = 0; k < body.getNumU(state); ++k) {
+                jointMobilities.push_back(u0 + k);
+            }
+        }
+        useMobilizerReactionForces |= isReversed;
+        isSelected[mbx] = true;
+        for (int k = 0; k < joint.numCoordinates(); ++k) {
+            selectedCoordinates.insert(joint.get_coordinates(k).getName());
+        }
+    }
+
+    // force elements of the model that apply mobility forces at the
+    // coordinates of the selected joints
+    const auto& forces = model.getForceSet();
+    for (int i = 0; i < forces.getSize(); ++i) {
+        const auto& force = forces[i];
+        if (!force.appliesForce(state)) continue;
+        string coordinate;
+        if (auto spring = dynamic_cast<const SpringGeneralizedForce*>(&force)) {
+            coordinate = spring->get_coordinate();
+        } else if (auto limit =
+                           dynamic_cast<const CoordinateLimitForce*>(&force)) {
+            coordinate = limit->get_coordinate();
+        } else if (auto expression =
+                           dynamic_cast<const ExpressionBasedCoordinateForce*>(
+                                   &force)) {
+            coordinate = expression->get_coordinate();
+        }
+        if (selectedCoordinates.count(coordinate)) {
+            useMobilizerReactionForces = true;
+        }
+    }
 
-        // find the point of application in immediate child frame, then
-        // transform to the base frame of the child (expressedInBody)
-        Vec3 childLocationInGlobal =
-                joints[i].getChildFrame().getTransformInGround(state).p();
-        auto pointOfApplication = ground.findStationLocationInGround(
-                state, childLocationInGlobal);
+    // a body belongs to a subtree if itself or one of its ancestors is selected
+    isSubtreeBody = vector<bool>(nb, false);
+    for (MobilizedBodyIndex mbx(nb - 1); mbx > 0; --mbx) {
+        for (auto ancestor = mbx; ancestor > 0;
+             ancestor = matter.getMobilizedBody(ancestor)
+                                .getParentMobilizedBody()
+                                .getMobilizedBodyIndex()) {
+            if (isSelected[ancestor]) {
+                isSubtreeBody[mbx] = true;
+                subtreeBodies.push_back(mbx);
+                break;
+            }
+        }
+    }
+    subtreeForces = Vector_<SpatialVec>(nb, SpatialVec(Vec3(0), Vec3(0)));
+    isSelectionInitialized = true;
+}
 
-        // transform SpatialVec of reaction forces and moments to the
-        // requested base frame (expressedInBody)
-        Vec3 force = ground.expressVectorInGround(state, jointReaction[1]);
-        Vec3 moment = ground.expressVectorInGround(state, jointReaction[0]);
+SimTK::Vector
+JointReaction::asForceMomentPoint(const JointReaction::Output& jrOutput) const {
+    Vector out;
+    asForceMomentPoint(jrOutput, out);
+    return out;
+}
+
+void JointReaction::asForceMomentPoint(const JointReaction::Output& jrOutput,
+                                       Vector& out) const {
+    const int nj = jrOutput.reactionWrench.size();
+    out.resize(nj * 9);
+    for (int i = 0; i < nj; ++i) {
+        const auto& moment = jrOutput.reactionWrench[i][0];
+        const auto& force = jrOutput.reactionWrench[i][1];
+        const auto& point = jrOutput.reactionPoint[i];
 
         /* place results in the truncated loads vectors*/
         out[i * 9 + 0] = force[0];
@@ -119,17 +313,26 @@ JointReaction::asForceMomentPoint(const JointReaction::Output& jrOutput) {
         out[i * 9 + 3] = moment[0];
         out[i * 9 + 4] = moment[1];
         out[i * 9 + 5] = moment[2];
-        out[i * 9 + 6] = pointOfApplication[0];
-        out[i * 9 + 7] = pointOfApplication[1];
-        out[i * 9 + 8] = pointOfApplication[2];
+        out[i * 9 + 6] = point[0];
+        out[i * 9 + 7] = point[1];
+        out[i * 9 + 8] = point[2];
     }
-    return out;
+}
+
+const vector<string>& JointReaction::getJointNames() const {
+    return jointNames;
+}
+
+int JointReaction::getJointIndex(const string& jointName) const {
+    auto it = find(jointNames.begin(), jointNames.end(), jointName);
+    return it != jointNames.end() ? it - jointNames.begin() : -1;
 }
 
 TimeSeriesTable JointReaction::initializeLogger() {
+    const auto& model = context->getModel();
     vector<string> columnNames;
-    for (int i = 0; i < model.getNumJoints(); ++i) {
-        const auto& joint = model.getJointSet()[i];
+    for (const auto& name : jointNames) {
+        const auto& joint = model.getJointSet().get(name);
         auto label = joint.getName() + "_on_" +
                      joint.getChildFrame().findBaseFrame().getName() +
                      "_in_ground";
@@ -0,0 +1,142 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ */
+#include "KinematicsContext.h"
+#include "Exception.h"
+#include "OpenSimUtils.h"
+
+using namespace std;
+using namespace OpenSim;
+using namespace SimTK;
+using namespace OpenSimRT;
+
+/*******************************************************************************/
+
+void ContextForce::computeForce(const State& state,
+                                Vector_<SpatialVec>& bodyForces,
+                                Vector& generalizedForces) const {
+    if (this->bodyForces.size() == bodyForces.size()) {
+        bodyForces += this->bodyForces;
+    }
+    if (mobilityForces.size() == generalizedForces.size()) {
+        generalizedForces += mobilityForces;
+    }
+}
+
+/*******************************************************************************/
+
+KinematicsContext::KinematicsContext(const Model& otherModel)
+        : model(*otherModel.clone()), initialized(false), isFrameValid(false),
+          numKinematicRealizations(0) {
+    // loads of the analysis that is evaluated
+    contextForce = new ContextForce();
+    contextForce->setName("context_force");
+    model.addForce(contextForce.get());
+
+    // actuator forces are provided explicitly by the analyses
+    OpenSimUtils::disableActuators(model);
+}
+
+Model& KinematicsContext::updModel() {
+    if (initialized) {
+        THROW_EXCEPTION("components must be added to the shared model before "
+                        "the context is initialized");
+    }
+    return model;
+}
+
+const Model& KinematicsContext::getModel() const { return model; }
+
+const State& KinematicsContext::getState() const { return state; }
+
+void KinematicsContext::initialize() {
+    if (initialized) return;
+    state = model.initSystem();
+    contextForce->bodyForces =
+            Vector_<SpatialVec>(model.getMatterSubsystem().getNumBodies(),
+                                SpatialVec(Vec3(0), Vec3(0)));
+    contextForce->mobilityForces = Vector(state.getNU(), 0.0);
+    for (const auto& coordinate : model.getCoordinatesInMultibodyTreeOrder()) {
+        coordinateNames.push_back(coordinate->getName());
+    }
+    initialized = true;
+}
+
+bool KinematicsContext::isInitialized() const { return initialized; }
+
+const vector<string>&
+KinematicsContext::getCoordinateNamesInMultibodyTreeOrder() const {
+    if (!initialized) THROW_EXCEPTION("context has not been initialized");
+    return coordinateNames;
+}
+
+void KinematicsContext::update(double t, const Vector& q, const Vector& qDot) {
+    if (!initialized) initialize();
+    if (q.size() != state.getNQ() || qDot.size() != state.getNU()) {
+        THROW_EXCEPTION("wrong dimensions of q or qDot");
+    }
+
+    // skip if the state is already realized for this frame
+    if (isFrameValid && state.getTime() == t) {
+        const auto& stateQ = state.getQ();
+        const auto& stateU = state.getU();
+        bool isSameFrame = true;
+        for (int i = 0; i < q.size() && isSameFrame; ++i) {
+            isSameFrame = stateQ[i] == q[i] && stateU[i] == qDot[i];
+        }
+        if (isSameFrame) return;
+    }
+
+    state.updTime() = t;
+    state.updQ() = q;
+    state.updU() = qDot;
+    model.getMultibodySystem().realize(state, Stage::Velocity);
+    isFrameValid = true;
+    numKinematicRealizations++;
+}
+
+void KinematicsContext::clearLoads() {
+    if (!initialized) initialize();
+    contextForce->bodyForces.setToZero();
+    contextForce->mobilityForces.setToZero();
+    state.invalidateAllCacheAtOrAbove(Stage::Dynamics);
+}
+
+Vector_<SpatialVec>& KinematicsContext::updBodyForces() {
+    return contextForce->bodyForces;
+}
+
+Vector& KinematicsContext::updMobilityForces() {
+    return contextForce->mobilityForces;
+}
+
+const Vector& KinematicsContext::getMobilityForces() const {
+    return contextForce->mobilityForces;
+}
+
+void KinematicsContext::realize(const Stage& stage) {
+    if (!isFrameValid) THROW_EXCEPTION("context has not been updated");
+    model.getMultibodySystem().realize(state, stage);
+}
+
+int KinematicsContext::getNumKinematicRealizations() const {
+    return numKinematicRealizations;
+}
+
+/*******************************************************************************/
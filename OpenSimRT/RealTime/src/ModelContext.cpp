@@ -0,0 +1,73 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ */
+#include "ModelContext.h"
+#include "OpenSimUtils.h"
+#include <chrono>
+
+using namespace std;
+using namespace OpenSim;
+using namespace SimTK;
+using namespace OpenSimRT;
+
+ModelContext::ModelContext(const Model& otherModel) {
+    auto start = chrono::steady_clock::now();
+    model.reset(otherModel.clone());
+    defaultState = model->initSystem();
+
+    // the coordinates are ordered by the initialized system
+    for (const auto& coordinate : model->getCoordinatesInMultibodyTreeOrder()) {
+        coordinateNamesInMultibodyTreeOrder.push_back(coordinate->getName());
+    }
+    coordinateNames = OpenSimUtils::getCoordinateNames(*model);
+    muscleNames = OpenSimUtils::getMuscleNames(*model);
+    actuatorNames = OpenSimUtils::getActuatorNames(*model);
+    initializationTime = chrono::duration<double>(
+                                 chrono::steady_clock::now() - start)
+                                 .count();
+}
+
+const Model& ModelContext::getModel() const { return *model; }
+
+const State& ModelContext::getDefaultState() const { return defaultState; }
+
+unique_ptr<Model> ModelContext::cloneModel() const {
+    return unique_ptr<Model>(model->clone());
+}
+
+const vector<string>&
+ModelContext::getCoordinateNamesInMultibodyTreeOrder() const {
+    return coordinateNamesInMultibodyTreeOrder;
+}
+
+const vector<string>& ModelContext::getCoordinateNames() const {
+    return coordinateNames;
+}
+
+const vector<string>& ModelContext::getMuscleNames() const {
+    return muscleNames;
+}
+
+const vector<string>& ModelContext::getActuatorNames() const {
+    return actuatorNames;
+}
+
+double ModelContext::getInitializationTime() const {
+    return initializationTime;
+}
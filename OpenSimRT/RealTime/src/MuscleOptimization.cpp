@@ -18,10 +18,15 @@
  * -----------------------------------------------------------------------------
  */
 #include "MuscleOptimization.h"
+#include "Checkpoint.h"
 #include "Exception.h"
 #include "OpenSimUtils.h"
+#include "Profiler.h"
+#include "Utils.h"
 #include <OpenSim/Actuators/CoordinateActuator.h>
 #include <OpenSim/Simulation/Model/ForceSet.h>
+#include <map>
+#include <numeric>
 
 using namespace std;
 using namespace OpenSim;
@@ -44,6 +49,47 @@ Matrix calculateMomentArm(const State& s, const Model& model,
     return R;
 }
 
+// configure an optimizer for the muscle optimization problem
+Optimizer* createOptimizer(
+        const TorqueBasedTarget& target,
+        const MuscleOptimization::OptimizationParameters& parameters) {
+    auto optimizer = new Optimizer(target, OptimizerAlgorithm::InteriorPoint);
+    optimizer->setConvergenceTolerance(parameters.convergenceTolerance);
+    optimizer->setMaxIterations(parameters.maximumIterations);
+    optimizer->setDiagnosticsLevel(0);
+    optimizer->useNumericalGradient(false);
+    optimizer->useNumericalJacobian(false);
+    optimizer->setLimitedMemoryHistory(parameters.memoryHistory);
+    optimizer->setAdvancedBoolOption("warm_start", true);
+    optimizer->setAdvancedRealOption("expect_infeasible_problem", false);
+    optimizer->setAdvancedRealOption("obj_scaling_factor", 1);
+    optimizer->setAdvancedRealOption("nlp_scaling_max_gradient", 1);
+    // optimizer->setAdvancedStrOption("hessian_approximation", "exact");
+    return optimizer;
+}
+
+// Evaluate the sparsity pattern of the moment arm matrix at a few random
+// poses, so that moment arms vanishing at a particular pose are not mistaken
+// as structural zeros.
+Matrix calcMomentArmSparsity(const MomentArmFunctionT& calcMomentArm,
+                             int numCoordinates) {
+    Random::Uniform random(-1.0, 1.0);
+    random.setSeed(0);
+    Matrix pattern;
+    for (int k = 0; k < 5; ++k) {
+        Vector q(numCoordinates);
+        for (int i = 0; i < numCoordinates; ++i) q[i] = random.getValue();
+        auto R = calcMomentArm(q);
+        if (k == 0) pattern = Matrix(R.nrow(), R.ncol(), 0.0);
+        for (int i = 0; i < R.nrow(); ++i) {
+            for (int j = 0; j < R.ncol(); ++j) {
+                if (R[i][j] != 0.0) pattern[i][j] = 1.0;
+            }
+        }
+    }
+    return pattern;
+}
+
 /*******************************************************************************/
 
 MuscleOptimization::MuscleOptimization(
@@ -51,36 +97,152 @@ MuscleOptimization::MuscleOptimization(
         const MuscleOptimization::OptimizationParameters&
                 optimizationParameters,
         const MomentArmFunctionT& momentArmFunction)
-        : model(*modelOther.clone()) {
+        : MuscleOptimization(shared_ptr<const Model>(modelOther.clone()),
+                             optimizationParameters, momentArmFunction) {}
+
+MuscleOptimization::MuscleOptimization(
+        shared_ptr<const ModelContext> modelContext,
+        const MuscleOptimization::OptimizationParameters&
+                optimizationParameters,
+        const MomentArmFunctionT& momentArmFunction)
+        : MuscleOptimization(
+                  // the model is owned by the context
+                  shared_ptr<const Model>(modelContext,
+                                          &modelContext->getModel()),
+                  optimizationParameters, momentArmFunction) {}
+
+MuscleOptimization::MuscleOptimization(
+        shared_ptr<const Model> model,
+        const MuscleOptimization::OptimizationParameters&
+                optimizationParameters,
+        const MomentArmFunctionT& momentArmFunction)
+        : model(model), optimizationParameters(optimizationParameters) {
+    // coordinates that are not spanned by any muscle cannot be balanced by
+    // muscle forces (the constraints are infeasible, unless their generalized
+    // forces vanish), thus they are excluded from the problem, whether it is
+    // solved as a whole or in blocks
+    auto pattern = calcMomentArmSparsity(momentArmFunction,
+                                         model->getNumCoordinates());
+    unspannedCoordinateIndices = findUnspannedCoordinates(pattern);
+    const auto& coordinates = model->getCoordinatesInMultibodyTreeOrder();
+    vector<int> coordinateIndices;
+    for (int i = 6, k = 0; i < pattern.nrow(); ++i) {
+        if (k < unspannedCoordinateIndices.size() &&
+            unspannedCoordinateIndices[k] == i) {
+            cout << "MuscleOptimization: coordinate "
+                 << coordinates[i]->getName()
+                 << " is not spanned by any muscle and is excluded" << endl;
+            ++k;
+        } else {
+            coordinateIndices.push_back(i);
+        }
+    }
+
     // configure optimizer
-    target = new TorqueBasedTarget(&model,
+    target = new TorqueBasedTarget(model.get(),
                                    optimizationParameters.objectiveExponent,
-                                   momentArmFunction);
-    optimizer = new Optimizer(*target, OptimizerAlgorithm::InteriorPoint);
-    optimizer->setConvergenceTolerance(
-            optimizationParameters.convergenceTolerance);
-    optimizer->setMaxIterations(optimizationParameters.maximumIterations);
-    optimizer->setDiagnosticsLevel(0);
-    optimizer->useNumericalGradient(false);
-    optimizer->useNumericalJacobian(false);
-    optimizer->setLimitedMemoryHistory(optimizationParameters.memoryHistory);
-    optimizer->setAdvancedBoolOption("warm_start", true);
-    optimizer->setAdvancedRealOption("expect_infeasible_problem", false);
-    optimizer->setAdvancedRealOption("obj_scaling_factor", 1);
-    optimizer->setAdvancedRealOption("nlp_scaling_max_gradient", 1);
-    // optimizer->setAdvancedStrOption("hessian_approximation", "exact");
+                                   momentArmFunction, coordinateIndices, {});
+    optimizer = createOptimizer(*target, optimizationParameters);
     parameterSeeds = Vector(target->getNumParameters(), 0.5);
+
+    // split the problem into independent blocks
+    if (!optimizationParameters.useBlockDecomposition) return;
+    auto independentBlocks = findIndependentBlocks(pattern);
+    if (independentBlocks.size() < 2) return;
+
+    // muscles that do not span any coordinate are not part of any block and
+    // their optimal force is zero
+    parameterSeeds = 0.0;
+    for (auto& indices : independentBlocks) {
+        Block block;
+        block.coordinateIndices = indices.first;
+        block.muscleIndices = indices.second;
+        block.target.reset(new TorqueBasedTarget(
+                model.get(), optimizationParameters.objectiveExponent,
+                momentArmFunction, block.coordinateIndices,
+                block.muscleIndices));
+        block.optimizer.reset(
+                createOptimizer(*block.target, optimizationParameters));
+        block.parameterSeeds = Vector(block.muscleIndices.size(), 0.5);
+        for (const auto& j : block.muscleIndices) parameterSeeds[j] = 0.5;
+        blocks.push_back(std::move(block));
+    }
+
+#ifdef OPENSIMRT_THREAD_SAFE_IPOPT
+    // the calling thread solves one of the blocks
+    int numberOfThreads = std::min<int>(optimizationParameters.numberOfThreads,
+                                        blocks.size());
+    if (numberOfThreads > 1) pool.reset(new ThreadPool(numberOfThreads - 1));
+#endif
+}
+
+void MuscleOptimization::setConvergenceCriteria(double convergenceTolerance,
+                                                int maximumIterations) {
+    optimizationParameters.convergenceTolerance = convergenceTolerance;
+    optimizationParameters.maximumIterations = maximumIterations;
+    optimizer->setConvergenceTolerance(convergenceTolerance);
+    optimizer->setMaxIterations(maximumIterations);
+    for (auto& block : blocks) {
+        block.optimizer->setConvergenceTolerance(convergenceTolerance);
+        block.optimizer->setMaxIterations(maximumIterations);
+    }
 }
 
 MuscleOptimization::Output
 MuscleOptimization::solve(const MuscleOptimization::Input& input) {
-    try {
-        target->prepareForOptimization(input);
-        optimizer->optimize(parameterSeeds);
-    } catch (exception& e) {
-        // optimization may find a feasible solution and fail
-        cout << "Failed at time: " << input.t << endl << e.what() << endl;
-        // exit(-1);
+    PROFILE_ZONE("MuscleOptimization::solve");
+    if (blocks.empty()) {
+        try {
+            target->prepareForOptimization(input);
+            optimizer->optimize(parameterSeeds);
+        } catch (exception& e) {
+            // optimization may find a feasible solution and fail
+            cout << "Failed at time: " << input.t << endl << e.what() << endl;
+            // exit(-1);
+        }
+    } else {
+        // moment arm is evaluated once and shared between the blocks
+        auto R = target->calcMomentArm(input.q);
+        auto solveBlock = [&](Block& block) {
+            try {
+                // warm start from the latest (merged) solution
+                for (int j = 0; j < block.muscleIndices.size(); ++j) {
+                    block.parameterSeeds[j] =
+                            parameterSeeds[block.muscleIndices[j]];
+                }
+                block.target->prepareForOptimization(R, input.tau);
+                block.optimizer->optimize(block.parameterSeeds);
+            } catch (exception& e) {
+                // optimization may find a feasible solution and fail
+                cout << "Failed at time: " << input.t << endl
+                     << e.what() << endl;
+            }
+        };
+
+        // distribute the blocks to the workers, if any, in a round-robin
+        // manner and solve the remaining blocks in the calling thread
+        int numberOfWorkers = pool ? pool->size() : 0;
+        vector<future<void>> futures;
+        for (int w = 0; w < numberOfWorkers; ++w) {
+            futures.push_back(pool->push([&, w]() {
+                for (int i = w + 1; i < blocks.size();
+                     i += numberOfWorkers + 1) {
+                    solveBlock(blocks[i]);
+                }
+            }));
+        }
+        for (int i = 0; i < blocks.size(); i += numberOfWorkers + 1) {
+            solveBlock(blocks[i]);
+        }
+        for (auto& f : futures) f.get();
+
+        // merge results
+        for (const auto& block : blocks) {
+            for (int j = 0; j < block.muscleIndices.size(); ++j) {
+                parameterSeeds[block.muscleIndices[j]] =
+                        block.parameterSeeds[j];
+            }
+        }
     }
     auto fm = target->extractMuscleForces(parameterSeeds);
     auto am = target->extractMuscleForces(
@@ -88,34 +250,192 @@ MuscleOptimization::solve(const MuscleOptimization::Input& input) {
     return MuscleOptimization::Output{input.t, am, fm, fm};
 }
 
+MuscleOptimization::BatchOutput
+MuscleOptimization::solveBatch(const TimeSeriesTable& qTable,
+                               const TimeSeriesTable& tauTable,
+                               int numberOfThreads) {
+    const int n = qTable.getNumRows();
+    if (tauTable.getNumRows() != n) {
+        THROW_EXCEPTION("q and tau tables of different size " + toString(n) +
+                        " != " + toString(tauTable.getNumRows()));
+    }
+#ifdef OPENSIMRT_THREAD_SAFE_IPOPT
+    if (numberOfThreads <= 0) {
+        numberOfThreads = max<int>(thread::hardware_concurrency(), 1);
+    }
+    numberOfThreads = max(min(numberOfThreads, n), 1);
+#else
+    // Ipopt is not thread-safe with its default linear solver (MUMPS)
+    numberOfThreads = 1;
+#endif
+
+    // number of frames solved before the beginning of each chunk to warm
+    // start the optimizer
+    const int warmUpFrames = 5;
+
+    // results are stored by row and appended to the tables afterwards
+    const auto& qMatrix = qTable.getMatrix();
+    const auto& tauMatrix = tauTable.getMatrix();
+    const auto& time = qTable.getIndependentColumn();
+    Matrix fmMatrix(n, target->getNumParameters());
+
+    auto solveChunk = [&](int begin, int end) {
+        TorqueBasedTarget chunkTarget(model.get(), target->p,
+                                      target->calcMomentArm,
+                                      target->coordinateIndices, {});
+        unique_ptr<Optimizer> chunkOptimizer(
+                createOptimizer(chunkTarget, optimizationParameters));
+        Vector seeds = parameterSeeds;
+        for (int i = max(begin - warmUpFrames, 0); i < end; ++i) {
+            try {
+                chunkTarget.prepareForOptimization(
+                        {time[i], ~qMatrix[i], ~tauMatrix[i]});
+                chunkOptimizer->optimize(seeds);
+            } catch (exception& e) {
+                // optimization may find a feasible solution and fail
+                cout << "Failed at time: " << time[i] << endl
+                     << e.what() << endl;
+            }
+            if (i >= begin) {
+                fmMatrix[i] = ~chunkTarget.extractMuscleForces(seeds);
+            }
+        }
+    };
+
+    // split frames into contiguous chunks of (almost) equal size
+    {
+        ThreadPool workers(numberOfThreads);
+        vector<future<void>> futures;
+        for (int w = 0; w < numberOfThreads; ++w) {
+            int begin = w * n / numberOfThreads;
+            int end = (w + 1) * n / numberOfThreads;
+            futures.push_back(workers.push(
+                    [&, begin, end]() { solveChunk(begin, end); }));
+        }
+        for (auto& f : futures) f.get();
+    }
+
+    BatchOutput output{initializeMuscleLogger(), initializeMuscleLogger()};
+    for (int i = 0; i < n; ++i) {
+        output.fm.appendRow(time[i], fmMatrix[i]);
+        output.am.appendRow(time[i],
+                            fmMatrix[i].elementwiseDivide(~target->fMax));
+    }
+    return output;
+}
+
+vector<pair<vector<int>, vector<int>>>
+MuscleOptimization::findIndependentBlocks(const Matrix& R) {
+    // union-find over the bipartite graph of coordinates (nodes [0, nc)) and
+    // muscles (nodes [nc, nc + nm)), connected by non-zero moment arms
+    int nc = R.nrow(), nm = R.ncol();
+    vector<int> parent(nc + nm);
+    iota(parent.begin(), parent.end(), 0);
+    function<int(int)> find = [&](int x) {
+        while (parent[x] != x) x = parent[x] = parent[parent[x]];
+        return x;
+    };
+    vector<bool> isCoordinateSpanned(nc, false), isMuscleSpanning(nm, false);
+    for (int i = 6; i < nc; ++i) {
+        for (int j = 0; j < nm; ++j) {
+            if (R[i][j] == 0.0) continue;
+            parent[find(i)] = find(nc + j);
+            isCoordinateSpanned[i] = true;
+            isMuscleSpanning[j] = true;
+        }
+    }
+
+    // group by root, preserving the coordinate order
+    map<int, pair<vector<int>, vector<int>>> groups;
+    vector<int> order;
+    for (int i = 6; i < nc; ++i) {
+        if (!isCoordinateSpanned[i]) continue;
+        int root = find(i);
+        if (groups.find(root) == groups.end()) order.push_back(root);
+        groups[root].first.push_back(i);
+    }
+    for (int j = 0; j < nm; ++j) {
+        if (isMuscleSpanning[j]) groups[find(nc + j)].second.push_back(j);
+    }
+
+    vector<pair<vector<int>, vector<int>>> blocks;
+    for (const auto& root : order) blocks.push_back(groups[root]);
+    return blocks;
+}
+
+vector<int> MuscleOptimization::findUnspannedCoordinates(const Matrix& R) {
+    vector<int> coordinates;
+    for (int i = 6; i < R.nrow(); ++i) {
+        bool isSpanned = false;
+        for (int j = 0; j < R.ncol() && !isSpanned; ++j) {
+            isSpanned = R[i][j] != 0.0;
+        }
+        if (!isSpanned) coordinates.push_back(i);
+    }
+    return coordinates;
+}
+
 TimeSeriesTable MuscleOptimization::initializeMuscleLogger() {
-    auto columnNames = OpenSimUtils::getMuscleNames(model);
+    auto columnNames = OpenSimUtils::getMuscleNames(*model);
 
     TimeSeriesTable m;
     m.setColumnLabels(columnNames);
     return m;
 }
 
+void MuscleOptimization::saveState(CheckpointWriter& writer) const {
+    writer.write(parameterSeeds);
+}
+
+void MuscleOptimization::loadState(CheckpointReader& reader) {
+    Vector seeds;
+    reader.read(seeds);
+    if (seeds.size() != parameterSeeds.size()) {
+        THROW_EXCEPTION("checkpoint does not match the model muscles");
+    }
+    parameterSeeds = seeds;
+}
+
 /*******************************************************************************/
 
 TorqueBasedTarget::TorqueBasedTarget(
-        Model* model, int objectiveExponent,
+        const Model* model, int objectiveExponent,
         const MomentArmFunctionT& momentArmFunction)
-        : model(model), p(objectiveExponent), calcMomentArm(momentArmFunction) {
-    // number of inequalities (minus pelvis torques, which are
-    // non-physiological)
+        : TorqueBasedTarget(model, objectiveExponent, momentArmFunction, {},
+                            {}) {}
+
+TorqueBasedTarget::TorqueBasedTarget(
+        const Model* model, int objectiveExponent,
+        const MomentArmFunctionT& momentArmFunction,
+        const vector<int>& coordinateIndices, const vector<int>& muscleIndices)
+        : model(model), p(objectiveExponent), calcMomentArm(momentArmFunction),
+          coordinateIndices(coordinateIndices), muscleIndices(muscleIndices) {
+    // by default all coordinates minus pelvis, which are non-physiological,
+    // and all actuators are included in the problem
     auto& cs = model->getCoordinateSet();
-    setNumEqualityConstraints(cs.getSize() - 6);
-    setNumLinearEqualityConstraints(cs.getSize() - 6);
+    auto& as = model->getActuators();
+    if (this->coordinateIndices.empty()) {
+        this->coordinateIndices.resize(cs.getSize() - 6);
+        iota(this->coordinateIndices.begin(), this->coordinateIndices.end(),
+             6);
+    }
+    if (this->muscleIndices.empty()) {
+        this->muscleIndices.resize(as.getSize());
+        iota(this->muscleIndices.begin(), this->muscleIndices.end(), 0);
+    }
+
+    // number of equalities
+    setNumEqualityConstraints(this->coordinateIndices.size());
+    setNumLinearEqualityConstraints(this->coordinateIndices.size());
 
     // parameter bounds
-    auto& as = model->getActuators();
-    int na = as.getSize();
+    int na = this->muscleIndices.size();
     fMax = Vector(na, 0.0);
     Vector lowerBounds(na, 0.0), upperBounds(na, 0.0);
     for (int i = 0; i < na; ++i) {
-        auto muscle = dynamic_cast<const Muscle*>(&as[i]);
-        auto pathAct = dynamic_cast<const PathActuator*>(&as[i]);
+        const auto& actuator = as[this->muscleIndices[i]];
+        auto muscle = dynamic_cast<const Muscle*>(&actuator);
+        auto pathAct = dynamic_cast<const PathActuator*>(&actuator);
         if (muscle) {
             fMax[i] = muscle->getMaxIsometricForce();
             lowerBounds[i] = 0.0;
@@ -134,10 +454,22 @@ TorqueBasedTarget::TorqueBasedTarget(
 
 void TorqueBasedTarget::prepareForOptimization(
         const MuscleOptimization::Input& input) {
-    tau = input.tau(6, input.tau.size() - 6);
-    R = calcMomentArm(input.q);
-    R = R(6, 0, R.nrow() - 6, R.ncol());
+    prepareForOptimization(calcMomentArm(input.q), input.tau);
 }
+
+void TorqueBasedTarget::prepareForOptimization(const Matrix& RFull,
+                                               const Vector& tauFull) {
+    int nc = coordinateIndices.size(), nm = muscleIndices.size();
+    tau.resize(nc);
+    R.resize(nc, nm);
+    for (int i = 0; i < nc; ++i) {
+        tau[i] = tauFull[coordinateIndices[i]];
+        for (int j = 0; j < nm; ++j) {
+            R[i][j] = RFull[coordinateIndices[i]][muscleIndices[j]];
+        }
+    }
+}
+
 Vector TorqueBasedTarget::extractMuscleForces(const Vector& x) const {
     return x;
 }
@@ -0,0 +1,132 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ */
+#include "MuscleOptimizationSurrogate.h"
+#include "Exception.h"
+#include "Profiler.h"
+#include "Utils.h"
+#include <OpenSim/Simulation/Model/Muscle.h>
+#include <OpenSim/Simulation/Model/PathActuator.h>
+#include <memory>
+
+using namespace std;
+using namespace OpenSim;
+using namespace SimTK;
+using namespace OpenSimRT;
+
+MuscleOptimizationSurrogate::MuscleOptimizationSurrogate(
+        const Model& otherModel, const Parameters& parameters,
+        const MomentArmFunctionT& momentArmFunction)
+        : parameters(parameters), network(parameters.networkFile),
+          calcMomentArm(momentArmFunction) {
+    unique_ptr<Model> model(otherModel.clone());
+    const auto& as = model->getActuators();
+    fMax = Vector(as.getSize(), 0.0);
+    for (int i = 0; i < as.getSize(); ++i) {
+        auto muscle = dynamic_cast<const Muscle*>(&as[i]);
+        auto pathAct = dynamic_cast<const PathActuator*>(&as[i]);
+        if (muscle) {
+            fMax[i] = muscle->getMaxIsometricForce();
+        } else if (pathAct) {
+            fMax[i] = pathAct->getOptimalForce();
+        } else {
+            THROW_EXCEPTION("unsupported type of actuator");
+        }
+    }
+
+    // network dimensions must agree with the model
+    int nq = model->getNumCoordinates();
+    if (network.getInputSize() != 2 * (nq - 6)) {
+        THROW_EXCEPTION("network input size " +
+                        toString(network.getInputSize()) +
+                        " does not agree with the model " +
+                        toString(2 * (nq - 6)));
+    }
+    if (network.getOutputSize() != as.getSize()) {
+        THROW_EXCEPTION("network output size " +
+                        toString(network.getOutputSize()) +
+                        " does not agree with the model " +
+                        toString(as.getSize()));
+    }
+    x.resize(network.getInputSize());
+}
+
+Vector MuscleOptimizationSurrogate::createNetworkInput(const Vector& q,
+                                                       const Vector& tau) {
+    int n = q.size() - 6;
+    Vector x(2 * n);
+    x(0, n) = q(6, n);
+    x(n, n) = tau(6, n);
+    return x;
+}
+
+MuscleOptimizationSurrogate::Output
+MuscleOptimizationSurrogate::solve(const MuscleOptimization::Input& input) {
+    PROFILE_ZONE("MuscleOptimizationSurrogate::solve");
+    // prediction
+    int n = input.q.size() - 6;
+    x(0, n) = input.q(6, n);
+    x(n, n) = input.tau(6, n);
+    Vector a;
+    network.evaluate(x, a);
+
+    // constraints in activation space A a = b, excluding the pelvis
+    auto R = calcMomentArm(input.q);
+    Matrix A(n, fMax.size());
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < fMax.size(); ++j) {
+            A[i][j] = R[i + 6][j] * fMax[j];
+        }
+    }
+    Vector b = input.tau(6, n);
+
+    // Dykstra's projection onto the intersection of the affine set and the
+    // non-negative orthant; the least squares (minimum norm) correction is
+    // used for the affine set, so that coordinates that are not spanned by
+    // any muscle do not prevent convergence
+    FactorQTZ qtz(A);
+    Vector p(a.size(), 0.0), r(a.size(), 0.0), y, correction;
+    Vector residuals = A * a - b;
+    for (int k = 0; k < parameters.projectionIterations &&
+                    residuals.norm() > parameters.projectionTolerance;
+         ++k) {
+        // affine set
+        y = a + p;
+        qtz.solve(Vector(A * y - b), correction);
+        y -= correction;
+        p += a - y;
+
+        // non-negative orthant
+        for (int j = 0; j < a.size(); ++j) {
+            a[j] = std::max(y[j] + r[j], 0.0);
+            r[j] += y[j] - a[j];
+        }
+        residuals = A * a - b;
+    }
+
+    // guarantee non-negative forces even if the projection did not run
+    for (int j = 0; j < a.size(); ++j) a[j] = std::max(a[j], 0.0);
+    residuals = A * a - b;
+    return Output{input.t, a, a.elementwiseMultiply(fMax), residuals,
+                  residuals.norm()};
+}
+
+bool MuscleOptimizationSurrogate::isAccurate(const Output& output) const {
+    return output.residualNorm <= parameters.fallbackThreshold;
+}
@@ -19,8 +19,12 @@
  */
 #include "RealTimeAnalysis.h"
 #include "Exception.h"
+#include "FrameArena.h"
 #include "JointReaction.h"
+#include "Profiler.h"
 #include <SimTKcommon/internal/BigMatrix.h>
+#include <algorithm>
+#include <sstream>
 #include <thread>
 
 using namespace std;
@@ -28,187 +32,917 @@ using namespace OpenSim;
 using namespace OpenSimRT;
 using namespace SimTK;
 
+// names of the pipeline stages (in the order of PipelineStage)
+static const vector<string> pipelineStageNames{
+        "acquire", "ik", "filter", "id", "so", "jr", "publish"};
+
 void RealTimeAnalysis::FilteredData::fromVector(const double& time,
                                                 const SimTK::Vector& x,
                                                 const SimTK::Vector& xd,
                                                 const SimTK::Vector& xdd,
                                                 const int& nq) {
+    // element access, since the vector views of SimTK allocate
     this->t = time;
-    this->q = x(0, nq);
-    this->qd = xd(0, nq);
-    this->qdd = xdd(0, nq);
-    this->externalWrenches = {};
+    this->q.resize(nq);
+    this->qd.resize(nq);
+    this->qdd.resize(nq);
+    for (int i = 0; i < nq; ++i) {
+        this->q[i] = x[i];
+        this->qd[i] = xd[i];
+        this->qdd[i] = xdd[i];
+    }
 
     auto wrenchSize = ExternalWrench::Input::size();
     int wrenchCount = (x.size() - nq) / wrenchSize;
-
-    ExternalWrench::Input wrench;
+    this->externalWrenches.resize(wrenchCount);
     for (int i = 0; i < wrenchCount; ++i) {
-        int offset = i * wrenchSize + nq;
-        wrench.fromVector(x(offset, offset + wrenchCount));
-        this->externalWrenches.push_back(wrench);
+        this->externalWrenches[i].fromVector(x, i * wrenchSize + nq);
     }
 }
 
 RealTimeAnalysis::RealTimeAnalysis(
         const Model& otherModel, const RealTimeAnalysis::Parameters& parameters)
-        : model(*otherModel.clone()), parameters(parameters),
+        : modelContext(make_shared<ModelContext>(otherModel)),
+          model(modelContext->getModel()), parameters(parameters),
           previousAcquisitionTime(-1.0), previousProcessingTime(-1.0),
-          notifyParentThread(false), terminationFlag(false) {
+          acquisitionPeriod(0.0), isMuscleOptimizationRelaxed(false),
+          numMuscleOptimizationFrames(0), isReplaying(false),
+          isCollectingReplayResults(false), numReplayFrames(0),
+          isCheckpointerStarted(false), isFilterRestored(false),
+          terminationFlag(false) {
+    startupTimes.push_back({"model", modelContext->getInitializationTime()});
+
+    // pipeline layout; each stage must be executed once and in order
+    const auto& threads = parameters.pipelineThreads;
+    vector<PipelineStage> stages;
+    vector<int> stageThread;
+    for (int i = 0; i < threads.size(); ++i) {
+        if (threads[i].empty()) THROW_EXCEPTION("empty pipeline thread");
+        for (const auto& stage : threads[i]) {
+            stages.push_back(stage);
+            stageThread.push_back(i);
+        }
+    }
+    int numStages = static_cast<int>(PipelineStage::PUBLISH) + 1;
+    if (stages.size() != numStages) {
+        THROW_EXCEPTION("pipeline must contain all stages exactly once");
+    }
+    for (int i = 0; i < numStages; ++i) {
+        if (stages[i] != static_cast<PipelineStage>(i)) {
+            THROW_EXCEPTION("pipeline stages are not in order");
+        }
+    }
+
+    // queues between consecutive threads
+    const auto& queueParameters = parameters.pipelineQueues;
+    if (queueParameters.size() != 1 &&
+        queueParameters.size() != threads.size() - 1) {
+        THROW_EXCEPTION("wrong number of pipeline queue parameters " +
+                        to_string(queueParameters.size()));
+    }
+    for (int i = 0; i < threads.size() - 1; ++i) {
+        const auto& queue = queueParameters.size() == 1 ? queueParameters[0]
+                                                        : queueParameters[i];
+        queues.push_back(unique_ptr<SPSCQueue<Frame>>(new SPSCQueue<Frame>(
+                queue.capacity, queue.overflowPolicy)));
+    }
+
+    // thread policies
+    const auto& policies = parameters.pipelineThreadPolicies;
+    if (policies.size() != 1 && policies.size() != threads.size()) {
+        THROW_EXCEPTION("wrong number of pipeline thread policies " +
+                        to_string(policies.size()));
+    }
+    if (parameters.lockMemory && parameters.warmUpFrames < 1) {
+        THROW_EXCEPTION("memory is locked after at least one warm-up frame");
+    }
+
+    // frame-level parallelism of JR
+    jointReactionThread = stageThread[static_cast<int>(PipelineStage::JR)];
+    if (parameters.jointReactionWorkers < 1) {
+        THROW_EXCEPTION("number of JR workers must be positive");
+    }
+    if (parameters.jointReactionWorkers > 1 &&
+        threads[jointReactionThread].size() != 1) {
+        THROW_EXCEPTION("the thread of JR must not contain other stages if "
+                        "JR is solved by workers");
+    }
+
+    // telemetry
+    for (const auto& name : pipelineStageNames) {
+        stageLatency.push_back(&telemetry.addLatencyHistogram(name));
+    }
+    endToEndLatency = &telemetry.addLatencyHistogram("sample_to_output");
+    for (int i = 0; i < queues.size(); ++i) {
+        auto name = "queue_" + to_string(i);
+        const auto& queue = *queues[i];
+        queueDepth.push_back(
+                &telemetry.addHistogram(name + "_depth", "frames"));
+        telemetry.addCounter(name + "_pushed",
+                             [&queue]() { return queue.getNumPushed(); });
+        telemetry.addCounter(name + "_popped",
+                             [&queue]() { return queue.getNumPopped(); });
+        telemetry.addCounter(name + "_dropped",
+                             [&queue]() { return queue.getNumDropped(); });
+    }
+
+    // results
+    mainResultsSubscriber = &resultsPublisher.subscribe();
+
+    // load shedding is performed by the thread of SO, since SO dominates
+    // the processing time
+    loadSheddingThread = stageThread[static_cast<int>(PipelineStage::SO)];
+    if (parameters.useLoadShedding) {
+        if (parameters.loadGovernorParameters.maximumLevel >
+            static_cast<int>(QualityLevel::NO_SO)) {
+            THROW_EXCEPTION("maximum load shedding level exceeds NO_SO");
+        }
+        if (parameters.decimationFactor < 1) {
+            THROW_EXCEPTION("decimation factor must be positive");
+        }
+        loadGovernor = new LoadGovernor(parameters.loadGovernorParameters);
+        qualityLevel = &telemetry.addHistogram("quality_level", "level");
+        telemetry.addCounter("load_shedding_transitions", [this]() {
+            return loadGovernor->getNumTransitions();
+        });
+    }
+
     // filter
+    auto start = Telemetry::now();
     lowPassFilter = new LowPassSmoothFilter(parameters.filterParameters);
+    recordStartupStep("filter", start);
 
-    // ik
+    // ik (shares the finalized model)
+    start = Telemetry::now();
     inverseKinematics = new InverseKinematics(
-            model, parameters.ikMarkerTasks, parameters.ikIMUTasks,
+            modelContext, parameters.ikMarkerTasks, parameters.ikIMUTasks,
             parameters.ikConstraintsWeight, parameters.ikAccuracy);
+    recordStartupStep("ik", start);
+
+    // id and jr are evaluated on the same frames, thus they share the
+    // kinematics if they run in the same thread; the contexts add components,
+    // thus they use copies of the model
+    start = Telemetry::now();
+    processingContext = make_shared<KinematicsContext>(model);
+    auto jrContext =
+            stageThread[static_cast<int>(PipelineStage::ID)] ==
+                            stageThread[static_cast<int>(PipelineStage::JR)]
+                    ? processingContext
+                    : make_shared<KinematicsContext>(model);
 
     // id
-    inverseDynamics = new InverseDynamics(model, parameters.wrenchParameters);
+    inverseDynamics =
+            new InverseDynamics(processingContext, parameters.wrenchParameters);
+    recordStartupStep("id", start);
 
-    // so
+    // so (shares the finalized model)
+    start = Telemetry::now();
     muscleOptimization = new MuscleOptimization(
-            model, parameters.muscleOptimizationParameters,
+            modelContext, parameters.muscleOptimizationParameters,
             parameters.momentArmFunction);
+    if (parameters.useMuscleOptimizationSurrogate) {
+        muscleOptimizationSurrogate = new MuscleOptimizationSurrogate(
+                model, parameters.muscleOptimizationSurrogateParameters,
+                parameters.momentArmFunction);
+    }
+    recordStartupStep("so", start);
 
     // jr
-    jointReaction = new JointReaction(model, parameters.wrenchParameters);
+    start = Telemetry::now();
+    jointReaction = new JointReaction(jrContext, parameters.wrenchParameters,
+                                      parameters.reactionJoints);
+    vector<shared_ptr<KinematicsContext>> workerContexts;
+    if (parameters.jointReactionWorkers > 1) {
+        for (int w = 0; w < parameters.jointReactionWorkers; ++w) {
+            workerContexts.push_back(make_shared<KinematicsContext>(
+                    modelContext->getModel()));
+            auto worker = new JointReactionWorker();
+            worker->jointReaction.reset(new JointReaction(
+                    workerContexts.back(), parameters.wrenchParameters,
+                    parameters.reactionJoints));
+            worker->input.reset(new SPSCQueue<Frame>(1));
+            worker->output.reset(new SPSCQueue<Frame>(1));
+            jointReactionWorkers.push_back(
+                    unique_ptr<JointReactionWorker>(worker));
+        }
+    }
+    recordStartupStep("jr", start);
+    start = Telemetry::now();
+    processingContext->initialize();
+    jrContext->initialize();
+    for (auto& context : workerContexts) context->initialize();
+    recordStartupStep("kinematics_contexts", start);
+
+    // binary log with the column labels of the loggers
+    if (!parameters.binaryLogFile.empty()) {
+        start = Telemetry::now();
+        binaryLogger.reset(new BinaryLogger(
+                parameters.binaryLogFile, parameters.binaryLoggerParameters));
+        auto loggers = initializeLoggers();
+        logTables.q = binaryLogger->addTable(
+                "q", loggers.qLogger.getColumnLabels());
+        logTables.qDot = binaryLogger->addTable(
+                "qDot", loggers.qDotLogger.getColumnLabels());
+        logTables.qDDot = binaryLogger->addTable(
+                "qDDot", loggers.qDDotLogger.getColumnLabels());
+        logTables.tau = binaryLogger->addTable(
+                "tau", loggers.tauLogger.getColumnLabels());
+        logTables.fm = binaryLogger->addTable(
+                "fm", loggers.fmLogger.getColumnLabels());
+        logTables.am = binaryLogger->addTable(
+                "am", loggers.amLogger.getColumnLabels());
+        logTables.residuals = binaryLogger->addTable(
+                "residuals", loggers.residualLogger.getColumnLabels());
+        logTables.jr = binaryLogger->addTable(
+                "jr", loggers.jrLogger.getColumnLabels());
+        binaryLogger->start();
+        auto logger = binaryLogger.get();
+        telemetry.addCounter("binary_log_dropped_rows", [logger]() {
+            return logger->getNumDroppedRows();
+        });
+        recordStartupStep("binary_log", start);
+    }
+
+    // checkpoints, started (and restored) with the threads
+    if (!parameters.checkpointFile.empty()) {
+        checkpointer.reset(new Checkpointer(parameters.checkpointFile,
+                                            parameters.checkpointInterval));
+        for (const auto& name : pipelineStageNames) {
+            checkpointSections.push_back(checkpointer->addSection(name));
+        }
+        auto checkpoints = checkpointer.get();
+        telemetry.addCounter("checkpoints", [checkpoints]() {
+            return checkpoints->getNumCheckpoints();
+        });
+    } else if (parameters.restoreFromCheckpoint) {
+        THROW_EXCEPTION("restore from checkpoint requires a checkpoint file");
+    }
 }
 
 bool RealTimeAnalysis::shouldTerminate() { return terminationFlag.load(); }
 
-void RealTimeAnalysis::shouldTerminate(bool flag) { terminationFlag = flag; }
+void RealTimeAnalysis::shouldTerminate(bool flag) {
+    terminationFlag = flag;
+    // unblock threads that wait on the queues or the results
+    if (flag) {
+        for (auto& queue : queues) queue->close();
+        for (auto& worker : jointReactionWorkers) {
+            worker->input->close();
+            worker->output->close();
+        }
+        resultsPublisher.close();
+        if (binaryLogger) binaryLogger->close();
+        if (checkpointer) checkpointer->close();
+    }
+}
 
 void RealTimeAnalysis::run() {
-    thread acquisitionThread(&RealTimeAnalysis::acquisition, this);
-    thread processingThread(&RealTimeAnalysis::processing, this);
-    acquisitionThread.detach();
-    processingThread.detach();
+    for (auto& pipelineThread : createPipelineThreads()) {
+        pipelineThread.detach();
+    }
 }
 
-Vector RealTimeAnalysis::prepareUnfilteredData(
-        const Vector& q,
-        const vector<ExternalWrench::Input>& externalWrenches) const {
+vector<thread> RealTimeAnalysis::createPipelineThreads() {
+    // the state is restored before the threads start (the stages are virtual,
+    // thus this cannot be done in the constructor)
+    if (checkpointer && !isCheckpointerStarted) {
+        if (parameters.restoreFromCheckpoint) restoreCheckpoint();
+        checkpointer->start();
+        isCheckpointerStarted = true;
+    }
+
+    vector<thread> pipelineThreads;
+    for (int i = 0; i < parameters.pipelineThreads.size(); ++i) {
+        if (i == jointReactionThread && !jointReactionWorkers.empty()) {
+            pipelineThreads.emplace_back(
+                    &RealTimeAnalysis::runJointReactionDispatcher, this, i);
+        } else {
+            pipelineThreads.emplace_back(&RealTimeAnalysis::runPipelineThread,
+                                         this, i);
+        }
+    }
+    for (int w = 0; w < jointReactionWorkers.size(); ++w) {
+        pipelineThreads.emplace_back(&RealTimeAnalysis::runJointReactionWorker,
+                                     this, w);
+    }
+    return pipelineThreads;
+}
+
+RealTimeAnalysis::ReplayReport RealTimeAnalysis::replay(bool collectResults) {
+    // lossless queues and logger; the configured policies are restored when
+    // the replay returns or throws
+    vector<OverflowPolicy> queuePolicies;
+    for (auto& queue : queues) {
+        queuePolicies.push_back(queue->getOverflowPolicy());
+        queue->setOverflowPolicy(OverflowPolicy::BLOCK);
+    }
+    auto loggerPolicy = binaryLogger ? binaryLogger->getOverflowPolicy()
+                                     : OverflowPolicy::BLOCK;
+    if (binaryLogger) binaryLogger->setOverflowPolicy(OverflowPolicy::BLOCK);
+    auto restorePolicies = [&]() {
+        for (int i = 0; i < queues.size(); ++i) {
+            queues[i]->setOverflowPolicy(queuePolicies[i]);
+        }
+        if (binaryLogger) binaryLogger->setOverflowPolicy(loggerPolicy);
+        isReplaying = false;
+    };
+    isReplaying = true;
+    isCollectingReplayResults = collectResults;
+    numReplayFrames = 0;
+    replayResults.clear();
+    telemetry.reset();
+
+    auto start = Telemetry::now();
+    try {
+        auto pipelineThreads = createPipelineThreads();
+        for (auto& pipelineThread : pipelineThreads) pipelineThread.join();
+    } catch (...) {
+        restorePolicies();
+        throw;
+    }
+    auto duration = 1e-9 * Telemetry::elapsed(start);
+    restorePolicies();
+    if (binaryLogger) binaryLogger->close();
+    if (checkpointer) checkpointer->close();
+    if (shouldTerminate()) THROW_EXCEPTION("replay was terminated");
+
+    ReplayReport report;
+    report.numFrames = numReplayFrames;
+    report.duration = duration;
+    report.framesPerSecond = report.numFrames / duration;
+    report.telemetry = telemetry.getSnapshot();
+    report.results = std::move(replayResults);
+    return report;
+}
+
+vector<size_t> RealTimeAnalysis::getNumDroppedFrames() const {
+    vector<size_t> dropped;
+    for (const auto& queue : queues) dropped.push_back(queue->getNumDropped());
+    return dropped;
+}
+
+Telemetry::Snapshot RealTimeAnalysis::getTelemetry() const {
+    return telemetry.getSnapshot();
+}
+
+void RealTimeAnalysis::exportTelemetry(const string& fileName) const {
+    telemetry.exportFile(fileName);
+}
+
+const vector<RealTimeAnalysis::StartupStep>&
+RealTimeAnalysis::getStartupTimes() const {
+    return startupTimes;
+}
+
+int RealTimeAnalysis::getReactionJointIndex(const string& jointName) const {
+    return jointReaction->getJointIndex(jointName);
+}
+
+void RealTimeAnalysis::recordStartupStep(
+        const string& name, const Telemetry::Clock::time_point& start) {
+    startupTimes.push_back({name, 1e-9 * Telemetry::elapsed(start)});
+}
+
+vector<vector<RealTimeAnalysis::PipelineStage>>
+RealTimeAnalysis::pipelineThreadsFromString(const string& layout) {
+    vector<vector<PipelineStage>> threads(1);
+    istringstream stream(layout);
+    string token;
+    while (stream >> token) {
+        auto stage = find(pipelineStageNames.begin(), pipelineStageNames.end(),
+                          token);
+        if (token == "|") {
+            threads.push_back({});
+        } else if (stage != pipelineStageNames.end()) {
+            threads.back().push_back(static_cast<PipelineStage>(
+                    stage - pipelineStageNames.begin()));
+        } else {
+            THROW_EXCEPTION("unknown pipeline stage " + token);
+        }
+    }
+    return threads;
+}
+
+void RealTimeAnalysis::prepareUnfilteredData(
+        const Vector& q, const vector<ExternalWrench::Input>& externalWrenches,
+        Vector& v) const {
     int m = q.size() + externalWrenches.size() * ExternalWrench::Input::size();
     if (m == 0) { THROW_EXCEPTION("cannot convert from empty"); }
 
-    Vector v(m);
-    v(0, q.size()) = q;
+    v.resize(m);
+    for (int i = 0; i < q.size(); ++i) v[i] = q[i];
     for (int i = 0; i < externalWrenches.size(); ++i) {
-        auto w = externalWrenches[i].toVector();
-        v(q.size() + i * w.size(), w.size()) = w;
+        externalWrenches[i].toVector(
+                v, q.size() + i * ExternalWrench::Input::size());
     }
-    return v;
 }
 
-void RealTimeAnalysis::acquisition() {
-    try {
-        while (true) {
-            if (shouldTerminate()) THROW_EXCEPTION("Acquisition terminated.");
+MuscleOptimization::Output RealTimeAnalysis::solveMuscleOptimization(
+        const MuscleOptimization::Input& input, bool& isSurrogateSolution,
+        double& surrogateResidual) {
+    isSurrogateSolution = false;
+    surrogateResidual = NaN;
+    if (muscleOptimizationSurrogate) {
+        auto so = muscleOptimizationSurrogate->solve(input);
+        surrogateResidual = so.residualNorm;
+        if (muscleOptimizationSurrogate->isAccurate(so)) {
+            isSurrogateSolution = true;
+            return MuscleOptimization::Output{so.t, so.am, so.fm, so.fm};
+        }
+    }
+    return muscleOptimization->solve(input);
+}
 
-            // get data
-            auto acquisitionData = parameters.dataAcquisitionFunction();
-            if (previousAcquisitionTime >= acquisitionData.IkFrame.t) {
-                continue;
-            }
+bool RealTimeAnalysis::acquire(Frame& frame) {
+    frame.acquisitionData = parameters.dataAcquisitionFunction();
+    frame.acquisitionTime = Telemetry::now();
+    if (previousAcquisitionTime >= frame.acquisitionData.IkFrame.t) {
+        return false;
+    }
 
-            // update time
-            previousAcquisitionTime = acquisitionData.IkFrame.t;
+    // smoothed period of the acquired samples
+    const double t = frame.acquisitionData.IkFrame.t;
+    if (previousAcquisitionTime >= 0) {
+        double period = acquisitionPeriod.load(memory_order_relaxed);
+        const double dt = t - previousAcquisitionTime;
+        period = period > 0 ? period + 0.1 * (dt - period) : dt;
+        acquisitionPeriod.store(period, memory_order_relaxed);
+    }
 
-            // perform ik
-            auto pose = inverseKinematics->solve(acquisitionData.IkFrame);
+    // update time
+    previousAcquisitionTime = t;
+    return true;
+}
 
-            // filter
-            auto unfilteredData = prepareUnfilteredData(
-                    pose.q, acquisitionData.ExternalWrenches);
-            auto filteredData = lowPassFilter->filter({pose.t, unfilteredData});
+bool RealTimeAnalysis::solveIK(Frame& frame) {
+    frame.pose = inverseKinematics->solve(frame.acquisitionData.IkFrame);
+    return true;
+}
 
-            // push to buffer
-            if (!filteredData.isValid) continue;
-            buffer.add(filteredData);
+bool RealTimeAnalysis::filter(Frame& frame) {
+    // the restored memory is continued by the first sample after the restart
+    if (isFilterRestored) {
+        isFilterRestored = false;
+        if (!lowPassFilter->isContinuousWith(frame.pose.t)) {
+            cout << "warning: filter memory is aligned with t = "
+                 << frame.pose.t << " after the restart" << endl;
+            lowPassFilter->alignWith(frame.pose.t);
         }
-    } catch (exception& e) {
-        cout << e.what() << endl;
+    }
+
+    filterInput.t = frame.pose.t;
+    prepareUnfilteredData(frame.pose.q, frame.acquisitionData.ExternalWrenches,
+                          filterInput.x);
+    lowPassFilter->filter(filterInput, filterOutput);
+
+    // skip if filter is not ready
+    if (!filterOutput.isValid) return false;
+
+    // represent filtered data as struct
+    frame.filteredData.fromVector(filterOutput.t, filterOutput.x,
+                                  filterOutput.xDot, filterOutput.xDDot,
+                                  model.getNumCoordinates());
+    return true;
+}
+
+bool RealTimeAnalysis::solveID(Frame& frame) {
+    const auto& data = frame.filteredData;
+    auto& input = inverseDynamicsInput;
+    input.t = data.t;
+    input.q = data.q;
+    input.qDot = data.qd;
+    input.qDDot = data.qdd;
+    input.externalWrenches = data.externalWrenches;
+    inverseDynamics->solve(input, inverseDynamicsOutput);
+    frame.output.tau = inverseDynamicsOutput.tau;
+    return true;
+}
+
+bool RealTimeAnalysis::solveSO(Frame& frame) {
+    auto& output = frame.output;
+    output.isSurrogateSolution = false;
+    output.surrogateResidual = NaN;
+    if (!parameters.solveMuscleOptimization) return true;
+
+    // hold the latest solution if SO is shed at this frame
+    const auto level = output.qualityLevel;
+    bool isShed = level == QualityLevel::NO_SO;
+    if (level == QualityLevel::DECIMATED_SO) {
+        isShed = numMuscleOptimizationFrames++ % parameters.decimationFactor !=
+                 0;
+    } else {
+        numMuscleOptimizationFrames = 0;
+    }
+    if (isShed) {
+        output.am = heldMuscleOptimization.am;
+        output.fm = heldMuscleOptimization.fm;
+        output.residuals = heldMuscleOptimization.residuals;
+        return true;
+    }
+
+    // relax the convergence criteria of the optimizer
+    const bool isRelaxed = level != QualityLevel::FULL;
+    if (isRelaxed != isMuscleOptimizationRelaxed) {
+        const auto& nominal = parameters.muscleOptimizationParameters;
+        muscleOptimization->setConvergenceCriteria(
+                isRelaxed ? parameters.relaxedConvergenceTolerance
+                          : nominal.convergenceTolerance,
+                isRelaxed ? parameters.relaxedMaximumIterations
+                          : nominal.maximumIterations);
+        isMuscleOptimizationRelaxed = isRelaxed;
+    }
+
+    const auto& data = frame.filteredData;
+    auto& input = muscleOptimizationInput;
+    input.t = data.t;
+    input.q = data.q;
+    input.tau = output.tau;
+    auto so = solveMuscleOptimization(input, output.isSurrogateSolution,
+                                      output.surrogateResidual);
+    output.am = so.am;
+    output.fm = so.fm;
+    output.residuals = so.residuals;
+    if (loadGovernor) {
+        heldMuscleOptimization.am = output.am;
+        heldMuscleOptimization.fm = output.fm;
+        heldMuscleOptimization.residuals = output.residuals;
+    }
+    return true;
+}
+
+bool RealTimeAnalysis::solveJR(Frame& frame) {
+    if (!parameters.solveMuscleOptimization) return true;
+    solveJointReaction(frame, *jointReaction, jointReactionBuffers);
+    holdJointReaction(frame);
+    return true;
+}
+
+void RealTimeAnalysis::solveJointReaction(Frame& frame,
+                                          JointReaction& analysis,
+                                          JointReactionBuffers& buffers) {
+    if (frame.output.qualityLevel >= QualityLevel::SKIP_JR) return;
+    const auto& data = frame.filteredData;
+    auto& input = buffers.input;
+    input.t = data.t;
+    input.q = data.q;
+    input.qDot = data.qd;
+    input.fm = frame.output.fm;
+    input.externalWrenches = data.externalWrenches;
+    analysis.solve(input, buffers.output);
+    frame.output.reactionWrenches = buffers.output.reactionWrench;
+    analysis.asForceMomentPoint(buffers.output,
+                                frame.output.reactionWrenchVector);
+}
+
+void RealTimeAnalysis::holdJointReaction(Frame& frame) {
+    if (frame.output.qualityLevel >= QualityLevel::SKIP_JR) {
+        frame.output.reactionWrenches = heldJointReaction.reactionWrenches;
+        frame.output.reactionWrenchVector =
+                heldJointReaction.reactionWrenchVector;
+    } else if (loadGovernor) {
+        heldJointReaction.reactionWrenches = frame.output.reactionWrenches;
+        heldJointReaction.reactionWrenchVector =
+                frame.output.reactionWrenchVector;
+    }
+}
+
+bool RealTimeAnalysis::publish(Frame& frame) {
+    const auto& data = frame.filteredData;
+    auto& result = frame.output;
+    result.t = data.t;
+    result.q = data.q;
+    result.qd = data.qd;
+    result.qdd = data.qdd;
+    result.grfRightWrench.resize(ExternalWrench::Input::size());
+    result.grfLeftWrench.resize(ExternalWrench::Input::size());
+    data.externalWrenches[0].toVector(result.grfRightWrench, 0);
+    data.externalWrenches[1].toVector(result.grfLeftWrench, 0);
+
+    // lock-free publication to the subscribers
+    resultsPublisher.publish(result);
+    if (isReplaying) {
+        numReplayFrames++;
+        if (isCollectingReplayResults) replayResults.push_back(result);
+    }
+    if (binaryLogger) logResults(result);
+    endToEndLatency->record(Telemetry::elapsed(frame.acquisitionTime));
+    return true;
+}
+
+void RealTimeAnalysis::logResults(const Output& result) {
+    binaryLogger->appendRow(logTables.q, result.t, result.q);
+    binaryLogger->appendRow(logTables.qDot, result.t, result.qd);
+    binaryLogger->appendRow(logTables.qDDot, result.t, result.qdd);
+    binaryLogger->appendRow(logTables.tau, result.t, result.tau);
+    if (parameters.solveMuscleOptimization) {
+        binaryLogger->appendRow(logTables.fm, result.t, result.fm);
+        binaryLogger->appendRow(logTables.am, result.t, result.am);
+        binaryLogger->appendRow(logTables.residuals, result.t,
+                                result.residuals);
+        binaryLogger->appendRow(logTables.jr, result.t,
+                                result.reactionWrenchVector);
+    }
+}
+
+void RealTimeAnalysis::saveStageState(PipelineStage stage,
+                                      CheckpointWriter& writer) {
+    switch (stage) {
+    case PipelineStage::IK:
+        inverseKinematics->saveState(writer);
+        break;
+    case PipelineStage::FILTER:
+        lowPassFilter->saveState(writer);
+        break;
+    case PipelineStage::SO:
+        muscleOptimization->saveState(writer);
+        break;
+    default: // stateless
+        break;
+    }
+}
 
-        // raise termination flag
-        terminationFlag = true;
+void RealTimeAnalysis::loadStageState(PipelineStage stage,
+                                      CheckpointReader& reader) {
+    switch (stage) {
+    case PipelineStage::IK:
+        inverseKinematics->loadState(reader);
+        break;
+    case PipelineStage::FILTER:
+        lowPassFilter->loadState(reader);
+        isFilterRestored = true;
+        break;
+    case PipelineStage::SO:
+        muscleOptimization->loadState(reader);
+        break;
+    default: // stateless
+        break;
+    }
+}
+
+void RealTimeAnalysis::updateCheckpoint(int i) {
+    CheckpointWriter writer;
+    for (const auto& stage : parameters.pipelineThreads[i]) {
+        writer.clear();
+        saveStageState(stage, writer);
+        if (writer.getData().empty()) continue;
+        checkpointer->update(checkpointSections[static_cast<int>(stage)],
+                             writer.getData());
+    }
+}
 
-        // notify buffer to not get stuck in processing thread
-        buffer.setDataRetrievalMode(DataRetrievalMode::CONTINUOUS);
+void RealTimeAnalysis::restoreCheckpoint() {
+    auto sections = Checkpointer::load(parameters.checkpointFile);
+    for (int i = 0; i < pipelineStageNames.size(); ++i) {
+        auto section = sections.find(pipelineStageNames[i]);
+        if (section == sections.end()) continue;
+        CheckpointReader reader(section->second);
+        loadStageState(static_cast<PipelineStage>(i), reader);
+        if (!reader.isEmpty()) {
+            THROW_EXCEPTION("checkpoint of " + section->first +
+                            " does not match the analysis");
+        }
+        // the next checkpoint includes the sections that were restored
+        checkpointer->update(checkpointSections[i], section->second);
     }
 }
 
-void RealTimeAnalysis::processing() {
+RealTimeAnalysis::QualityLevel
+RealTimeAnalysis::updateLoadGovernor(uint64_t latency) {
+    int level = loadGovernor->update(
+            1e-9 * latency, acquisitionPeriod.load(memory_order_relaxed));
+    return static_cast<QualityLevel>(level);
+}
+
+void RealTimeAnalysis::runPipelineThread(int i) {
+    const auto& stages = parameters.pipelineThreads[i];
+    const bool isFirst = i == 0;
+    const bool isLast = i == parameters.pipelineThreads.size() - 1;
+    const auto& policies = parameters.pipelineThreadPolicies;
+    // load shedding makes the results depend on timing, thus it is disabled
+    // during replay
+    const bool isGoverned =
+            loadGovernor && !isReplaying && i == loadSheddingThread;
+    auto level = QualityLevel::FULL;
+    bool isEndOfTrial = false;
+    int numPublished = 0;
+    const auto checkpointInterval =
+            static_cast<uint64_t>(1e9 * parameters.checkpointInterval);
+    auto lastCheckpoint = Telemetry::now();
     try {
-        FilteredData filteredData;
-        Vector am, fm, residuals, reactionWrenchVector;
-        Vector_<SpatialVec> reactionWrenches;
+        // real-time configuration of the thread (warns if not permitted)
+        policies[policies.size() == 1 ? 0 : i].apply();
+        PROFILE_THREAD("pipeline " + to_string(i));
+
+        Frame frame;
         while (true) {
-            if (shouldTerminate()) THROW_EXCEPTION("Processing terminated.");
+            if (shouldTerminate()) THROW_EXCEPTION("Pipeline terminated.");
 
-            // get data from buffer
-            auto data = buffer.get(1)[0];
-            filteredData.fromVector(data.t, data.x, data.xDot, data.xDDot,
-                                    model.getNumCoordinates());
+            // get frame from the previous thread; during replay, the previous
+            // thread closes the queue at the end of the trial
+            if (!isFirst && !queues[i - 1]->popCopy(frame)) {
+                if (isReplaying && !shouldTerminate()) break;
+                THROW_EXCEPTION("Pipeline terminated.");
+            }
 
-            // solve id
-            auto id = inverseDynamics->solve({filteredData.t, filteredData.q,
-                                              filteredData.qd, filteredData.qdd,
-                                              filteredData.externalWrenches});
+            // release the temporaries of the previous frame of the thread
+            FrameContext::beginFrame();
 
-            // solve so and jr
-            if (parameters.solveMuscleOptimization) {
-                auto so = muscleOptimization->solve(
-                        {filteredData.t, filteredData.q, id.tau});
-                am = so.am;
-                fm = so.fm;
-                residuals = so.residuals;
-
-                auto jr = jointReaction->solve({filteredData.t, filteredData.q,
-                                                filteredData.qd, so.fm,
-                                                filteredData.externalWrenches});
-                reactionWrenches = jr.reactionWrench;
-                reactionWrenchVector = jointReaction->asForceMomentPoint(jr);
+            // the quality level is decided before the stages of the thread
+            if (isGoverned) {
+                frame.output.qualityLevel = level;
+                qualityLevel->record(static_cast<uint64_t>(level));
+            }
+
+            // execute stages
+            bool isValid = true;
+            uint64_t processingTime = 0; // excluding the wait for data
+            for (int j = 0; j < stages.size() && isValid; ++j) {
+                PROFILE_ZONE(pipelineStageNames[static_cast<int>(stages[j])]
+                                     .c_str());
+                auto stageStart = Telemetry::now();
+                switch (stages[j]) {
+                case PipelineStage::ACQUIRE:
+                    if (!isReplaying) {
+                        isValid = acquire(frame);
+                        break;
+                    }
+                    // the acquisition function throws at the end of a trial
+                    try {
+                        isValid = acquire(frame);
+                    } catch (const std::exception&) {
+                        isEndOfTrial = true;
+                        isValid = false;
+                    }
+                    break;
+                case PipelineStage::IK:
+                    isValid = solveIK(frame);
+                    break;
+                case PipelineStage::FILTER:
+                    isValid = filter(frame);
+                    break;
+                case PipelineStage::ID:
+                    isValid = solveID(frame);
+                    break;
+                case PipelineStage::SO:
+                    isValid = solveSO(frame);
+                    break;
+                case PipelineStage::JR:
+                    isValid = solveJR(frame);
+                    break;
+                case PipelineStage::PUBLISH:
+                    isValid = publish(frame);
+                    break;
+                }
+                auto stageTime = Telemetry::elapsed(stageStart);
+                stageLatency[static_cast<int>(stages[j])]->record(stageTime);
+                if (stages[j] != PipelineStage::ACQUIRE) {
+                    processingTime += stageTime;
+                }
+            }
+
+            if (isEndOfTrial) break;
+
+            // adapt the quality of the next frame
+            if (isGoverned && isValid) {
+                level = updateLoadGovernor(processingTime);
+            }
+
+            // push to the next thread
+            if (isValid && !isLast) {
+                queues[i]->pushCopy(frame);
+                queueDepth[i]->record(queues[i]->getSize());
+            }
+
+            // lock the memory once the analyses have allocated their buffers
+            if (isValid && isLast && parameters.lockMemory &&
+                ++numPublished == parameters.warmUpFrames) {
+                OpenSimRT::lockMemory(parameters.prefaultHeapSize);
             }
 
-            { // thread-safe write to output
-                lock_guard<mutex> locker(mu);
-                output.t = filteredData.t;
-                output.q = filteredData.q;
-                output.qd = filteredData.qd;
-                output.qdd = filteredData.qdd;
-                output.grfRightWrench =
-                        filteredData.externalWrenches[0].toVector();
-                output.grfLeftWrench =
-                        filteredData.externalWrenches[1].toVector();
-                output.tau = id.tau;
-                output.am = am;
-                output.fm = fm;
-                output.residuals = residuals;
-                output.reactionWrenches = reactionWrenches;
-                output.reactionWrenchVector = reactionWrenchVector;
+            // state of the stages after the frame
+            if (checkpointer &&
+                Telemetry::elapsed(lastCheckpoint) >= checkpointInterval) {
+                updateCheckpoint(i);
+                lastCheckpoint = Telemetry::now();
             }
-            // notify main thread to read output
-            notifyParentThread = true;
-            cond.notify_one();
         }
+
+        // end of the trial (replay), the next thread processes the remaining
+        // frames of the queue
+        if (!isLast) queues[i]->close();
     } catch (const std::exception& e) {
         cout << e.what() << endl;
 
-        // raise termination flag
-        terminationFlag = true;
+        // raise termination flag and unblock the other threads and the
+        // subscribers of the results
+        shouldTerminate(true);
+    }
+}
+
+void RealTimeAnalysis::runJointReactionDispatcher(int i) {
+    const int n = jointReactionWorkers.size();
+    const auto& policies = parameters.pipelineThreadPolicies;
+    auto& input = *queues[i - 1];
+    try {
+        policies[policies.size() == 1 ? 0 : i].apply();
+        PROFILE_THREAD("jr dispatcher");
+
+        // at most one frame per worker is in flight, the oldest is collected
+        // first, so that the order of the frames is preserved
+        Frame frame;
+        int next = 0, oldest = 0, inFlight = 0;
+        bool isEndOfTrial = false;
+        while (true) {
+            if (shouldTerminate()) THROW_EXCEPTION("Pipeline terminated.");
+            bool isIdle = true;
+
+            // dispatch
+            if (!isEndOfTrial && inFlight < n) {
+                bool hasFrame = input.tryPopCopy(frame);
+                // during replay, the previous thread closes the queue at the
+                // end of the trial (possibly after the last push)
+                if (!hasFrame && input.isClosed()) {
+                    hasFrame = input.tryPopCopy(frame);
+                    if (!hasFrame && !isReplaying) {
+                        THROW_EXCEPTION("Pipeline terminated.");
+                    }
+                    isEndOfTrial = !hasFrame;
+                }
+                if (hasFrame) {
+                    jointReactionWorkers[next]->input->pushCopy(frame);
+                    next = (next + 1) % n;
+                    inFlight++;
+                    isIdle = false;
+                }
+            }
+
+            // collect in order
+            if (inFlight > 0 &&
+                jointReactionWorkers[oldest]->output->tryPopCopy(frame)) {
+                stageLatency[static_cast<int>(PipelineStage::JR)]->record(
+                        frame.workerTime);
+                if (parameters.solveMuscleOptimization) {
+                    holdJointReaction(frame);
+                }
+                queues[i]->pushCopy(frame);
+                queueDepth[i]->record(queues[i]->getSize());
+                oldest = (oldest + 1) % n;
+                inFlight--;
+                isIdle = false;
+            }
 
-        // notify main thread in case of exception
-        notifyParentThread = true;
-        cond.notify_one();
+            PROFILE_COUNTER("jr_in_flight", inFlight);
+            if (isEndOfTrial && inFlight == 0) break;
+            if (isIdle) this_thread::yield();
+        }
+
+        // end of the trial (replay)
+        for (auto& worker : jointReactionWorkers) worker->input->close();
+        queues[i]->close();
+    } catch (const std::exception& e) {
+        cout << e.what() << endl;
+        shouldTerminate(true);
+    }
+}
+
+void RealTimeAnalysis::runJointReactionWorker(int w) {
+    const auto& policies = parameters.pipelineThreadPolicies;
+    auto& worker = *jointReactionWorkers[w];
+    try {
+        policies[policies.size() == 1 ? 0 : jointReactionThread].apply();
+        PROFILE_THREAD("jr worker " + to_string(w));
+
+        Frame frame;
+        while (worker.input->popCopy(frame)) {
+            FrameContext::beginFrame();
+            auto start = Telemetry::now();
+            if (parameters.solveMuscleOptimization) {
+                solveJointReaction(frame, *worker.jointReaction,
+                                   worker.buffers);
+            }
+            frame.workerTime = Telemetry::elapsed(start);
+            if (!worker.output->pushCopy(frame)) break;
+        }
+    } catch (const std::exception& e) {
+        cout << e.what() << endl;
+        shouldTerminate(true);
     }
 }
 
 RealTimeAnalysis::Output RealTimeAnalysis::getResults() {
-    unique_lock<mutex> locker(mu);
-    cond.wait(locker, [&]() { return notifyParentThread.load(); });
-    notifyParentThread = false;
-    return output;
+    Output results;
+    if (!mainResultsSubscriber->wait(results)) {
+        return mainResultsSubscriber->getLatest();
+    }
+    return results;
+}
+
+RealTimeAnalysis::ResultsSubscriber& RealTimeAnalysis::subscribeToResults() {
+    return resultsPublisher.subscribe();
+}
+
+void RealTimeAnalysis::addResultsCallback(const ResultsCallback& callback) {
+    resultsPublisher.addCallback(callback);
 }
 
 RealTimeAnalysis::Loggers RealTimeAnalysis::initializeLoggers() {
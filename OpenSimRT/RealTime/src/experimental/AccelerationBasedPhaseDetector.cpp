@@ -28,8 +28,19 @@ using namespace SimTK;
 
 AccelerationBasedPhaseDetector::AccelerationBasedPhaseDetector(
         const Model& otherModel, const Parameters& otherParameters)
-        : GaitPhaseDetector(otherParameters.windowSize),
-          model(*otherModel.clone()), parameters(otherParameters) {
+        : AccelerationBasedPhaseDetector(
+                  std::make_shared<KinematicsContext>(otherModel),
+                  otherParameters) {
+    context->initialize();
+}
+
+AccelerationBasedPhaseDetector::AccelerationBasedPhaseDetector(
+        const std::shared_ptr<KinematicsContext>& context,
+        const Parameters& otherParameters)
+        : GaitPhaseDetector(otherParameters.windowSize), context(context),
+          parameters(otherParameters) {
+    auto& model = context->updModel();
+
     // initialize buffers with consecutive values indicating the acceleration
     // exceeds the threshold
     rSlidingWindow.init(Array_<Vec2>(2, Vec2(0.0)));
@@ -71,16 +82,14 @@ AccelerationBasedPhaseDetector::AccelerationBasedPhaseDetector(
     model.addModelComponent(heelStationL.get());
     model.addModelComponent(toeStationR.get());
     model.addModelComponent(toeStationL.get());
-
-    // initialize system
-    state = model.initSystem();
 }
 
 void AccelerationBasedPhaseDetector::updDetector(
         const GRFMPrediction::Input& input) {
-    // update detector simtk state
-    OpenSimUtils::updateState(model, state, input.q, input.qDot);
-    model.realizeAcceleration(state);
+    // update detector simtk state; only the station positions are required,
+    // which are realized once per frame for all analyses of the context
+    context->update(input.t, input.q, input.qDot);
+    const auto& state = context->getState();
 
     // get station position
     auto rHeelPos = heelStationR->getLocationInGround(state);
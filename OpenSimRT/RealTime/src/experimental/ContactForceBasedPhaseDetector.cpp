@@ -33,8 +33,18 @@ using namespace SimTK;
 
 ContactForceBasedPhaseDetector::ContactForceBasedPhaseDetector(
         const Model& otherModel, const Parameters& otherParameters)
-        : GaitPhaseDetector(otherParameters.windowSize),
-          model(*otherModel.clone()), parameters(otherParameters) {
+        : ContactForceBasedPhaseDetector(
+                  make_shared<KinematicsContext>(otherModel), otherParameters) {
+    context->initialize();
+}
+
+ContactForceBasedPhaseDetector::ContactForceBasedPhaseDetector(
+        const shared_ptr<KinematicsContext>& context,
+        const Parameters& otherParameters)
+        : GaitPhaseDetector(otherParameters.windowSize), context(context),
+          parameters(otherParameters) {
+    auto& model = context->updModel();
+
     // add platform
     auto platform = new OpenSim::Body("Platform", 1.0, Vec3(0), Inertia(0));
     model.addBody(platform);
@@ -109,16 +119,20 @@ ContactForceBasedPhaseDetector::ContactForceBasedPhaseDetector(
     model.addForce(rightContactForce.get());
     model.addForce(leftContactForce.get());
 
-    // initialize system
-    state = model.initSystem();
+    // the contact forces are monitored, but must not act on the shared model
+    rightContactForce->set_appliesForce(false);
+    leftContactForce->set_appliesForce(false);
 }
 
 void ContactForceBasedPhaseDetector::updDetector(
         const GRFMPrediction::Input& input) {
-    OpenSimUtils::updateState(model, state, input.q, input.qDot);
-    model.realizeDynamics(state);
+    // kinematics are realized once per frame for all analyses of the context
+    context->update(input.t, input.q, input.qDot);
+    context->realize(Stage::Dynamics);
+    const auto& state = context->getState();
 
-    // compute contact forces
+    // compute contact forces (getRecordValues evaluates the contribution of
+    // the force element even if it is not applied)
     auto rightContactWrench = rightContactForce.get()->getRecordValues(state);
     Vec3 rightContactForce(-rightContactWrench.get(0),
                            -rightContactWrench.get(1),
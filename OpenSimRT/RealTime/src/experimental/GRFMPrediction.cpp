@@ -21,6 +21,7 @@
 #include "Exception.h"
 #include "GaitPhaseDetector.h"
 #include "OpenSimUtils.h"
+#include "Profiler.h"
 #include "Utils.h"
 
 using namespace std;
@@ -31,8 +32,18 @@ using namespace SimTK;
 GRFMPrediction::GRFMPrediction(const Model& otherModel,
                                const Parameters& aParameters,
                                GaitPhaseDetector* detector)
-        : model(*otherModel.clone()), gaitPhaseDetector(detector),
+        : GRFMPrediction(make_shared<KinematicsContext>(otherModel),
+                         aParameters, detector) {
+    context->initialize();
+}
+
+GRFMPrediction::GRFMPrediction(const shared_ptr<KinematicsContext>& context,
+                               const Parameters& aParameters,
+                               GaitPhaseDetector* detector)
+        : context(context), gaitPhaseDetector(detector),
           parameters(aParameters) {
+    auto& model = context->updModel();
+
     // reserve memory size for computing the mean gait direction
     gaitDirectionBuffer.setSize(parameters.directionWindowSize);
 
@@ -58,11 +69,8 @@ GRFMPrediction::GRFMPrediction(const Model& otherModel,
     model.addModelComponent(toeStationR.get());
     model.addModelComponent(toeStationL.get());
 
-    // disable muscles, otherwise they apply passive forces
-    OpenSimUtils::disableActuators(model);
-
-    // initialize system
-    state = model.initSystem();
+    // NOTE: muscles do not apply passive forces since the actuators of the
+    // shared model are disabled by the context
 
     // define STA functions by Ren et al.
     // https://doi.org/10.1016/j.jbiomech.2008.06.001
@@ -113,10 +121,16 @@ void GRFMPrediction::computeTotalReactionComponents(const Input& input,
                                                     Vec3& totalReactionForce,
                                                     Vec3& totalReactionMoment) {
     // get matter subsystem
+    const auto& model = context->getModel();
+    const auto& state = context->getState();
     const auto& matter = model.getMatterSubsystem();
 
     // total forces / moments
     if (parameters.method == Method::InverseDynamics) {
+        // no external loads are applied
+        context->clearLoads();
+        context->realize(Stage::Dynamics);
+
         // ====================================================================
         // method 1: compute total forces/moment from pelvis using ID
         // ====================================================================
@@ -133,7 +147,6 @@ void GRFMPrediction::computeTotalReactionComponents(const Input& input,
                                                               Stage::Dynamics);
 
         // perform inverse dynamics
-        Vector tau;
         model.getMultibodySystem()
                 .getMatterSubsystem()
                 .calcResidualForceIgnoringConstraints(
@@ -142,7 +155,6 @@ void GRFMPrediction::computeTotalReactionComponents(const Input& input,
 
         //====================================================================
         // spatial forces/moments in pelvis wrt the ground
-        Vector_<SpatialVec> spatialGenForces;
         matter.multiplyBySystemJacobian(state, tau, spatialGenForces);
         const auto& idx = model.getBodySet()
                                   .get(parameters.pelvisBodyName)
@@ -156,8 +168,6 @@ void GRFMPrediction::computeTotalReactionComponents(const Input& input,
         //====================================================================
     } else if (parameters.method == Method::NewtonEuler) {
         // compute body velocities and accelerations
-        SimTK::Vector_<SimTK::SpatialVec> bodyVelocities;
-        SimTK::Vector_<SimTK::SpatialVec> bodyAccelerations;
         matter.multiplyBySystemJacobian(state, input.qDot, bodyVelocities);
         matter.calcBodyAccelerationFromUDot(state, input.qDDot,
                                             bodyAccelerations);
@@ -166,6 +176,14 @@ void GRFMPrediction::computeTotalReactionComponents(const Input& input,
             const auto& body = model.getBodySet()[i];
             const auto& bix = body.getMobilizedBodyIndex();
 
+            // bodies welded to ground (e.g., the contact platform of a phase
+            // detector that shares the model) are supported by the ground
+            const auto& mob = matter.getMobilizedBody(bix);
+            if (mob.getNumU(state) == 0 &&
+                mob.getParentMobilizedBody().isGround()) {
+                continue;
+            }
+
             // F_ext
             totalReactionForce += body.getMass() * (bodyAccelerations[bix][1] -
                                                     model.getGravity());
@@ -181,6 +199,8 @@ void GRFMPrediction::computeTotalReactionComponents(const Input& input,
 
 SimTK::Rotation
 GRFMPrediction::computeGaitDirectionRotation(const std::string& bodyName) {
+    const auto& model = context->getModel();
+    const auto& state = context->getState();
     const auto& body = model.getBodySet().get(bodyName);
     const auto& mob = model.getMatterSubsystem().getMobilizedBody(
             body.getMobilizedBodyIndex());
@@ -208,6 +228,7 @@ GRFMPrediction::computeGaitDirectionRotation(const std::string& bodyName) {
 
 GRFMPrediction::Output
 GRFMPrediction::solve(const GRFMPrediction::Input& input) {
+    PROFILE_ZONE("GRFMPrediction::solve");
     Output output;
     output.t = input.t;
     output.right.force = Vec3(0.0);
@@ -218,9 +239,9 @@ GRFMPrediction::solve(const GRFMPrediction::Input& input) {
     output.left.point = Vec3(0.0);
 
     if (gaitPhaseDetector->isDetectorReady()) {
-        // update model state and realize state
-        OpenSimUtils::updateState(model, state, input.q, input.qDot);
-        model.realizeDynamics(state);
+        // update model state (kinematics are realized once per frame for all
+        // analyses of the context)
+        context->update(input.t, input.q, input.qDot);
 
         // compute the transformation to the average heading direction
         auto R = computeGaitDirectionRotation(parameters.pelvisBodyName);
@@ -337,6 +358,8 @@ void GRFMPrediction::seperateReactionComponents(
 void GRFMPrediction::computeReactionPoint(const double& t,
                                           SimTK::Vec3& rightPoint,
                                           SimTK::Vec3& leftPoint) {
+    const auto& state = context->getState();
+
     // get previous SS time-period
     Tss = gaitPhaseDetector->getSingleSupportDuration();
 
@@ -19,6 +19,8 @@
  */
 #include "GaitPhaseDetector.h"
 #include "GRFMPrediction.h"
+#include "Checkpoint.h"
+#include "Exception.h"
 
 using namespace OpenSimRT;
 
@@ -35,9 +37,8 @@ GaitPhaseDetector::GaitPhaseDetector(const int& windowSize) : Tds(-1), Tss(-1) {
     // define function for detecting HS - transition SWING -> STANCE
     // (compare latest value the the previous n-1 values in the window)
     detectHS = [](const SlidingWindow<GaitPhaseState::LegPhase>& w) {
-        return (w.nFirstEqual(GaitPhaseState::LegPhase::SWING,
-                              w.data.size() - 1) &&
-                w.data.back() == GaitPhaseState::LegPhase::STANCE)
+        return (w.nFirstEqual(GaitPhaseState::LegPhase::SWING, w.size() - 1) &&
+                w.back() == GaitPhaseState::LegPhase::STANCE)
                        ? true
                        : false;
     };
@@ -45,9 +46,8 @@ GaitPhaseDetector::GaitPhaseDetector(const int& windowSize) : Tds(-1), Tss(-1) {
     // define function for detecting TO - transition STANCE -> SWING
     // (compare latest value the the previous n-1 values in the window)
     detectTO = [](const SlidingWindow<GaitPhaseState::LegPhase>& w) {
-        return (w.nFirstEqual(GaitPhaseState::LegPhase::STANCE,
-                              w.data.size() - 1) &&
-                w.data.back() == GaitPhaseState::LegPhase::SWING)
+        return (w.nFirstEqual(GaitPhaseState::LegPhase::STANCE, w.size() - 1) &&
+                w.back() == GaitPhaseState::LegPhase::SWING)
                        ? true
                        : false;
     };
@@ -153,3 +153,46 @@ const double GaitPhaseDetector::getToeOffTime() {
 const double GaitPhaseDetector::getDoubleSupportDuration() { return Tds; };
 
 const double GaitPhaseDetector::getSingleSupportDuration() { return Tss; };
+
+void GaitPhaseDetector::saveState(CheckpointWriter& writer) const {
+    writer.write(Ths.right);
+    writer.write(Ths.left);
+    writer.write(Tto.right);
+    writer.write(Tto.left);
+    writer.write(Tds);
+    writer.write(Tss);
+    writer.write(static_cast<int>(gaitPhase));
+    writer.write(static_cast<int>(leadingLeg));
+    for (const auto* window : {&phaseWindowR, &phaseWindowL}) {
+        writer.write(static_cast<int>(window->size()));
+        for (size_t i = 0; i < window->size(); ++i) {
+            writer.write(static_cast<int>((*window)[i]));
+        }
+    }
+}
+
+void GaitPhaseDetector::loadState(CheckpointReader& reader) {
+    int phase, leg;
+    reader.read(Ths.right);
+    reader.read(Ths.left);
+    reader.read(Tto.right);
+    reader.read(Tto.left);
+    reader.read(Tds);
+    reader.read(Tss);
+    reader.read(phase);
+    reader.read(leg);
+    gaitPhase = static_cast<GaitPhaseState::GaitPhase>(phase);
+    leadingLeg = static_cast<GaitPhaseState::LeadingLeg>(leg);
+    for (auto* window : {&phaseWindowR, &phaseWindowL}) {
+        int size;
+        reader.read(size);
+        if (size != static_cast<int>(window->getCapacity())) {
+            THROW_EXCEPTION("checkpoint does not match the window size");
+        }
+        window->clear();
+        for (int i = 0; i < size; ++i) {
+            reader.read(phase);
+            window->insert(static_cast<GaitPhaseState::LegPhase>(phase));
+        }
+    }
+}
@@ -19,6 +19,8 @@
  */
 #include "MarkerReconstruction.h"
 #include "OpenSimUtils.h"
+#include "Profiler.h"
+#include <algorithm>
 
 using namespace std;
 using namespace OpenSim;
@@ -29,11 +31,26 @@ using namespace SimTK;
 MarkerReconstruction::MarkerReconstruction(
         const Model& otherModel,
         const vector<InverseKinematics::MarkerTask>& markerTasks)
-        : model(*otherModel.clone()), isInitialized(false) {
+        : MarkerReconstruction(shared_ptr<const Model>(otherModel.clone()),
+                               markerTasks) {}
+
+MarkerReconstruction::MarkerReconstruction(
+        shared_ptr<const ModelContext> modelContext,
+        const vector<InverseKinematics::MarkerTask>& markerTasks)
+        : MarkerReconstruction(
+                  // the model is owned by the context
+                  shared_ptr<const Model>(modelContext,
+                                          &modelContext->getModel()),
+                  markerTasks) {}
+
+MarkerReconstruction::MarkerReconstruction(
+        shared_ptr<const Model> model,
+        const vector<InverseKinematics::MarkerTask>& markerTasks)
+        : model(model), isInitialized(false) {
     // map markers to corresponding body segments
     for (int i = 0; i < markerTasks.size(); ++i) {
         const auto& markerName = markerTasks[i].name;
-        const auto& marker = model.getMarkerSet().get(markerName);
+        const auto& marker = model->getMarkerSet().get(markerName);
         markersPerBodyMap.emplace(marker.getParentFrameName(), markerName);
 
         // get marker observation order from tasks.
@@ -42,7 +59,7 @@ MarkerReconstruction::MarkerReconstruction(
     // create table with distances between markers in same body
     for (int i = 0; i < markerTasks.size(); ++i) {
         const auto& iMarkerName = markerTasks[i].name;
-        const auto& iMarker = model.getMarkerSet().get(iMarkerName);
+        const auto& iMarker = model->getMarkerSet().get(iMarkerName);
 
         const auto& markersInBody =
                 markersPerBodyMap.equal_range(iMarker.getParentFrameName());
@@ -51,12 +68,30 @@ MarkerReconstruction::MarkerReconstruction(
         for (auto itr = markersInBody.first; itr != markersInBody.second;
              ++itr) {
             const auto& jMarkerName = itr->second;
-            const auto& jMarker = model.getMarkerSet().get(jMarkerName);
+            const auto& jMarker = model->getMarkerSet().get(jMarkerName);
 
             Vec3 dij = jMarker.get_location() - iMarker.get_location();
             markerDistanceTable[iMarkerName][jMarkerName] = dij;
         }
     }
+    // markers in the same body ordered by their distance in the model, so that
+    // the closest markers are found without sorting in each frame
+    markersByDistance.resize(observationOrder.size());
+    for (int i = 0; i < observationOrder.size(); ++i) {
+        const auto& distances = markerDistanceTable[observationOrder[i]];
+        auto& markers = markersByDistance[i];
+        for (int j = 0; j < observationOrder.size(); ++j) {
+            if (j != i && distances.count(observationOrder[j])) {
+                markers.push_back(j);
+            }
+        }
+        stable_sort(markers.begin(), markers.end(), [&](int j, int k) {
+            return distances.at(observationOrder[j]).norm() <
+                   distances.at(observationOrder[k]).norm();
+        });
+    }
+    // the same size in each frame, thus they are allocated once
+    covariance.resize(3, 3);
 }
 
 bool MarkerReconstruction::isValidFrame(
@@ -109,77 +144,81 @@ void MarkerReconstruction::reconstructionMethod(
     Sphere c2{d2x.norm(), currentObservations[id2]};
 
     // find intersection of the two spheres.
-    auto* circle = sphereSphereIntersection(c1, c2);
+    Circle circle;
 
     // reconstructed point is the point on the circle closest to
     // x_tilde.
-    if (circle) {
+    if (sphereSphereIntersection(c1, c2, circle)) {
         // projection on the plane of the circle
         currentObservations[i] = closestPointToCircle(x_tilde, circle);
 
     } else { // spheres do not intersect.
         currentObservations[i] = x_tilde;
     }
-    delete circle;
 }
 
 void MarkerReconstruction::reconstructionMethod(
         Array_<Vec3>& currentObservations, const int& i,
-        const vector<int>& indices) {
-    Matrix A(3, 3);
-    Matrix B(3, 3);
-
-    // marker coordinates as columns in matrices
+        const ArenaVector<int>& indices) {
+    // find centroid of the markers in the previous (A) and current (B) frame
+    Vec3 centroid_A(0);
+    Vec3 centroid_B(0);
     for (int j = 0; j < 3; ++j) {
-        A.updCol(j) = Vector(3, &previousObservations[indices[j]][0]);
+        centroid_A += previousObservations[indices[j]];
+        centroid_B += currentObservations[indices[j]];
     }
+    centroid_A /= 3;
+    centroid_B /= 3;
+
+    // marker coordinates as columns in matrices, centered at the centroids
+    Mat33 A;
+    Mat33 B;
     for (int j = 0; j < 3; ++j) {
-        B.updCol(j) = Vector(3, &currentObservations[indices[j]][0]);
+        A.col(j) = previousObservations[indices[j]] - centroid_A;
+        B.col(j) = currentObservations[indices[j]] - centroid_B;
     }
 
-    // find centroid and substract from columns in A and B
-    const auto centroid_A = A.rowSum() / A.ncol();
-    const auto centroid_B = B.rowSum() / B.ncol();
-
-    for (int j = 0; j < A.ncol(); ++j) { A.updCol(j) -= centroid_A; }
-    for (int j = 0; j < B.ncol(); ++j) { B.updCol(j) -= centroid_B; }
-
     // solve SVD for H = A * B**T --> [U, S, V**T] = SVD(H)
-    Matrix rightVectors;
-    Matrix leftVectors;
-    Vector singularValues;
-
-    FactorSVD svd(A * (~B));
+    Mat33 H = A * (~B);
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) { covariance(r, c) = H(r, c); }
+    }
+    FactorSVD svd(covariance);
     svd.getSingularValuesAndVectors(singularValues, leftVectors, rightVectors);
 
-    // rotation matrix R = V * U**T
-    auto r = (~rightVectors) * (~leftVectors);
-    auto R = Mat33(r[0][0], r[0][1], r[0][2], r[1][0], r[1][1], r[1][2],
-                   r[2][0], r[2][1], r[2][2]);
+    // rotation matrix R = V * U**T, with the sign of the last right singular
+    // vector
+    auto rotation = [&](double sign) {
+        Mat33 R;
+        for (int r = 0; r < 3; ++r) {
+            for (int c = 0; c < 3; ++c) {
+                R(r, c) = rightVectors(0, r) * leftVectors(c, 0) +
+                          rightVectors(1, r) * leftVectors(c, 1) +
+                          sign * rightVectors(2, r) * leftVectors(c, 2);
+            }
+        }
+        return R;
+    };
+    auto R = rotation(1);
 
     // address reflexion case
-    if (det(R) < 0) {
-        rightVectors[2] *= -1;
-        r = (~rightVectors) * (~leftVectors);
-        R = Mat33(r[0][0], r[0][1], r[0][2], r[1][0], r[1][1], r[1][2], r[2][0],
-                  r[2][1], r[2][2]);
-    }
+    if (det(R) < 0) { R = rotation(-1); }
 
     // translation vector
-    auto t = centroid_B - Matrix(R) * centroid_A;
+    Vec3 t = centroid_B - R * centroid_A;
 
     // transform missing marker to compute a current estimate
-    auto estimate = Matrix(R) * Vector(previousObservations[i]) + t;
-    currentObservations[i] = Vec3(estimate[0], estimate[1], estimate[2]);
+    currentObservations[i] = R * previousObservations[i] + t;
 }
 
 void MarkerReconstruction::solve(Array_<Vec3>& currentObservations) {
+    auto& arena = FrameContext::getArena();
     for (int i = 0; i < currentObservations.size(); ++i) {
         if (!currentObservations[i].isFinite()) {
             // find the closest markers (max = 3) of the missing marker.
-            const auto& mMarkerName = observationOrder[i];
+            FrameArena::Scope scope(arena);
             auto indices =
-                    findClosestMarkers(mMarkerName, currentObservations, 3);
+                    findClosestMarkers(i, currentObservations, 3, arena);
 
             // dispatch reconstruction method based on the number of closest
             // markers in the same body
@@ -204,20 +243,21 @@ void MarkerReconstruction::solve(Array_<Vec3>& currentObservations) {
 
 Array_<Vec3>
 MarkerReconstruction::solve(const Array_<Vec3>& currentObservations) {
+    PROFILE_ZONE("MarkerReconstruction::solve");
     auto reconstructedObservations(currentObservations);
     solve(reconstructedObservations);
     return reconstructedObservations;
 }
 
-MarkerReconstruction::Circle*
-MarkerReconstruction::sphereSphereIntersection(const Sphere& c1,
-                                               const Sphere& c2) {
+bool MarkerReconstruction::sphereSphereIntersection(const Sphere& c1,
+                                                    const Sphere& c2,
+                                                    Circle& circle) {
     double d = (c1.origin - c2.origin).norm();        // distance of two origins
     Vec3 d_hat = (c2.origin - c1.origin).normalize(); // unit vector
 
     // check for solvability.
     if (d > (c1.radius + c2.radius) || (d < abs(c1.radius - c2.radius))) {
-        return nullptr;
+        return false;
     }
 
     // determine the distance from c1.origin to point p.
@@ -229,60 +269,29 @@ MarkerReconstruction::sphereSphereIntersection(const Sphere& c1,
     // determine the distance from point p to either of the intersection points.
     double h = sqrt((c1.radius * c1.radius) - (a * a));
     // determine the intersection points.
-    return new Circle{h, p, d_hat};
+    circle = Circle{h, p, d_hat};
+    return true;
 }
 
 Vec3 MarkerReconstruction::closestPointToCircle(const Vec3& vec,
-                                                const Circle* c) {
-    auto dist = dot(vec - c->origin, c->normal);
-    auto vec_prime = vec - dist * c->normal;
+                                                const Circle& c) {
+    auto dist = dot(vec - c.origin, c.normal);
+    auto vec_prime = vec - dist * c.normal;
 
     // shortest distance between a point and a circle in 2D.
-    auto n = (vec_prime - c->origin).normalize();
-    return c->origin + n * c->radius;
+    auto n = (vec_prime - c.origin).normalize();
+    return c.origin + n * c.radius;
 };
 
-vector<int> MarkerReconstruction::findClosestMarkers(
-        const string& mMarkerName, const Array_<Vec3>& currentObservations,
-        int numMarkers) {
-    // info of missing marker
-    const auto& mMarker = model.getMarkerSet().get(mMarkerName);
-    const auto& bodyName = mMarker.getParentFrameName();
-    const int idx = distance(observationOrder.cbegin(),
-                             find(observationOrder.cbegin(),
-                                  observationOrder.cend(), mMarkerName));
-
-    // marker list per body, ignoring missing markers
-    vector<string> markersInBody;
-    for (auto itr = markersPerBodyMap.equal_range(bodyName).first;
-         itr != markersPerBodyMap.equal_range(bodyName).second; ++itr) {
-        const int i = distance(observationOrder.cbegin(),
-                               find(observationOrder.cbegin(),
-                                    observationOrder.cend(), itr->second));
-
-        if (currentObservations[i].isFinite()) {
-            markersInBody.push_back(itr->second);
-        }
-    }
-
-    // compare function based on marker distance
-    auto comp = [&](const string& iMarker, const string& jMarker) -> bool {
-        const auto& d1 = markerDistanceTable[mMarkerName][iMarker];
-        const auto& d2 = markerDistanceTable[mMarkerName][jMarker];
-        return d1.norm() < d2.norm();
-    };
-
-    // sort markers in body based on distance
-    sort(markersInBody.begin(), markersInBody.end(), comp);
-
-    // return the N closest marker IDs
-    vector<int> output;
-    numMarkers = min((int) markersInBody.size(), numMarkers);
-    for (auto itr = markersInBody.cbegin();
-         itr != markersInBody.cbegin() + numMarkers; ++itr) {
-        output.push_back(distance(observationOrder.cbegin(),
-                                  find(observationOrder.cbegin(),
-                                       observationOrder.cend(), *itr)));
+ArenaVector<int> MarkerReconstruction::findClosestMarkers(
+        int i, const Array_<Vec3>& currentObservations, int numMarkers,
+        FrameArena& arena) {
+    // markers in body ordered by distance, ignoring missing markers
+    ArenaVector<int> output{ArenaAllocator<int>(arena)};
+    output.reserve(numMarkers);
+    for (const auto& j : markersByDistance[i]) {
+        if (output.size() == numMarkers) break;
+        if (currentObservations[j].isFinite()) { output.push_back(j); }
     }
     return output;
 }
@@ -19,6 +19,7 @@
  */
 #include "RealTimeAnalysisExtended.h"
 #include "Exception.h"
+#include "GaitPhaseDetector.h"
 #include "InverseDynamics.h"
 
 using namespace std;
@@ -32,155 +33,95 @@ RealTimeAnalysisExtended::RealTimeAnalysisExtended(const Model& otherModel,
                            *static_cast<const RealTimeAnalysis::Parameters*>(
                                    &parameters)),
           parameters(parameters) {
-    // create MarkerReconstruction instance
+    // create MarkerReconstruction instance (shares the finalized model)
+    auto start = Telemetry::now();
     markerReconstruction =
-            new MarkerReconstruction(model, parameters.ikMarkerTasks);
+            new MarkerReconstruction(modelContext, parameters.ikMarkerTasks);
+    markerReconstructionLatency =
+            &telemetry.addLatencyHistogram("marker_reconstruction");
+    recordStartupStep("marker_reconstruction", start);
 
     // create optionally GRFMPrediction instance. requires a valid reference to
     // an instance of GaitPhaseDetector.
     if (parameters.useGRFMPrediction) {
+        start = Telemetry::now();
         if (parameters.phaseDetector == nullptr)
             THROW_EXCEPTION("Phase detector is null");
-        grfmPrediction = new GRFMPrediction(model, parameters.grfmParameters,
+        auto context = parameters.acquisitionContext
+                               ? parameters.acquisitionContext
+                               : make_shared<KinematicsContext>(model);
+        grfmPrediction = new GRFMPrediction(context, parameters.grfmParameters,
                                             parameters.phaseDetector.get());
+        context->initialize();
+        grfmPredictionLatency = &telemetry.addLatencyHistogram("grfm");
+        recordStartupStep("grfm", start);
     }
 }
 
-void RealTimeAnalysisExtended::acquisition() {
-    try {
-        while (true) {
-            if (shouldTerminate()) THROW_EXCEPTION("Acquisition terminated.");
-
-            // get data
-            auto acquisitionData = parameters.dataAcquisitionFunction();
-            if (previousAcquisitionTime >= acquisitionData.IkFrame.t) {
-                continue;
-            }
-
-            // update time
-            previousAcquisitionTime = acquisitionData.IkFrame.t;
-
-            // reconstruct possible missing markers. requires at least one valid
-            // frame with all markers positions
-            if (!markerReconstruction->initState(
-                        acquisitionData.IkFrame.markerObservations))
-                continue;
-            markerReconstruction->solve(
-                    acquisitionData.IkFrame.markerObservations);
-
-            // perform ik
-            auto pose = inverseKinematics->solve(acquisitionData.IkFrame);
-
-            // filter ik results
-            auto unfilteredData = prepareUnfilteredData(
-                    pose.q, acquisitionData.ExternalWrenches);
-            auto filteredData = lowPassFilter->filter({pose.t, unfilteredData});
-
-            // skip if filter is not ready
-            if (!filteredData.isValid) continue;
-
-            // represent filtered data as struct
-            FilteredData data;
-            data.fromVector(filteredData.t, filteredData.x, filteredData.xDot,
-                            filteredData.xDDot, model.getNumCoordinates());
-
-            // grfm prediction
-            if (parameters.useGRFMPrediction) {
-                // update detector
-                if (parameters.detectorUpdateMethod ==
-                    PhaseDetectorUpdateMethod::INTERNAL)
-                    parameters.internalPhaseDetectorUpdateFunction(
-                            data.t, data.q, data.qd, data.qdd);
-                else if (parameters.detectorUpdateMethod ==
-                         PhaseDetectorUpdateMethod::EXTERNAL)
-                    parameters.externalPhaseDetectorUpdateFunction();
-                else
-                    THROW_EXCEPTION("Wrong detector update method");
-
-                // solve grfm prediction
-                auto grfmOutput = grfmPrediction->solve(
-                        {data.t, data.q, data.qd, data.qdd});
-
-                // setup wrenches
-                ExternalWrench::Input grfRightWrench = {
-                        grfmOutput.right.point, grfmOutput.right.force,
-                        grfmOutput.right.torque};
-                ExternalWrench::Input grfLeftWrench = {grfmOutput.left.point,
-                                                       grfmOutput.left.force,
-                                                       grfmOutput.left.torque};
-
-                // set external wrenches in data struct
-                data.externalWrenches = {grfRightWrench, grfLeftWrench};
-            }
-
-            // push to buffer
-            buffer.add(data);
-        }
-    } catch (exception& e) {
-        cout << e.what() << endl;
+bool RealTimeAnalysisExtended::solveIK(Frame& frame) {
+    // reconstruct possible missing markers. requires at least one valid
+    // frame with all markers positions
+    auto start = Telemetry::now();
+    auto& markerObservations = frame.acquisitionData.IkFrame.markerObservations;
+    if (!markerReconstruction->initState(markerObservations)) return false;
+    markerReconstruction->solve(markerObservations);
+    markerReconstructionLatency->record(Telemetry::elapsed(start));
+
+    // perform ik
+    return RealTimeAnalysis::solveIK(frame);
+}
 
-        // raise termination flag
-        terminationFlag = true;
+bool RealTimeAnalysisExtended::filter(Frame& frame) {
+    // filter ik results
+    if (!RealTimeAnalysis::filter(frame)) return false;
 
-        // notify buffer to not get stuck in processing thread
-        buffer.setDataRetrievalMode(DataRetrievalMode::CONTINUOUS);
+    // grfm prediction
+    if (parameters.useGRFMPrediction) {
+        auto start = Telemetry::now();
+        auto& data = frame.filteredData;
+
+        // update detector
+        if (parameters.detectorUpdateMethod ==
+            PhaseDetectorUpdateMethod::INTERNAL)
+            parameters.internalPhaseDetectorUpdateFunction(data.t, data.q,
+                                                           data.qd, data.qdd);
+        else if (parameters.detectorUpdateMethod ==
+                 PhaseDetectorUpdateMethod::EXTERNAL)
+            parameters.externalPhaseDetectorUpdateFunction();
+        else
+            THROW_EXCEPTION("Wrong detector update method");
+
+        // solve grfm prediction
+        auto grfmOutput =
+                grfmPrediction->solve({data.t, data.q, data.qd, data.qdd});
+
+        // setup wrenches
+        ExternalWrench::Input grfRightWrench = {grfmOutput.right.point,
+                                                grfmOutput.right.force,
+                                                grfmOutput.right.torque};
+        ExternalWrench::Input grfLeftWrench = {grfmOutput.left.point,
+                                               grfmOutput.left.force,
+                                               grfmOutput.left.torque};
+
+        // set external wrenches in data struct
+        data.externalWrenches = {grfRightWrench, grfLeftWrench};
+        grfmPredictionLatency->record(Telemetry::elapsed(start));
     }
+    return true;
 }
 
-void RealTimeAnalysisExtended::processing() {
-    try {
-        Vector am, fm, residuals, reactionWrenchVector;
-        Vector_<SpatialVec> reactionWrenches;
-        while (true) {
-            if (shouldTerminate()) THROW_EXCEPTION("Processing terminated.");
-
-            // get data from buffer
-            auto data = buffer.get(1)[0];
-
-            // solve id
-            auto id = inverseDynamics->solve(
-                    {data.t, data.q, data.qd, data.qdd, data.externalWrenches});
-
-            // solve so and jr
-            if (parameters.solveMuscleOptimization) {
-                auto so = muscleOptimization->solve({data.t, data.q, id.tau});
-                am = so.am;
-                fm = so.fm;
-                residuals = so.residuals;
-
-                auto jr = jointReaction->solve({data.t, data.q, data.qd, so.fm,
-                                                data.externalWrenches});
-                reactionWrenches = jr.reactionWrench;
-                reactionWrenchVector = jointReaction->asForceMomentPoint(jr);
-            }
-
-            { // thread-safe write to output
-                lock_guard<mutex> locker(mu);
-                output.t = data.t;
-                output.q = data.q;
-                output.qd = data.qd;
-                output.qdd = data.qdd;
-                output.grfRightWrench = data.externalWrenches[0].toVector();
-                output.grfLeftWrench = data.externalWrenches[1].toVector();
-                output.tau = id.tau;
-                output.am = am;
-                output.fm = fm;
-                output.residuals = residuals;
-                output.reactionWrenches = reactionWrenches;
-                output.reactionWrenchVector = reactionWrenchVector;
-            }
-            // notify main thread to read output
-            notifyParentThread = true;
-            cond.notify_one();
-        }
-    } catch (const std::exception& e) {
-        cout << e.what() << endl;
-
-        // raise termination flag
-        terminationFlag = true;
+void RealTimeAnalysisExtended::saveStageState(PipelineStage stage,
+                                              CheckpointWriter& writer) {
+    RealTimeAnalysis::saveStageState(stage, writer);
+    if (stage == PipelineStage::FILTER && parameters.useGRFMPrediction) {
+        parameters.phaseDetector->saveState(writer);
+    }
+}
 
-        // notify main thread in case of exception
-        notifyParentThread = true;
-        cond.notify_one();
+void RealTimeAnalysisExtended::loadStageState(PipelineStage stage,
+                                              CheckpointReader& reader) {
+    RealTimeAnalysis::loadStageState(stage, reader);
+    if (stage == PipelineStage::FILTER && parameters.useGRFMPrediction) {
+        parameters.phaseDetector->loadState(reader);
     }
 }
@@ -169,6 +169,7 @@ void run() {
     visualizer.addDecorationGenerator(leftGRFDecorator);
     auto rightKneeForceDecorator = new ForceDecorator(Red, 0.0005, 3);
     visualizer.addDecorationGenerator(rightKneeForceDecorator);
+    auto rightKnee = jr.getJointIndex("knee_r");
 
     // mean delay
     int sumDelayMS = 0;
@@ -232,16 +233,9 @@ void run() {
         visualizer.update(q);
         rightGRFDecorator->update(grfRightWrench.point, grfRightWrench.force);
         leftGRFDecorator->update(grfLeftWrench.point, grfLeftWrench.force);
-        // tibia_r -> 3 (pelvis, femur_r, tibia_r) // should check order
-        auto kneeForce = -jrOutput.reactionWrench[2](1);
-        Vec3 kneeJoint;
-        state.updQ() = q;
-        model.realizePosition(state);
-        kneeJoint = model.getBodySet()
-                            .get("tibia_r")
-                            .findStationLocationInAnotherFrame(
-                                    state, Vec3(0), model.getGround());
-        rightKneeForceDecorator->update(kneeJoint, kneeForce);
+        auto kneeForce = -jrOutput.reactionWrench[rightKnee](1);
+        rightKneeForceDecorator->update(jrOutput.reactionPoint[rightKnee],
+                                        kneeForce);
 
         // log data (use filter time to align with delay)
         jrLogger.appendRow(ikFiltered.t, ~jr.asForceMomentPoint(jrOutput));
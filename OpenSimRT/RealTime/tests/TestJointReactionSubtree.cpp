@@ -0,0 +1,171 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestJointReactionSubtree.cpp
+ *
+ * \brief Tests that the joint reactions of gait1992 that are computed from the
+ * residuals of the subtrees agree with the mobilizer reaction forces of
+ * Simbody for every joint, without muscle forces, with muscle forces (the
+ * moving path points of the knees apply mobility forces) and for a selection
+ * of joints whose subtrees contain such mobility forces.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "Exception.h"
+#include "INIReader.h"
+#include "JointReaction.h"
+#include "KinematicsContext.h"
+#include "OpenSimUtils.h"
+#include "Settings.h"
+#include "Utils.h"
+#include <OpenSim/Actuators/Thelen2003Muscle.h>
+#include <OpenSim/Simulation/Model/Muscle.h>
+#include <iostream>
+
+using namespace std;
+using namespace OpenSim;
+using namespace SimTK;
+using namespace OpenSimRT;
+
+struct Data {
+    string modelFile;
+    Storage grfMotion;
+    vector<ExternalWrench::Parameters> wrenchParameters;
+    vector<vector<string>> grfLabels;
+    TimeSeriesTable qTable;
+    Storage soFm;
+};
+
+// maximum difference of the reactions from the mobilizer reactions, relative
+// to their magnitude (at least one)
+double runCase(const Data& data, const vector<string>& jointNames,
+               bool useMuscleForces, int numFrames) {
+    Model model(data.modelFile);
+    auto context = make_shared<KinematicsContext>(model);
+    JointReaction jr(context, data.wrenchParameters, jointNames);
+    context->initialize();
+    const auto& joints = context->getModel().getJointSet();
+    const int nm = context->getModel().getMuscles().getSize();
+    const auto& times = data.qTable.getIndependentColumn();
+
+    JointReaction::Output output;
+    double maxError = 0;
+    for (int i = 1; i < numFrames + 1; ++i) {
+        // central differences, any velocity is consistent for both methods
+        double t = times[i];
+        auto q = data.qTable.getRowAtIndex(i).getAsVector();
+        Vector qDot = (data.qTable.getRowAtIndex(i + 1).getAsVector() -
+                       data.qTable.getRowAtIndex(i - 1).getAsVector()) /
+                      (times[i + 1] - times[i - 1]);
+
+        Vector fm(nm, 0.0);
+        if (useMuscleForces) {
+            Array<double> row;
+            data.soFm.getDataAtTime(t, nm, row);
+            for (int j = 0; j < nm; ++j) fm[j] = row[j];
+        }
+        vector<ExternalWrench::Input> wrenches;
+        for (const auto& labels : data.grfLabels) {
+            wrenches.push_back(ExternalWrench::getWrenchFromStorage(
+                    t, labels, data.grfMotion));
+        }
+        jr.solve({t, q, qDot, fm, wrenches}, output);
+
+        // the state of the context is realized with the same loads
+        const auto& state = context->getState();
+        const auto& names = jr.getJointNames();
+        for (int j = 0; j < names.size(); ++j) {
+            auto expected = joints.get(names[j])
+                                    .calcReactionOnChildExpressedInGround(
+                                            state);
+            const auto& actual = output.reactionWrench[j];
+            double scale = max(
+                    1.0, max(expected[0].norm(), expected[1].norm()));
+            double error = max((actual[0] - expected[0]).norm(),
+                               (actual[1] - expected[1]).norm());
+            maxError = max(maxError, error / scale);
+        }
+    }
+    return maxError;
+}
+
+void run() {
+    // subject data
+    INIReader ini(INI_FILE);
+    auto section = "TEST_JR_FROM_FILE";
+    auto subjectDir = DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
+    auto grfMotFile = subjectDir + ini.getString(section, "GRF_MOT_FILE", "");
+    auto ikFile = subjectDir + ini.getString(section, "IK_FILE", "");
+    auto soFile = subjectDir + ini.getString(section, "SO_FILE", "");
+    const int numFrames = 50;
+    const double tolerance = 1e-9;
+
+    Data data;
+    data.modelFile = subjectDir + ini.getString(section, "MODEL_FILE", "");
+    data.grfMotion = Storage(grfMotFile);
+    for (const string& side : {"RIGHT", "LEFT"}) {
+        auto prefix = "GRF_" + side + "_";
+        data.wrenchParameters.push_back(
+                {ini.getString(section, prefix + "APPLY_TO_BODY", ""),
+                 ini.getString(section, prefix + "FORCE_EXPRESSED_IN_BODY",
+                               ""),
+                 ini.getString(section, prefix + "POINT_EXPRESSED_IN_BODY",
+                               "")});
+        data.grfLabels.push_back(ExternalWrench::createGRFLabelsFromIdentifiers(
+                ini.getString(section, prefix + "POINT_IDENTIFIER", ""),
+                ini.getString(section, prefix + "FORCE_IDENTIFIER", ""),
+                ini.getString(section, prefix + "TORQUE_IDENTIFIER", "")));
+    }
+
+    Object::RegisterType(Thelen2003Muscle());
+    Model model(data.modelFile);
+    model.initSystem();
+    data.qTable = OpenSimUtils::getMultibodyTreeOrderedCoordinatesFromStorage(
+            model, ikFile, 0.01);
+    data.soFm = Storage(soFile);
+    data.soFm.resampleLinear(0.01);
+    if (data.qTable.getNumRows() < numFrames + 2) {
+        THROW_EXCEPTION("not enough frames");
+    }
+
+    // all joints, without mobility forces (residuals of the subtrees) and with
+    // the mobility forces of the knees (mobilizer reactions)
+    auto error = runCase(data, {}, false, numFrames);
+    cout << "all joints without muscle forces: " << error << endl;
+    if (error > tolerance) THROW_EXCEPTION("subtree reactions differ");
+    error = runCase(data, {}, true, numFrames);
+    cout << "all joints with muscle forces: " << error << endl;
+    if (error > tolerance) THROW_EXCEPTION("reactions differ");
+
+    // the mobility forces of the knees are internal to the subtrees of the
+    // hips
+    error = runCase(data, {"hip_r", "hip_l", "back"}, true, numFrames);
+    cout << "hips and back with muscle forces: " << error << endl;
+    if (error > tolerance) THROW_EXCEPTION("subtree reactions differ");
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,219 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestMuscleOptimizationBlocks.cpp
+ *
+ * \brief Tests the detection of the independent blocks of the muscle
+ * optimization on a synthetic moment arm pattern (including a coordinate that
+ * is not spanned by any muscle) and that the block solves of gait1992 match
+ * the solve of the whole problem, sequentially and in parallel, also when the
+ * moment arms of a coordinate are zeroed (excluded by both).
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "Exception.h"
+#include "INIReader.h"
+#include "MuscleOptimization.h"
+#include "OpenSimUtils.h"
+#include "Settings.h"
+#include "Utils.h"
+#include <Actuators/Thelen2003Muscle.h>
+#include <iostream>
+
+using namespace std;
+using namespace OpenSim;
+using namespace SimTK;
+using namespace OpenSimRT;
+
+typedef vector<pair<vector<int>, vector<int>>> Blocks;
+
+void testFindIndependentBlocks() {
+    // 6 pelvis + 4 coordinates x 5 muscles: coordinates 6 and 7 are coupled
+    // by muscle 1, coordinate 8 is spanned by muscles 2 and 3, coordinate 9
+    // by none and muscle 4 spans only the pelvis (ignored)
+    Matrix R(10, 5, 0.0);
+    for (int j = 0; j < 5; ++j) R[0][j] = 1.0;
+    R[6][0] = 0.02;
+    R[6][1] = -0.01;
+    R[7][1] = 0.03;
+    R[8][2] = 0.04;
+    R[8][3] = -0.05;
+    R[5][4] = 0.01;
+
+    auto blocks = MuscleOptimization::findIndependentBlocks(R);
+    Blocks expected = {{{6, 7}, {0, 1}}, {{8}, {2, 3}}};
+    if (blocks != expected) THROW_EXCEPTION("wrong independent blocks");
+
+    // the unspanned coordinate is excluded from the blocks
+    auto unspanned = MuscleOptimization::findUnspannedCoordinates(R);
+    if (unspanned != vector<int>{9}) {
+        THROW_EXCEPTION("wrong unspanned coordinates");
+    }
+    for (const auto& block : blocks) {
+        for (const auto& i : block.first) {
+            if (i == 9) THROW_EXCEPTION("unspanned coordinate in a block");
+        }
+    }
+
+    // a single muscle couples all coordinates
+    for (int i = 6; i < 10; ++i) R[i][4] = 0.01;
+    blocks = MuscleOptimization::findIndependentBlocks(R);
+    if (blocks.size() != 1 || blocks[0].first.size() != 4 ||
+        blocks[0].second.size() != 5) {
+        THROW_EXCEPTION("coupled coordinates were split");
+    }
+    if (!MuscleOptimization::findUnspannedCoordinates(R).empty()) {
+        THROW_EXCEPTION("wrong unspanned coordinates");
+    }
+}
+
+// moment arm of the model with the last coordinate not spanned by any muscle
+MomentArmFunctionT calcModelMomentArm = nullptr;
+Matrix calcMomentArmZeroed(const Vector& q) {
+    auto R = calcModelMomentArm(q);
+    for (int j = 0; j < R.ncol(); ++j) R[R.nrow() - 1][j] = 0.0;
+    return R;
+}
+
+void compareSolves(const Model& model,
+                   MuscleOptimization::OptimizationParameters parameters,
+                   const MomentArmFunctionT& calcMomentArm,
+                   const vector<int>& expectedUnspanned,
+                   const TimeSeriesTable& qTable,
+                   const TimeSeriesTable& tauTable, int numFrames,
+                   double tolerance) {
+    // whole problem, blocks in the calling thread and blocks in parallel (in
+    // the calling thread as well, unless USE_THREAD_SAFE_IPOPT)
+    parameters.useBlockDecomposition = false;
+    MuscleOptimization whole(model, parameters, calcMomentArm);
+    parameters.useBlockDecomposition = true;
+    parameters.numberOfThreads = 1;
+    MuscleOptimization sequential(model, parameters, calcMomentArm);
+    parameters.numberOfThreads = 3;
+    MuscleOptimization parallel(model, parameters, calcMomentArm);
+    cout << "blocks: " << sequential.blocks.size() << endl;
+    if (sequential.blocks.size() < 2) THROW_EXCEPTION("no independent blocks");
+
+    // the unspanned coordinates are excluded from both problems
+    if (whole.unspannedCoordinateIndices != expectedUnspanned ||
+        sequential.unspannedCoordinateIndices != expectedUnspanned) {
+        THROW_EXCEPTION("wrong unspanned coordinates");
+    }
+    for (const auto& i : expectedUnspanned) {
+        for (const auto& j : whole.target->coordinateIndices) {
+            if (i == j) THROW_EXCEPTION("unspanned coordinate in the problem");
+        }
+    }
+
+    // the problem is strictly convex, thus the solutions coincide up to the
+    // convergence tolerance
+    double maxError = 0, maxParallelError = 0;
+    for (int i = 0; i < numFrames; ++i) {
+        MuscleOptimization::Input input{
+                qTable.getIndependentColumn()[i],
+                qTable.getRowAtIndex(i).getAsVector(),
+                tauTable.getRowAtIndex(i).getAsVector()};
+        auto wholeOutput = whole.solve(input);
+        auto sequentialOutput = sequential.solve(input);
+        auto parallelOutput = parallel.solve(input);
+        maxError = max(maxError,
+                       max(abs(sequentialOutput.am - wholeOutput.am)));
+        maxParallelError = max(
+                maxParallelError,
+                max(abs(parallelOutput.am - sequentialOutput.am)));
+    }
+    cout << "max activation error: " << maxError << " (blocks), "
+         << maxParallelError << " (parallel blocks)" << endl;
+    if (maxError > tolerance) {
+        THROW_EXCEPTION("block solves differ from the whole problem");
+    }
+    // each block has its own optimizer, thus the schedule does not matter
+    if (maxParallelError > 1e-12) {
+        THROW_EXCEPTION("parallel block solves differ from sequential");
+    }
+}
+
+void testBlocksMatchWholeProblem() {
+    INIReader ini(INI_FILE);
+    auto section = "TEST_SO_BLOCKS";
+    auto subjectDir = DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
+    auto modelFile = subjectDir + ini.getString(section, "MODEL_FILE", "");
+    auto ikFile = subjectDir + ini.getString(section, "IK_FILE", "");
+    auto idFile = subjectDir + ini.getString(section, "ID_FILE", "");
+
+    // Windows places executables in different folders. When ctest is
+    // called on a Linux machine it runs the test from different
+    // folders and thus the dynamic library might not be found
+    // properly.
+#ifndef WIN32
+    auto momentArmLibraryPath =
+            LIBRARY_OUTPUT_PATH + "/" +
+            ini.getString(section, "MOMENT_ARM_LIBRARY", "");
+#else
+    auto momentArmLibraryPath =
+            ini.getString(section, "MOMENT_ARM_LIBRARY", "");
+#endif
+    auto numFrames = ini.getInteger(section, "NUMBER_OF_FRAMES", 0);
+    auto tolerance = ini.getReal(section, "TOLERANCE", 0);
+
+    MuscleOptimization::OptimizationParameters optimizationParameters;
+    optimizationParameters.convergenceTolerance =
+            ini.getReal(section, "CONVERGENCE_TOLERANCE", 0);
+    optimizationParameters.memoryHistory =
+            ini.getInteger(section, "MEMORY_HISTORY", 0);
+    optimizationParameters.maximumIterations =
+            ini.getInteger(section, "MAXIMUM_ITERATIONS", 0);
+    optimizationParameters.objectiveExponent =
+            ini.getInteger(section, "OBJECTIVE_EXPONENT", 0);
+
+    Object::RegisterType(Thelen2003Muscle());
+    Model model(modelFile);
+    model.initSystem();
+    auto calcMomentArm = OpenSimUtils::getMomentArmFromDynamicLibrary(
+            model, momentArmLibraryPath);
+    auto qTable = OpenSimUtils::getMultibodyTreeOrderedCoordinatesFromStorage(
+            model, ikFile, 0.01);
+    auto tauTable = OpenSimUtils::getMultibodyTreeOrderedCoordinatesFromStorage(
+            model, idFile, 0.01);
+    numFrames = min<int>(numFrames, qTable.getNumRows());
+
+    // all coordinates spanned and the last coordinate not spanned by any
+    // muscle (zeroed moment arms)
+    calcModelMomentArm = calcMomentArm;
+    const int nc = model.getNumCoordinates();
+    compareSolves(model, optimizationParameters, calcMomentArm, {}, qTable,
+                  tauTable, numFrames, tolerance);
+    compareSolves(model, optimizationParameters, calcMomentArmZeroed,
+                  {nc - 1}, qTable, tauTable, numFrames, tolerance);
+}
+
+void run() {
+    testFindIndependentBlocks();
+    testBlocksMatchWholeProblem();
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
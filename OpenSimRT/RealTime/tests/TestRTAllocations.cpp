@@ -0,0 +1,302 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestRTAllocations.cpp
+ *
+ * \brief Replays a recorded trial with RealTimeAnalysis and counts the heap
+ * allocations of each stage and of the pipeline between the stages (frame
+ * transfer between the threads, telemetry, load governor) per frame. After
+ * the warm-up, the pipeline must not allocate and no frame of a stage may
+ * exceed the budget of the stage in setup.ini (MAX_ALLOCATIONS_<STAGE>, zero
+ * for the analyses; a negative budget is not asserted, e.g., for the
+ * acquisition function of the user).
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#define OPENSIMRT_ALLOCATION_HOOK
+#include "AllocationCounter.h"
+#include "INIReader.h"
+#include "InverseDynamics.h"
+#include "OpenSimUtils.h"
+#include "RealTimeAnalysis.h"
+#include "Settings.h"
+#include <Actuators/Thelen2003Muscle.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <iomanip>
+#include <iostream>
+
+using namespace std;
+using namespace SimTK;
+using namespace OpenSim;
+using namespace OpenSimRT;
+
+/**
+ * Allocations of a stage (accessed by the thread of the stage and read after
+ * the replay).
+ */
+struct StageAllocations {
+    int numValid = 0;    // frames that passed the stage
+    int numMeasured = 0; // frames after the warm-up
+    uint64_t allocations = 0;
+    uint64_t maxAllocations = 0; // per frame
+};
+
+// stage that was executed last by the thread and allocation count at its end
+static thread_local int lastStage = -1;
+static thread_local uint64_t lastStageEnd = 0;
+
+/**
+ * Counts the allocations of the calling thread in each stage and between the
+ * stages. A stage is measured after it has passed warmUpFrames frames, the
+ * code that follows a stage (e.g., push to the next thread) after the stage
+ * is measured.
+ */
+class AllocationTrackingAnalysis : public RealTimeAnalysis {
+ public:
+    AllocationTrackingAnalysis(const Model& model,
+                               const Parameters& parameters, int warmUpFrames)
+            : RealTimeAnalysis(model, parameters), warmUpFrames(warmUpFrames),
+              pipelineAllocations(0) {}
+
+    const StageAllocations& getStageAllocations(PipelineStage stage) const {
+        return stages[static_cast<int>(stage)];
+    }
+    /**
+     * Allocations of the pipeline between the stages.
+     */
+    uint64_t getPipelineAllocations() const {
+        return pipelineAllocations.load();
+    }
+
+ protected:
+    bool acquire(Frame& frame) override {
+        return track(PipelineStage::ACQUIRE,
+                     [&]() { return RealTimeAnalysis::acquire(frame); });
+    }
+    bool solveIK(Frame& frame) override {
+        return track(PipelineStage::IK,
+                     [&]() { return RealTimeAnalysis::solveIK(frame); });
+    }
+    bool filter(Frame& frame) override {
+        return track(PipelineStage::FILTER,
+                     [&]() { return RealTimeAnalysis::filter(frame); });
+    }
+    bool solveID(Frame& frame) override {
+        return track(PipelineStage::ID,
+                     [&]() { return RealTimeAnalysis::solveID(frame); });
+    }
+    bool solveSO(Frame& frame) override {
+        return track(PipelineStage::SO,
+                     [&]() { return RealTimeAnalysis::solveSO(frame); });
+    }
+    bool solveJR(Frame& frame) override {
+        return track(PipelineStage::JR,
+                     [&]() { return RealTimeAnalysis::solveJR(frame); });
+    }
+    bool publish(Frame& frame) override {
+        return track(PipelineStage::PUBLISH,
+                     [&]() { return RealTimeAnalysis::publish(frame); });
+    }
+
+ private:
+    template <typename F> bool track(PipelineStage stage, F&& solve) {
+        auto begin = AllocationCounter::getThreadAllocations();
+        if (lastStage >= 0 && stages[lastStage].numValid > warmUpFrames) {
+            pipelineAllocations += begin - lastStageEnd;
+        }
+
+        auto& s = stages[static_cast<int>(stage)];
+        bool isValid = solve();
+        auto end = AllocationCounter::getThreadAllocations();
+        if (s.numValid >= warmUpFrames) {
+            s.numMeasured++;
+            s.allocations += end - begin;
+            s.maxAllocations = max(s.maxAllocations, end - begin);
+        }
+        if (isValid) s.numValid++;
+        lastStage = static_cast<int>(stage);
+        lastStageEnd = end;
+        return isValid;
+    }
+
+    int warmUpFrames;
+    StageAllocations stages[7];
+    std::atomic<uint64_t> pipelineAllocations;
+};
+
+void run() {
+    if (!AllocationCounter::isInstalled()) {
+        THROW_EXCEPTION("allocation hook is not installed");
+    }
+
+    INIReader ini(INI_FILE);
+    auto section = "TEST_RT_ALLOCATIONS";
+    auto subjectDir = DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
+    auto modelFile = subjectDir + ini.getString(section, "MODEL_FILE", "");
+    auto trcFile = subjectDir + ini.getString(section, "TRC_FILE", "");
+    auto grfMotFile = subjectDir + ini.getString(section, "GRF_MOT_FILE", "");
+    auto ikTaskSetFile =
+            subjectDir + ini.getString(section, "IK_TASK_SET_FILE", "");
+    auto pipelineLayout = ini.getString(section, "PIPELINE_LAYOUT", "");
+    auto warmUpFrames = ini.getInteger(section, "ALLOCATION_WARM_UP_FRAMES", 0);
+
+#ifndef WIN32
+    auto momentArmLibraryPath =
+            LIBRARY_OUTPUT_PATH + "/" +
+            ini.getString(section, "MOMENT_ARM_LIBRARY", "");
+#else
+    auto momentArmLibraryPath =
+            ini.getString(section, "MOMENT_ARM_LIBRARY", "");
+#endif
+
+    // prepare model
+    Object::RegisterType(Thelen2003Muscle());
+    Model model(modelFile);
+    auto state = model.initSystem();
+    auto calcMomentArm = OpenSimUtils::getMomentArmFromDynamicLibrary(
+            model, momentArmLibraryPath);
+
+    // marker tasks
+    IKTaskSet ikTaskSet(ikTaskSetFile);
+    MarkerData markerData(trcFile);
+    vector<InverseKinematics::MarkerTask> markerTasks;
+    vector<string> observationOrder;
+    InverseKinematics::createMarkerTasksFromIKTaskSet(
+            model, ikTaskSet, markerTasks, observationOrder);
+
+    // external forces
+    Storage grfMotion(grfMotFile);
+    vector<ExternalWrench::Parameters> wrenchParameters;
+    vector<vector<string>> wrenchLabels;
+    for (string side : {"RIGHT", "LEFT"}) {
+        auto key = [&side](const string& name) {
+            return "GRF_" + side + "_" + name;
+        };
+        wrenchParameters.push_back(
+                {ini.getString(section, key("APPLY_TO_BODY"), ""),
+                 ini.getString(section, key("FORCE_EXPRESSED_IN_BODY"), ""),
+                 ini.getString(section, key("POINT_EXPRESSED_IN_BODY"), "")});
+        wrenchLabels.push_back(ExternalWrench::createGRFLabelsFromIdentifiers(
+                ini.getString(section, key("POINT_IDENTIFIER"), ""),
+                ini.getString(section, key("FORCE_IDENTIFIER"), ""),
+                ini.getString(section, key("TORQUE_IDENTIFIER"), "")));
+    }
+
+    // the acquisition function throws at the end of the trial
+    int frameIndex = 0;
+    auto dataAcquisitionFunction = [&]() -> MotionCaptureInput {
+        MotionCaptureInput input;
+        input.IkFrame = InverseKinematics::getFrameFromMarkerData(
+                frameIndex, markerData, observationOrder, false);
+        for (const auto& labels : wrenchLabels) {
+            input.ExternalWrenches.push_back(
+                    ExternalWrench::getWrenchFromStorage(
+                            input.IkFrame.t, labels, grfMotion));
+        }
+        frameIndex++;
+        return input;
+    };
+
+    // pipeline
+    RealTimeAnalysis::Parameters parameters;
+    parameters.solveMuscleOptimization =
+            ini.getBoolean(section, "SOLVE_SO", true);
+    parameters.ikMarkerTasks = markerTasks;
+    parameters.ikConstraintsWeight =
+            ini.getReal(section, "IK_CONSTRAINT_WEIGHT", 0.0);
+    parameters.ikAccuracy = ini.getReal(section, "IK_ACCURACY", 0.0);
+    parameters.filterParameters.numSignals =
+            state.getNU() + 2 * ExternalWrench::Input::size();
+    parameters.filterParameters.memory = ini.getInteger(section, "MEMORY", 0);
+    parameters.filterParameters.delay = ini.getInteger(section, "DELAY", 0);
+    parameters.filterParameters.cutoffFrequency =
+            ini.getReal(section, "CUTOFF_FREQ", 0);
+    parameters.filterParameters.splineOrder =
+            ini.getInteger(section, "SPLINE_ORDER", 0);
+    parameters.filterParameters.calculateDerivatives = true;
+    auto& soParameters = parameters.muscleOptimizationParameters;
+    soParameters.convergenceTolerance =
+            ini.getReal(section, "CONVERGENCE_TOLERANCE", 0.0);
+    soParameters.memoryHistory = ini.getInteger(section, "MEMORY_HISTORY", 0);
+    soParameters.maximumIterations =
+            ini.getInteger(section, "MAXIMUM_ITERATIONS", 0);
+    soParameters.objectiveExponent =
+            ini.getInteger(section, "OBJECTIVE_EXPONENT", 0);
+    parameters.wrenchParameters = wrenchParameters;
+    if (!pipelineLayout.empty()) {
+        parameters.pipelineThreads =
+                RealTimeAnalysis::pipelineThreadsFromString(pipelineLayout);
+    }
+    parameters.dataAcquisitionFunction = dataAcquisitionFunction;
+    parameters.momentArmFunction = calcMomentArm;
+    AllocationTrackingAnalysis pipeline(model, parameters, warmUpFrames);
+
+    // the results are received by the subscriber of the pipeline, collecting
+    // them would allocate
+    auto report = pipeline.replay(false);
+    cout << "Replay: " << report.numFrames << " frames" << endl;
+
+    // allocations per frame after the warm-up
+    using Stage = RealTimeAnalysis::PipelineStage;
+    const vector<pair<string, Stage>> stageNames{
+            {"acquire", Stage::ACQUIRE}, {"ik", Stage::IK},
+            {"filter", Stage::FILTER},   {"id", Stage::ID},
+            {"so", Stage::SO},           {"jr", Stage::JR},
+            {"publish", Stage::PUBLISH}};
+    for (const auto& stage : stageNames) {
+        const auto& s = pipeline.getStageAllocations(stage.second);
+        double mean = s.numMeasured ? 1.0 * s.allocations / s.numMeasured : 0;
+        cout << "Stage " << left << setw(8) << stage.first << right
+             << " frames: " << setw(5) << s.numMeasured
+             << " allocations/frame: " << setw(8) << mean
+             << " max: " << s.maxAllocations << endl;
+    }
+    cout << "Pipeline allocations: " << pipeline.getPipelineAllocations()
+         << endl;
+
+    const auto& publish = pipeline.getStageAllocations(Stage::PUBLISH);
+    if (publish.numMeasured == 0) THROW_EXCEPTION("no frame was measured");
+    if (pipeline.getPipelineAllocations() != 0) {
+        THROW_EXCEPTION("pipeline allocated between the stages");
+    }
+    for (const auto& stage : stageNames) {
+        auto name = stage.first;
+        transform(name.begin(), name.end(), name.begin(), ::toupper);
+        auto budget = ini.getInteger(section, "MAX_ALLOCATIONS_" + name, 0);
+        const auto& s = pipeline.getStageAllocations(stage.second);
+        if (budget >= 0 && s.maxAllocations > static_cast<uint64_t>(budget)) {
+            THROW_EXCEPTION("stage " + stage.first + " allocated " +
+                            to_string(s.maxAllocations) +
+                            " times in a frame (budget " +
+                            to_string(budget) + ")");
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
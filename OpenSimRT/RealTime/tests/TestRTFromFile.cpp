@@ -21,7 +21,12 @@
  *
  * @brief Tests the RealTimeAnalysis class with data acquired from file.
  * Observed delay = ~19ms without SO + JR, ~30ms with enabled SO + JR (test with
- * Ubuntu 20.04, Intel(R) Core(TM) i7-9750H CPU @ 2.60GHz)
+ * Ubuntu 20.04, Intel(R) Core(TM) i7-9750H CPU @ 2.60GHz). If REPLAY is set,
+ * the trial is replayed twice as fast as possible, the throughput and the
+ * per-stage time breakdown are reported and the two replays must produce
+ * identical results (regression benchmark). If CHECKPOINT_FILE is set, the
+ * state of the pipeline is checkpointed periodically and, with
+ * RESTORE_FROM_CHECKPOINT, a restarted test resumes from the latest checkpoint.
  *
  * @author Dimitar Stanev <jimstanev@gmail.com>, Filip Konstantinos
  * <filip.k@ece.upatras.gr>
@@ -29,6 +34,7 @@
 #include "INIReader.h"
 #include "InverseDynamics.h"
 #include "OpenSimUtils.h"
+#include "Profiler.h"
 #include "RealTimeAnalysis.h"
 #include "Settings.h"
 #include "Visualization.h"
@@ -36,6 +42,7 @@
 #include <Common/TimeSeriesTable.h>
 #include <OpenSim/Common/STOFileAdapter.h>
 #include <iostream>
+#include <map>
 #include <thread>
 
 using namespace std;
@@ -43,6 +50,51 @@ using namespace SimTK;
 using namespace OpenSim;
 using namespace OpenSimRT;
 
+static bool isIdentical(const Vector& a, const Vector& b) {
+    if (a.size() != b.size()) return false;
+    for (int i = 0; i < a.size(); ++i) {
+        if (a[i] != b[i]) return false;
+    }
+    return true;
+}
+
+/**
+ * Bit-wise comparison of the results of two replays.
+ */
+static bool isIdentical(const vector<RealTimeAnalysis::Output>& a,
+                        const vector<RealTimeAnalysis::Output>& b) {
+    if (a.size() != b.size()) return false;
+    for (int i = 0; i < a.size(); ++i) {
+        if (a[i].t != b[i].t || !isIdentical(a[i].q, b[i].q) ||
+            !isIdentical(a[i].qd, b[i].qd) ||
+            !isIdentical(a[i].qdd, b[i].qdd) ||
+            !isIdentical(a[i].tau, b[i].tau) ||
+            !isIdentical(a[i].am, b[i].am) || !isIdentical(a[i].fm, b[i].fm) ||
+            !isIdentical(a[i].reactionWrenchVector,
+                         b[i].reactionWrenchVector)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void printReplayReport(const RealTimeAnalysis::ReplayReport& report) {
+    cout << "Replay: " << report.numFrames << " frames in " << report.duration
+         << " s (" << report.framesPerSecond << " frames/s)" << endl;
+    double total = 0;
+    for (const auto& stage : report.telemetry.histograms) {
+        if (stage.name != "sample_to_output" && stage.unit == "us") {
+            total += stage.count * stage.mean;
+        }
+    }
+    for (const auto& stage : report.telemetry.histograms) {
+        if (stage.name == "sample_to_output" || stage.unit != "us") continue;
+        cout << "Replay stage " << stage.name << ": " << stage.mean
+             << " us/frame, " << 100 * stage.count * stage.mean / total
+             << " %" << endl;
+    }
+}
+
 void run(char const* name) {
     INIReader ini(INI_FILE);
     auto section = "TEST_RT_PIPELINE_FROM_FILE";
@@ -99,6 +151,67 @@ void run(char const* name) {
     auto memoryHistory = ini.getInteger(section, "MEMORY_HISTORY", 0);
     auto maximumIterations = ini.getInteger(section, "MAXIMUM_ITERATIONS", 0);
     auto objectiveExponent = ini.getInteger(section, "OBJECTIVE_EXPONENT", 0);
+    auto useSurrogate = ini.getBoolean(section, "USE_SO_SURROGATE", false);
+    auto surrogateFile =
+            subjectDir + ini.getString(section, "SO_SURROGATE_FILE", "");
+    auto projectionIterations =
+            ini.getInteger(section, "SO_SURROGATE_PROJECTION_ITERATIONS", 0);
+    auto projectionTolerance =
+            ini.getReal(section, "SO_SURROGATE_PROJECTION_TOLERANCE", 0.0);
+    auto fallbackThreshold =
+            ini.getReal(section, "SO_SURROGATE_FALLBACK_THRESHOLD", 0.0);
+
+    // jr parameters
+    auto reactionJoints =
+            ini.getVector(section, "JR_JOINTS", vector<string>());
+
+    // telemetry export (optional)
+    auto telemetryFile = ini.getString(section, "TELEMETRY_FILE", "");
+
+    // trace of the profiling zones (optional, requires USE_PROFILER)
+    auto traceFile = ini.getString(section, "TRACE_FILE", "");
+
+    // asynchronous binary log of the results (optional), instead of the
+    // in-memory loggers
+    auto binaryLogFile = ini.getString(section, "BINARY_LOG_FILE", "");
+    if (!binaryLogFile.empty()) binaryLogFile = subjectDir + binaryLogFile;
+
+    // periodic checkpoints of the state of the pipeline and restart (optional)
+    auto checkpointFile = ini.getString(section, "CHECKPOINT_FILE", "");
+    if (!checkpointFile.empty()) checkpointFile = subjectDir + checkpointFile;
+    auto checkpointInterval = ini.getReal(section, "CHECKPOINT_INTERVAL", 1.0);
+    auto restoreFromCheckpoint =
+            ini.getBoolean(section, "RESTORE_FROM_CHECKPOINT", false);
+
+    // as fast as possible deterministic replay (benchmark)
+    auto replay = ini.getBoolean(section, "REPLAY", false);
+
+    // pipeline layout
+    auto pipelineLayout = ini.getString(section, "PIPELINE_LAYOUT", "");
+    auto queueCapacity = ini.getInteger(section, "PIPELINE_QUEUE_CAPACITY", 1);
+    auto overflowPolicy = overflowPolicyFromString(
+            ini.getString(section, "PIPELINE_OVERFLOW_POLICY", "drop_oldest"));
+    auto jointReactionWorkers = ini.getInteger(section, "JR_WORKERS", 1);
+
+    // real-time configuration of the pipeline threads
+    auto threadPolicies = threadPoliciesFromString(
+            ini.getString(section, "PIPELINE_THREAD_CPUS", ""),
+            ini.getString(section, "PIPELINE_THREAD_PRIORITIES", ""));
+    auto lockMemory = ini.getBoolean(section, "LOCK_MEMORY", false);
+    auto prefaultHeapSize = ini.getInteger(section, "PREFAULT_HEAP_SIZE", 0);
+    auto warmUpFrames = ini.getInteger(section, "WARM_UP_FRAMES", 100);
+
+    // load shedding
+    auto useLoadShedding = ini.getBoolean(section, "USE_LOAD_SHEDDING", false);
+    auto maximumQualityLevel =
+            ini.getInteger(section, "LOAD_SHEDDING_MAXIMUM_LEVEL", 4);
+    auto relaxedTolerance =
+            ini.getReal(section, "LOAD_SHEDDING_RELAXED_TOLERANCE", 10);
+    auto relaxedIterations =
+            ini.getInteger(section, "LOAD_SHEDDING_RELAXED_ITERATIONS", 15);
+    auto decimationFactor =
+            ini.getInteger(section, "LOAD_SHEDDING_DECIMATION_FACTOR", 3);
+
     // Windows places executables in different folders. When ctest is
     // called on a Linux machine it runs the test from different
     // folders and thus the dynamic library might not be found
@@ -151,13 +264,13 @@ void run(char const* name) {
     wrenchParameters.push_back(grfLeftFootPar);
 
     // acquisition function (simulates acquisition from motion)
+    int frameIndex = 0;
     auto dataAcquisitionFunction = [&]() -> MotionCaptureInput {
-        static int i = 0;
         MotionCaptureInput input;
 
         // get frame data
         input.IkFrame = InverseKinematics::getFrameFromMarkerData(
-                i, markerData, observationOrder, false);
+                frameIndex, markerData, observationOrder, false);
         double t = input.IkFrame.t;
 
         // get grf force
@@ -168,8 +281,8 @@ void run(char const* name) {
         input.ExternalWrenches = {grfRightWrench, grfLeftWrench};
 
         // dummy delay to simulate real time
-        this_thread::sleep_for(10ms);
-        i++;
+        if (!replay) this_thread::sleep_for(10ms);
+        frameIndex++;
         return input;
     };
 
@@ -189,6 +302,11 @@ void run(char const* name) {
     muscleOptimizationParameters.memoryHistory = memoryHistory;
     muscleOptimizationParameters.maximumIterations = maximumIterations;
     muscleOptimizationParameters.objectiveExponent = objectiveExponent;
+    MuscleOptimizationSurrogate::Parameters surrogateParameters;
+    surrogateParameters.networkFile = surrogateFile;
+    surrogateParameters.projectionIterations = projectionIterations;
+    surrogateParameters.projectionTolerance = projectionTolerance;
+    surrogateParameters.fallbackThreshold = fallbackThreshold;
 
     // pipeline
     RealTimeAnalysis::Parameters pipelineParameters;
@@ -200,75 +318,184 @@ void run(char const* name) {
     pipelineParameters.muscleOptimizationParameters =
             muscleOptimizationParameters;
     pipelineParameters.wrenchParameters = wrenchParameters;
+    pipelineParameters.reactionJoints = reactionJoints;
+    if (!pipelineLayout.empty()) {
+        pipelineParameters.pipelineThreads =
+                RealTimeAnalysis::pipelineThreadsFromString(pipelineLayout);
+    }
+    pipelineParameters.pipelineQueues = {{queueCapacity, overflowPolicy}};
+    pipelineParameters.jointReactionWorkers = jointReactionWorkers;
+    pipelineParameters.pipelineThreadPolicies = threadPolicies;
+    pipelineParameters.lockMemory = lockMemory;
+    pipelineParameters.prefaultHeapSize = prefaultHeapSize << 20; // MB
+    pipelineParameters.warmUpFrames = warmUpFrames;
+    pipelineParameters.useLoadShedding = useLoadShedding;
+    pipelineParameters.loadGovernorParameters.maximumLevel =
+            maximumQualityLevel;
+    pipelineParameters.relaxedConvergenceTolerance = relaxedTolerance;
+    pipelineParameters.relaxedMaximumIterations = relaxedIterations;
+    pipelineParameters.decimationFactor = decimationFactor;
     pipelineParameters.dataAcquisitionFunction = dataAcquisitionFunction;
     pipelineParameters.momentArmFunction = calcMomentArm;
+    pipelineParameters.useMuscleOptimizationSurrogate = useSurrogate;
+    pipelineParameters.muscleOptimizationSurrogateParameters =
+            surrogateParameters;
+    pipelineParameters.binaryLogFile = binaryLogFile;
+    pipelineParameters.checkpointFile = checkpointFile;
+    pipelineParameters.checkpointInterval = checkpointInterval;
+    pipelineParameters.restoreFromCheckpoint = restoreFromCheckpoint;
     RealTimeAnalysis pipeline(model, pipelineParameters);
     auto log = pipeline.initializeLoggers();
+    for (const auto& step : pipeline.getStartupTimes()) {
+        cout << "Startup " << step.name << ": " << step.duration << " s"
+             << endl;
+    }
 
-    // run pipeline
-    pipeline.run();
-
-    // visualizer
-    BasicModelVisualizer visualizer(model);
-    auto rightGRFDecorator = new ForceDecorator(Green, 0.001, 3);
-    visualizer.addDecorationGenerator(rightGRFDecorator);
-    auto leftGRFDecorator = new ForceDecorator(Green, 0.001, 3);
-    visualizer.addDecorationGenerator(leftGRFDecorator);
-    auto rightKneeForceDecorator = new ForceDecorator(Red, 0.0005, 3);
-    visualizer.addDecorationGenerator(rightKneeForceDecorator);
-    auto leftKneeForceDecorator = new ForceDecorator(Red, 0.0005, 3);
-    visualizer.addDecorationGenerator(leftKneeForceDecorator);
-
-    // mean delay
-    int sumDelayMS = 0;
-    int sumDelayMSCount = 0;
-    try {
-        while (!pipeline.shouldTerminate()) {
-            chrono::high_resolution_clock::time_point t1;
-            t1 = chrono::high_resolution_clock::now();
-
-            // fetch of rt results
-            auto results = pipeline.getResults();
-
-            chrono::high_resolution_clock::time_point t2;
-            t2 = chrono::high_resolution_clock::now();
-            sumDelayMS += chrono::duration_cast<chrono::milliseconds>(t2 - t1)
-                                  .count();
-            sumDelayMSCount++;
-
-            // update visualizer
-            if (!solveMuscleOptimization)
-                visualizer.update(results.q);
-            else {
-                visualizer.update(results.q, results.am);
-                visualizer.updateReactionForceDecorator(
-                        results.reactionWrenches, "tibia_r",
-                        rightKneeForceDecorator);
-                visualizer.updateReactionForceDecorator(
-                        results.reactionWrenches, "tibia_l",
-                        leftKneeForceDecorator);
-            }
-            // log
-            log.qLogger.appendRow(results.t, ~results.q);
-            log.qDotLogger.appendRow(results.t, ~results.qd);
-            log.qDDotLogger.appendRow(results.t, ~results.qdd);
-            log.tauLogger.appendRow(results.t, ~results.tau);
-            if (solveMuscleOptimization) {
-                log.fmLogger.appendRow(results.t, ~results.fm);
-                log.amLogger.appendRow(results.t, ~results.am);
-                log.residualLogger.appendRow(results.t, ~results.residuals);
-                log.jrLogger.appendRow(results.t,
-                                       ~results.reactionWrenchVector);
-            }
+    // log
+    auto logResults = [&](const RealTimeAnalysis::Output& results) {
+        if (!binaryLogFile.empty()) return; // logged by the pipeline
+        log.qLogger.appendRow(results.t, ~results.q);
+        log.qDotLogger.appendRow(results.t, ~results.qd);
+        log.qDDotLogger.appendRow(results.t, ~results.qdd);
+        log.tauLogger.appendRow(results.t, ~results.tau);
+        if (solveMuscleOptimization) {
+            log.fmLogger.appendRow(results.t, ~results.fm);
+            log.amLogger.appendRow(results.t, ~results.am);
+            log.residualLogger.appendRow(results.t, ~results.residuals);
+            log.jrLogger.appendRow(results.t, ~results.reactionWrenchVector);
+        }
+    };
+
+    if (replay) {
+        auto report = pipeline.replay();
+        for (const auto& results : report.results) logResults(results);
+        printReplayReport(report);
+
+        // a second replay of the trial must produce identical results (unless
+        // the first started from a checkpoint, that has been overwritten)
+        frameIndex = 0;
+        auto secondParameters = pipelineParameters;
+        secondParameters.binaryLogFile = "";
+        secondParameters.checkpointFile = "";
+        secondParameters.restoreFromCheckpoint = false;
+        RealTimeAnalysis secondPipeline(model, secondParameters);
+        auto secondReport = secondPipeline.replay();
+        printReplayReport(secondReport);
+        if (!restoreFromCheckpoint &&
+            !isIdentical(report.results, secondReport.results)) {
+            THROW_EXCEPTION("replays produced different results");
+        }
+    } else {
+        // run pipeline
+        pipeline.run();
+
+        // visualizer
+        BasicModelVisualizer visualizer(model);
+        auto rightGRFDecorator = new ForceDecorator(Green, 0.001, 3);
+        visualizer.addDecorationGenerator(rightGRFDecorator);
+        auto leftGRFDecorator = new ForceDecorator(Green, 0.001, 3);
+        visualizer.addDecorationGenerator(leftGRFDecorator);
+        auto rightKneeForceDecorator = new ForceDecorator(Red, 0.0005, 3);
+        visualizer.addDecorationGenerator(rightKneeForceDecorator);
+        auto leftKneeForceDecorator = new ForceDecorator(Red, 0.0005, 3);
+        visualizer.addDecorationGenerator(leftKneeForceDecorator);
+        // the knee reactions are drawn only if the knees are selected
+        auto rightKnee = pipeline.getReactionJointIndex("knee_r");
+        auto leftKnee = pipeline.getReactionJointIndex("knee_l");
 
-        } // while loop
-    } catch (const exception& e) {
-        cout << e.what() << "\n";
-        pipeline.shouldTerminate(true);
+        // mean delay
+        int sumDelayMS = 0;
+        int sumDelayMSCount = 0;
+        int surrogateCount = 0;
+        vector<int> qualityLevelCount(5, 0);
+        try {
+            while (!pipeline.shouldTerminate()) {
+                chrono::high_resolution_clock::time_point t1;
+                t1 = chrono::high_resolution_clock::now();
+
+                // fetch of rt results
+                auto results = pipeline.getResults();
+
+                chrono::high_resolution_clock::time_point t2;
+                t2 = chrono::high_resolution_clock::now();
+                sumDelayMS +=
+                        chrono::duration_cast<chrono::milliseconds>(t2 - t1)
+                                .count();
+                sumDelayMSCount++;
+                qualityLevelCount[static_cast<int>(results.qualityLevel)]++;
+
+                // update visualizer
+                if (!solveMuscleOptimization)
+                    visualizer.update(results.q);
+                else {
+                    visualizer.update(results.q, results.am);
+                    if (rightKnee >= 0) {
+                        visualizer.updateReactionForceDecorator(
+                                results.reactionWrenches[rightKnee], "tibia_r",
+                                rightKneeForceDecorator);
+                    }
+                    if (leftKnee >= 0) {
+                        visualizer.updateReactionForceDecorator(
+                                results.reactionWrenches[leftKnee], "tibia_l",
+                                leftKneeForceDecorator);
+                    }
+                }
+                // log
+                logResults(results);
+                if (results.isSurrogateSolution) surrogateCount++;
+
+            } // while loop
+        } catch (const exception& e) {
+            cout << e.what() << "\n";
+            pipeline.shouldTerminate(true);
+        }
+
+        cout << "Mean delay: " << (double) sumDelayMS / sumDelayMSCount
+             << " ms" << endl;
+        if (useSurrogate) {
+            cout << "Frames solved by the SO surrogate: " << surrogateCount
+                 << "/" << sumDelayMSCount << endl;
+        }
+        if (useLoadShedding) {
+            for (int i = 0; i < qualityLevelCount.size(); ++i) {
+                cout << "Frames at quality level " << i << ": "
+                     << qualityLevelCount[i] << endl;
+            }
+        }
+        auto droppedFrames = pipeline.getNumDroppedFrames();
+        for (int i = 0; i < droppedFrames.size(); ++i) {
+            cout << "Frames dropped by pipeline queue " << i << ": "
+                 << droppedFrames[i] << endl;
+        }
+    }
+    for (const auto& stage : pipeline.getTelemetry().histograms) {
+        cout << "Telemetry " << stage.name << " p50/p99/max: " << stage.p50
+             << "/" << stage.p99 << "/" << stage.max << " " << stage.unit
+             << endl;
+    }
+    if (!telemetryFile.empty()) {
+        pipeline.exportTelemetry(subjectDir + telemetryFile);
+    }
+    if (!traceFile.empty()) {
+        Profiler::exportChromeTrace(subjectDir + traceFile);
     }
 
-    cout << "Mean delay: " << (double) sumDelayMS / sumDelayMSCount << " ms"
-         << endl;
+    // read the results back from the binary log
+    if (!binaryLogFile.empty()) {
+        pipeline.shouldTerminate(true); // closes the log
+        map<string, TimeSeriesTable*> loggers = {
+                {"q", &log.qLogger},
+                {"qDot", &log.qDotLogger},
+                {"qDDot", &log.qDDotLogger},
+                {"tau", &log.tauLogger},
+                {"fm", &log.fmLogger},
+                {"am", &log.amLogger},
+                {"residuals", &log.residualLogger},
+                {"jr", &log.jrLogger}};
+        for (const auto& table : OpenSimUtils::readBinaryLog(binaryLogFile)) {
+            *loggers.at(table.first) = table.second;
+        }
+    }
 
      // store results
      //STOFileAdapter::write(log.qLogger, subjectDir +
@@ -82,6 +82,9 @@ void run() {
     auto memoryHistory = ini.getReal(section, "MEMORY_HISTORY", 0);
     auto maximumIterations = ini.getInteger(section, "MAXIMUM_ITERATIONS", 0);
     auto objectiveExponent = ini.getInteger(section, "OBJECTIVE_EXPONENT", 0);
+    auto useBlockDecomposition =
+            ini.getBoolean(section, "USE_BLOCK_DECOMPOSITION", true);
+    auto numberOfThreads = ini.getInteger(section, "NUMBER_OF_THREADS", 1);
 
     Object::RegisterType(Thelen2003Muscle());
     Model model(modelFile);
@@ -111,7 +114,10 @@ void run() {
     optimizationParameters.memoryHistory = memoryHistory;
     optimizationParameters.maximumIterations = maximumIterations;
     optimizationParameters.objectiveExponent = objectiveExponent;
+    optimizationParameters.useBlockDecomposition = useBlockDecomposition;
+    optimizationParameters.numberOfThreads = numberOfThreads;
     MuscleOptimization so(model, optimizationParameters, calcMomentArm);
+    cout << "Muscle optimization blocks: " << so.blocks.size() << endl;
     auto fmLogger = so.initializeMuscleLogger();
     auto amLogger = so.initializeMuscleLogger();
     // auto tauResLogger = so.initializeResidualLogger();
@@ -153,6 +159,18 @@ void run() {
     cout << "Mean delay: " << (double) sumDelayMS / qTable.getNumRows() << " ms"
          << endl;
 
+    // solve the whole trial in batch mode (offline)
+    chrono::high_resolution_clock::time_point t1;
+    t1 = chrono::high_resolution_clock::now();
+
+    auto batchOutput = so.solveBatch(qTable, tauTable);
+
+    chrono::high_resolution_clock::time_point t2;
+    t2 = chrono::high_resolution_clock::now();
+    cout << "Batch mode: "
+         << chrono::duration_cast<chrono::milliseconds>(t2 - t1).count()
+         << " ms for " << qTable.getNumRows() << " frames" << endl;
+
     // store results
     // STOFileAdapter::write(fmLogger,
     //                       subjectDir +
@@ -176,6 +194,8 @@ void run() {
                 TimeSeriesTable(subjectDir +
                                 "real_time/muscle_optimization/am.sto"),
                 1e-1);
+        OpenSimUtils::compareTables(batchOutput.fm, fmLogger, 1e-1);
+        OpenSimUtils::compareTables(batchOutput.am, amLogger, 1e-1);
     } catch (exception& e) {
         // catch the exception but do not report a test fail because
         // it is due to machine precision
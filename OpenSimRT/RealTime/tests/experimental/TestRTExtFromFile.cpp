@@ -217,7 +217,10 @@ void run(char const* name) {
     detectorParameters.sphereRadius = contactSphereRadius;
     detectorParameters.rFootBodyName = rFootBodyName;
     detectorParameters.lFootBodyName = lFootBodyName;
-    auto detector = ContactForceBasedPhaseDetector(model, detectorParameters);
+    // the detector and grfm prediction share the kinematics
+    auto acquisitionContext = make_shared<KinematicsContext>(model);
+    auto detector = ContactForceBasedPhaseDetector(acquisitionContext,
+                                                   detectorParameters);
 
     // grfm prediction
     GRFMPrediction::Parameters grfmParameters;
@@ -252,6 +255,7 @@ void run(char const* name) {
     pipelineParameters.momentArmFunction = calcMomentArm;
     pipelineParameters.useGRFMPrediction = useGRFMPrediction;
     pipelineParameters.phaseDetector = detector;
+    pipelineParameters.acquisitionContext = acquisitionContext;
     pipelineParameters.detectorUpdateMethod =
             RealTimeAnalysisExtended::PhaseDetectorUpdateMethod::INTERNAL;
     pipelineParameters.grfmParameters = grfmParameters;
@@ -276,6 +280,9 @@ void run(char const* name) {
     visualizer.addDecorationGenerator(rightKneeForceDecorator);
     auto leftKneeForceDecorator = new ForceDecorator(Red, 0.0005, 3);
     visualizer.addDecorationGenerator(leftKneeForceDecorator);
+    // the knee reactions are drawn only if the knees are selected
+    auto rightKnee = pipeline.getReactionJointIndex("knee_r");
+    auto leftKnee = pipeline.getReactionJointIndex("knee_l");
 
     // mean delay
     int sumDelayMS = 0;
@@ -299,12 +306,16 @@ void run(char const* name) {
                 visualizer.update(results.q);
             else {
                 visualizer.update(results.q, results.am);
-                visualizer.updateReactionForceDecorator(
-                        results.reactionWrenches, "tibia_r",
-                        rightKneeForceDecorator);
-                visualizer.updateReactionForceDecorator(
-                        results.reactionWrenches, "tibia_l",
-                        leftKneeForceDecorator);
+                if (rightKnee >= 0) {
+                    visualizer.updateReactionForceDecorator(
+                            results.reactionWrenches[rightKnee], "tibia_r",
+                            rightKneeForceDecorator);
+                }
+                if (leftKnee >= 0) {
+                    visualizer.updateReactionForceDecorator(
+                            results.reactionWrenches[leftKnee], "tibia_l",
+                            leftKneeForceDecorator);
+                }
             }
 
             // log
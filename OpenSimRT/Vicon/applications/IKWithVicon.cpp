@@ -47,6 +47,9 @@ void run() {
     auto referenceFrameZ = ini.getString("VICON", "REFERENCE_FRAME_AXIS_Z", "");
     auto subjectDir = DATA_DIR + ini.getString("VICON", "SUBJECT_DIR", "");
     auto modelFile = subjectDir + ini.getString("VICON", "MODEL_FILE", "");
+    auto acquisitionThreadPolicy = threadPoliciesFromString(
+            ini.getString("VICON", "ACQUISITION_THREAD_CPUS", ""),
+            ini.getString("VICON", "ACQUISITION_THREAD_PRIORITY", ""))[0];
 
     // setup vicon
     ViconDataStream vicon(
@@ -68,6 +71,7 @@ void run() {
     // visualizer
     BasicModelVisualizer visualizer(model);
 
+    vicon.threadPolicy = acquisitionThreadPolicy;
     vicon.startAcquisition();
     double previousTime = -1.0;
     while (true) {
@@ -31,6 +31,7 @@
 
 #include "CircularBuffer.h"
 #include "InverseDynamics.h"
+#include "ThreadPolicy.h"
 #include "internal/ViconExports.h"
 #include <DataStreamClient.h>
 #include <SimTKcommon.h>
@@ -67,6 +68,10 @@ class Vicon_API ViconDataStream {
 
     bool shouldTerminate;
 
+    // real-time configuration of the acquisition thread (set before
+    // startAcquisition)
+    ThreadPolicy threadPolicy;
+
  private:
     void getFrame();
 
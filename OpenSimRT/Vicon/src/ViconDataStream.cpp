@@ -230,6 +230,7 @@ void ViconDataStream::getFrame() {
 
 void ViconDataStream::startAcquisition() {
     function<void()> acquisitionFunction = [&]() -> void {
+        threadPolicy.apply();
         while (!shouldTerminate) { getFrame(); }
     };
     thread acquisitionThread(acquisitionFunction);
@@ -0,0 +1,268 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file Benchmark.h
+ *
+ * \brief Minimal harness for the microbenchmarks of the real-time modules.
+ * Each benchmark times a single call (e.g., solve) per sample, discards the
+ * warm-up samples and reports summary statistics in JSON, so that results of
+ * different releases can be compared.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#pragma once
+
+#include "Exception.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace OpenSimRT {
+
+/**
+ * Prevents the compiler from removing a computation whose result is not used.
+ */
+template <typename T> inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r"(&value) : "memory");
+#else
+    static_cast<void>(*static_cast<const volatile char*>(
+            static_cast<const void*>(&value)));
+#endif
+}
+
+/**
+ * Collects the duration of each call of a benchmark. The first warmUp samples
+ * are discarded (caches, lazy initialization, optimizer warm start).
+ */
+class BenchmarkTimer {
+ public:
+    BenchmarkTimer(const std::string& name, const std::string& dataset,
+                   int warmUp)
+            : name(name), dataset(dataset), warmUp(warmUp), numCalls(0) {}
+
+    void start() { begin = std::chrono::steady_clock::now(); }
+
+    void stop() {
+        auto end = std::chrono::steady_clock::now();
+        if (numCalls++ < warmUp) return;
+        samples.push_back(
+                std::chrono::duration<double, std::micro>(end - begin)
+                        .count());
+    }
+
+    /**
+     * Time a callable.
+     */
+    template <typename F> void measure(F&& f) {
+        start();
+        doNotOptimize(f());
+        stop();
+    }
+
+    const std::string& getName() const { return name; }
+    const std::string& getDataset() const { return dataset; }
+    const std::vector<double>& getSamples() const { return samples; }
+
+ private:
+    std::string name;
+    std::string dataset;
+    int warmUp;
+    int numCalls;
+    std::chrono::steady_clock::time_point begin;
+    std::vector<double> samples; // [us]
+};
+
+/**
+ * A suite of benchmarks of the same module.
+ *
+ * Command line arguments:
+ *
+ *   --output <file.json>   write the results in JSON
+ *   --repetitions <n>      number of passes over the dataset (default 3)
+ *   --warm-up <n>          number of discarded samples (default 10)
+ *
+ * ****************************************************************************
+ * Example code:
+ * ****************************************************************************
+ *
+ * BenchmarkSuite suite("InverseDynamics", argc, argv);
+ * auto& timer = suite.addTimer("InverseDynamics::solve", "gait1992");
+ * for (int r = 0; r < suite.getRepetitions(); ++r)
+ *     for (const auto& input : inputs)
+ *         timer.measure([&]() { return id.solve(input); });
+ * suite.report();
+ */
+class BenchmarkSuite {
+ public:
+    BenchmarkSuite(const std::string& suite, int argc, char* argv[])
+            : suite(suite), repetitions(3), warmUp(10) {
+        for (int i = 1; i < argc; ++i) {
+            std::string argument(argv[i]);
+            if (i + 1 == argc) {
+                THROW_EXCEPTION("missing value of argument " + argument);
+            }
+            if (argument == "--output") {
+                output = argv[++i];
+            } else if (argument == "--repetitions") {
+                repetitions = std::stoi(argv[++i]);
+            } else if (argument == "--warm-up") {
+                warmUp = std::stoi(argv[++i]);
+            } else {
+                THROW_EXCEPTION("unknown argument " + argument);
+            }
+        }
+        if (repetitions < 1) THROW_EXCEPTION("repetitions must be positive");
+    }
+
+    int getRepetitions() const { return repetitions; }
+
+    /**
+     * The returned reference remains valid when more timers are added.
+     */
+    BenchmarkTimer& addTimer(const std::string& name,
+                             const std::string& dataset) {
+        timers.emplace_back(name, dataset, warmUp);
+        return timers.back();
+    }
+
+    /**
+     * Print a table of the results and write the JSON file (if requested).
+     */
+    void report() const {
+        std::cout << std::left << std::setw(44) << "benchmark" << std::right
+                  << std::setw(8) << "n" << std::setw(12) << "median[us]"
+                  << std::setw(12) << "p99[us]" << std::setw(12) << "max[us]"
+                  << std::endl;
+        for (const auto& timer : timers) {
+            auto s = computeStatistics(timer.getSamples());
+            std::cout << std::left << std::setw(44)
+                      << timer.getName() + " (" + timer.getDataset() + ")"
+                      << std::right << std::setw(8) << s.n << std::fixed
+                      << std::setprecision(2) << std::setw(12) << s.median
+                      << std::setw(12) << s.p99 << std::setw(12) << s.max
+                      << std::defaultfloat << std::endl;
+        }
+        if (output.empty()) return;
+
+        std::ofstream file(output);
+        if (!file) THROW_EXCEPTION("cannot write " + output);
+        file << toJSON();
+    }
+
+    std::string toJSON() const {
+        std::ostringstream json;
+        json << std::setprecision(6);
+        json << "{\n"
+             << "  \"suite\": \"" << escape(suite) << "\",\n"
+             << "  \"date\": \"" << currentDate() << "\",\n"
+             << "  \"compiler\": \"" << escape(compiler()) << "\",\n"
+             << "  \"repetitions\": " << repetitions << ",\n"
+             << "  \"warm_up\": " << warmUp << ",\n"
+             << "  \"benchmarks\": [";
+        for (std::size_t i = 0; i < timers.size(); ++i) {
+            auto s = computeStatistics(timers[i].getSamples());
+            json << (i == 0 ? "\n" : ",\n") << "    {\"name\": \""
+                 << escape(timers[i].getName()) << "\", \"dataset\": \""
+                 << escape(timers[i].getDataset())
+                 << "\", \"iterations\": " << s.n << ", \"unit\": \"us\""
+                 << ", \"min\": " << s.min << ", \"mean\": " << s.mean
+                 << ", \"median\": " << s.median << ", \"p90\": " << s.p90
+                 << ", \"p99\": " << s.p99 << ", \"max\": " << s.max
+                 << ", \"stddev\": " << s.stddev << "}";
+        }
+        json << "\n  ]\n}\n";
+        return json.str();
+    }
+
+ private:
+    struct Statistics {
+        std::size_t n = 0;
+        double min = 0, mean = 0, median = 0, p90 = 0, p99 = 0, max = 0,
+               stddev = 0;
+    };
+
+    static Statistics computeStatistics(std::vector<double> x) {
+        Statistics s;
+        s.n = x.size();
+        if (x.empty()) return s;
+        std::sort(x.begin(), x.end());
+        // nearest-rank percentile
+        auto percentile = [&x](double p) {
+            auto rank = static_cast<std::size_t>(std::ceil(p * x.size()));
+            return x[std::max<std::size_t>(rank, 1) - 1];
+        };
+        s.min = x.front();
+        s.max = x.back();
+        s.median = percentile(0.5);
+        s.p90 = percentile(0.9);
+        s.p99 = percentile(0.99);
+        s.mean = std::accumulate(x.begin(), x.end(), 0.0) / s.n;
+        double sum = 0;
+        for (const auto& xi : x) sum += (xi - s.mean) * (xi - s.mean);
+        s.stddev = std::sqrt(sum / s.n);
+        return s;
+    }
+
+    static std::string escape(const std::string& s) {
+        std::string result;
+        for (char c : s) {
+            if (c == '"' || c == '\\') result += '\\';
+            result += c;
+        }
+        return result;
+    }
+
+    static std::string currentDate() {
+        std::time_t now = std::time(nullptr);
+        char buffer[32];
+        std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ",
+                      std::gmtime(&now));
+        return buffer;
+    }
+
+    static std::string compiler() {
+#if defined(__clang__)
+        return "clang " __clang_version__;
+#elif defined(__GNUC__)
+        return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+        return "msvc " + std::to_string(_MSC_VER);
+#else
+        return "unknown";
+#endif
+    }
+
+    std::string suite;
+    std::string output;
+    int repetitions;
+    int warmUp;
+    std::deque<BenchmarkTimer> timers;
+};
+
+} // namespace OpenSimRT
@@ -0,0 +1,134 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file BenchmarkData.h
+ *
+ * \brief Prepares the inputs of the benchmarks from the recorded data (the
+ * same setup.ini sections as the corresponding tests), so that the filtering
+ * and the file access are not part of the measurements.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#pragma once
+
+#include "INIReader.h"
+#include "InverseDynamics.h"
+#include "OpenSimUtils.h"
+#include "SignalProcessing.h"
+#include <OpenSim/Common/Storage.h>
+#include <OpenSim/Simulation/Model/Model.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace OpenSimRT {
+
+/**
+ * Filtered kinematics and ground reaction wrenches of a recorded frame.
+ */
+struct GaitFrame {
+    int index; // row of the kinematics table
+    double t;
+    SimTK::Vector q;
+    SimTK::Vector qDot;
+    SimTK::Vector qDDot;
+    std::vector<ExternalWrench::Input> externalWrenches; // right, left
+};
+
+/**
+ * Read the parameters of the right and left ground reaction wrenches
+ * (GRF_RIGHT_* and GRF_LEFT_* keys) and the corresponding .mot labels.
+ */
+inline void
+readGRFParameters(INIReader& ini, const std::string& section,
+                  std::vector<ExternalWrench::Parameters>& wrenchParameters,
+                  std::vector<std::vector<std::string>>& wrenchLabels) {
+    for (std::string side : {"RIGHT", "LEFT"}) {
+        auto key = [&side](const std::string& name) {
+            return "GRF_" + side + "_" + name;
+        };
+        wrenchParameters.push_back(
+                {ini.getString(section, key("APPLY_TO_BODY"), ""),
+                 ini.getString(section, key("FORCE_EXPRESSED_IN_BODY"), ""),
+                 ini.getString(section, key("POINT_EXPRESSED_IN_BODY"), "")});
+        wrenchLabels.push_back(ExternalWrench::createGRFLabelsFromIdentifiers(
+                ini.getString(section, key("POINT_IDENTIFIER"), ""),
+                ini.getString(section, key("FORCE_IDENTIFIER"), ""),
+                ini.getString(section, key("TORQUE_IDENTIFIER"), "")));
+    }
+}
+
+/**
+ * Filter the kinematics (IK_FILE) and, if wrenchLabels are provided, the
+ * ground reaction wrenches (GRF_MOT_FILE) with the LowPassSmoothFilter
+ * parameters of the section, as in the Test*FromFile programs. Only the valid
+ * frames of the filter are returned.
+ */
+inline std::vector<GaitFrame> prepareGaitFrames(
+        INIReader& ini, const std::string& section,
+        const std::string& subjectDir, const OpenSim::Model& model,
+        const std::vector<std::vector<std::string>>& wrenchLabels = {}) {
+    auto ikFile = subjectDir + ini.getString(section, "IK_FILE", "");
+    auto qTable = OpenSimUtils::getMultibodyTreeOrderedCoordinatesFromStorage(
+            model, ikFile, 0.01);
+
+    LowPassSmoothFilter::Parameters filterParam;
+    filterParam.memory = ini.getInteger(section, "MEMORY", 0);
+    filterParam.delay = ini.getInteger(section, "DELAY", 0);
+    filterParam.cutoffFrequency = ini.getReal(section, "CUTOFF_FREQ", 0);
+    filterParam.splineOrder = ini.getInteger(section, "SPLINE_ORDER", 0);
+
+    filterParam.numSignals = model.getNumCoordinates();
+    filterParam.calculateDerivatives = true;
+    LowPassSmoothFilter ikFilter(filterParam);
+
+    filterParam.numSignals = 9;
+    filterParam.calculateDerivatives = false;
+    std::vector<LowPassSmoothFilter> grfFilters(
+            wrenchLabels.size(), LowPassSmoothFilter(filterParam));
+
+    std::unique_ptr<OpenSim::Storage> grfMotion;
+    if (!wrenchLabels.empty()) {
+        grfMotion.reset(new OpenSim::Storage(
+                subjectDir + ini.getString(section, "GRF_MOT_FILE", "")));
+    }
+
+    std::vector<GaitFrame> frames;
+    for (int i = 0; i < qTable.getNumRows(); ++i) {
+        double t = qTable.getIndependentColumn()[i];
+        auto ikFiltered =
+                ikFilter.filter({t, qTable.getRowAtIndex(i).getAsVector()});
+        bool isValid = ikFiltered.isValid;
+
+        GaitFrame frame{i, ikFiltered.t, ikFiltered.x, ikFiltered.xDot,
+                        ikFiltered.xDDot};
+        for (std::size_t j = 0; j < wrenchLabels.size(); ++j) {
+            auto wrench = ExternalWrench::getWrenchFromStorage(
+                    t, wrenchLabels[j], *grfMotion);
+            auto grfFiltered = grfFilters[j].filter({t, wrench.toVector()});
+            wrench.fromVector(grfFiltered.x);
+            frame.externalWrenches.push_back(wrench);
+            isValid = isValid && grfFiltered.isValid;
+        }
+        if (isValid) frames.push_back(frame);
+    }
+    return frames;
+}
+
+} // namespace OpenSimRT
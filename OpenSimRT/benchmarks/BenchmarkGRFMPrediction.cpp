@@ -0,0 +1,144 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file BenchmarkGRFMPrediction.cpp
+ *
+ * \brief Measures GRFMPrediction::solve on the gait1992 recording, with the
+ * acceleration-based gait phase detector of the corresponding test. The update
+ * of the detector is not part of the measurement.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "AccelerationBasedPhaseDetector.h"
+#include "Benchmark.h"
+#include "BenchmarkData.h"
+#include "Exception.h"
+#include "GRFMPrediction.h"
+#include "INIReader.h"
+#include "Settings.h"
+#include <Actuators/Thelen2003Muscle.h>
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+using namespace OpenSim;
+using namespace SimTK;
+using namespace OpenSimRT;
+
+void run(int argc, char* argv[]) {
+    BenchmarkSuite suite("GRFMPrediction", argc, argv);
+
+    // subject data
+    INIReader ini(INI_FILE);
+    auto section = "TEST_ACCELERATION_GRFM_PREDICTION_FROM_FILE";
+    auto subjectDir = DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
+    auto modelFile = subjectDir + ini.getString(section, "MODEL_FILE", "");
+    // remove last N samples in motion for smooth transition between passes
+    auto removeNLastRows =
+            ini.getInteger(section, "REMOVE_N_LAST_TABLE_ROWS", 0);
+
+    Object::RegisterType(Thelen2003Muscle());
+    Model model(modelFile);
+    model.initSystem();
+
+    auto frames = prepareGaitFrames(ini, section, subjectDir, model);
+    frames.resize(frames.size() - min<size_t>(removeNLastRows, frames.size()));
+    if (frames.empty()) THROW_EXCEPTION("no valid frames");
+
+    // acceleration-based event detector
+    AccelerationBasedPhaseDetector::Parameters detectorParameters;
+    detectorParameters.heelAccThreshold =
+            ini.getReal(section, "HEEL_ACC_THRESHOLD", 0);
+    detectorParameters.toeAccThreshold =
+            ini.getReal(section, "TOE_ACC_THRESHOLD", 0);
+    detectorParameters.windowSize = ini.getInteger(section, "WINDOW_SIZE", 0);
+    detectorParameters.rFootBodyName =
+            ini.getString(section, "RIGHT_FOOT_BODY_NAME", "");
+    detectorParameters.lFootBodyName =
+            ini.getString(section, "LEFT_FOOT_BODY_NAME", "");
+    detectorParameters.rHeelLocationInFoot =
+            ini.getSimtkVec(section, "RIGHT_HEEL_LOCATION_IN_FOOT", Vec3(0));
+    detectorParameters.lHeelLocationInFoot =
+            ini.getSimtkVec(section, "LEFT_HEEL_LOCATION_IN_FOOT", Vec3(0));
+    detectorParameters.rToeLocationInFoot =
+            ini.getSimtkVec(section, "RIGHT_TOE_LOCATION_IN_FOOT", Vec3(0));
+    detectorParameters.lToeLocationInFoot =
+            ini.getSimtkVec(section, "LEFT_TOE_LOCATION_IN_FOOT", Vec3(0));
+    detectorParameters.samplingFrequency = 1 / 0.01;
+    detectorParameters.accLPFilterFreq =
+            ini.getInteger(section, "ACC_LP_FILTER_FREQ", 0);
+    detectorParameters.velLPFilterFreq =
+            ini.getInteger(section, "VEL_LP_FILTER_FREQ", 0);
+    detectorParameters.posLPFilterFreq =
+            ini.getInteger(section, "POS_LP_FILTER_FREQ", 0);
+    detectorParameters.accLPFilterOrder =
+            ini.getInteger(section, "ACC_LP_FILTER_ORDER", 0);
+    detectorParameters.velLPFilterOrder =
+            ini.getInteger(section, "VEL_LP_FILTER_ORDER", 0);
+    detectorParameters.posLPFilterOrder =
+            ini.getInteger(section, "POS_LP_FILTER_ORDER", 0);
+    detectorParameters.posDiffOrder =
+            ini.getInteger(section, "POS_DIFF_ORDER", 0);
+    detectorParameters.velDiffOrder =
+            ini.getInteger(section, "VEL_DIFF_ORDER", 0);
+    AccelerationBasedPhaseDetector detector(model, detectorParameters);
+
+    // grfm prediction
+    GRFMPrediction::Parameters grfmParameters;
+    grfmParameters.method =
+            GRFMPrediction::selectMethod(ini.getString(section, "METHOD", ""));
+    grfmParameters.pelvisBodyName =
+            ini.getString(section, "PELVIS_BODY_NAME", "");
+    grfmParameters.rStationBodyName = detectorParameters.rFootBodyName;
+    grfmParameters.lStationBodyName = detectorParameters.lFootBodyName;
+    grfmParameters.rHeelStationLocation =
+            ini.getSimtkVec(section, "RIGHT_HEEL_STATION_LOCATION", Vec3(0));
+    grfmParameters.lHeelStationLocation =
+            ini.getSimtkVec(section, "LEFT_HEEL_STATION_LOCATION", Vec3(0));
+    grfmParameters.rToeStationLocation =
+            ini.getSimtkVec(section, "RIGHT_TOE_STATION_LOCATION", Vec3(0));
+    grfmParameters.lToeStationLocation =
+            ini.getSimtkVec(section, "LEFT_TOE_STATION_LOCATION", Vec3(0));
+    grfmParameters.directionWindowSize =
+            ini.getInteger(section, "DIRECTION_WINDOW_SIZE", 0);
+    GRFMPrediction grfm(model, grfmParameters, &detector);
+
+    // the time of each pass continues the previous one (cyclic motion)
+    const double period = frames.back().t - frames.front().t + 0.01;
+    auto& timer = suite.addTimer("GRFMPrediction::solve", "gait1992");
+    for (int r = 0; r < suite.getRepetitions(); ++r) {
+        for (const auto& frame : frames) {
+            GRFMPrediction::Input input{frame.t + r * period, frame.q,
+                                        frame.qDot, frame.qDDot};
+            detector.updDetector(input);
+            timer.measure([&]() { return grfm.solve(input); });
+        }
+    }
+    suite.report();
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run(argc, argv);
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,81 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file BenchmarkInverseDynamics.cpp
+ *
+ * \brief Measures InverseDynamics::solve on the gait1992 recording, using the
+ * filtered kinematics and ground reaction wrenches as input.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "Benchmark.h"
+#include "BenchmarkData.h"
+#include "INIReader.h"
+#include "InverseDynamics.h"
+#include "OpenSimUtils.h"
+#include "Settings.h"
+#include <Actuators/Thelen2003Muscle.h>
+#include <iostream>
+
+using namespace std;
+using namespace OpenSim;
+using namespace OpenSimRT;
+
+void run(int argc, char* argv[]) {
+    BenchmarkSuite suite("InverseDynamics", argc, argv);
+
+    // subject data
+    INIReader ini(INI_FILE);
+    auto section = "TEST_ID_FROM_FILE";
+    auto subjectDir = DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
+    auto modelFile = subjectDir + ini.getString(section, "MODEL_FILE", "");
+
+    // setup model
+    Object::RegisterType(Thelen2003Muscle());
+    Model model(modelFile);
+    OpenSimUtils::removeActuators(model);
+    model.initSystem();
+
+    vector<ExternalWrench::Parameters> wrenchParameters;
+    vector<vector<string>> wrenchLabels;
+    readGRFParameters(ini, section, wrenchParameters, wrenchLabels);
+    auto frames =
+            prepareGaitFrames(ini, section, subjectDir, model, wrenchLabels);
+
+    InverseDynamics id(model, wrenchParameters);
+    auto& timer = suite.addTimer("InverseDynamics::solve", "gait1992");
+    for (int r = 0; r < suite.getRepetitions(); ++r) {
+        for (const auto& frame : frames) {
+            InverseDynamics::Input input{frame.t, frame.q, frame.qDot,
+                                         frame.qDDot, frame.externalWrenches};
+            timer.measure([&]() { return id.solve(input); });
+        }
+    }
+    suite.report();
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run(argc, argv);
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,128 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file BenchmarkInverseKinematics.cpp
+ *
+ * \brief Measures InverseKinematics::solve with marker tasks on the gait1992
+ * recording and with IMU tasks on the mobl2016 recording.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "Benchmark.h"
+#include "INIReader.h"
+#include "InverseKinematics.h"
+#include "OpenSimUtils.h"
+#include "Settings.h"
+#include <Actuators/Schutte1993Muscle_Deprecated.h>
+#include <OpenSim/Simulation/Model/Model.h>
+#include <iostream>
+
+using namespace std;
+using namespace OpenSim;
+using namespace OpenSimRT;
+
+/**
+ * Solve the frames in order (each solution is the initial guess of the next
+ * frame).
+ */
+void measure(BenchmarkSuite& suite, const string& dataset,
+             InverseKinematics& ik,
+             const vector<InverseKinematics::Input>& frames) {
+    auto& timer = suite.addTimer("InverseKinematics::solve", dataset);
+    for (int r = 0; r < suite.getRepetitions(); ++r) {
+        for (const auto& frame : frames) {
+            timer.measure([&]() { return ik.solve(frame); });
+        }
+    }
+}
+
+void benchmarkMarkers(BenchmarkSuite& suite, INIReader& ini) {
+    auto section = "TEST_IK_FROM_FILE";
+    auto subjectDir = DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
+    auto modelFile = subjectDir + ini.getString(section, "MODEL_FILE", "");
+    auto trcFile = subjectDir + ini.getString(section, "TRC_FILE", "");
+    auto ikTaskSetFile =
+            subjectDir + ini.getString(section, "IK_TASK_SET_FILE", "");
+
+    Model model(modelFile);
+    OpenSimUtils::removeActuators(model);
+
+    IKTaskSet ikTaskSet(ikTaskSetFile);
+    MarkerData markerData(trcFile);
+    vector<InverseKinematics::MarkerTask> markerTasks;
+    vector<string> observationOrder;
+    InverseKinematics::createMarkerTasksFromIKTaskSet(
+            model, ikTaskSet, markerTasks, observationOrder);
+
+    vector<InverseKinematics::Input> frames;
+    for (int i = 0; i < markerData.getNumFrames(); ++i) {
+        frames.push_back(InverseKinematics::getFrameFromMarkerData(
+                i, markerData, observationOrder, false));
+    }
+
+    InverseKinematics ik(model, markerTasks,
+                         vector<InverseKinematics::IMUTask>{}, SimTK::Infinity,
+                         1e-5);
+    measure(suite, "gait1992 markers", ik, frames);
+}
+
+void benchmarkIMUs(BenchmarkSuite& suite, INIReader& ini) {
+    auto section = "TEST_IK_IMU_FROM_FILE";
+    auto subjectDir = DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
+    auto modelFile = subjectDir + ini.getString(section, "MODEL_FILE", "");
+    auto trcFile = subjectDir + ini.getString(section, "TRC_FILE", "");
+
+    Object::RegisterType(Schutte1993Muscle_Deprecated());
+    Model model(modelFile);
+    OpenSimUtils::removeActuators(model);
+
+    MarkerData markerData(trcFile);
+    vector<InverseKinematics::IMUTask> imuTasks;
+    vector<string> observationOrder;
+    InverseKinematics::createIMUTasksFromMarkerData(model, markerData, imuTasks,
+                                                    observationOrder);
+
+    vector<InverseKinematics::Input> frames;
+    for (int i = 0; i < markerData.getNumFrames(); ++i) {
+        frames.push_back(InverseKinematics::getFrameFromMarkerData(
+                i, markerData, observationOrder, true));
+    }
+
+    InverseKinematics ik(model, vector<InverseKinematics::MarkerTask>{},
+                         imuTasks, SimTK::Infinity, 1e-5);
+    measure(suite, "mobl2016 imus", ik, frames);
+}
+
+void run(int argc, char* argv[]) {
+    BenchmarkSuite suite("InverseKinematics", argc, argv);
+    INIReader ini(INI_FILE);
+    benchmarkMarkers(suite, ini);
+    benchmarkIMUs(suite, ini);
+    suite.report();
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run(argc, argv);
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,101 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file BenchmarkJointReaction.cpp
+ *
+ * \brief Measures JointReaction::solve on the gait1992 recording, using the
+ * filtered kinematics, ground reaction wrenches and the muscle forces of static
+ * optimization as input.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "Benchmark.h"
+#include "BenchmarkData.h"
+#include "Exception.h"
+#include "INIReader.h"
+#include "JointReaction.h"
+#include "Settings.h"
+#include "Utils.h"
+#include <OpenSim/Actuators/Thelen2003Muscle.h>
+#include <OpenSim/Simulation/Model/Muscle.h>
+#include <iostream>
+
+using namespace std;
+using namespace OpenSim;
+using namespace SimTK;
+using namespace OpenSimRT;
+
+void run(int argc, char* argv[]) {
+    BenchmarkSuite suite("JointReaction", argc, argv);
+
+    // subject data
+    INIReader ini(INI_FILE);
+    auto section = "TEST_JR_FROM_FILE";
+    auto subjectDir = DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
+    auto modelFile = subjectDir + ini.getString(section, "MODEL_FILE", "");
+    auto soFile = subjectDir + ini.getString(section, "SO_FILE", "");
+    auto delay = ini.getInteger(section, "DELAY", 0);
+
+    // setup model
+    Object::RegisterType(Thelen2003Muscle());
+    Model model(modelFile);
+    model.initSystem();
+
+    vector<ExternalWrench::Parameters> wrenchParameters;
+    vector<vector<string>> wrenchLabels;
+    readGRFParameters(ini, section, wrenchParameters, wrenchLabels);
+    auto frames =
+            prepareGaitFrames(ini, section, subjectDir, model, wrenchLabels);
+
+    // read muscle forces (aligned with the delay of the filter)
+    Storage soFm(soFile);
+    soFm.resampleLinear(0.01);
+    const int numMuscles = model.getMuscles().getSize();
+    auto fmColumnLabels = soFm.getColumnLabels(); // time is first
+    for (int i = 0; i < numMuscles; i++)
+        if (fmColumnLabels[i + 1] != model.getMuscles()[i].getName())
+            THROW_EXCEPTION("muscle forces are in different order");
+
+    vector<JointReaction::Input> inputs;
+    for (const auto& frame : frames) {
+        auto soStateVector = soFm.getStateVector(frame.index - delay);
+        Vector fm(numMuscles, &soStateVector->getData()[0]);
+        inputs.push_back({frame.t, frame.q, frame.qDot, fm,
+                          frame.externalWrenches});
+    }
+
+    JointReaction jr(model, wrenchParameters);
+    auto& timer = suite.addTimer("JointReaction::solve", "gait1992");
+    for (int r = 0; r < suite.getRepetitions(); ++r) {
+        for (const auto& input : inputs) {
+            timer.measure([&]() { return jr.solve(input); });
+        }
+    }
+    suite.report();
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run(argc, argv);
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
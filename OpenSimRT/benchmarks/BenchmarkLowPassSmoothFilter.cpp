@@ -0,0 +1,90 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file BenchmarkLowPassSmoothFilter.cpp
+ *
+ * \brief Measures LowPassSmoothFilter::filter on the kinematics of the gait1992
+ * recording, with the filter parameters of the inverse dynamics test.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "Benchmark.h"
+#include "INIReader.h"
+#include "OpenSimUtils.h"
+#include "Settings.h"
+#include "SignalProcessing.h"
+#include <Actuators/Thelen2003Muscle.h>
+#include <OpenSim/Simulation/Model/Model.h>
+#include <iostream>
+
+using namespace std;
+using namespace OpenSim;
+using namespace OpenSimRT;
+
+void run(int argc, char* argv[]) {
+    BenchmarkSuite suite("LowPassSmoothFilter", argc, argv);
+
+    // subject data
+    INIReader ini(INI_FILE);
+    auto section = "TEST_ID_FROM_FILE";
+    auto subjectDir = DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
+    auto modelFile = subjectDir + ini.getString(section, "MODEL_FILE", "");
+    auto ikFile = subjectDir + ini.getString(section, "IK_FILE", "");
+
+    Object::RegisterType(Thelen2003Muscle());
+    Model model(modelFile);
+    auto qTable = OpenSimUtils::getMultibodyTreeOrderedCoordinatesFromStorage(
+            model, ikFile, 0.01);
+    vector<SimTK::Vector> qRaw;
+    for (int i = 0; i < qTable.getNumRows(); ++i) {
+        qRaw.push_back(qTable.getRowAtIndex(i).getAsVector());
+    }
+    const auto& time = qTable.getIndependentColumn();
+
+    LowPassSmoothFilter::Parameters filterParam;
+    filterParam.numSignals = model.getNumCoordinates();
+    filterParam.memory = ini.getInteger(section, "MEMORY", 0);
+    filterParam.delay = ini.getInteger(section, "DELAY", 0);
+    filterParam.cutoffFrequency = ini.getReal(section, "CUTOFF_FREQ", 0);
+    filterParam.splineOrder = ini.getInteger(section, "SPLINE_ORDER", 0);
+    filterParam.calculateDerivatives = true;
+    LowPassSmoothFilter filter(filterParam);
+
+    // the time of each pass continues the previous one, because the filter
+    // requires a constant sampling period
+    const double period = time.back() - time.front() + 0.01;
+    auto& timer = suite.addTimer("LowPassSmoothFilter::filter", "gait1992");
+    for (int r = 0; r < suite.getRepetitions(); ++r) {
+        for (size_t i = 0; i < qRaw.size(); ++i) {
+            LowPassSmoothFilter::Input input{time[i] + r * period, qRaw[i]};
+            timer.measure([&]() { return filter.filter(input); });
+        }
+    }
+    suite.report();
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run(argc, argv);
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
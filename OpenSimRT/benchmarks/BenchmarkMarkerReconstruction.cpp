@@ -0,0 +1,109 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file BenchmarkMarkerReconstruction.cpp
+ *
+ * \brief Measures MarkerReconstruction::solve on the gait1992 recording, where
+ * the markers of the corresponding test are occluded in every frame.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "Benchmark.h"
+#include "Exception.h"
+#include "INIReader.h"
+#include "InverseKinematics.h"
+#include "MarkerReconstruction.h"
+#include "Settings.h"
+#include <Actuators/Thelen2003Muscle.h>
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+using namespace OpenSim;
+using namespace OpenSimRT;
+using namespace SimTK;
+
+void run(int argc, char* argv[]) {
+    BenchmarkSuite suite("MarkerReconstruction", argc, argv);
+
+    // subject data
+    INIReader ini(INI_FILE);
+    auto section = "TEST_MISSING_MARKER_RECONSTRUCTION_FROM_FILE";
+    auto subjectDir = DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
+    auto modelFile = subjectDir + ini.getString(section, "MODEL_FILE", "");
+    auto trcFile = subjectDir + ini.getString(section, "TRC_FILE", "");
+    auto missingMarkerLabels =
+            ini.getVector(section, "MISSING_MARKERS", vector<string>{});
+
+    Object::RegisterType(Thelen2003Muscle());
+    Model model(modelFile);
+
+    MarkerData markerData(trcFile);
+    vector<InverseKinematics::MarkerTask> markerTasks;
+    vector<string> observationOrder;
+    InverseKinematics::createMarkerTasksFromMarkerData(
+            model, markerData, markerTasks, observationOrder);
+
+    // indices of the occluded markers
+    vector<int> missing;
+    for (const auto& label : missingMarkerLabels) {
+        auto itr = find(observationOrder.begin(), observationOrder.end(),
+                        label);
+        if (itr == observationOrder.end()) {
+            THROW_EXCEPTION("Invalid input. Marker name does not exist");
+        }
+        missing.push_back(distance(observationOrder.begin(), itr));
+    }
+
+    vector<Array_<Vec3>> frames;
+    for (int i = 0; i < markerData.getNumFrames(); ++i) {
+        frames.push_back(InverseKinematics::getFrameFromMarkerData(
+                                 i, markerData, observationOrder, false)
+                                 .markerObservations);
+    }
+
+    // the reconstruction is initialized with the first complete frame
+    MarkerReconstruction mmr(model, markerTasks);
+    auto first = find_if(frames.begin(), frames.end(), [&](const auto& f) {
+        return mmr.initState(f);
+    });
+    if (first == frames.end()) THROW_EXCEPTION("no complete marker frame");
+    for (auto& frame : frames) {
+        for (const auto& j : missing) frame[j] = Vec3(NaN);
+    }
+
+    auto& timer = suite.addTimer("MarkerReconstruction::solve", "gait1992");
+    for (int r = 0; r < suite.getRepetitions(); ++r) {
+        for (auto frame = first; frame != frames.end(); ++frame) {
+            const auto& observations = *frame;
+            timer.measure([&]() { return mmr.solve(observations); });
+        }
+    }
+    suite.report();
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run(argc, argv);
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
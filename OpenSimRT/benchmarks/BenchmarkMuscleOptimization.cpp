@@ -0,0 +1,123 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file BenchmarkMuscleOptimization.cpp
+ *
+ * \brief Measures MuscleOptimization::solve on the gait1992 recording, using
+ * the kinematics and the generalized forces of OpenSim as input, for the whole
+ * problem and for its independent blocks.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "Benchmark.h"
+#include "Exception.h"
+#include "INIReader.h"
+#include "MuscleOptimization.h"
+#include "OpenSimUtils.h"
+#include "Settings.h"
+#include "Utils.h"
+#include <Actuators/Thelen2003Muscle.h>
+#include <iostream>
+
+using namespace std;
+using namespace OpenSim;
+using namespace OpenSimRT;
+
+void run(int argc, char* argv[]) {
+    BenchmarkSuite suite("MuscleOptimization", argc, argv);
+
+    // subject data
+    INIReader ini(INI_FILE);
+    auto section = "TEST_SO_FROM_FILE";
+    auto subjectDir = DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
+    auto modelFile = subjectDir + ini.getString(section, "MODEL_FILE", "");
+    auto ikFile = subjectDir + ini.getString(section, "IK_FILE", "");
+    auto idFile = subjectDir + ini.getString(section, "ID_FILE", "");
+
+#ifndef WIN32
+    auto momentArmLibraryPath =
+            LIBRARY_OUTPUT_PATH + "/" +
+            ini.getString(section, "MOMENT_ARM_LIBRARY", "");
+#else
+    auto momentArmLibraryPath =
+            ini.getString(section, "MOMENT_ARM_LIBRARY", "");
+#endif
+
+    MuscleOptimization::OptimizationParameters optimizationParameters;
+    optimizationParameters.convergenceTolerance =
+            ini.getReal(section, "CONVERGENCE_TOLERANCE", 0);
+    optimizationParameters.memoryHistory =
+            ini.getReal(section, "MEMORY_HISTORY", 0);
+    optimizationParameters.maximumIterations =
+            ini.getInteger(section, "MAXIMUM_ITERATIONS", 0);
+    optimizationParameters.objectiveExponent =
+            ini.getInteger(section, "OBJECTIVE_EXPONENT", 0);
+    optimizationParameters.numberOfThreads =
+            ini.getInteger(section, "NUMBER_OF_THREADS", 1);
+
+    Object::RegisterType(Thelen2003Muscle());
+    Model model(modelFile);
+    model.initSystem();
+    auto calcMomentArm = OpenSimUtils::getMomentArmFromDynamicLibrary(
+            model, momentArmLibraryPath);
+
+    // kinematics and generalized forces with ordered coordinates
+    auto qTable = OpenSimUtils::getMultibodyTreeOrderedCoordinatesFromStorage(
+            model, ikFile, 0.01);
+    auto tauTable = OpenSimUtils::getMultibodyTreeOrderedCoordinatesFromStorage(
+            model, idFile, 0.01);
+    if (tauTable.getNumRows() != qTable.getNumRows()) {
+        THROW_EXCEPTION("ik and id storages of different size " +
+                        toString(qTable.getNumRows()) +
+                        " != " + toString(tauTable.getNumRows()));
+    }
+    vector<MuscleOptimization::Input> inputs;
+    for (int i = 0; i < qTable.getNumRows(); i++) {
+        inputs.push_back({qTable.getIndependentColumn()[i],
+                          qTable.getRowAtIndex(i).getAsVector(),
+                          tauTable.getRowAtIndex(i).getAsVector()});
+    }
+
+    // the optimization is warm started from the previous solution, thus the
+    // frames are solved in order
+    for (bool useBlockDecomposition : {false, true}) {
+        optimizationParameters.useBlockDecomposition = useBlockDecomposition;
+        MuscleOptimization so(model, optimizationParameters, calcMomentArm);
+        auto& timer = suite.addTimer(
+                useBlockDecomposition ? "MuscleOptimization::solve (blocks)"
+                                      : "MuscleOptimization::solve (whole)",
+                "gait1992");
+        for (int r = 0; r < suite.getRepetitions(); ++r) {
+            for (const auto& input : inputs) {
+                timer.measure([&]() { return so.solve(input); });
+            }
+        }
+    }
+    suite.report();
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run(argc, argv);
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,117 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file BenchmarkSyncManager.cpp
+ *
+ * \brief Measures SyncManager::appendPack/getPack (and the RingSyncManager) by
+ * synchronizing the kinematics (100Hz) and the ground reaction forces (600Hz)
+ * of the gait1992 recording, as if they were streamed by different devices.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "Benchmark.h"
+#include "INIReader.h"
+#include "OpenSimUtils.h"
+#include "RingSyncManager.h"
+#include "Settings.h"
+#include "SyncManager.h"
+#include <Actuators/Thelen2003Muscle.h>
+#include <OpenSim/Common/Storage.h>
+#include <OpenSim/Simulation/Model/Model.h>
+#include <iostream>
+#include <utility>
+
+using namespace std;
+using namespace OpenSim;
+using namespace OpenSimRT;
+
+typedef pair<double, SimTK::Vector> Sample;
+
+/**
+ * The latest sample of each stream at the arrival of a force plate sample.
+ */
+struct Tick {
+    Sample kinematics;
+    Sample forces;
+};
+
+template <typename Manager>
+void measure(BenchmarkSuite& suite, const string& name,
+             const vector<Tick>& ticks) {
+    auto& appendTimer = suite.addTimer(name + "::appendPack", "gait1992");
+    auto& getTimer = suite.addTimer(name + "::getPack", "gait1992");
+
+    // each pass starts with an empty manager
+    for (int r = 0; r < suite.getRepetitions(); ++r) {
+        Manager manager(100, 1e-4);
+        for (const auto& tick : ticks) {
+            appendTimer.start();
+            manager.appendPack(tick.kinematics, tick.forces);
+            appendTimer.stop();
+            getTimer.measure([&]() { return manager.getPack(); });
+        }
+    }
+}
+
+void run(int argc, char* argv[]) {
+    BenchmarkSuite suite("SyncManager", argc, argv);
+
+    // subject data
+    INIReader ini(INI_FILE);
+    auto section = "TEST_ID_FROM_FILE";
+    auto subjectDir = DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
+    auto modelFile = subjectDir + ini.getString(section, "MODEL_FILE", "");
+    auto ikFile = subjectDir + ini.getString(section, "IK_FILE", "");
+    auto grfMotFile = subjectDir + ini.getString(section, "GRF_MOT_FILE", "");
+
+    Object::RegisterType(Thelen2003Muscle());
+    Model model(modelFile);
+    auto qTable = OpenSimUtils::getMultibodyTreeOrderedCoordinatesFromStorage(
+            model, ikFile, 0.01);
+    const auto& qTime = qTable.getIndependentColumn();
+    Storage grfMotion(grfMotFile);
+
+    // replay the force plate samples within the duration of the kinematics
+    vector<Tick> ticks;
+    int k = 0;
+    for (int i = 0; i < grfMotion.getSize(); ++i) {
+        auto stateVector = grfMotion.getStateVector(i);
+        double t = stateVector->getTime();
+        if (t < qTime.front() || t > qTime.back()) continue;
+        while (k + 1 < (int) qTime.size() && qTime[k + 1] <= t) ++k;
+        ticks.push_back(
+                {{qTime[k], qTable.getRowAtIndex(k).getAsVector()},
+                 {t, SimTK::Vector(stateVector->getSize(),
+                                   &stateVector->getData()[0])}});
+    }
+
+    measure<SyncManager<>>(suite, "SyncManager", ticks);
+    measure<RingSyncManager<>>(suite, "RingSyncManager", ticks);
+    suite.report();
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run(argc, argv);
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
@@ -247,3 +247,64 @@ function(addApplications)
       )
   endforeach()
 endfunction()
+
+
+
+function(addBenchmarks)
+  # Create benchmark executables for this directory and a target that runs
+  # all of them (make benchmarks). Each benchmark writes its results in
+  # ${PROJECT_BINARY_DIR}/benchmarks/<name>.json.
+  #
+  # Parse Arguments
+  # ---------------
+  # BENCHMARKPROGRAMS: Names of benchmark CPP files. One executable will be
+  #   created for each cpp of these files.
+  # LINKLIBS: Arguments to TARGET_LINK_LIBRARIES.
+  #
+  # Example:
+  #   addBenchmarks(
+  #       BENCHMARKPROGRAMS ${BENCHMARK_PROGRAMS}
+  #       LINKLIBS RealTime Common
+  #   )
+  # *****************************************************************************
+
+  # Parse arguments.
+  # ----------------
+  set(options)
+  set(oneValueArgs)
+  set(multiValueArgs BENCHMARKPROGRAMS LINKLIBS)
+  cmake_parse_arguments(
+    ADDBENCHMARKS "${options}" "${oneValueArgs}" "${multiValueArgs}" ${ARGN})
+
+  set(BENCHMARK_OUTPUT_DIR ${PROJECT_BINARY_DIR}/benchmarks)
+  set(BENCHMARK_COMMANDS)
+  set(BENCHMARK_NAMES)
+  foreach(benchmark_program ${ADDBENCHMARKS_BENCHMARKPROGRAMS})
+    # NAME_WE stands for "name without extension"
+    get_filename_component(BENCHMARK_NAME ${benchmark_program} NAME_WE)
+
+    add_executable(${BENCHMARK_NAME} ${benchmark_program})
+    target_link_libraries(${BENCHMARK_NAME} ${ADDBENCHMARKS_LINKLIBS})
+    set_target_properties(${BENCHMARK_NAME}
+      PROPERTIES
+      PROJECT_LABEL "Benchmark - ${BENCHMARK_NAME}"
+      FOLDER "Benchmarks"
+      )
+    list(APPEND BENCHMARK_NAMES ${BENCHMARK_NAME})
+    list(APPEND BENCHMARK_COMMANDS
+      COMMAND ${BENCHMARK_NAME}
+      --output ${BENCHMARK_OUTPUT_DIR}/${BENCHMARK_NAME}.json)
+  endforeach()
+
+  # the benchmarks are not part of ctest, because they take long and their
+  # results depend on the machine
+  add_custom_target(benchmarks
+    COMMAND ${CMAKE_COMMAND} -E make_directory ${BENCHMARK_OUTPUT_DIR}
+    ${BENCHMARK_COMMANDS}
+    DEPENDS ${BENCHMARK_NAMES}
+    WORKING_DIRECTORY ${PROJECT_BINARY_DIR}
+    COMMENT "Running benchmarks (results in ${BENCHMARK_OUTPUT_DIR})"
+    VERBATIM
+    )
+  set_target_properties(benchmarks PROPERTIES FOLDER "Benchmarks")
+endfunction()